@@ -65,6 +65,8 @@ ccDisplayOptionsDlg::ccDisplayOptionsDlg(QWidget* parent)
 	connect(m_ui->singleClickPickingCheckBox,	   &QCheckBox::toggled, this, [&](bool state) { m_parameters.singleClickPicking = state; });
 	connect(m_ui->autoDisplayNormalsCheckBox,      &QCheckBox::toggled, this, [&](bool state) { m_options.normalsDisplayedByDefault = state; });
 	connect(m_ui->useNativeDialogsCheckBox,        &QCheckBox::toggled, this, [&](bool state) { m_options.useNativeDialogs = state; });
+	connect(m_ui->compactVBOsCheckBox,             &QCheckBox::toggled, this, [&](bool state) { m_parameters.compactVBOs = state; });
+	connect(m_ui->streamCloudsLODCheckBox,         &QCheckBox::toggled, this, [&](bool state) { m_parameters.streamCloudsLOD = state; });
 
 	connect(m_ui->useVBOCheckBox,	&QAbstractButton::clicked,	this, &ccDisplayOptionsDlg::changeVBOUsage);
 
@@ -75,6 +77,7 @@ ccDisplayOptionsDlg::ccDisplayOptionsDlg(QWidget* parent)
 	connect(m_ui->numberPrecisionSpinBox,	qOverload<int>(&QSpinBox::valueChanged), this, &ccDisplayOptionsDlg::changeNumberPrecision);
 	connect(m_ui->labelOpacitySpinBox,		qOverload<int>(&QSpinBox::valueChanged), this, &ccDisplayOptionsDlg::changeLabelOpacity);
 	connect(m_ui->labelMarkerSizeSpinBox,	qOverload<int>(&QSpinBox::valueChanged), this, &ccDisplayOptionsDlg::changeLabelMarkerSize);
+	connect(m_ui->lodStreamingBudgetSpinBox,	qOverload<int>(&QSpinBox::valueChanged), this, [&](int val) { m_parameters.lodStreamingBudgetMb = static_cast<unsigned>(val); });
 
 	connect(m_ui->zoomSpeedDoubleSpinBox,		qOverload<double>(&QDoubleSpinBox::valueChanged), this, &ccDisplayOptionsDlg::changeZoomSpeed);
 	connect(m_ui->maxCloudSizeDoubleSpinBox,	qOverload<double>(&QDoubleSpinBox::valueChanged), this, &ccDisplayOptionsDlg::changeMaxCloudSize);
@@ -184,6 +187,10 @@ void ccDisplayOptionsDlg::refresh()
 	m_ui->drawRoundedPointsCheckBox->setChecked(m_parameters.drawRoundedPoints);
 	m_ui->maxCloudSizeDoubleSpinBox->setValue(m_parameters.minLoDCloudSize / 1000000.0);
 	m_ui->useVBOCheckBox->setChecked(m_parameters.useVBOs);
+	m_ui->compactVBOsCheckBox->setChecked(m_parameters.compactVBOs);
+	m_ui->compactVBOsCheckBox->setEnabled(m_parameters.useVBOs);
+	m_ui->streamCloudsLODCheckBox->setChecked(m_parameters.streamCloudsLOD);
+	m_ui->lodStreamingBudgetSpinBox->setValue(static_cast<int>(m_parameters.lodStreamingBudgetMb));
 	m_ui->showCrossCheckBox->setChecked(m_parameters.displayCross);
 	m_ui->singleClickPickingCheckBox->setChecked(m_parameters.singleClickPicking);
 
@@ -376,6 +383,7 @@ void ccDisplayOptionsDlg::changeMaxCloudSize(double val)
 void ccDisplayOptionsDlg::changeVBOUsage()
 {
 	m_parameters.useVBOs = m_ui->useVBOCheckBox->isChecked();
+	m_ui->compactVBOsCheckBox->setEnabled(m_parameters.useVBOs);
 	if (m_parameters.useVBOs && m_ui->maxCloudSizeDoubleSpinBox->value() < s_defaultMaxVBOCloudSizeM)
 	{
 		m_ui->maxCloudSizeDoubleSpinBox->setValue(s_defaultMaxVBOCloudSizeM);
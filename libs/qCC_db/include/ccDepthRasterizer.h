@@ -0,0 +1,159 @@
+//##########################################################################
+//#                                                                        #
+//#                              CLOUDCOMPARE                              #
+//#                                                                        #
+//#  This program is free software; you can redistribute it and/or modify  #
+//#  it under the terms of the GNU General Public License as published by  #
+//#  the Free Software Foundation; version 2 or later of the License.      #
+//#                                                                        #
+//#  This program is distributed in the hope that it will be useful,       #
+//#  but WITHOUT ANY WARRANTY; without even the implied warranty of        #
+//#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          #
+//#  GNU General Public License for more details.                          #
+//#                                                                        #
+//#                    COPYRIGHT: CloudCompare project                     #
+//#                                                                        #
+//##########################################################################
+
+#ifndef CC_DEPTH_RASTERIZER_HEADER
+#define CC_DEPTH_RASTERIZER_HEADER
+
+//Local
+#include "qCC_db.h"
+
+//CCCoreLib
+#include <CCGeom.h>
+
+//System
+#include <cstdint>
+#include <vector>
+
+//! CPU depth buffer rasterizer (no OpenGL context required)
+/** Renders points (samples) and triangles in a depth buffer, with a 'nearest' or
+	'farthest' depth test. The coordinates are expressed in pixels (x, y) with the
+	origin at the bottom-left corner of the buffer (as with OpenGL).
+
+	Several rasterizers can be used at the same time (one per thread) to render
+	different views in parallel. A big set of samples can also be rendered in
+	parallel in a single view (see drawSamples): the samples are first binned by
+	tile, then each tile is resolved by a single thread (no lock).
+**/
+class QCC_DB_LIB_API ccDepthRasterizer
+{
+public:
+
+	//! Depth test
+	enum DepthTest
+	{
+		KEEP_NEAREST,	/**< keeps the smallest depth value **/
+		KEEP_FARTHEST,	/**< keeps the biggest depth value **/
+	};
+
+	//! Triangle culling mode
+	enum CullingMode
+	{
+		NO_CULLING,		/**< all the triangles are drawn **/
+		CULL_BACK_FACES	/**< clockwise triangles are skipped (as with OpenGL) **/
+	};
+
+	//! Tile size (in pixels) used to render samples in parallel
+	static const unsigned TILE_SIZE = 64;
+
+	//! Invalid pixel index (i.e. outside of the buffer)
+	static const uint32_t INVALID_PIXEL = 0xFFFFFFFF;
+
+	//! Projected sample
+	struct Sample
+	{
+		//! Pixel index (see pixelIndex) or INVALID_PIXEL
+		uint32_t pixel;
+		//! Depth value
+		PointCoordinateType depth;
+	};
+
+	//! Default constructor
+	ccDepthRasterizer();
+
+	//! Initializes the buffer
+	/** \param width buffer width (in pixels)
+		\param height buffer height (in pixels)
+		\param depthTest depth test
+		\param emptyValue value of the empty pixels (should be 'behind' all the depth values)
+		\return success
+	**/
+	bool init(unsigned width, unsigned height, DepthTest depthTest, PointCoordinateType emptyValue);
+
+	//! Clears the buffer (all the pixels are set to the empty value)
+	void clear();
+
+	//! Returns the buffer width
+	inline unsigned width() const { return m_width; }
+	//! Returns the buffer height
+	inline unsigned height() const { return m_height; }
+	//! Returns the value of the empty pixels
+	inline PointCoordinateType emptyValue() const { return m_emptyValue; }
+
+	//! Returns the depth buffer (row by row, starting from the bottom)
+	inline std::vector<PointCoordinateType>& buffer() { return m_depth; }
+	//! Returns the depth buffer (const version)
+	inline const std::vector<PointCoordinateType>& buffer() const { return m_depth; }
+
+	//! Returns the depth value of a pixel
+	inline PointCoordinateType depth(uint32_t pixel) const { return m_depth[pixel]; }
+	//! Returns whether a pixel is empty
+	inline bool isEmpty(uint32_t pixel) const { return m_depth[pixel] == m_emptyValue; }
+
+	//! Returns the index of the pixel containing a given position (or INVALID_PIXEL)
+	inline uint32_t pixelIndex(PointCoordinateType x, PointCoordinateType y) const
+	{
+		if (x < 0 || y < 0)
+		{
+			return INVALID_PIXEL;
+		}
+		unsigned i = static_cast<unsigned>(x);
+		unsigned j = static_cast<unsigned>(y);
+		return (i < m_width && j < m_height ? j * m_width + i : INVALID_PIXEL);
+	}
+
+	//! Draws a single sample
+	inline void drawSample(uint32_t pixel, PointCoordinateType depth)
+	{
+		PointCoordinateType& z = m_depth[pixel];
+		if (m_depthTest == KEEP_NEAREST ? depth < z : depth > z)
+		{
+			z = depth;
+		}
+	}
+
+	//! Draws a triangle
+	/** The pixels whose center lies inside the triangle are drawn (the depth
+		is linearly interpolated).
+		\param A first vertex (x, y in pixels and z = depth)
+		\param B second vertex
+		\param C third vertex
+		\param cullingMode culling mode
+	**/
+	void drawTriangle(const CCVector3& A, const CCVector3& B, const CCVector3& C, CullingMode cullingMode);
+
+	//! Draws a set of samples in parallel
+	/** The samples are binned by tile (counting sort) then each tile is resolved by a single thread.
+		\param samples projected samples (the ones with an invalid pixel index are ignored)
+		\return success (false if not enough memory)
+	**/
+	bool drawSamples(const std::vector<Sample>& samples);
+
+protected:
+
+	//! Depth buffer
+	std::vector<PointCoordinateType> m_depth;
+	//! Buffer width
+	unsigned m_width;
+	//! Buffer height
+	unsigned m_height;
+	//! Depth test
+	DepthTest m_depthTest;
+	//! Empty value
+	PointCoordinateType m_emptyValue;
+};
+
+#endif //CC_DEPTH_RASTERIZER_HEADER
@@ -175,6 +175,23 @@ public: //projection tools
 						PointCoordinateType &depth,
 						double posIndex = 0 ) const;
 
+	//! Projects a point in the sensor world with a precomputed 'world to sensor' transformation
+	/** Faster than the other version when many points are projected from the same sensor position.
+		\param[in] sourcePoint 3D point to project
+		\param[in] worldToSensor 'world to sensor' transformation (see getWorldToSensorTransformation)
+		\param[out] destPoint projected point in polar coordinates (see the other version)
+		\param[out] depth distance between the sensor optical center and the 3D point
+	**/
+	void projectPoint(	const CCVector3& sourcePoint,
+						const ccGLMatrix& worldToSensor,
+						CCVector2& destPoint,
+						PointCoordinateType &depth ) const;
+
+	//! Returns the 'world to sensor' transformation
+	/** \param[in] posIndex (optional) sensor position index (see ccIndexedTransformationBuffer)
+	**/
+	ccGLMatrix getWorldToSensorTransformation(double posIndex = 0) const;
+
 	//! 2D grid of normals
 	using NormalGrid = std::vector<CCVector3>;
 
@@ -204,7 +221,9 @@ public: //projection tools
 public: //depth buffer management
 
 	//! Projects a point cloud along the sensor point of view defined by this instance
-	/** \warning this method uses the cloud global iterator
+	/** The points are projected in parallel and the depth buffer is rendered
+		with a (tiled) CPU rasterizer (see ccDepthRasterizer).
+		\warning this method uses the cloud global iterator (if the cloud has no random access)
 		\param cloud a point cloud
 		\param errorCode error code in case the returned cloud is 0
 		\param projectedCloud optional (empty) cloud to store the projected points
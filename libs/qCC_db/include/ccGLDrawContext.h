@@ -23,6 +23,12 @@
 //Local
 #include "ccMaterial.h"
 
+//Qt
+#include <QString>
+
+//system
+#include <vector>
+
 class ccGenericGLDisplay;
 class ccScalarField;
 class ccColorRampShader;
@@ -70,6 +76,35 @@ enum CC_DRAWING_FLAGS
 #define MACRO_LODActivated(context)        (context.drawingFlags & CC_LOD_ACTIVATED)
 #define MACRO_VirtualTransEnabled(context) (context.drawingFlags & CC_VIRTUAL_TRANS_ENABLED)
 
+//! Rendering statistics
+/** Filled by the entities during a rendering pass (only if requested, see ccGLDrawContext::stats).
+**/
+struct ccRenderingStats
+{
+	//! Drawing time of an entity
+	struct EntityTiming
+	{
+		//! Entity unique ID
+		unsigned uniqueID = 0;
+		//! Entity name
+		QString name;
+		//! Drawing time (CPU side, in nanoseconds)
+		qint64 drawTime_ns = 0;
+		//! Number of points drawn
+		quint64 pointsDrawn = 0;
+	};
+
+	//! Number of points drawn
+	quint64 pointsDrawn = 0;
+	//! Number of bytes uploaded on the GPU (VBOs, LOD pages, etc.)
+	quint64 uploadedBytes = 0;
+	//! Drawing time of each entity (3D pass only)
+	std::vector<EntityTiming> entities;
+
+	//! Resets the statistics
+	void reset() { pointsDrawn = 0; uploadedBytes = 0; entities.clear(); }
+};
+
 //! Display context
 struct ccGLDrawContext
 {
@@ -118,6 +153,10 @@ struct ccGLDrawContext
 	bool moreLODPointsAvailable;
 	//! Whether higher levels are available or not
 	bool higherLODLevelsAvailable;
+	//! Whether to stream the LOD of big clouds by pages (loaded on the GPU by priority)
+	bool lodStreaming;
+	//! GPU memory budget for the streamed LOD pages (shared by all the clouds of the 3D view, in bytes)
+	size_t lodStreamingBudget;
 
 	//! Whether to decimate big meshes when rotating the camera
 	bool decimateMeshOnMove;
@@ -133,6 +172,8 @@ struct ccGLDrawContext
 	ccShader* customRenderingShader;
 	//! Use VBOs for faster display
 	bool useVBOs;
+	//! Use the compact (quantized) VBO layout
+	bool useCompactVBOs;
 
 	//! Label marker size (radius)
 	float labelMarkerSize;
@@ -156,6 +197,9 @@ struct ccGLDrawContext
 	//! Whether to draw rounded points (instead of squares)
 	bool drawRoundedPoints;
 
+	//! Rendering statistics (optional, only if the display is profiled)
+	ccRenderingStats* stats;
+
 	//Default constructor
 	ccGLDrawContext()
 		: drawingFlags(0)
@@ -178,12 +222,15 @@ struct ccGLDrawContext
 		, currentLODLevel(0)
 		, moreLODPointsAvailable(false)
 		, higherLODLevelsAvailable(false)
+		, lodStreaming(false)
+		, lodStreamingBudget(1 << 30)
 		, decimateMeshOnMove(true)
 		, minLODTriangleCount(2500000)
 		, sfColorScaleToDisplay(nullptr)
 		, colorRampShader(nullptr)
 		, customRenderingShader(nullptr)
 		, useVBOs(true)
+		, useCompactVBOs(false)
 		, labelMarkerSize(5)
 		, labelMarkerTextShift_pix(5)
 		, dispNumberPrecision(6)
@@ -192,6 +239,7 @@ struct ccGLDrawContext
 		, destBlend(GL_ONE_MINUS_SRC_ALPHA)
 		, stereoPassIndex(0)
 		, drawRoundedPoints(false)
+		, stats(nullptr)
 	{}
    
 	template<class TYPE>
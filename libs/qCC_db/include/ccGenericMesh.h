@@ -25,6 +25,7 @@
 #include "ccAdvancedTypes.h"
 #include "ccGenericGLDisplay.h"
 #include "ccShiftedObject.h"
+#include "ccTriangleBVH.h"
 
 namespace CCCoreLib
 {
@@ -212,7 +213,10 @@ public:
 	**/
 	void importParametersFrom(const ccGenericMesh* mesh);
 
-	//! Brute force triangle picking
+	//! Triangle picking
+	/** Above MIN_TRIANGLES_FOR_PICKING_BVH triangles, a BVH of the triangles is built (on the first call)
+		and kept until the geometry is modified. Otherwise all the triangles are tested ('brute force').
+	**/
 	virtual bool trianglePicking(	const CCVector2d& clickPos,
 									const ccGLCameraParameters& camera,
 									int& nearestTriIndex,
@@ -242,6 +246,17 @@ public:
 	//inherited methods (GenericIndexedMesh)
 	bool normalsAvailable() const override { return hasNormals(); }
 
+	//inherited from ccHObject
+	void notifyGeometryUpdate() override;
+
+	//! Min number of triangles to use a BVH for triangle picking
+	static const unsigned MIN_TRIANGLES_FOR_PICKING_BVH = 65536;
+
+	//! Returns the BVH of the triangles used for picking (built if necessary)
+	/** \return the BVH or a null pointer if it couldn't be built (not enough memory)
+	**/
+	ccTriangleBVH::Shared getPickingBVH() const;
+
 protected:
 
 	//inherited from ccHObject
@@ -289,6 +304,9 @@ protected:
 
 	//! Polygon stippling state
 	bool m_stippling;
+
+	//! BVH of the triangles used for picking (lazy initialization)
+	mutable ccTriangleBVH::Shared m_pickingBVH;
 };
 
 #endif //CC_GENERIC_MESH_HEADER
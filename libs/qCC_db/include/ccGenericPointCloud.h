@@ -251,12 +251,21 @@ public:
 	**/
 	unsigned char getPointSize() const { return m_pointSize; }
 
+	//! Returns the geometry version of the cloud
+	/** This counter is incremented each time notifyGeometryUpdate is called
+		(so that structures built on the points can detect in-place modifications).
+	**/
+	inline unsigned getGeometryVersion() const { return m_geometryVersion; }
+
+	//inherited from ccHObject
+	void notifyGeometryUpdate() override;
+
 	//! Imports the parameters from another cloud
 	/** Only the specific parameters are imported.
 	**/
 	void importParametersFrom(const ccGenericPointCloud* cloud);
 
-	//! Point picking (brute force or octree-driven)
+	//! Point picking (LOD, octree-driven or brute force)
 	/** \warning the octree-driven method only works if pickWidth == pickHeight
 	**/
 	bool pointPicking(	const CCVector2d& clickPos,
@@ -267,6 +276,22 @@ public:
 						double pickHeight = 2.0,
 						bool autoComputeOctree = false);
 
+	//! Returns whether the point picking relies on the LOD structure (instead of the octree)
+	/** See pointPickingWithLOD.
+	**/
+	virtual bool canPickWithLOD() { return false; }
+
+	//! Point picking with the LOD structure (if any)
+	/** See pointPicking for the parameters.
+		\return whether the LOD structure could be used (otherwise another method should be used)
+	**/
+	virtual bool pointPickingWithLOD(	const CCVector2d& clickPos,
+										const ccGLCameraParameters& camera,
+										int& nearestPointIndex,
+										double& nearestSquareDist,
+										double pickWidth,
+										double pickHeight) { return false; }
+
 protected:
 	//inherited from ccHObject
 	bool toFile_MeOnly(QFile& out) const override;
@@ -281,6 +306,9 @@ protected:
 	//! Point size (won't be applied if 0)
 	unsigned char m_pointSize;
 
+	//! Geometry version (see getGeometryVersion)
+	unsigned m_geometryVersion;
+
 };
 
 #endif //CC_GENERIC_POINT_CLOUD_HEADER
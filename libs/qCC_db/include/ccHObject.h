@@ -364,6 +364,17 @@ public: //display
 	bool toFile(QFile& out) const override;
 	bool fromFile(QFile& in, short dataVersion, int flags, LoadedIDMap& oldToNewIDMap) override;
 
+	//! Per-entity file offsets (see ccHObject::toFile)
+	using FileOffsets = std::vector< std::pair<const ccHObject*, qint64> >;
+
+	//! Custom version of ccSerializableObject::toFile
+	/** Also records the file offset at which each (serializable) entity of the tree starts.
+		\param out output file (already opened)
+		\param offsets per-entity file offsets (optional)
+		\return success
+	**/
+	bool toFile(QFile& out, FileOffsets* offsets) const;
+
 	//! Custom version of ccSerializableObject::fromFile
 	/** This is used to load only the object's part of a stream (and not its children)
 		\param in input file (already opened)
@@ -159,6 +159,33 @@ public: //HELPERS
 																const BestRadiusParams& params,
 																QWidget* parentWidget = nullptr);
 
+public: //CACHE
+
+	//! Sets the folder in which the computed octrees are cached (empty = no cache, default)
+	/** Each octree is saved in a file named after a hash of its cloud points.
+		Computing the octree of the same cloud again (in another session, or
+		in another command line call) then boils down to reading this file.
+	**/
+	static void SetCacheFolder(const QString& folder);
+	//! Returns the folder in which the computed octrees are cached (if any)
+	static QString CacheFolder();
+
+	//! Computes a hash of the cloud points (identifies the cloud octree in the cache)
+	static QByteArray ComputeCloudHash(const ccGenericPointCloud* cloud);
+
+	//! Builds the octree or loads it from the cache (if any)
+	/** Same output as DgmOctree::build.
+		If the octree is not already in the cache, it is added to it.
+	**/
+	int buildWithCache(CCCoreLib::GenericProgressCallback* progressCb = nullptr);
+
+	//! Saves the octree structure in a (cache) file
+	bool toCacheFile(const QString& filename, const QByteArray& cloudHash) const;
+	//! Loads the octree structure from a (cache) file
+	/** The file must have been saved with the same cloud hash.
+	**/
+	bool fromCacheFile(const QString& filename, const QByteArray& cloudHash);
+
 Q_SIGNALS:
 
 	//! Signal sent when the octree organization is modified (cleared, etc.)
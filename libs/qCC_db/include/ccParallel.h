@@ -0,0 +1,59 @@
+//##########################################################################
+//#                                                                        #
+//#                              CLOUDCOMPARE                              #
+//#                                                                        #
+//#  This program is free software; you can redistribute it and/or modify  #
+//#  it under the terms of the GNU General Public License as published by  #
+//#  the Free Software Foundation; version 2 or later of the License.      #
+//#                                                                        #
+//#  This program is distributed in the hope that it will be useful,       #
+//#  but WITHOUT ANY WARRANTY; without even the implied warranty of        #
+//#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          #
+//#  GNU General Public License for more details.                          #
+//#                                                                        #
+//#                    COPYRIGHT: CloudCompare project                     #
+//#                                                                        #
+//##########################################################################
+
+#ifndef CC_PARALLEL_HEADER
+#define CC_PARALLEL_HEADER
+
+#ifdef CC_CORE_LIB_USES_TBB
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+#endif
+
+//! Runs a function on each index of [0 ; count[ in parallel (if possible)
+/** Relies on TBB if CCCoreLib uses it, or on OpenMP otherwise (if available).
+	The iterations are dynamically scheduled, so the tasks may have different costs.
+	\param count number of iterations
+	\param func function (or lambda) called with each index (must be thread-safe)
+	\param grainSize minimum number of consecutive indexes processed by a single thread (for very light tasks)
+**/
+template <class Function> inline void ccParallelFor(int count, const Function& func, int grainSize = 1)
+{
+	if (grainSize < 1)
+	{
+		grainSize = 1;
+	}
+
+#ifdef CC_CORE_LIB_USES_TBB
+	tbb::parallel_for(tbb::blocked_range<int>(0, count, static_cast<size_t>(grainSize)), [&](const tbb::blocked_range<int>& range)
+	{
+		for (int i = range.begin(); i != range.end(); ++i)
+		{
+			func(i);
+		}
+	});
+#else
+#if defined(_OPENMP)
+#pragma omp parallel for schedule(dynamic, grainSize)
+#endif
+	for (int i = 0; i < count; ++i)
+	{
+		func(i);
+	}
+#endif
+}
+
+#endif //CC_PARALLEL_HEADER
@@ -40,6 +40,7 @@ class ccMesh;
 class QGLBuffer;
 class ccProgressDialog;
 class ccPointCloudLOD;
+class ccPointCloudLODPageCache;
 
 /***************************************************
 				ccPointCloud
@@ -167,6 +168,21 @@ public: //features deletion/clearing
 	//! Notify a modification of points display parameters or contents
 	inline void pointsHaveChanged() { m_vboManager.updateFlags |= vboSet::UPDATE_POINTS; }
 
+	//! Notify a modification of the colors of a range of points
+	/** Only the corresponding parts of the VBOs will be updated.
+		\param firstIndex index of the first modified point
+		\param lastIndex index of the last modified point (included)
+	**/
+	inline void colorsHaveChanged(unsigned firstIndex, unsigned lastIndex) { m_vboManager.flagRange(vboSet::UPDATE_COLORS, firstIndex, lastIndex); }
+	//! Notify a modification of the normals of a range of points
+	/** See colorsHaveChanged(unsigned, unsigned).
+	**/
+	inline void normalsHaveChanged(unsigned firstIndex, unsigned lastIndex) { m_vboManager.flagRange(vboSet::UPDATE_NORMALS, firstIndex, lastIndex); }
+	//! Notify a modification of the coordinates of a range of points
+	/** See colorsHaveChanged(unsigned, unsigned).
+	**/
+	inline void pointsHaveChanged(unsigned firstIndex, unsigned lastIndex) { m_vboManager.flagRange(vboSet::UPDATE_POINTS, firstIndex, lastIndex); }
+
 public: //features allocation/resize
 
 	//! Reserves memory to store the points coordinates
@@ -741,7 +757,12 @@ public: //other methods
 	void releaseVBOs();
 
 	//! Returns the VBOs size (if any)
-	size_t vboSize() const;
+	/** \param loadedPointCount if not null, the number of points loaded in the (standard) VBOs is returned
+		(so that the number of bytes per point can be deduced)
+		\param lodPagesSize if not null, the size (in bytes) of the LOD pages (included in the returned size) is returned
+		\return the total size (in bytes) of the VBOs and of the LOD pages
+	**/
+	size_t vboSize(unsigned* loadedPointCount = nullptr, size_t* lodPagesSize = nullptr) const;
 
 protected:
 
@@ -790,15 +811,36 @@ protected: // VBO
 		int rgbShift;
 		int normalShift;
 
+		//! Whether the VBO uses the compact layout
+		/** Compact layout: 16 bits quantized coordinates (relative to the chunk bounding-box)
+			instead of floats. It is only used for the chunks that are spatially coherent (see
+			updateVBOs). The normals are not quantized (they are not loaded in VBOs anyway, see
+			DONT_LOAD_NORMALS_IN_VBOS).
+		**/
+		bool compact;
+		//! Dequantization origin (compact layout only)
+		CCVector3d origin;
+		//! Dequantization scale (compact layout only)
+		double scale;
+		//! Allocated size (in bytes, or -1 if not initialized)
+		int sizeBytes;
+
 		//! Inits the VBO
 		/** \return the number of allocated bytes (or -1 if an error occurred)
 		**/
-		int init(int count, bool withColors, bool withNormals, bool* reallocated = nullptr);
+		int init(int count, bool withColors, bool withNormals, bool compactLayout, bool* reallocated = nullptr);
+
+		//! Returns the size of the coordinates of a point (in bytes)
+		static int PointSize(bool compactLayout);
 
 		VBO()
 			: QGLBuffer(QGLBuffer::VertexBuffer)
 			, rgbShift(0)
 			, normalShift(0)
+			, compact(false)
+			, origin(0, 0, 0)
+			, scale(1.0)
+			, sizeBytes(-1)
 		{}
 	};
 
@@ -816,13 +858,27 @@ protected: // VBO
 			UPDATE_ALL = UPDATE_POINTS | UPDATE_COLORS | UPDATE_NORMALS
 		};
 
+		//! Modified range of points in a chunk (relative indexes)
+		struct DirtyRange
+		{
+			//! Update flags
+			int flags = 0;
+			//! First modified point
+			unsigned first = 0;
+			//! Last modified point (included)
+			unsigned last = 0;
+		};
+
 		vboSet()
 			: hasColors(false)
 			, colorIsSF(false)
 			, sourceSF(nullptr)
 			, hasNormals(false)
+			, compact(false)
 			, totalMemSizeBytes(0)
+			, pointCount(0)
 			, updateFlags(0)
+			, hasDirtyRanges(false)
 			, state(NEW)
 		{}
 
@@ -831,9 +887,23 @@ protected: // VBO
 		bool colorIsSF;
 		ccScalarField* sourceSF;
 		bool hasNormals;
+		bool compact;
 		size_t totalMemSizeBytes;
+		unsigned pointCount;
 		int updateFlags;
 
+		//! Modified ranges (per chunk)
+		/** Only used for the features that are not flagged in 'updateFlags' (whole update)
+		**/
+		std::vector<DirtyRange> dirtyRanges;
+		//! Whether some ranges are flagged
+		bool hasDirtyRanges;
+
+		//! Flags a range of points as modified
+		void flagRange(int flags, unsigned firstIndex, unsigned lastIndex);
+		//! Clears the modified ranges
+		void clearDirtyRanges();
+
 		//! Current state
 		STATES state;
 	};
@@ -842,7 +912,10 @@ protected: // VBO
 	vboSet m_vboManager;
 
 	//per-block data transfer to the GPU (VBO or standard mode)
-	void glChunkVertexPointer(const CC_DRAW_CONTEXT& context, size_t chunkIndex, unsigned decimStep, bool useVBOs);
+	/** glChunkVertexPointer returns whether a (dequantization) transformation has been pushed on
+		the modelview matrix stack. It must be popped after the chunk has been drawn.
+	**/
+	bool glChunkVertexPointer(const CC_DRAW_CONTEXT& context, size_t chunkIndex, unsigned decimStep, bool useVBOs);
 	void glChunkColorPointer (const CC_DRAW_CONTEXT& context, size_t chunkIndex, unsigned decimStep, bool useVBOs);
 	void glChunkSFPointer    (const CC_DRAW_CONTEXT& context, size_t chunkIndex, unsigned decimStep, bool useVBOs);
 	void glChunkNormalPointer(const CC_DRAW_CONTEXT& context, size_t chunkIndex, unsigned decimStep, bool useVBOs);
@@ -857,11 +930,48 @@ public: //Level of Detail (LOD)
 	//! Clears the LOD structure
 	void clearLOD();
 
+	//! Returns the LOD structure (if any)
+	inline ccPointCloudLOD* getLOD() const { return m_lod; }
+
+	//! Tests the LOD visibility of all the clouds of a branch in parallel (before their display)
+	/** Only the clouds displayed in the context, with an initialized LOD structure, are considered.
+		Their (first) LOD rendering pass will directly use the result (see ccPointCloudLOD::prepareVisibility).
+		\param root root of the branch
+		\param context drawing context (first LOD rendering pass)
+		\param modelViewMat base modelview matrix
+		\param projectionMat projection matrix
+	**/
+	static void PrepareLODVisibility(ccHObject* root, const CC_DRAW_CONTEXT& context, const ccGLMatrixd& modelViewMat, const ccGLMatrixd& projectionMat);
+
+	//! Min number of points to use the LOD structure for point picking
+	static const unsigned MIN_POINTS_FOR_LOD_PICKING = 1000000;
+
+	//! Returns whether the point picking relies on the LOD structure
+	/** I.e. if the cloud has at least MIN_POINTS_FOR_LOD_PICKING points and its LOD structure is not broken.
+	**/
+	bool canPickWithLOD() override;
+
+	//! Point picking with the LOD structure
+	/** If the cloud has at least MIN_POINTS_FOR_LOD_PICKING points and the LOD structure is not ready yet,
+		its construction is started (in the background) and the method returns false.
+		See ccGenericPointCloud::pointPicking for the parameters.
+		\return whether the LOD structure could be used (otherwise another method should be used)
+	**/
+	bool pointPickingWithLOD(	const CCVector2d& clickPos,
+								const ccGLCameraParameters& camera,
+								int& nearestPointIndex,
+								double& nearestSquareDist,
+								double pickWidth,
+								double pickHeight) override;
+
 protected: //Level of Detail (LOD)
 
 	//! L.O.D. structure
 	ccPointCloudLOD* m_lod;
 
+	//! L.O.D. pages loaded on the GPU (streaming display)
+	ccPointCloudLODPageCache* m_lodPages;
+
 protected: //waveform (e.g. from airborne scanners)
 
 	//! General waveform descriptors
@@ -23,6 +23,7 @@
 #include <ccFrustum.h>
 
 //Qt
+#include <QFuture>
 #include <QMutex>
 
 //system
@@ -30,8 +31,10 @@
 #include <array>
 #include <functional>
 
+class ccGenericPointCloud;
 class ccPointCloud;
 class ccPointCloudLODThread;
+class QFile;
 
 //! Level descriptor
 struct LODLevelDesc
@@ -139,6 +142,9 @@ public:
 		return m_levels[level].data[index];
 	}
 
+	//! Returns the number of nodes of a given level
+	inline size_t nodeCount(unsigned char level) const { return (level < m_levels.size() ? m_levels[level].data.size() : 0); }
+
 	inline Node& root() { return node(0, 0); }
 
 	inline const Node& root() const { return node(0, 0); }
@@ -150,22 +156,101 @@ public:
 	//}
 
 	//! Test all cells visibility with a given frustum
-	/** Automatically calls resetVisibility
+	/** Automatically calls resetVisibility. The octree subtrees are processed in parallel.
 	**/
 	uint32_t flagVisibility(const Frustum& frustum, ccClipPlaneSet* clipPlanes = nullptr);
 
+	//! Tests all cells visibility in advance (e.g. for several clouds in parallel, before their display)
+	/** The result will be used by the next call to usePreparedVisibility with the same matrices.
+		\param modelViewMat modelview matrix (including the GL transformation of the cloud)
+		\param projectionMat projection matrix
+		\param clipPlanes clipping planes (if any)
+	**/
+	void prepareVisibility(const ccGLMatrixd& modelViewMat, const ccGLMatrixd& projectionMat, ccClipPlaneSet* clipPlanes = nullptr);
+
+	//! Returns whether the cells visibility has already been tested with the given parameters (see prepareVisibility)
+	/** A prepared visibility can only be used once.
+	**/
+	bool usePreparedVisibility(const ccGLMatrixd& modelViewMat, const ccGLMatrixd& projectionMat, const ccClipPlaneSet* clipPlanes = nullptr);
+
+	//! Visibility preparation job (see PrepareVisibility)
+	struct VisibilityJob
+	{
+		//! LOD structure
+		ccPointCloudLOD* lod = nullptr;
+		//! Modelview matrix (including the GL transformation of the cloud)
+		ccGLMatrixd modelViewMat;
+		//! Clipping planes (if any)
+		ccClipPlaneSet* clipPlanes = nullptr;
+	};
+
+	//! Prepares the visibility of several structures in parallel (see prepareVisibility)
+	static void PrepareVisibility(const std::vector<VisibilityJob>& jobs, const ccGLMatrixd& projectionMat);
+
 	//! Builds an index map with the remaining visible points
+	/** If the map has been prepared with the same parameters (see prepareIndexMap), it is directly returned.
+	**/
 	LODIndexSet& getIndexMap(unsigned char level, unsigned& maxCount, unsigned& remainingPointsAtThisLevel);
 
+	//! Prepares the next index map in the background
+	/** Should be called right after getIndexMap, with the parameters of the next call (i.e. the same level if
+		some points remain to be displayed at this level), so that the map is ready when the next rendering pass
+		starts. If the next call to getIndexMap has different parameters, the prepared map is discarded.
+	**/
+	void prepareIndexMap(unsigned char level, unsigned maxCount);
+
 	//! Returns the last index map
 	inline const LODIndexSet& getLasIndexMap() const { return m_lastIndexMap; }
 
 	//! Returns whether all points have been displayed or not
 	inline bool allDisplayed() const { return m_currentState.displayedPoints >= m_currentState.visiblePoints; }
 
+	//! Returns the index of the point at a given position in the LOD order
+	inline unsigned pointIndex(uint32_t codeIndex) const
+	{
+		return (m_octree ? m_octree->pointsAndTheirCellCodes()[codeIndex].theIndex : m_pointIndexes[codeIndex]);
+	}
+
 	//! Returns the memory used by the structure (in bytes)
 	size_t memory() const;
 
+	//! Point picking
+	/** Only the nodes whose bounding sphere (projected on screen) intersects the picking area are visited.
+		The structure must be initialized.
+		\param cloud associated cloud
+		\param clickPos clicked position (in pixels)
+		\param camera camera parameters
+		\param trans GL transformation of the cloud (if any)
+		\param pickWidth half-width of the picking area (in pixels)
+		\param pickHeight half-height of the picking area (in pixels)
+		\param isPickable optional function to skip some points (e.g. hidden points)
+		\param[out] nearestPointIndex index of the nearest point (or -1 if none)
+		\param[out] nearestSquareDist squared distance between the nearest point and the clicked position (unprojected on the near plane)
+		\return whether a point has been picked
+	**/
+	bool pointPicking(	const ccGenericPointCloud& cloud,
+						const CCVector2d& clickPos,
+						const ccGLCameraParameters& camera,
+						const ccGLMatrix* trans,
+						double pickWidth,
+						double pickHeight,
+						const std::function<bool(unsigned)>& isPickable,
+						int& nearestPointIndex,
+						double& nearestSquareDist) const;
+
+	//! Saves the structure to a file (the structure must be initialized)
+	/** Only the persistent part of the nodes is saved, along with the point indexes in the LOD order.
+	**/
+	bool toFile(QFile& out) const;
+
+	//! Loads the structure from a file
+	/** The structure is directly flagged as 'initialized' (no octree is required).
+		\param in input file (must be already opened)
+		\param flags deserialization flags (see ccSerializableObject::DeserializationFlags)
+		\param pointCount number of points of the associated cloud
+	**/
+	bool fromFile(QFile& in, int flags, unsigned pointCount);
+
 protected: //methods
 
 	friend ccPointCloudLODThread;
@@ -199,8 +284,23 @@ protected: //methods
 	void resetVisibility();
 
 	//! Adds a given number of points to the active index map (should be dispatched among the children cells)
+	/** Only the corresponding ranges of codes are recorded (see m_indexMapRanges).
+	**/
 	uint32_t addNPointsToIndexMap(Node& node, uint32_t count);
 
+	//! Builds an index map with the remaining visible points (see getIndexMap)
+	void buildIndexMap(unsigned char level, unsigned& maxCount, unsigned& remainingPointsAtThisLevel, LODIndexSet& indexMap);
+
+	//! Waits for the index map being prepared in the background (if any)
+	/** \param discard whether to discard the prepared map (see discardPreparedIndexMap)
+	**/
+	void waitForPreparedIndexMap(bool discard);
+
+	//! Discards the index map prepared in the background
+	/** The displayed point counts and the render state are restored as they were before the map was built.
+	**/
+	void discardPreparedIndexMap();
+
 protected: //members
 
 	struct Level
@@ -239,15 +339,91 @@ protected: //members
 	//! Current rendering state
 	RenderParams m_currentState;
 
-	//! Index map
+	//! Index map (work buffer)
 	LODIndexSet m_indexMap;
 
-	//! Last index map (pointer on)
+	//! Last index map
 	LODIndexSet m_lastIndexMap;
 
+	//! Range of codes to be added to the index map
+	struct CodeRange
+	{
+		//! First code index
+		uint32_t firstCodeIndex;
+		//! Number of codes
+		uint32_t count;
+		//! Position in the index map
+		uint32_t offset;
+	};
+
+	//! Ranges of codes of the index map being built
+	std::vector<CodeRange> m_indexMapRanges;
+
+	//! Number of indexes of the index map being built
+	uint32_t m_indexMapSize;
+
+	//! Update of the displayed point count of a node
+	struct NodeUpdate
+	{
+		//! Node
+		Node* node;
+		//! Number of points added to the node displayed point count
+		uint32_t count;
+	};
+
+	//! Updates of the nodes displayed point counts (only recorded while preparing an index map)
+	std::vector<NodeUpdate>* m_nodeUpdates;
+
+	//! Index map prepared in the background
+	struct PreparedIndexMap
+	{
+		//! Background task
+		QFuture<void> task;
+		//! Whether a map is being prepared (or has been prepared but not used yet)
+		bool pending = false;
+		//! Level
+		unsigned char level = 0;
+		//! Requested number of points
+		unsigned requestedCount = 0;
+		//! Actual number of points
+		unsigned count = 0;
+		//! Remaining points at this level
+		unsigned remainingPointsAtThisLevel = 0;
+		//! Indexes
+		LODIndexSet indexes;
+		//! Render state before the map was built
+		RenderParams previousState;
+		//! Updates of the nodes displayed point counts
+		std::vector<NodeUpdate> nodeUpdates;
+	};
+
+	//! Index map prepared in the background
+	PreparedIndexMap m_preparedIndexMap;
+
+	//! Visibility prepared in advance
+	struct PreparedVisibility
+	{
+		//! Whether the visibility has been prepared
+		bool valid = false;
+		//! Modelview matrix
+		ccGLMatrixd modelViewMat;
+		//! Projection matrix
+		ccGLMatrixd projectionMat;
+		//! Clipping planes
+		ccClipPlaneSet clipPlanes;
+	};
+
+	//! Visibility prepared in advance
+	PreparedVisibility m_preparedVisibility;
+
 	//! Associated octree
 	ccOctree::Shared m_octree;
 
+	//! Point indexes in the LOD order
+	/** Only used if the structure has been loaded from a file (otherwise the octree codes are used)
+	**/
+	LODIndexSet m_pointIndexes;
+
 	//! Computing thread
 	ccPointCloudLODThread* m_thread;
 
@@ -0,0 +1,212 @@
+//##########################################################################
+//#                                                                        #
+//#                              CLOUDCOMPARE                              #
+//#                                                                        #
+//#  This program is free software; you can redistribute it and/or modify  #
+//#  it under the terms of the GNU General Public License as published by  #
+//#  the Free Software Foundation; version 2 or later of the License.      #
+//#                                                                        #
+//#  This program is distributed in the hope that it will be useful,       #
+//#  but WITHOUT ANY WARRANTY; without even the implied warranty of        #
+//#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          #
+//#  GNU General Public License for more details.                          #
+//#                                                                        #
+//#                    COPYRIGHT: CloudCompare project                     #
+//#                                                                        #
+//##########################################################################
+
+#ifndef CC_POINT_CLOUD_LOD_PAGE_CACHE
+#define CC_POINT_CLOUD_LOD_PAGE_CACHE
+
+//Local
+#include "ccGenericGLDisplay.h"
+#include "ccPointCloudLOD.h"
+
+//Qt
+#include <QGLBuffer>
+
+//system
+#include <list>
+#include <vector>
+
+class ccPointCloud;
+class ccScalarField;
+class QOpenGLContext;
+class QOpenGLFunctions_2_1;
+struct ccRenderingStats;
+
+//! Cache of L.O.D. 'pages' loaded on the GPU (streaming display of big clouds)
+/** A page is the biggest LOD node with less than MAX_PAGE_POINT_COUNT points (or a leaf).
+	Its points are stored in a single VBO, in a 'progressive' order (round-robin on its leaves)
+	so that any prefix of the page is a uniform subsample of it. With the compact layout, the
+	coordinates are quantized on 16 bits relatively to the page node (center and radius).
+
+	For each frame, the visible pages are sorted by their projected size on screen (the biggest
+	first) and only the corresponding number of points is drawn (~ 1 point per pixel). The missing
+	pages are loaded by priority, over several display passes if necessary.
+
+	The memory budget is shared by all the clouds drawn in the same GL context (i.e. the same 3D view):
+	when it is reached, the least recently used pages of all these clouds (i.e. the ones that are out
+	of view first) are evicted.
+
+	\warning The pages are built from the points of the cloud (in RAM) when they are loaded: there is no
+	on-disk page store. Therefore only the GPU memory is bounded, not the RAM.
+**/
+class ccPointCloudLODPageCache
+{
+public:
+
+	//! Max number of points per page
+	static const uint32_t MAX_PAGE_POINT_COUNT = (1 << 16);
+	//! Max number of points loaded per display pass
+	static const uint32_t MAX_LOADED_POINT_COUNT_PER_PASS = (1 << 21);
+
+	//! Displayed features (must be the same for all the loaded pages)
+	struct Content
+	{
+		//! Whether colors are loaded
+		bool hasColors = false;
+		//! Scalar field from which the colors are loaded (if any)
+		ccScalarField* sourceSF = nullptr;
+		//! Whether normals are loaded
+		bool hasNormals = false;
+		//! Whether the coordinates are quantized (compact layout)
+		bool compact = false;
+
+		bool operator == (const Content& other) const { return hasColors == other.hasColors && sourceSF == other.sourceSF && hasNormals == other.hasNormals && compact == other.compact; }
+		bool operator != (const Content& other) const { return !(*this == other); }
+	};
+
+	//! Default constructor
+	explicit ccPointCloudLODPageCache(ccPointCloud& cloud);
+
+	//! Destructor
+	/** \warning The pages should have been released before (see release).
+	**/
+	virtual ~ccPointCloudLODPageCache();
+
+	//! Releases all the pages (and the page list)
+	/** The GL context should be active.
+	**/
+	void release();
+
+	//! Returns the GPU memory used by the loaded pages (in bytes)
+	inline size_t memory() const { return m_memory; }
+
+	//! Returns the GPU memory used by the pages of all the clouds in a given GL context (in bytes)
+	static size_t SharedMemory(const QOpenGLContext* context);
+
+	//! Starts a new frame
+	/** The visibility of the LOD nodes must have been flagged first (see ccPointCloudLOD::flagVisibility).
+		The page list is built if necessary. If the content changes, all the pages are released.
+		\param lod the LOD structure (must be initialized)
+		\param camera the current camera parameters (with the actual viewport and matrices)
+		\param content the displayed features
+		\return false if the pages can't be used (not enough memory)
+	**/
+	bool startFrame(ccPointCloudLOD& lod, const ccGLCameraParameters& camera, const Content& content);
+
+	//! Draws the pages of the current frame
+	/** The already loaded pages are drawn only if 'drawLoadedPages' is true (= first pass of a frame).
+		Then the missing pages are loaded (and drawn) by priority, up to MAX_LOADED_POINT_COUNT_PER_PASS
+		points or until the memory budget is reached. The vertex (and color/normal) arrays must be enabled.
+		\param glFunc OpenGL functions
+		\param lod the LOD structure
+		\param memoryBudget the max GPU memory used by the pages of all the clouds drawn in the current GL context (in bytes)
+		\param drawLoadedPages whether to draw the pages loaded before this pass
+		\param stats rendering statistics to update (optional)
+		\return whether some visible pages remain to be loaded (i.e. another pass is needed)
+	**/
+	bool draw(QOpenGLFunctions_2_1* glFunc, const ccPointCloudLOD& lod, size_t memoryBudget, bool drawLoadedPages, ccRenderingStats* stats = nullptr);
+
+	//! Returns whether some visible pages of the current frame remain to be loaded
+	inline bool hasPendingPages() const { return m_queueIndex < m_queue.size() && !m_budgetReached && !m_failed; }
+
+protected:
+
+	//! Page descriptor
+	struct Page
+	{
+		//! Node level
+		uint8_t level = 0;
+		//! Node index (at this level)
+		int32_t nodeIndex = -1;
+		//! Number of points
+		uint32_t pointCount = 0;
+		//! Number of points to display in the current frame
+		uint32_t displayedCount = 0;
+		//! Priority in the current frame (projected radius in pixels)
+		float priority = 0;
+		//! Last frame in which the page was drawn
+		uint64_t lastFrame = 0;
+		//! GPU buffer (if loaded)
+		QGLBuffer* buffer = nullptr;
+		//! Colors position in the buffer
+		int colorShift = 0;
+		//! Normals position in the buffer
+		int normalShift = 0;
+		//! Buffer size (in bytes)
+		size_t sizeBytes = 0;
+		//! Dequantization origin (compact layout only)
+		CCVector3d origin;
+		//! Dequantization scale (compact layout only)
+		double scale = 1.0;
+		//! Position in the LRU list (if loaded)
+		std::list<uint32_t>::iterator lruIt;
+	};
+
+	//! Builds the page list
+	bool buildPages(const ccPointCloudLOD& lod);
+
+	//! Returns the size of a page on the GPU (in bytes)
+	size_t pageSize(const Page& page) const;
+
+	//! Loads a page on the GPU
+	bool load(Page& page, const ccPointCloudLOD& lod);
+
+	//! Unloads a page
+	void unload(Page& page);
+
+	//! Unloads the least recently used page of all the caches of the current GL context
+	/** Only the pages that have not been drawn in the current display frame can be evicted.
+		\return false if no page can be evicted
+	**/
+	bool evictLeastRecentlyUsedPage();
+
+	//! Draws a (loaded) page
+	void drawPage(QOpenGLFunctions_2_1* glFunc, Page& page, ccRenderingStats* stats);
+
+	//! Associated cloud
+	ccPointCloud& m_cloud;
+
+	//! Pages
+	std::vector<Page> m_pages;
+
+	//! Features of the loaded pages
+	Content m_content;
+
+	//! Visible pages of the current frame (sorted by priority)
+	std::vector<uint32_t> m_queue;
+	//! First page of the queue that may not be loaded yet
+	size_t m_queueIndex;
+
+	//! Loaded pages (the least recently used first)
+	std::list<uint32_t> m_lru;
+
+	//! Loaded pages size (in bytes)
+	size_t m_memory;
+
+	//! Current frame (global index, see startFrame)
+	uint64_t m_frame;
+
+	//! GL context of the loaded pages
+	QOpenGLContext* m_context;
+
+	//! Whether the memory budget has been reached in the current frame
+	bool m_budgetReached;
+
+	//! Whether the pages can't be loaded (GPU error)
+	bool m_failed;
+};
+
+#endif //CC_POINT_CLOUD_LOD_PAGE_CACHE
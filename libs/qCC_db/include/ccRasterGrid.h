@@ -42,8 +42,6 @@ struct QCC_DB_LIB_API ccRasterCell
 		, nbPoints(0)
 		, pointIndex(0)
 		, color(0, 0, 0)
-		, pointRefHead(nullptr)
-		, pointRefTail(nullptr)
 	{}
 
 	//! Height value
@@ -64,11 +62,6 @@ struct QCC_DB_LIB_API ccRasterCell
 	unsigned pointIndex;
 	//! Color
 	CCVector3d color;
-	//! Pointer to first point reference for this cell (used to compute the median)
-	void** pointRefHead;
-	//! Pointer to last point reference for this cell (used to compute the median)
-	void** pointRefTail;
-
 };
 
 //! Raster grid type
@@ -184,10 +177,18 @@ struct QCC_DB_LIB_API ccRasterGrid
 	void updateCellStats();
 
 	//! Interpolates the empty cells
-	/** \warning The number of non empty cells must be up-to-date (see updateNonEmptyCellCount)
+	/** Large grids are processed by tiles (in parallel). Each tile is triangulated with the non-empty
+		cells of an overlapping margin, and only the triangles that belong to the global triangulation
+		are used. The margin is increased where needed (large empty areas) but it is capped so as to
+		bound the memory consumption. Therefore the result is the same as with a single triangulation
+		if a max edge length is set, or if no empty area is larger than this cap. Otherwise the cells
+		that can't be resolved are interpolated with the local triangulation of the tile (a warning is
+		issued).
+		\warning The number of non empty cells must be up-to-date (see updateNonEmptyCellCount)
 		\param maxSquareEdgeLength Max (square) edge length to filter large triangles during the interpolation process
+		\param tileSize tile size (in cells) or 0 to triangulate the whole grid at once
 	**/
-	bool interpolateEmptyCells(double maxSquareEdgeLength);
+	bool interpolateEmptyCells(double maxSquareEdgeLength, unsigned tileSize = 1024);
 
 	//! Sets valid
 	inline void setValid(bool state) { valid = state; }
@@ -196,6 +197,19 @@ struct QCC_DB_LIB_API ccRasterGrid
 
 	//! Computes the position of the cell that includes a given point
 	inline CCVector2i computeCellPos(const CCVector3& P, unsigned char dimX, unsigned char dimY) const
+	{
+		return ComputeCellPos(P, minCorner, gridStep, dimX, dimY);
+	}
+
+	//! Computes the position of the cell that includes a given point (for a grid that is not instantiated)
+	/** \param P point
+		\param minCorner min corner of the grid (i.e. the center of its lower left cell)
+		\param gridStep grid step
+		\param dimX first dimension of the grid
+		\param dimY second dimension of the grid
+		eturn the cell position (may be outside of the grid)
+	**/
+	static inline CCVector2i ComputeCellPos(const CCVector3& P, const CCVector3d& minCorner, double gridStep, unsigned char dimX, unsigned char dimY)
 	{
 		//minCorner corresponds to the lower left cell CENTER
 		return CCVector2i(	static_cast<int>((P.u[dimX] - minCorner.u[dimX]) / gridStep + 0.5),
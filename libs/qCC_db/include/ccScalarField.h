@@ -170,6 +170,34 @@ public:
 	//inherited
 	void computeMinAndMax() override;
 
+	//! Updates the min and max values, the histogram and the statistics only if they are not valid anymore
+	/** See statisticsAreValid.
+	**/
+	void updateStatistics();
+
+	//! Returns whether the cached min and max values, histogram and statistics are still valid
+	/** They are invalidated by the ccScalarField setters (setValue, addElement, fill and
+		resizeSafe) and by invalidateStatistics. Values modified by any other means (through
+		the CCCoreLib::ScalarField interface, the data pointer, etc.) must be followed by
+		a call to invalidateStatistics or computeMinAndMax.
+	**/
+	inline bool statisticsAreValid() const { return m_statisticsValid; }
+
+	//! Declares the cached min and max values, histogram and statistics as invalid
+	inline void invalidateStatistics() { m_statisticsValid = false; }
+
+	//! Sets the value at a given index (and invalidates the statistics)
+	inline void setValue(std::size_t index, ScalarType value) { ScalarField::setValue(index, value); m_statisticsValid = false; }
+
+	//! Adds a value (and invalidates the statistics)
+	inline void addElement(ScalarType value) { ScalarField::addElement(value); m_statisticsValid = false; }
+
+	//! Fills the scalar field with a given value (and invalidates the statistics)
+	void fill(ScalarType fillValue = 0);
+
+	//! Resizes the scalar field (and invalidates the statistics if the size changes)
+	bool resizeSafe(std::size_t count, bool initNewElements = false, ScalarType valueForNewElements = 0);
+
 	//! Returns associated color scale
 	inline const ccColorScale::Shared& getColorScale() const { return m_colorScale; }
 
@@ -192,6 +220,22 @@ public:
 	//! Returns associated histogram values (for display)
 	inline const Histogram& getHistogram() const { return m_histogram; }
 
+	//! Scalar field statistics
+	struct Statistics
+	{
+		unsigned count = 0;		//!< number of values
+		unsigned nanCount = 0;	//!< number of invalid (NaN) values
+		double mean = 0;		//!< mean of the valid values
+		double stdDev = 0;		//!< standard deviation of the valid values
+	};
+
+	//! Returns the statistics of the scalar field values
+	/** They are computed along with the min and max values and the histogram
+		(see computeMinAndMax) and cached until the next call to this method.
+		See statisticsAreValid.
+	**/
+	inline const Statistics& getStatistics() const { return m_statistics; }
+
 	//! Returns whether the scalar field in its current configuration MAY have 'hidden' values or not
 	/** 'Hidden' values are typically NaN values or values outside of the 'displayed' interval
 		while those values are not displayed in grey (see ccScalarField::showNaNValuesInGrey).
@@ -270,6 +314,12 @@ protected: //members
 	//! Associated histogram values (for display)
 	Histogram m_histogram;
 
+	//! Cached statistics
+	Statistics m_statistics;
+
+	//! Whether the min and max values, the histogram and the statistics are up to date
+	bool m_statisticsValid;
+
 	//! Modification flag
 	/** Any modification to the scalar field values or parameters
 		will turn this flag on.
@@ -26,8 +26,12 @@
 #include <CCTypes.h>
 
 //System
+#include <algorithm>
 #include <cassert>
 #include <cstdint>
+#include <cstring>
+#include <functional>
+#include <vector>
 
 //Qt
 #include <QDataStream>
@@ -57,6 +61,7 @@ public:
 		DF_POINT_COORDS_64_BITS	= 1, /**< Point coordinates are stored as 64 bits double (otherwise 32 bits floats) **/
 		//DGM: inversion is 'historical' ;)
 		DF_SCALAR_VAL_32_BITS	= 2, /**< Scalar values are stored as 32 bits floats (otherwise 64 bits double) **/
+		DF_MAPPED_READ			= 16, /**< Arrays that must be decoded (compressed chunks or values stored with another type) are decoded directly from a memory-mapped view of the file (runtime flag, never stored in files) **/
 	};
 
 	//! Map of loaded unique IDs (old ID --> new ID)
@@ -173,21 +178,12 @@ public:
 			return ccSerializableObject::WriteError();
 
 		//array data (dataVersion>=20)
+		//DGM: stored by chunks (with checksum and optional compression) since dataVersion 53
+		if (!WriteChunkedArrayData(out, reinterpret_cast<const char*>(data.data()), data.size(), sizeof(Type)))
 		{
-			//DGM: do it by chunks, in case it's too big to be processed by the system
-			const char* _data = (const char*)data.data();
-			qint64 byteCount = static_cast<qint64>(elementCount);
-			byteCount *= sizeof(Type);
-			while (byteCount != 0)
-			{
-				static const qint64 s_maxByteSaveCount = (1 << 26); //64 Mb each time
-				qint64 saveCount = std::min(byteCount, s_maxByteSaveCount);
-				if (out.write(_data, saveCount) < 0)
-					return ccSerializableObject::WriteError();
-				_data += saveCount;
-				byteCount -= saveCount;
-			}
+			return false;
 		}
+
 		return true;
 	}
 
@@ -195,9 +191,10 @@ public:
 	/** \param data vector to load
 		\param in input file (must be already opened)
 		\param dataVersion version current data version
+		\param flags deserialization flags (see ccSerializableObject::DeserializationFlags)
 		\return success
 	**/
-	template <class Type, int N, class ComponentType> static bool GenericArrayFromFile(std::vector<Type>& data, QFile& in, short dataVersion)
+	template <class Type, int N, class ComponentType> static bool GenericArrayFromFile(std::vector<Type>& data, QFile& in, short dataVersion, int flags = 0)
 	{
 		::uint8_t componentCount = 0;
 		::uint32_t elementCount = 0;
@@ -223,21 +220,21 @@ public:
 			}
 
 			//array data (dataVersion>=20)
+			assert(sizeof(ComponentType) * N == sizeof(Type));
+			if (dataVersion >= 53)
+			{
+				//stored by chunks (dataVersion>=53)
+				if (!ReadChunkedArrayData(in, reinterpret_cast<char*>(data.data()), data.size(), sizeof(Type), flags))
+				{
+					return false;
+				}
+			}
+			else
 			{
-				//Apparently Qt and/or Windows don't like to read too many bytes in a row...
-				static const qint64 MaxElementPerChunk = (static_cast<qint64>(1) << 24);
-				assert(sizeof(ComponentType) * N == sizeof(Type));
 				qint64 byteCount = static_cast<qint64>(data.size()) * (sizeof(ComponentType) * N);
-				char* dest = (char*)data.data();
-				while (byteCount > 0)
+				if (!ReadArrayData(in, reinterpret_cast<char*>(data.data()), byteCount))
 				{
-					qint64 chunkSize = std::min(MaxElementPerChunk, byteCount);
-					if (in.read(dest, chunkSize) < 0)
-					{
-						return ccSerializableObject::ReadError();
-					}
-					byteCount -= chunkSize;
-					dest += chunkSize;
+					return false;
 				}
 			}
 		}
@@ -249,9 +246,10 @@ public:
 	/** \param data vector to load
 		\param in input file (must be already opened)
 		\param dataVersion version current data version
+		\param flags deserialization flags (see ccSerializableObject::DeserializationFlags)
 		\return success
 	**/
-	template <class Type, int N, class ComponentType, class FileComponentType> static bool GenericArrayFromTypedFile(std::vector<Type>& data, QFile& in, short dataVersion)
+	template <class Type, int N, class ComponentType, class FileComponentType> static bool GenericArrayFromTypedFile(std::vector<Type>& data, QFile& in, short dataVersion, int flags = 0)
 	{
 		::uint8_t componentCount = 0;
 		::uint32_t elementCount = 0;
@@ -277,30 +275,171 @@ public:
 			}
 
 			//array data (dataVersion>=20)
-			//--> sadly we can't read it as a block...
-			//we must convert each element, value by value!
-			FileComponentType dummyArray[N] = { 0 };
-
+			//the values must be converted (by blocks, or directly from a memory-mapped view of the file)
 			ComponentType* _data = (ComponentType*)data.data();
-			for (unsigned i = 0; i < elementCount; ++i)
+			const qint64 fileElementSize = static_cast<qint64>(sizeof(FileComponentType) * N);
+			const qint64 byteCount = static_cast<qint64>(elementCount) * fileElementSize;
+
+			if (dataVersion >= 53)
 			{
-				if (in.read((char*)dummyArray, sizeof(FileComponentType) * N) >= 0)
+				//stored by chunks (dataVersion>=53): each chunk is converted as soon as it is decoded
+				return ReadChunkedArrayData(in, elementCount, static_cast<size_t>(fileElementSize), [&](size_t firstElement, const char* chunkData, size_t chunkElementCount)
 				{
-					for (unsigned k = 0; k < N; ++k)
+					//DGM: the chunk data is not necessarily aligned on FileComponentType
+					ComponentType* chunkDest = _data + firstElement * N;
+					FileComponentType value = 0;
+					for (size_t i = 0; i < chunkElementCount * N; ++i)
 					{
-						*_data++ = static_cast<ComponentType>(dummyArray[k]);
+						memcpy(&value, chunkData + i * sizeof(FileComponentType), sizeof(FileComponentType));
+						chunkDest[i] = static_cast<ComponentType>(value);
 					}
+				}, flags);
+			}
+
+			if (flags & ccSerializableObject::DF_MAPPED_READ)
+			{
+				qint64 startPos = in.pos();
+				const uchar* view = in.map(startPos, byteCount);
+				if (view)
+				{
+					//DGM: the view is not necessarily aligned on FileComponentType
+					FileComponentType value = 0;
+					for (qint64 i = 0; i < static_cast<qint64>(elementCount) * N; ++i)
+					{
+						memcpy(&value, view + i * sizeof(FileComponentType), sizeof(FileComponentType));
+						*_data++ = static_cast<ComponentType>(value);
+					}
+					in.unmap(const_cast<uchar*>(view));
+
+					if (!in.seek(startPos + byteCount))
+					{
+						return ccSerializableObject::ReadError();
+					}
+					return true;
 				}
-				else
+				//otherwise we fall back to the standard reading method
+			}
+
+			//we read the values by blocks (rather than one element at a time)
+			static const unsigned MaxElementPerBlock = (1 << 16);
+			std::vector<FileComponentType> buffer;
+			try
+			{
+				buffer.resize(static_cast<size_t>(std::min(elementCount, MaxElementPerBlock)) * N);
+			}
+			catch (const std::bad_alloc&)
+			{
+				return ccSerializableObject::MemoryError();
+			}
+
+			for (unsigned i = 0; i < elementCount; )
+			{
+				unsigned blockSize = std::min(elementCount - i, MaxElementPerBlock);
+				if (in.read((char*)buffer.data(), fileElementSize * blockSize) < 0)
 				{
 					return ccSerializableObject::ReadError();
 				}
+				for (size_t k = 0; k < static_cast<size_t>(blockSize) * N; ++k)
+				{
+					*_data++ = static_cast<ComponentType>(buffer[k]);
+				}
+				i += blockSize;
 			}
 		}
 
 		return true;
 	}
 
+	//! Helper: reads a raw block of array data from file
+	/** The data is read directly in the destination buffer, by chunks (a memory-mapped view
+		of the file wouldn't save anything here, as the data would have to be copied anyway).
+		\param in input file (must be already opened)
+		\param dest destination buffer (must be big enough)
+		\param byteCount number of bytes to read
+		\return success
+	**/
+	static bool ReadArrayData(QFile& in, char* dest, qint64 byteCount)
+	{
+		if (byteCount <= 0)
+		{
+			return true;
+		}
+
+		//Apparently Qt and/or Windows don't like to read too many bytes in a row...
+		static const qint64 MaxElementPerChunk = (static_cast<qint64>(1) << 24);
+		while (byteCount > 0)
+		{
+			qint64 chunkSize = std::min(MaxElementPerChunk, byteCount);
+			if (in.read(dest, chunkSize) != chunkSize)
+			{
+				return ccSerializableObject::ReadError();
+			}
+			byteCount -= chunkSize;
+			dest += chunkSize;
+		}
+
+		return true;
+	}
+
+public: //chunked arrays (dataVersion >= 53)
+
+	//! Array chunk encoding
+	enum ChunkCodec
+	{
+		CHUNK_RAW	= 0, /**< Uncompressed chunk **/
+		CHUNK_ZLIB	= 1, /**< zlib compressed chunk (see qCompress) **/
+	};
+
+	//! Sets the compression level of array chunks when saving
+	/** \param level -1 = no compression (default), 0 to 9 = zlib compression level
+	**/
+	QCC_DB_LIB_API static void SetArrayCompressionLevel(int level);
+
+	//! Returns the compression level of array chunks when saving
+	QCC_DB_LIB_API static int ArrayCompressionLevel();
+
+	//! Computes the (CRC-32) checksum of a memory block
+	QCC_DB_LIB_API static ::uint32_t Checksum(const char* data, size_t byteCount);
+
+	//! Writes array data by chunks of ccChunk::SIZE elements
+	/** Format: chunk table (codec, stored byte count and checksum for each chunk) followed by
+		the (possibly compressed) chunks. Chunks are compressed in parallel.
+		\param out output file (must be already opened)
+		\param data array data
+		\param elementCount number of elements
+		\param elementSize size of an element (in bytes)
+		\return success
+	**/
+	QCC_DB_LIB_API static bool WriteChunkedArrayData(QFile& out, const char* data, size_t elementCount, size_t elementSize);
+
+	//! Reads array data stored by chunks (see WriteChunkedArrayData)
+	/** Chunks are decoded and their checksum is verified in parallel.
+		\param in input file (must be already opened)
+		\param dest destination buffer (must be big enough)
+		\param elementCount number of elements
+		\param elementSize size of an element (in bytes)
+		\param flags deserialization flags (see ccSerializableObject::DeserializationFlags)
+		\return success
+	**/
+	QCC_DB_LIB_API static bool ReadChunkedArrayData(QFile& in, char* dest, size_t elementCount, size_t elementSize, int flags = 0);
+
+	//! Function called with each decoded chunk: processChunk(index of the first element, chunk data, element count)
+	/** The chunk data is only valid during the call, and is not necessarily aligned.
+	**/
+	using ChunkFunction = std::function<void(size_t, const char*, size_t)>;
+
+	//! Reads array data stored by chunks (see WriteChunkedArrayData), one chunk at a time
+	/** Chunks are decoded and their checksum is verified in parallel (the function must be thread-safe).
+		Contrarily to the other version, the whole array is never stored in memory.
+		\param in input file (must be already opened)
+		\param elementCount number of elements
+		\param elementSize size of an element (in bytes)
+		\param processChunk function called with each decoded chunk
+		\param flags deserialization flags (see ccSerializableObject::DeserializationFlags)
+		\return success
+	**/
+	QCC_DB_LIB_API static bool ReadChunkedArrayData(QFile& in, size_t elementCount, size_t elementSize, const ChunkFunction& processChunk, int flags = 0);
+
 protected:
 
 	static bool ReadArrayHeader(QFile& in,
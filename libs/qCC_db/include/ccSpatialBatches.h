@@ -0,0 +1,98 @@
+//##########################################################################
+//#                                                                        #
+//#                              CLOUDCOMPARE                              #
+//#                                                                        #
+//#  This program is free software; you can redistribute it and/or modify  #
+//#  it under the terms of the GNU General Public License as published by  #
+//#  the Free Software Foundation; version 2 or later of the License.      #
+//#                                                                        #
+//#  This program is distributed in the hope that it will be useful,       #
+//#  but WITHOUT ANY WARRANTY; without even the implied warranty of        #
+//#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          #
+//#  GNU General Public License for more details.                          #
+//#                                                                        #
+//#                    COPYRIGHT: CloudCompare project                     #
+//#                                                                        #
+//##########################################################################
+
+#ifndef CC_SPATIAL_BATCHES_HEADER
+#define CC_SPATIAL_BATCHES_HEADER
+
+//Local
+#include "qCC_db.h"
+
+//Qt
+#include <QThread>
+#include <QThreadPool>
+#include <QtConcurrentMap>
+
+//System
+#include <algorithm>
+#include <vector>
+
+namespace CCCoreLib
+{
+	class GenericIndexedCloud;
+}
+
+//! Helpers to process a set of points in parallel, by batches of spatially close points
+/** Typically used for per-core point computations (M3C2, CANUPO, etc.): once the points
+	are sorted in Morton order, each batch (= one job) covers a compact area of the clouds,
+	so that the octree cells and the neighbourhood buffers of a thread are reused.
+**/
+class QCC_DB_LIB_API ccSpatialBatches
+{
+public:
+
+	//! Max number of points per batch
+	static const unsigned MAX_POINTS_PER_BATCH = 256;
+
+	//! Sorts a set of point indexes in Morton (Z-order) order
+	/** The (unique) point index is used as a tie-breaker, so that the order is deterministic.
+		\param cloud cloud
+		\param indexes point indexes (sorted in place)
+		\return false if not enough memory (in which case the order is left unchanged)
+	**/
+	static bool SortByMortonCode(CCCoreLib::GenericIndexedCloud* cloud, std::vector<unsigned>& indexes);
+
+	//! Processes the indexes [0 ; count[ by batches of contiguous indexes, in parallel
+	/** The batches are small enough to have at least a few batches per thread (load balancing).
+		\param count number of indexes
+		\param maxThreadCount max number of threads (0 = all)
+		\param processBatch function called with each batch: processBatch(start, stop) - must be thread-safe
+		\return false if not enough memory to prepare the batches (nothing has been processed then)
+	**/
+	template <class BatchFunction> static bool Process(unsigned count, int maxThreadCount, const BatchFunction& processBatch)
+	{
+		if (maxThreadCount <= 0)
+		{
+			maxThreadCount = QThread::idealThreadCount();
+		}
+
+		const unsigned batchSize = std::max(1u, std::min(MAX_POINTS_PER_BATCH, count / (4 * static_cast<unsigned>(maxThreadCount))));
+		std::vector<unsigned> batchStarts;
+		try
+		{
+			batchStarts.reserve((count + batchSize - 1) / batchSize);
+			for (unsigned start = 0; start < count; start += batchSize)
+			{
+				batchStarts.push_back(start);
+			}
+		}
+		catch (const std::bad_alloc&)
+		{
+			//not enough memory
+			return false;
+		}
+
+		QThreadPool::globalInstance()->setMaxThreadCount(maxThreadCount);
+		QtConcurrent::blockingMap(batchStarts, [&](unsigned start)
+		{
+			processBatch(start, std::min(count, start + batchSize));
+		});
+
+		return true;
+	}
+};
+
+#endif //CC_SPATIAL_BATCHES_HEADER
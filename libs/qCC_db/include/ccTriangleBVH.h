@@ -0,0 +1,115 @@
+//##########################################################################
+//#                                                                        #
+//#                              CLOUDCOMPARE                              #
+//#                                                                        #
+//#  This program is free software; you can redistribute it and/or modify  #
+//#  it under the terms of the GNU General Public License as published by  #
+//#  the Free Software Foundation; version 2 or later of the License.      #
+//#                                                                        #
+//#  This program is distributed in the hope that it will be useful,       #
+//#  but WITHOUT ANY WARRANTY; without even the implied warranty of        #
+//#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          #
+//#  GNU General Public License for more details.                          #
+//#                                                                        #
+//#                    COPYRIGHT: CloudCompare project                     #
+//#                                                                        #
+//##########################################################################
+
+#ifndef CC_TRIANGLE_BVH_HEADER
+#define CC_TRIANGLE_BVH_HEADER
+
+//Local
+#include "qCC_db.h"
+
+//CCCoreLib
+#include <CCGeom.h>
+
+//Qt
+#include <QSharedPointer>
+
+//system
+#include <functional>
+#include <vector>
+
+class ccGenericMesh;
+class ccGenericPointCloud;
+
+//! Bounding Volume Hierarchy of the triangles of a mesh
+/** Binary tree of axis-aligned bounding-boxes (median split along the largest dimension).
+	Mainly used to accelerate the (CPU-based) triangle picking.
+**/
+class QCC_DB_LIB_API ccTriangleBVH
+{
+public:
+
+	//! Shared type
+	using Shared = QSharedPointer<ccTriangleBVH>;
+
+	//! Max number of triangles per leaf
+	static const unsigned MAX_TRIANGLES_PER_LEAF = 4;
+
+	//! Default constructor
+	ccTriangleBVH();
+
+	//! Builds the structure
+	/** \param mesh mesh (in its local coordinate system, i.e. without its GL transformation)
+		\return success
+	**/
+	bool build(const ccGenericMesh& mesh);
+
+	//! Returns whether the structure is (still) valid for a given mesh
+	/** Checks that the number of triangles and the vertices are the same as when the structure was built,
+		and that the vertices haven't been modified since (see ccGenericPointCloud::getGeometryVersion).
+	**/
+	bool isValidFor(const ccGenericMesh& mesh) const;
+
+	//! Triangle test function
+	/** Should return whether the ray hits the triangle and, if so, the corresponding ray parameter
+		(t such that the hit point is origin + t * dir, with the same 'dir' as the one passed to intersect)
+	**/
+	using HitFunction = std::function<bool(unsigned triIndex, double& t)>;
+
+	//! Returns the first triangle hit by a ray
+	/** The nodes are visited front to back, and the ones that are further than the current hit are skipped.
+		\param origin ray origin
+		\param dir ray direction (no need to be normalized)
+		\param hit triangle test function
+		\return the index of the nearest triangle hit (or -1 if none)
+	**/
+	int intersect(const CCVector3d& origin, const CCVector3d& dir, const HitFunction& hit) const;
+
+	//! Returns the memory used by the structure (in bytes)
+	size_t memory() const;
+
+protected:
+
+	//! Tree node
+	struct Node
+	{
+		//! Bounding-box min corner
+		CCVector3f bbMin;
+		//! Bounding-box max corner
+		CCVector3f bbMax;
+		//! First triangle (leaf) or first child (the second child directly follows the first one)
+		uint32_t start = 0;
+		//! Number of triangles (0 for inner nodes)
+		uint32_t count = 0;
+	};
+
+	//! Nodes (the root is the first one)
+	std::vector<Node> m_nodes;
+
+	//! Triangle indexes (sorted by leaf)
+	std::vector<unsigned> m_triIndexes;
+
+	//! Number of triangles of the mesh when the structure was built
+	unsigned m_triangleCount;
+
+	//! Vertices of the mesh when the structure was built
+	const ccGenericPointCloud* m_vertices;
+
+	//! Geometry version of the vertices when the structure was built
+	unsigned m_verticesVersion;
+};
+
+#endif //CC_TRIANGLE_BVH_HEADER
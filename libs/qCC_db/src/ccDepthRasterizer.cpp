@@ -0,0 +1,273 @@
+//##########################################################################
+//#                                                                        #
+//#                              CLOUDCOMPARE                              #
+//#                                                                        #
+//#  This program is free software; you can redistribute it and/or modify  #
+//#  it under the terms of the GNU General Public License as published by  #
+//#  the Free Software Foundation; version 2 or later of the License.      #
+//#                                                                        #
+//#  This program is distributed in the hope that it will be useful,       #
+//#  but WITHOUT ANY WARRANTY; without even the implied warranty of        #
+//#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          #
+//#  GNU General Public License for more details.                          #
+//#                                                                        #
+//#                    COPYRIGHT: CloudCompare project                     #
+//#                                                                        #
+//##########################################################################
+
+#include "ccDepthRasterizer.h"
+
+//Local
+#include "ccParallel.h"
+
+//Qt
+#include <QThread>
+
+//System
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+
+//! Below this number of samples, they are drawn directly (see ccDepthRasterizer::drawSamples)
+static const size_t c_minParallelSampleCount = (1 << 16);
+//! Min number of samples per range (see ccDepthRasterizer::drawSamples)
+static const size_t c_minSamplesPerRange = (1 << 14);
+
+ccDepthRasterizer::ccDepthRasterizer()
+	: m_width(0)
+	, m_height(0)
+	, m_depthTest(KEEP_NEAREST)
+	, m_emptyValue(0)
+{
+}
+
+bool ccDepthRasterizer::init(unsigned width, unsigned height, DepthTest depthTest, PointCoordinateType emptyValue)
+{
+	if (width == 0 || height == 0 || static_cast<uint64_t>(width) * height >= INVALID_PIXEL)
+	{
+		assert(false);
+		return false;
+	}
+
+	m_depthTest = depthTest;
+	m_emptyValue = emptyValue;
+
+	try
+	{
+		m_depth.assign(static_cast<size_t>(width) * height, emptyValue);
+	}
+	catch (const std::bad_alloc&)
+	{
+		//not enough memory
+		m_depth.clear();
+		m_width = m_height = 0;
+		return false;
+	}
+
+	m_width = width;
+	m_height = height;
+
+	return true;
+}
+
+void ccDepthRasterizer::clear()
+{
+	std::fill(m_depth.begin(), m_depth.end(), m_emptyValue);
+}
+
+void ccDepthRasterizer::drawTriangle(const CCVector3& A, const CCVector3& B, const CCVector3& C, CullingMode cullingMode)
+{
+	const CCVector3* P0 = &A;
+	const CCVector3* P1 = &B;
+	const CCVector3* P2 = &C;
+
+	//signed area (x2): positive for counter-clockwise triangles (front faces)
+	double area = (static_cast<double>(B.x) - A.x) * (static_cast<double>(C.y) - A.y) - (static_cast<double>(B.y) - A.y) * (static_cast<double>(C.x) - A.x);
+	if (area < 0)
+	{
+		if (cullingMode == CULL_BACK_FACES)
+		{
+			return;
+		}
+		//we work with counter-clockwise triangles only
+		std::swap(P1, P2);
+		area = -area;
+	}
+	else if (area == 0)
+	{
+		//degenerate triangle
+		return;
+	}
+
+	//bounding box of the pixels (whose center lies inside the triangle)
+	double xMin = std::max(-1.0, static_cast<double>(std::min({ A.x, B.x, C.x })));
+	double xMax = std::min(static_cast<double>(m_width), static_cast<double>(std::max({ A.x, B.x, C.x })));
+	double yMin = std::max(-1.0, static_cast<double>(std::min({ A.y, B.y, C.y })));
+	double yMax = std::min(static_cast<double>(m_height), static_cast<double>(std::max({ A.y, B.y, C.y })));
+	int iMin = std::max(0, static_cast<int>(std::ceil(xMin - 0.5)));
+	int iMax = std::min(static_cast<int>(m_width) - 1, static_cast<int>(std::floor(xMax - 0.5)));
+	int jMin = std::max(0, static_cast<int>(std::ceil(yMin - 0.5)));
+	int jMax = std::min(static_cast<int>(m_height) - 1, static_cast<int>(std::floor(yMax - 0.5)));
+	if (iMin > iMax || jMin > jMax)
+	{
+		return;
+	}
+
+	//edge functions (= barycentric coordinates x area), evaluated incrementally
+	//E(a, b, p) = (b.x - a.x) * (p.y - a.y) - (b.y - a.y) * (p.x - a.x)
+	const double px = iMin + 0.5;
+	const double py = jMin + 0.5;
+	double w0Row = (static_cast<double>(P2->x) - P1->x) * (py - P1->y) - (static_cast<double>(P2->y) - P1->y) * (px - P1->x);
+	double w1Row = (static_cast<double>(P0->x) - P2->x) * (py - P2->y) - (static_cast<double>(P0->y) - P2->y) * (px - P2->x);
+	double w2Row = (static_cast<double>(P1->x) - P0->x) * (py - P0->y) - (static_cast<double>(P1->y) - P0->y) * (px - P0->x);
+	const double dw0dx = -(static_cast<double>(P2->y) - P1->y);
+	const double dw1dx = -(static_cast<double>(P0->y) - P2->y);
+	const double dw2dx = -(static_cast<double>(P1->y) - P0->y);
+	const double dw0dy = static_cast<double>(P2->x) - P1->x;
+	const double dw1dy = static_cast<double>(P0->x) - P2->x;
+	const double dw2dy = static_cast<double>(P1->x) - P0->x;
+	const double invArea = 1.0 / area;
+
+	for (int j = jMin; j <= jMax; ++j)
+	{
+		double w0 = w0Row;
+		double w1 = w1Row;
+		double w2 = w2Row;
+		const uint32_t rowStart = static_cast<uint32_t>(j) * m_width;
+
+		for (int i = iMin; i <= iMax; ++i)
+		{
+			if (w0 >= 0 && w1 >= 0 && w2 >= 0)
+			{
+				PointCoordinateType depth = static_cast<PointCoordinateType>((w0 * P0->z + w1 * P1->z + w2 * P2->z) * invArea);
+				drawSample(rowStart + static_cast<uint32_t>(i), depth);
+			}
+			w0 += dw0dx;
+			w1 += dw1dx;
+			w2 += dw2dx;
+		}
+
+		w0Row += dw0dy;
+		w1Row += dw1dy;
+		w2Row += dw2dy;
+	}
+}
+
+bool ccDepthRasterizer::drawSamples(const std::vector<Sample>& samples)
+{
+	const size_t sampleCount = samples.size();
+	if (sampleCount == 0)
+	{
+		return true;
+	}
+
+	//small sets are drawn directly
+	if (sampleCount < c_minParallelSampleCount)
+	{
+		for (const Sample& sample : samples)
+		{
+			if (sample.pixel != INVALID_PIXEL)
+			{
+				drawSample(sample.pixel, sample.depth);
+			}
+		}
+		return true;
+	}
+	if (sampleCount >= std::numeric_limits<uint32_t>::max())
+	{
+		//sample indexes are stored on 32 bits
+		assert(false);
+		return false;
+	}
+
+	const unsigned tileCountX = (m_width + TILE_SIZE - 1) / TILE_SIZE;
+	const unsigned tileCountY = (m_height + TILE_SIZE - 1) / TILE_SIZE;
+	const unsigned tileCount = tileCountX * tileCountY;
+
+	//the samples are split in a few ranges (binned in parallel)
+	const size_t maxRangeCount = static_cast<size_t>(std::max(1, QThread::idealThreadCount())) * 4;
+	const unsigned rangeCount = static_cast<unsigned>(std::max<size_t>(1, std::min(maxRangeCount, sampleCount / c_minSamplesPerRange)));
+	const size_t rangeSize = (sampleCount + rangeCount - 1) / rangeCount;
+
+	std::vector<uint32_t> rangeTileOffsets; //number of samples per range and per tile, then offsets
+	std::vector<uint32_t> tileStart;
+	std::vector<uint32_t> sortedIndexes;
+	try
+	{
+		rangeTileOffsets.resize(static_cast<size_t>(rangeCount) * tileCount, 0);
+		tileStart.resize(static_cast<size_t>(tileCount) + 1, 0);
+		sortedIndexes.resize(sampleCount);
+	}
+	catch (const std::bad_alloc&)
+	{
+		//not enough memory
+		return false;
+	}
+
+	auto tileIndex = [&](uint32_t pixel)
+	{
+		const unsigned i = pixel % m_width;
+		const unsigned j = pixel / m_width;
+		return (j / TILE_SIZE) * tileCountX + (i / TILE_SIZE);
+	};
+
+	//count the samples per range and per tile
+	ccParallelFor(static_cast<int>(rangeCount), [&](int r)
+	{
+		uint32_t* counts = rangeTileOffsets.data() + static_cast<size_t>(r) * tileCount;
+		const size_t start = r * rangeSize;
+		const size_t stop = std::min(sampleCount, start + rangeSize);
+		for (size_t n = start; n < stop; ++n)
+		{
+			if (samples[n].pixel != INVALID_PIXEL)
+			{
+				++counts[tileIndex(samples[n].pixel)];
+			}
+		}
+	});
+
+	//convert the counts to offsets (the samples of each tile must be contiguous)
+	{
+		uint32_t offset = 0;
+		for (unsigned t = 0; t < tileCount; ++t)
+		{
+			tileStart[t] = offset;
+			for (unsigned r = 0; r < rangeCount; ++r)
+			{
+				uint32_t& value = rangeTileOffsets[static_cast<size_t>(r) * tileCount + t];
+				uint32_t count = value;
+				value = offset;
+				offset += count;
+			}
+		}
+		tileStart[tileCount] = offset;
+	}
+
+	//sort the sample indexes by tile
+	ccParallelFor(static_cast<int>(rangeCount), [&](int r)
+	{
+		uint32_t* offsets = rangeTileOffsets.data() + static_cast<size_t>(r) * tileCount;
+		const size_t start = r * rangeSize;
+		const size_t stop = std::min(sampleCount, start + rangeSize);
+		for (size_t n = start; n < stop; ++n)
+		{
+			if (samples[n].pixel != INVALID_PIXEL)
+			{
+				sortedIndexes[offsets[tileIndex(samples[n].pixel)]++] = static_cast<uint32_t>(n);
+			}
+		}
+	});
+
+	//eventually each tile is resolved by a single thread
+	ccParallelFor(static_cast<int>(tileCount), [&](int t)
+	{
+		for (uint32_t k = tileStart[t]; k < tileStart[t + 1]; ++k)
+		{
+			const Sample& sample = samples[sortedIndexes[k]];
+			drawSample(sample.pixel, sample.depth);
+		}
+	});
+
+	return true;
+}
@@ -21,16 +21,26 @@
 #include "ccGBLSensor.h"
 
 //Local
+#include "ccDepthRasterizer.h"
+#include "ccParallel.h"
 #include "ccPointCloud.h"
 #include "ccProgressDialog.h"
 #include "ccSphere.h"
 
+//CCCoreLib
+#include <GenericIndexedCloud.h>
+
 //Qt
 #include <QCoreApplication>
 
 //maximum depth buffer dimension (width or height)
 static const int s_MaxDepthBufferSize = (1 << 14); //16384
 
+//! Number of points projected between two progress updates (see ccGBLSensor::computeDepthBuffer)
+static const unsigned c_projectionBlockSize = (1 << 20);
+//! Number of points projected by a single task (see ccGBLSensor::computeDepthBuffer)
+static const unsigned c_projectionSubBlockSize = (1 << 14);
+
 enum Errors {	ERROR_BAD_INPUT      = -1,
 				ERROR_MEMORY         = -2,
 				ERROR_PROC_CANCELLED = -3,
@@ -137,22 +147,36 @@ void ccGBLSensor::setYawStep(PointCoordinateType dTheta)
 	}
 }
 
+ccGLMatrix ccGBLSensor::getWorldToSensorTransformation(double posIndex/*=0*/) const
+{
+	//sensor to world global transformation = sensor position * rigid transformation
+	ccIndexedTransformation sensorPos; //identity by default
+	if (m_posBuffer)
+		m_posBuffer->getInterpolatedTransformation(posIndex,sensorPos);
+	sensorPos *= m_rigidTransformation;
+
+	//inverse global transformation (i.e world to sensor)
+	return sensorPos.inverse();
+}
+
 void ccGBLSensor::projectPoint(	const CCVector3& sourcePoint,
 								CCVector2& destPoint,
 								PointCoordinateType &depth,
 								double posIndex/*=0*/) const
+{
+	projectPoint(sourcePoint, getWorldToSensorTransformation(posIndex), destPoint, depth);
+}
+
+void ccGBLSensor::projectPoint(	const CCVector3& sourcePoint,
+								const ccGLMatrix& worldToSensor,
+								CCVector2& destPoint,
+								PointCoordinateType &depth) const
 {
 	//project point in sensor world
 	CCVector3 P = sourcePoint;
 
-	//sensor to world global transformation = sensor position * rigid transformation
-	ccIndexedTransformation sensorPos; //identity by default
-	if (m_posBuffer)
-		m_posBuffer->getInterpolatedTransformation(posIndex,sensorPos);
-	sensorPos *= m_rigidTransformation;
-
 	//apply (inverse) global transformation (i.e world to sensor)
-	sensorPos.inverse().apply(P);
+	worldToSensor.apply(P);
 
 	//convert to 2D sensor field of view + compute its distance
 	switch (m_rotationOrder)
@@ -688,63 +712,142 @@ bool ccGBLSensor::computeDepthBuffer(CCCoreLib::GenericCloud* theCloud, int& err
 
 	unsigned pointCount = theCloud->size();
 
-	//project points and accumulate them in Z-buffer
+	//random access to the points (if possible)
+	CCCoreLib::GenericIndexedCloud* indexedCloud = dynamic_cast<CCCoreLib::GenericIndexedCloud*>(theCloud);
+	std::vector<CCVector3> points;
+
+	//projected points (yaw, pitch, depth)
+	std::vector<CCVector3> projections;
+	//depth buffer samples
+	std::vector<ccDepthRasterizer::Sample> samples;
+	try
 	{
-		if (projectedCloud)
+		if (!indexedCloud)
 		{
-			projectedCloud->clear();
-			if (!projectedCloud->reserve(pointCount) || !projectedCloud->enableScalarField())
+			points.resize(pointCount);
+			theCloud->placeIteratorAtBeginning();
+			for (unsigned i = 0; i < pointCount; ++i)
 			{
-				//not enough memory
-				errorCode = ERROR_MEMORY;
-				clearDepthBuffer();
-				return false;
+				points[i] = *theCloud->getNextPoint();
 			}
 		}
+		if (projectedCloud)
+		{
+			projections.resize(pointCount);
+		}
+		samples.resize(pointCount);
+	}
+	catch (const std::bad_alloc&)
+	{
+		//not enough memory
+		errorCode = ERROR_MEMORY;
+		clearDepthBuffer();
+		return false;
+	}
 
-		theCloud->placeIteratorAtBeginning();
+	//project the points (in parallel)
+	{
+		//the sensor position is the same for all points
+		const ccGLMatrix worldToSensor = getWorldToSensorTransformation(m_activeIndex);
+
+		//progress bar
+		ccProgressDialog pdlg(true);
+		CCCoreLib::NormalizedProgress nprogress(&pdlg, pointCount);
+		pdlg.setMethodTitle(QObject::tr("Depth buffer"));
+		pdlg.setInfo(QObject::tr("Points: %L1").arg(pointCount));
+		pdlg.start();
+		QCoreApplication::processEvents();
+
+		for (unsigned blockStart = 0; blockStart < pointCount; blockStart += c_projectionBlockSize)
 		{
-			//progress bar
-			ccProgressDialog pdlg(true);
-			CCCoreLib::NormalizedProgress nprogress(&pdlg, pointCount);
-			pdlg.setMethodTitle(QObject::tr("Depth buffer"));
-			pdlg.setInfo(QObject::tr("Points: %L1").arg(pointCount));
-			pdlg.start();
-			QCoreApplication::processEvents();
+			const unsigned blockSize = std::min(c_projectionBlockSize, pointCount - blockStart);
+			const int subBlockCount = static_cast<int>((blockSize + c_projectionSubBlockSize - 1) / c_projectionSubBlockSize);
 
-			for (unsigned i = 0; i < pointCount; ++i)
+			ccParallelFor(subBlockCount, [&](int k)
 			{
-				const CCVector3 *P = theCloud->getNextPoint();
-				CCVector2 Q;
-				PointCoordinateType depth;
-				projectPoint(*P, Q, depth, m_activeIndex);
-
-				unsigned x = 0;
-				unsigned y = 0;
-				if (convertToDepthMapCoords(Q.x, Q.y, x, y))
+				const unsigned start = blockStart + static_cast<unsigned>(k) * c_projectionSubBlockSize;
+				const unsigned stop = std::min(start + c_projectionSubBlockSize, blockStart + blockSize);
+				for (unsigned i = start; i < stop; ++i)
 				{
-					PointCoordinateType& zBuf = m_depthBuffer.zBuff[y*m_depthBuffer.width + x];
-					zBuf = std::max(zBuf, depth);
-					m_sensorRange = std::max(m_sensorRange, depth);
-				}
+					//getPoint(i, P) copies the point (the pointer returned by getPoint(i) may not be thread-safe)
+					CCVector3 P;
+					if (indexedCloud)
+						indexedCloud->getPoint(i, P);
+					else
+						P = points[i];
+					CCVector2 Q;
+					PointCoordinateType depth;
+					projectPoint(P, worldToSensor, Q, depth);
+
+					ccDepthRasterizer::Sample& sample = samples[i];
+					sample.depth = depth;
+					sample.pixel = ccDepthRasterizer::INVALID_PIXEL;
+
+					unsigned x = 0;
+					unsigned y = 0;
+					if (convertToDepthMapCoords(Q.x, Q.y, x, y))
+					{
+						sample.pixel = y * m_depthBuffer.width + x;
+					}
 
-				if (projectedCloud)
-				{
-					projectedCloud->addPoint(CCVector3(Q.x, Q.y, 0));
-					projectedCloud->setPointScalarValue(i, depth);
+					if (projectedCloud)
+					{
+						projections[i] = CCVector3(Q.x, Q.y, depth);
+					}
 				}
+			});
 
-				if (!nprogress.oneStep())
-				{
-					//cancelled by user
-					errorCode = ERROR_PROC_CANCELLED;
-					clearDepthBuffer();
-					return false;
-				}
+			if (!nprogress.steps(blockSize))
+			{
+				//cancelled by user
+				errorCode = ERROR_PROC_CANCELLED;
+				clearDepthBuffer();
+				return false;
 			}
 		}
 	}
 
+	//accumulate them in the Z-buffer (the rasterizer uses its own buffer)
+	//the depth buffer keeps the farthest points (0 = no information)
+	m_depthBuffer.zBuff.clear();
+	m_depthBuffer.zBuff.shrink_to_fit();
+	ccDepthRasterizer rasterizer;
+	if (	!rasterizer.init(m_depthBuffer.width, m_depthBuffer.height, ccDepthRasterizer::KEEP_FARTHEST, 0)
+		||	!rasterizer.drawSamples(samples))
+	{
+		//not enough memory
+		errorCode = ERROR_MEMORY;
+		clearDepthBuffer();
+		return false;
+	}
+	samples.clear();
+	samples.shrink_to_fit();
+
+	m_depthBuffer.zBuff.swap(rasterizer.buffer());
+	for (PointCoordinateType depth : m_depthBuffer.zBuff)
+	{
+		m_sensorRange = std::max(m_sensorRange, depth);
+	}
+
+	if (projectedCloud)
+	{
+		projectedCloud->clear();
+		if (!projectedCloud->reserve(pointCount) || !projectedCloud->enableScalarField())
+		{
+			//not enough memory
+			errorCode = ERROR_MEMORY;
+			clearDepthBuffer();
+			return false;
+		}
+
+		for (unsigned i = 0; i < pointCount; ++i)
+		{
+			const CCVector3& Q = projections[i];
+			projectedCloud->addPoint(CCVector3(Q.x, Q.y, 0));
+			projectedCloud->setPointScalarValue(i, Q.z);
+		}
+	}
+
 	m_depthBuffer.fillHoles();
 
 	errorCode = 0;
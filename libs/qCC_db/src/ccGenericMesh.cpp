@@ -40,6 +40,7 @@
 
 //system
 #include <cassert>
+#include <limits>
 
 ccGenericMesh::ccGenericMesh(QString name/*=QString()*/, unsigned uniqueID/*=ccUniqueIDGenerator::InvalidUniqueID*/)
 	: GenericIndexedMesh()
@@ -887,6 +888,32 @@ void ccGenericMesh::importParametersFrom(const ccGenericMesh* mesh)
 	setMetaData(mesh->metaData());
 }
 
+void ccGenericMesh::notifyGeometryUpdate()
+{
+	//the picking BVH is (potentially) deprecated
+	m_pickingBVH.clear();
+
+	ccShiftedObject::notifyGeometryUpdate();
+}
+
+ccTriangleBVH::Shared ccGenericMesh::getPickingBVH() const
+{
+	if (!m_pickingBVH || !m_pickingBVH->isValidFor(*this))
+	{
+		ccTriangleBVH::Shared bvh(new ccTriangleBVH);
+		if (!bvh->build(*this))
+		{
+			ccLog::Warning(QString("[ccGenericMesh] Failed to build the picking BVH of mesh '%1' (not enough memory?)").arg(getName()));
+			m_pickingBVH.clear();
+			return m_pickingBVH;
+		}
+		ccLog::PrintDebug(QString("[ccGenericMesh] Picking BVH of mesh '%1' built (%2 Mb)").arg(getName()).arg(bvh->memory() / static_cast<double>(1 << 20), 0, 'f', 2));
+		m_pickingBVH = bvh;
+	}
+
+	return m_pickingBVH;
+}
+
 void ccGenericMesh::computeInterpolationWeights(unsigned triIndex, const CCVector3& P, CCVector3d& weights) const
 {
 	CCCoreLib::GenericTriangle* tri = const_cast<ccGenericMesh*>(this)->_getTriangle(triIndex);
@@ -1031,6 +1058,70 @@ bool ccGenericMesh::trianglePicking(const CCVector2d& clickPos,
 		return false;
 	}
 
+	//can we use a BVH to accelerate the picking process?
+	if (size() >= MIN_TRIANGLES_FOR_PICKING_BVH)
+	{
+		ccTriangleBVH::Shared bvh = getPickingBVH();
+		if (bvh)
+		{
+			//picking ray (in the local coordinate system of the mesh)
+			CCVector3d rayOrigin = X;
+			CCVector3d rayEnd(0, 0, 0);
+			if (!camera.unproject(CCVector3d(clickPos.x, clickPos.y, 1.0), rayEnd))
+			{
+				return false;
+			}
+			if (!noGLTrans)
+			{
+				ccGLMatrixd invTrans = ccGLMatrixd(trans.data()).inverse();
+				invTrans.apply(rayOrigin);
+				invTrans.apply(rayEnd);
+			}
+			const CCVector3d rayDir = rayEnd - rayOrigin;
+			const double rayDirNorm2 = rayDir.norm2();
+			if (rayDirNorm2 < std::numeric_limits<double>::epsilon())
+			{
+				//degenerate ray
+				return false;
+			}
+
+			//the BVH visits the candidate triangles front to back
+			bool hasHit = false;
+			double nearestT = 0.0;
+			CCVector3d nearestBC(0, 0, 0);
+			nearestTriIndex = bvh->intersect(rayOrigin, rayDir, [&](unsigned triIndex, double& t)
+			{
+				CCVector3d P;
+				CCVector3d BC;
+				if (!trianglePicking(triIndex, clickPos, trans, noGLTrans, *vertices, camera, P, &BC))
+				{
+					return false;
+				}
+				//ray parameter (in the same unit as the BVH boxes entry parameters)
+				t = (P - rayOrigin).dot(rayDir) / rayDirNorm2;
+				if (!hasHit || t < nearestT)
+				{
+					hasHit = true;
+					nearestT = t;
+					nearestPoint = P;
+					nearestBC = BC;
+				}
+				return true;
+			});
+
+			if (nearestTriIndex < 0)
+			{
+				return false;
+			}
+
+			nearestSquareDist = (X - nearestPoint).norm2d();
+			if (barycentricCoords)
+				*barycentricCoords = nearestBC;
+
+			return true;
+		}
+	}
+
 //#define TEST_PICKING
 #ifdef TEST_PICKING
 	QImage testImage(camera.viewport[2], camera.viewport[3], QImage::Format::Format_ARGB32);
@@ -39,6 +39,7 @@
 ccGenericPointCloud::ccGenericPointCloud(QString name, unsigned uniqueID)
 	: ccShiftedObject(name, uniqueID)
 	, m_pointSize(0)
+	, m_geometryVersion(0)
 {
 	setVisible(true);
 	lockVisibility(false);
@@ -48,6 +49,7 @@ ccGenericPointCloud::ccGenericPointCloud(const ccGenericPointCloud& cloud)
 	: ccShiftedObject(cloud)
 	, m_pointsVisibility(cloud.m_pointsVisibility)
 	, m_pointSize(cloud.m_pointSize)
+	, m_geometryVersion(0)
 {
 }
 
@@ -56,6 +58,13 @@ ccGenericPointCloud::~ccGenericPointCloud()
 	clear();
 }
 
+void ccGenericPointCloud::notifyGeometryUpdate()
+{
+	++m_geometryVersion;
+
+	ccShiftedObject::notifyGeometryUpdate();
+}
+
 void ccGenericPointCloud::clear()
 {
 	unallocateVisibilityArray();
@@ -164,7 +173,7 @@ ccOctree::Shared ccGenericPointCloud::computeOctree(CCCoreLib::GenericProgressCa
 	deleteOctree();
 	
 	ccOctree::Shared octree = ccOctree::Shared(new ccOctree(this));
-	if (octree->build(progressCb) > 0)
+	if (octree->buildWithCache(progressCb) > 0)
 	{
 		setOctree(octree, autoAddChild);
 	}
@@ -243,7 +252,7 @@ bool ccGenericPointCloud::fromFile_MeOnly(QFile& in, short dataVersion, int flag
 		return ReadError();
 	if (hasVisibilityArray)
 	{
-		if (!ccSerializationHelper::GenericArrayFromFile<unsigned char, 1, unsigned char>(m_pointsVisibility, in, dataVersion))
+		if (!ccSerializationHelper::GenericArrayFromFile<unsigned char, 1, unsigned char>(m_pointsVisibility, in, dataVersion, flags))
 		{
 			unallocateVisibilityArray();
 			return false;
@@ -296,6 +305,12 @@ bool ccGenericPointCloud::pointPicking(	const CCVector2d& clickPos,
 										double pickHeight/*=2.0*/,
 										bool autoComputeOctree/*=false*/)
 {
+	//can we use the LOD structure to accelerate the point picking process?
+	if (pointPickingWithLOD(clickPos, camera, nearestPointIndex, nearestSquareDist, pickWidth, pickHeight))
+	{
+		return (nearestPointIndex >= 0);
+	}
+
 	//can we use the octree to accelerate the point picking process?
 	if (pickWidth == pickHeight)
 	{
@@ -45,6 +45,7 @@
 #include "ccTorus.h"
 
 //Qt
+#include <QElapsedTimer>
 #include <QIcon>
 
 ccHObject::ccHObject(const QString& name, unsigned uniqueID/*=ccUniqueIDGenerator::InvalidUniqueID*/)
@@ -746,7 +747,26 @@ void ccHObject::draw(CC_DRAW_CONTEXT& context)
 				toggleClipPlanes(context, true);
 			}
 
-			drawMeOnly(context);
+			if (context.stats && draw3D)
+			{
+				//profiling mode
+				QElapsedTimer timer;
+				timer.start();
+				quint64 pointsDrawnBefore = context.stats->pointsDrawn;
+
+				drawMeOnly(context);
+
+				ccRenderingStats::EntityTiming timing;
+				timing.uniqueID = getUniqueID();
+				timing.name = getName();
+				timing.drawTime_ns = timer.nsecsElapsed();
+				timing.pointsDrawn = context.stats->pointsDrawn - pointsDrawnBefore;
+				context.stats->entities.push_back(timing);
+			}
+			else
+			{
+				drawMeOnly(context);
+			}
 
 			//disable clipping planes (if any)
 			if (useClipPlanes)
@@ -970,9 +990,26 @@ bool ccHObject::isSerializable() const
 }
 
 bool ccHObject::toFile(QFile& out) const
+{
+	return toFile(out, nullptr);
+}
+
+bool ccHObject::toFile(QFile& out, FileOffsets* offsets) const
 {
 	assert(out.isOpen() && (out.openMode() & QIODevice::WriteOnly));
 
+	if (offsets)
+	{
+		try
+		{
+			offsets->emplace_back(this, out.pos());
+		}
+		catch (const std::bad_alloc&)
+		{
+			return MemoryError();
+		}
+	}
+
 	//write 'ccObject' header
 	if (!ccObject::toFile(out))
 		return false;
@@ -999,7 +1036,7 @@ bool ccHObject::toFile(QFile& out) const
 	{
 		if (child->isSerializable())
 		{
-			if (!child->toFile(out))
+			if (!child->toFile(out, offsets))
 				return false;
 		}
 	}
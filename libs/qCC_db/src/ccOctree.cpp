@@ -26,19 +26,38 @@
 #include "ccScalarField.h"
 #include "ccPointCloud.h"
 #include "ccBox.h"
+#include "ccParallel.h"
 #include "ccProgressDialog.h"
+#include "ccSerializableObject.h"
 
 //CCCoreLib
 #include <Neighbourhood.h>
 #include <RayAndBox.h>
 #include <ScalarFieldTools.h>
 
+//Qt
+#include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+
+//System
+#include <atomic>
+#include <cstring>
+#include <random>
+
 #ifdef QT_DEBUG
 //#define DEBUG_PICKING_MECHANISM
 #endif
 
-//System
-#include <random>
+//! Folder in which the computed octrees are cached (empty = no cache)
+static QString s_cacheFolder;
+//! Octree cache files are only used above this number of points (below, building the octree is fast anyway)
+static const unsigned c_minCachedOctreeSize = 1000000;
+//! Octree cache file header
+static const char c_cacheFileMagic[4] = { 'C', 'C', 'O', 'C' };
+//! Octree cache file version
+static const uint32_t c_cacheFileVersion = 1;
 
 ccOctree::ccOctree(ccGenericPointCloud* aCloud)
 	: CCCoreLib::DgmOctree(aCloud)
@@ -941,3 +960,263 @@ PointCoordinateType ccOctree::GuessBestRadius(	ccGenericPointCloud* cloud,
 
 	return bestRadius;
 }
+
+void ccOctree::SetCacheFolder(const QString& folder)
+{
+	s_cacheFolder = folder;
+}
+
+QString ccOctree::CacheFolder()
+{
+	return s_cacheFolder;
+}
+
+QByteArray ccOctree::ComputeCloudHash(const ccGenericPointCloud* cloud)
+{
+	if (!cloud)
+	{
+		assert(false);
+		return QByteArray();
+	}
+
+	//we hash the points by blocks (in parallel)
+	const unsigned pointCount = cloud->size();
+	static const unsigned BlockSize = (1 << 16);
+	const int blockCount = static_cast<int>((pointCount + BlockSize - 1) / BlockSize);
+	std::vector<uint64_t> blockHashes;
+	try
+	{
+		blockHashes.resize(blockCount);
+	}
+	catch (const std::bad_alloc&)
+	{
+		return QByteArray();
+	}
+
+	ccGenericPointCloud* _cloud = const_cast<ccGenericPointCloud*>(cloud);
+	auto hashBlock = [&](int blockIndex)
+	{
+		//64 bits FNV-1a (on 32 bits words)
+		uint64_t h = 14695981039346656037ULL;
+		const unsigned start = static_cast<unsigned>(blockIndex) * BlockSize;
+		const unsigned stop = std::min(start + BlockSize, pointCount);
+		for (unsigned i = start; i < stop; ++i)
+		{
+			uint32_t words[sizeof(CCVector3) / sizeof(uint32_t)];
+			memcpy(words, _cloud->getPoint(i)->u, sizeof(words));
+			for (uint32_t word : words)
+			{
+				h = (h ^ word) * 1099511628211ULL;
+			}
+		}
+		blockHashes[blockIndex] = h;
+	};
+
+	ccParallelFor(blockCount, hashBlock);
+
+	//the final hash also depends on the number of points and on the octree structure
+	QCryptographicHash hash(QCryptographicHash::Sha1);
+	hash.addData(reinterpret_cast<const char*>(&pointCount), sizeof(unsigned));
+	const uint32_t structureInfo[3] = { static_cast<uint32_t>(sizeof(PointCoordinateType)), static_cast<uint32_t>(sizeof(IndexAndCode)), static_cast<uint32_t>(MAX_OCTREE_LEVEL) };
+	hash.addData(reinterpret_cast<const char*>(structureInfo), sizeof(structureInfo));
+	if (!blockHashes.empty())
+	{
+		hash.addData(reinterpret_cast<const char*>(blockHashes.data()), static_cast<int>(blockHashes.size() * sizeof(uint64_t)));
+	}
+
+	return hash.result();
+}
+
+int ccOctree::buildWithCache(CCCoreLib::GenericProgressCallback* progressCb/*=nullptr*/)
+{
+	if (	s_cacheFolder.isEmpty()
+		||	!m_theAssociatedCloudAsGPC
+		||	m_theAssociatedCloudAsGPC->size() < c_minCachedOctreeSize )
+	{
+		return build(progressCb);
+	}
+
+	QByteArray cloudHash = ComputeCloudHash(m_theAssociatedCloudAsGPC);
+	if (cloudHash.isEmpty())
+	{
+		return build(progressCb);
+	}
+	QString filename = QDir(s_cacheFolder).absoluteFilePath(QString::fromLatin1(cloudHash.toHex()) + ".ccoctree");
+
+	if (QFile::exists(filename))
+	{
+		if (fromCacheFile(filename, cloudHash))
+		{
+			ccLog::PrintDebug(QString("[ccOctree] Octree loaded from cache: %1").arg(filename));
+			return static_cast<int>(m_numberOfProjectedPoints);
+		}
+		ccLog::Warning(QString("[ccOctree] Invalid octree cache file: %1").arg(filename));
+	}
+
+	int result = build(progressCb);
+	if (result > 0)
+	{
+		//we add the octree to the cache (we write a temporary file first, as other processes may use the same cache)
+		QString tempFilename = filename + QString(".%1.tmp").arg(QCoreApplication::applicationPid());
+		if (QDir().mkpath(s_cacheFolder) && toCacheFile(tempFilename, cloudHash))
+		{
+			QFile::remove(filename);
+			if (!QFile::rename(tempFilename, filename))
+			{
+				QFile::remove(tempFilename);
+			}
+		}
+		else
+		{
+			QFile::remove(tempFilename);
+			ccLog::Warning(QString("[ccOctree] Failed to save the octree in cache folder '%1'").arg(s_cacheFolder));
+		}
+	}
+
+	return result;
+}
+
+bool ccOctree::toCacheFile(const QString& filename, const QByteArray& cloudHash) const
+{
+	QFile out(filename);
+	if (!out.open(QFile::WriteOnly | QFile::Truncate))
+	{
+		return false;
+	}
+
+	//header
+	const uint32_t codeCount = static_cast<uint32_t>(m_thePointsAndTheirCellCodes.size());
+	const uint32_t codeSize = static_cast<uint32_t>(sizeof(IndexAndCode));
+	const uint32_t hashSize = static_cast<uint32_t>(cloudHash.size());
+	if (	out.write(c_cacheFileMagic, 4) < 0
+		||	out.write(reinterpret_cast<const char*>(&c_cacheFileVersion), 4) < 0
+		||	out.write(reinterpret_cast<const char*>(&hashSize), 4) < 0
+		||	out.write(cloudHash) < 0
+		||	out.write(reinterpret_cast<const char*>(&codeSize), 4) < 0
+		||	out.write(reinterpret_cast<const char*>(&codeCount), 4) < 0
+		||	out.write(reinterpret_cast<const char*>(&m_numberOfProjectedPoints), sizeof(unsigned)) < 0
+		||	out.write(reinterpret_cast<const char*>(&m_nearestPow2), sizeof(int)) < 0
+		||	out.write(reinterpret_cast<const char*>(m_dimMin.u), sizeof(CCVector3)) < 0
+		||	out.write(reinterpret_cast<const char*>(m_dimMax.u), sizeof(CCVector3)) < 0
+		||	out.write(reinterpret_cast<const char*>(m_pointsMin.u), sizeof(CCVector3)) < 0
+		||	out.write(reinterpret_cast<const char*>(m_pointsMax.u), sizeof(CCVector3)) < 0 )
+	{
+		return false;
+	}
+
+	//sorted codes and indexes
+	return ccSerializationHelper::WriteChunkedArrayData(	out,
+															reinterpret_cast<const char*>(m_thePointsAndTheirCellCodes.data()),
+															m_thePointsAndTheirCellCodes.size(),
+															sizeof(IndexAndCode));
+}
+
+bool ccOctree::fromCacheFile(const QString& filename, const QByteArray& cloudHash)
+{
+	QFile in(filename);
+	if (!in.open(QFile::ReadOnly))
+	{
+		return false;
+	}
+
+	//header
+	char magic[4] = { 0, 0, 0, 0 };
+	uint32_t version = 0;
+	uint32_t hashSize = 0;
+	if (	in.read(magic, 4) != 4
+		||	memcmp(magic, c_cacheFileMagic, 4) != 0
+		||	in.read(reinterpret_cast<char*>(&version), 4) != 4
+		||	version != c_cacheFileVersion
+		||	in.read(reinterpret_cast<char*>(&hashSize), 4) != 4
+		||	in.read(hashSize) != cloudHash )
+	{
+		return false;
+	}
+
+	uint32_t codeSize = 0;
+	uint32_t codeCount = 0;
+	unsigned numberOfProjectedPoints = 0;
+	int nearestPow2 = 0;
+	CCVector3 dimMin;
+	CCVector3 dimMax;
+	CCVector3 pointsMin;
+	CCVector3 pointsMax;
+	if (	in.read(reinterpret_cast<char*>(&codeSize), 4) != 4
+		||	codeSize != sizeof(IndexAndCode)
+		||	in.read(reinterpret_cast<char*>(&codeCount), 4) != 4
+		||	codeCount > m_theAssociatedCloudAsGPC->size()
+		||	in.read(reinterpret_cast<char*>(&numberOfProjectedPoints), sizeof(unsigned)) != sizeof(unsigned)
+		||	numberOfProjectedPoints != codeCount
+		||	in.read(reinterpret_cast<char*>(&nearestPow2), sizeof(int)) != sizeof(int)
+		||	in.read(reinterpret_cast<char*>(dimMin.u), sizeof(CCVector3)) != sizeof(CCVector3)
+		||	in.read(reinterpret_cast<char*>(dimMax.u), sizeof(CCVector3)) != sizeof(CCVector3)
+		||	in.read(reinterpret_cast<char*>(pointsMin.u), sizeof(CCVector3)) != sizeof(CCVector3)
+		||	in.read(reinterpret_cast<char*>(pointsMax.u), sizeof(CCVector3)) != sizeof(CCVector3) )
+	{
+		return false;
+	}
+
+	clear();
+
+	try
+	{
+		m_thePointsAndTheirCellCodes.resize(codeCount);
+	}
+	catch (const std::bad_alloc&)
+	{
+		return false;
+	}
+
+	if (!ccSerializationHelper::ReadChunkedArrayData(	in,
+														reinterpret_cast<char*>(m_thePointsAndTheirCellCodes.data()),
+														codeCount,
+														sizeof(IndexAndCode),
+														ccSerializableObject::DF_MAPPED_READ))
+	{
+		clear();
+		return false;
+	}
+
+	//the cache file may be corrupted or stale: the point indexes must be valid, and the codes sorted
+	{
+		const unsigned pointCount = m_theAssociatedCloudAsGPC->size();
+		static const unsigned BlockSize = (1 << 16);
+		const int blockCount = static_cast<int>((codeCount + BlockSize - 1) / BlockSize);
+		std::atomic<bool> valid(true);
+		ccParallelFor(blockCount, [&](int blockIndex)
+		{
+			const unsigned start = static_cast<unsigned>(blockIndex) * BlockSize;
+			const unsigned stop = std::min(start + BlockSize, codeCount);
+			for (unsigned i = start; i < stop; ++i)
+			{
+				const IndexAndCode& indexAndCode = m_thePointsAndTheirCellCodes[i];
+				if (	indexAndCode.theIndex >= pointCount
+					||	(i != 0 && indexAndCode.theCode < m_thePointsAndTheirCellCodes[i - 1].theCode) )
+				{
+					valid = false;
+					return;
+				}
+			}
+		});
+
+		if (!valid)
+		{
+			clear();
+			return false;
+		}
+	}
+
+	m_numberOfProjectedPoints = numberOfProjectedPoints;
+	m_nearestPow2 = nearestPow2;
+	m_dimMin = dimMin;
+	m_dimMax = dimMax;
+	m_pointsMin = pointsMin;
+	m_pointsMax = pointsMax;
+
+	//restore the pre-computed tables (same as after a standard build)
+	updateCellSizeTable();
+	updateMinAndMaxTables();
+	updateCellCountTable();
+
+	return true;
+}
@@ -43,6 +43,7 @@
 #include "ccNormalVectors.h"
 #include "ccOctree.h"
 #include "ccPointCloudLOD.h"
+#include "ccPointCloudLODPageCache.h"
 #include "ccPolyline.h"
 #include "ccProgressDialog.h"
 #include "ccScalarField.h"
@@ -67,6 +68,7 @@ ccPointCloud::ccPointCloud(QString name/*=QString()*/, unsigned uniqueID/*=ccUni
 	, m_currentDisplayedScalarFieldIndex(-1)
 	, m_visibilityCheckEnabled(false)
 	, m_lod(nullptr)
+	, m_lodPages(nullptr)
 	, m_fwfData(nullptr)
 {
 	setName(name); //sadly we cannot use the ccGenericPointCloud constructor argument
@@ -439,6 +441,12 @@ ccPointCloud::~ccPointCloud()
 		delete m_lod;
 		m_lod = nullptr;
 	}
+
+	if (m_lodPages)
+	{
+		delete m_lodPages;
+		m_lodPages = nullptr;
+	}
 }
 
 void ccPointCloud::clear()
@@ -461,7 +469,7 @@ void ccPointCloud::unallocatePoints()
 
 void ccPointCloud::notifyGeometryUpdate()
 {
-	ccHObject::notifyGeometryUpdate();
+	ccGenericPointCloud::notifyGeometryUpdate();
 
 	releaseVBOs();
 	clearLOD();
@@ -1525,7 +1533,7 @@ void ccPointCloud::setPointColor(unsigned pointIndex, const ccColor::Rgba& col)
 	m_rgbaColors->setValue(pointIndex, col);
 
 	//We must update the VBOs
-	colorsHaveChanged();
+	colorsHaveChanged(pointIndex, pointIndex);
 }
 
 void ccPointCloud::setPointNormalIndex(unsigned pointIndex, CompressedNormType norm)
@@ -1535,7 +1543,7 @@ void ccPointCloud::setPointNormalIndex(unsigned pointIndex, CompressedNormType n
 	m_normals->setValue(pointIndex, norm);
 
 	//We must update the VBOs
-	normalsHaveChanged();
+	normalsHaveChanged(pointIndex, pointIndex);
 }
 
 void ccPointCloud::setPointNormal(unsigned pointIndex, const CCVector3& N)
@@ -2200,7 +2208,7 @@ inline float GetSymmetricalNormalizedValue(const ScalarType& sfVal, const ccScal
 //the GL type depends on the PointCoordinateType 'size' (float or double)
 static GLenum GL_COORD_TYPE = sizeof(PointCoordinateType) == 4 ? GL_FLOAT : GL_DOUBLE;
 
-void ccPointCloud::glChunkVertexPointer(const CC_DRAW_CONTEXT& context, size_t chunkIndex, unsigned decimStep, bool useVBOs)
+bool ccPointCloud::glChunkVertexPointer(const CC_DRAW_CONTEXT& context, size_t chunkIndex, unsigned decimStep, bool useVBOs)
 {
 	QOpenGLFunctions_2_1* glFunc = context.glFunctions<QOpenGLFunctions_2_1>();
 	assert(glFunc != nullptr);
@@ -2212,17 +2220,31 @@ void ccPointCloud::glChunkVertexPointer(const CC_DRAW_CONTEXT& context, size_t c
 		&& m_vboManager.vbos[chunkIndex]->isCreated())
 	{
 		//we can use VBOs directly
-		if (m_vboManager.vbos[chunkIndex]->bind())
+		VBO* vbo = m_vboManager.vbos[chunkIndex];
+		if (vbo->bind())
 		{
+			if (vbo->compact)
+			{
+				glFunc->glVertexPointer(3, GL_SHORT, decimStep * VBO::PointSize(true), nullptr);
+				vbo->release();
+
+				//the coordinates are quantized: we must apply the dequantization transformation
+				glFunc->glMatrixMode(GL_MODELVIEW);
+				glFunc->glPushMatrix();
+				glFunc->glTranslated(vbo->origin.x, vbo->origin.y, vbo->origin.z);
+				glFunc->glScaled(vbo->scale, vbo->scale, vbo->scale);
+				return true;
+			}
+
 			glFunc->glVertexPointer(3, GL_COORD_TYPE, decimStep * 3 * sizeof(PointCoordinateType), nullptr);
-			m_vboManager.vbos[chunkIndex]->release();
+			vbo->release();
 		}
 		else
 		{
 			ccLog::Warning("[VBO] Failed to bind VBO?! We'll deactivate them then...");
 			m_vboManager.state = vboSet::FAILED;
 			//recall the method
-			glChunkVertexPointer(context, chunkIndex, decimStep, false);
+			return glChunkVertexPointer(context, chunkIndex, decimStep, false);
 		}
 	}
 	else
@@ -2230,6 +2252,8 @@ void ccPointCloud::glChunkVertexPointer(const CC_DRAW_CONTEXT& context, size_t c
 		//standard OpenGL copy
 		glFunc->glVertexPointer(3, GL_COORD_TYPE, decimStep * 3 * sizeof(PointCoordinateType), ccChunk::Start(m_points, chunkIndex));
 	}
+
+	return false;
 }
 
 ///Maximum number of points (per cloud) displayed in a single LOD iteration
@@ -2245,6 +2269,8 @@ static PointCoordinateType s_pointBuffer [MAX_POINT_COUNT_PER_LOD_RENDER_PASS *
 static PointCoordinateType s_normalBuffer[MAX_POINT_COUNT_PER_LOD_RENDER_PASS * 3];
 static ColorCompType       s_rgbBuffer4ub[MAX_POINT_COUNT_PER_LOD_RENDER_PASS * 4];
 static float               s_rgbBuffer3f [MAX_POINT_COUNT_PER_LOD_RENDER_PASS * 3];
+//staging buffer for the compact VBO layout
+static GLshort             s_quantizedPointBuffer[ccChunk::SIZE * 3];
 
 void ccPointCloud::glChunkNormalPointer(const CC_DRAW_CONTEXT& context, size_t chunkIndex, unsigned decimStep, bool useVBOs)
 {
@@ -2582,8 +2608,18 @@ void ccPointCloud::drawMeOnly(CC_DRAW_CONTEXT& context)
 			}
 		}
 
+		if (m_lodPages && !context.lodStreaming && !pushName)
+		{
+			//streaming has been disabled: we free the GPU memory used by the pages
+			m_lodPages->release();
+			delete m_lodPages;
+			m_lodPages = nullptr;
+		}
+
 		// L.O.D. display
 		DisplayDesc toDisplay(0, size());
+		//whether the LOD pages are streamed on the GPU (see ccPointCloudLODPageCache)
+		bool streamLODPages = false;
 		if (!pushName)
 		{
 			if (	context.decimateCloudOnMove
@@ -2593,6 +2629,12 @@ void ccPointCloud::drawMeOnly(CC_DRAW_CONTEXT& context)
 			{
 				bool skipLoD = false;
 
+				//LOD pages streaming (not compatible with hidden points)
+				bool lodStreaming = (	context.lodStreaming
+									&&	context.useVBOs
+									&&	!isVisibilityTableInstantiated()
+									&&	(!glParams.showSF || !m_currentDisplayedScalarField->mayHaveHiddenValues()) );
+
 				//is there a LoD structure associated yet?
 				if (!m_lod || !m_lod->isBroken())
 				{
@@ -2614,8 +2656,7 @@ void ccPointCloud::drawMeOnly(CC_DRAW_CONTEXT& context)
 						if (underConstruction || maxLevel == 0)
 						{
 							//not yet ready
-							context.moreLODPointsAvailable = underConstruction;
-							context.higherLODLevelsAvailable = false;
+							context.moreLODPointsAvailable |= underConstruction;
 						}
 						else if (context.stereoPassIndex == 0)
 						{
@@ -2632,27 +2673,80 @@ void ccPointCloud::drawMeOnly(CC_DRAW_CONTEXT& context)
 								Frustum frustum(camera.modelViewMat, camera.projectionMat);
 
 								//first time: we flag the cells visibility and count the number of visible points
-								m_lod->flagVisibility(frustum, m_clipPlanes.empty() ? nullptr : &m_clipPlanes);
+								//(unless it has already been done for this frame, see PrepareLODVisibility)
+								if (!m_lod->usePreparedVisibility(camera.modelViewMat, camera.projectionMat, m_clipPlanes.empty() ? nullptr : &m_clipPlanes))
+								{
+									m_lod->flagVisibility(frustum, m_clipPlanes.empty() ? nullptr : &m_clipPlanes);
+								}
+
+								if (lodStreaming)
+								{
+									if (	m_vboManager.updateFlags != 0
+										||	m_vboManager.hasDirtyRanges
+										||	(glParams.showSF && m_currentDisplayedScalarField->getModificationFlag()))
+									{
+										//the loaded pages (and VBOs) are outdated
+										releaseVBOs();
+										m_vboManager.updateFlags = 0;
+										if (glParams.showSF)
+										{
+											m_currentDisplayedScalarField->setModificationFlag(false);
+										}
+									}
+
+									ccPointCloudLODPageCache::Content content;
+									content.sourceSF = glParams.showSF ? m_currentDisplayedScalarField : nullptr;
+									content.hasColors = glParams.showSF || (glParams.showColors && !isColorOverridden());
+									content.hasNormals = glParams.showNorms;
+									content.compact = context.useCompactVBOs;
+
+									if (!m_lodPages)
+									{
+										m_lodPages = new ccPointCloudLODPageCache(*this);
+									}
+									streamLODPages = m_lodPages->startFrame(*m_lod, camera, content);
+								}
+							}
+							else
+							{
+								//we continue to load the pages of the current frame (if any)
+								streamLODPages = (lodStreaming && m_lodPages && m_lodPages->hasPendingPages());
 							}
 
-							unsigned remainingPointsAtThisLevel = 0;
-							toDisplay.startIndex = 0;
-							toDisplay.count = MAX_POINT_COUNT_PER_LOD_RENDER_PASS;
-							toDisplay.indexMap = &m_lod->getIndexMap(context.currentLODLevel, toDisplay.count, remainingPointsAtThisLevel);
-							if (toDisplay.count == 0)
+							if (streamLODPages)
 							{
-								//nothing to draw at this level
-								toDisplay.indexMap = nullptr;
+								//the pages will be drawn by priority (see below)
+								skipLoD = true;
 							}
 							else
 							{
-								assert(toDisplay.count == toDisplay.indexMap->size());
-								toDisplay.endIndex = toDisplay.startIndex + toDisplay.count;
-							}
+								unsigned remainingPointsAtThisLevel = 0;
+								toDisplay.startIndex = 0;
+								toDisplay.count = MAX_POINT_COUNT_PER_LOD_RENDER_PASS;
+								toDisplay.indexMap = &m_lod->getIndexMap(context.currentLODLevel, toDisplay.count, remainingPointsAtThisLevel);
+								if (toDisplay.count == 0)
+								{
+									//nothing to draw at this level
+									toDisplay.indexMap = nullptr;
+								}
+								else
+								{
+									assert(toDisplay.count == toDisplay.indexMap->size());
+									toDisplay.endIndex = toDisplay.startIndex + toDisplay.count;
+								}
 
-							//could we draw more points at the next level?
-							context.moreLODPointsAvailable = (remainingPointsAtThisLevel != 0);
-							context.higherLODLevelsAvailable = (!m_lod->allDisplayed() && context.currentLODLevel + 1 <= maxLevel);
+								//could we draw more points at the next level?
+								//(other clouds may have more points to draw as well)
+								context.moreLODPointsAvailable |= (remainingPointsAtThisLevel != 0);
+								context.higherLODLevelsAvailable |= (!m_lod->allDisplayed() && context.currentLODLevel + 1 <= maxLevel);
+
+								if (remainingPointsAtThisLevel != 0)
+								{
+									//the next pass will be at the same level: we prepare its index map in the background
+									//(while the current points are drawn)
+									m_lod->prepareIndexMap(context.currentLODLevel, MAX_POINT_COUNT_PER_LOD_RENDER_PASS);
+								}
+							}
 						}
 					}
 				}
@@ -2743,8 +2837,37 @@ void ccPointCloud::drawMeOnly(CC_DRAW_CONTEXT& context)
 
 		//main display procedure
 		{
+			if (streamLODPages)
+			{
+				assert(m_lodPages);
+
+				glFunc->glEnableClientState(GL_VERTEX_ARRAY);
+				if (glParams.showSF || glParams.showColors)
+				{
+					glFunc->glEnableClientState(GL_COLOR_ARRAY);
+				}
+				if (glParams.showNorms)
+				{
+					glFunc->glEnableClientState(GL_NORMAL_ARRAY);
+				}
+
+				//the pages already loaded are only drawn in the first pass (the next passes only draw the new ones)
+				//if some visible pages are still missing, they will be loaded in the next pass
+				//(the LOD level stays at 255 after 255 passes, see ccGLWindow)
+				context.higherLODLevelsAvailable |= m_lodPages->draw(glFunc, *m_lod, context.lodStreamingBudget, context.currentLODLevel == 0, context.stats);
+
+				if (glParams.showNorms)
+				{
+					glFunc->glDisableClientState(GL_NORMAL_ARRAY);
+				}
+				if (glParams.showSF || glParams.showColors)
+				{
+					glFunc->glDisableClientState(GL_COLOR_ARRAY);
+				}
+				glFunc->glDisableClientState(GL_VERTEX_ARRAY);
+			}
 			//if some points are hidden (= visibility table instantiated), we can't use display arrays :(
-			if (isVisibilityTableInstantiated())
+			else if (isVisibilityTableInstantiated())
 			{
 				assert(m_pointsVisibility.size() == m_points.size());
 				//compressed normals set
@@ -2944,6 +3067,10 @@ void ccPointCloud::drawMeOnly(CC_DRAW_CONTEXT& context)
 							}
 
 							glFunc->glDrawArrays(GL_POINTS, 0, count);
+							if (context.stats)
+							{
+								context.stats->pointsDrawn += count;
+							}
 
 							s = e;
 						}
@@ -2956,7 +3083,7 @@ void ccPointCloud::drawMeOnly(CC_DRAW_CONTEXT& context)
 							size_t chunkSize = ccChunk::Size(k, m_points);
 
 							//points
-							glChunkVertexPointer(context, k, toDisplay.decimStep, useVBOs);
+							bool dequantize = glChunkVertexPointer(context, k, toDisplay.decimStep, useVBOs);
 							//normals
 							if (glParams.showNorms)
 							{
@@ -2989,6 +3116,15 @@ void ccPointCloud::drawMeOnly(CC_DRAW_CONTEXT& context)
 								chunkSize = static_cast<unsigned>(floor(static_cast<float>(chunkSize) / toDisplay.decimStep));
 							}
 							glFunc->glDrawArrays(GL_POINTS, 0, static_cast<GLsizei>(chunkSize));
+							if (context.stats)
+							{
+								context.stats->pointsDrawn += chunkSize;
+							}
+
+							if (dequantize)
+							{
+								glFunc->glPopMatrix();
+							}
 						}
 					}
 
@@ -3149,6 +3285,10 @@ void ccPointCloud::drawMeOnly(CC_DRAW_CONTEXT& context)
 							glLODChunkColorPointer<QOpenGLFunctions_2_1>(m_rgbaColors, glFunc, *toDisplay.indexMap, s, e);
 
 						glFunc->glDrawArrays(GL_POINTS, 0, count);
+						if (context.stats)
+						{
+							context.stats->pointsDrawn += count;
+						}
 						s = e;
 					}
 				}
@@ -3159,7 +3299,7 @@ void ccPointCloud::drawMeOnly(CC_DRAW_CONTEXT& context)
 						size_t chunkSize = ccChunk::Size(k, m_points);
 
 						//points
-						glChunkVertexPointer(context, k, toDisplay.decimStep, useVBOs);
+						bool dequantize = glChunkVertexPointer(context, k, toDisplay.decimStep, useVBOs);
 						//normals
 						if (glParams.showNorms)
 							glChunkNormalPointer(context, k, toDisplay.decimStep, useVBOs);
@@ -3172,6 +3312,15 @@ void ccPointCloud::drawMeOnly(CC_DRAW_CONTEXT& context)
 							chunkSize = static_cast<unsigned>(floor(static_cast<float>(chunkSize) / toDisplay.decimStep));
 						}
 						glFunc->glDrawArrays(GL_POINTS, 0, static_cast<GLsizei>(chunkSize));
+						if (context.stats)
+						{
+							context.stats->pointsDrawn += chunkSize;
+						}
+
+						if (dequantize)
+						{
+							glFunc->glPopMatrix();
+						}
 					}
 				}
 
@@ -4302,6 +4451,19 @@ bool ccPointCloud::toFile_MeOnly(QFile& out) const
 		}
 	}
 
+	//LOD structure (dataVersion >= 54)
+	{
+		bool withLOD = (m_lod && m_lod->isInitialized());
+		if (out.write((const char*)&withLOD, sizeof(bool)) < 0)
+		{
+			return WriteError();
+		}
+		if (withLOD && !m_lod->toFile(out))
+		{
+			return false;
+		}
+	}
+
 	return true;
 }
 
@@ -4316,15 +4478,15 @@ bool ccPointCloud::fromFile_MeOnly(QFile& in, short dataVersion, int flags, Load
 		bool fileCoordIsDouble = (flags & ccSerializableObject::DF_POINT_COORDS_64_BITS);
 		if (!fileCoordIsDouble && sizeof(PointCoordinateType) == 8) //file is 'float' and current type is 'double'
 		{
-			result = ccSerializationHelper::GenericArrayFromTypedFile<CCVector3, 3, PointCoordinateType, float>(m_points, in, dataVersion);
+			result = ccSerializationHelper::GenericArrayFromTypedFile<CCVector3, 3, PointCoordinateType, float>(m_points, in, dataVersion, flags);
 		}
 		else if (fileCoordIsDouble && sizeof(PointCoordinateType) == 4) //file is 'double' and current type is 'float'
 		{
-			result = ccSerializationHelper::GenericArrayFromTypedFile<CCVector3, 3, PointCoordinateType, double>(m_points, in, dataVersion);
+			result = ccSerializationHelper::GenericArrayFromTypedFile<CCVector3, 3, PointCoordinateType, double>(m_points, in, dataVersion, flags);
 		}
 		else
 		{
-			result = ccSerializationHelper::GenericArrayFromFile<CCVector3, 3, PointCoordinateType>(m_points, in, dataVersion);
+			result = ccSerializationHelper::GenericArrayFromFile<CCVector3, 3, PointCoordinateType>(m_points, in, dataVersion, flags);
 		}
 		if (!result)
 		{
@@ -4644,6 +4806,28 @@ bool ccPointCloud::fromFile_MeOnly(QFile& in, short dataVersion, int flags, Load
 		}
 	}
 
+	//LOD structure (dataVersion >= 54)
+	if (dataVersion >= 54)
+	{
+		bool withLOD = false;
+		if (in.read((char*)&withLOD, sizeof(bool)) < 0)
+		{
+			return ReadError();
+		}
+		if (withLOD)
+		{
+			if (!m_lod)
+			{
+				m_lod = new ccPointCloudLOD;
+			}
+			if (!m_lod->fromFile(in, flags, size()))
+			{
+				m_lod->clear();
+				return false;
+			}
+		}
+	}
+
 	//notifyGeometryUpdate(); //FIXME: we can't call it now as the dependent 'pointers' are not valid yet!
 
 	//We should update the VBOs (just in case)
@@ -4842,11 +5026,17 @@ bool ccPointCloud::updateVBOs(const CC_DRAW_CONTEXT& context, const glDrawParams
 #ifndef DONT_LOAD_NORMALS_IN_VBOS
 		if ( glParams.showNorms && !m_vboManager.hasNormals )
 		{
-			updateFlags |= UPDATE_NORMALS;
+			m_vboManager.updateFlags |= vboSet::UPDATE_NORMALS;
 		}
 #endif
+		//the whole layout changes
+		if (m_vboManager.compact != context.useCompactVBOs)
+		{
+			m_vboManager.updateFlags = vboSet::UPDATE_ALL;
+		}
+
 		//nothing to do?
-		if (m_vboManager.updateFlags == 0)
+		if (m_vboManager.updateFlags == 0 && !m_vboManager.hasDirtyRanges)
 		{
 			return true;
 		}
@@ -4886,8 +5076,11 @@ bool ccPointCloud::updateVBOs(const CC_DRAW_CONTEXT& context, const glDrawParams
 
 	//init VBOs
 	unsigned pointsInVBOs = 0;
+	quint64 uploadedBytes = 0;
 	size_t totalSizeBytesBefore = m_vboManager.totalMemSizeBytes;
 	m_vboManager.totalMemSizeBytes = 0;
+	m_vboManager.pointCount = 0;
+	m_vboManager.compact = context.useCompactVBOs;
 	{
 		//DGM: the context should be already active as this method should only be called from 'drawMeOnly'
 		assert(!glParams.showSF		|| m_currentDisplayedScalarField);
@@ -4905,20 +5098,81 @@ bool ccPointCloud::updateVBOs(const CC_DRAW_CONTEXT& context, const glDrawParams
 		m_vboManager.hasNormals  = false;
 #endif
 
+		//max extent of a chunk for the compact layout (see below)
+		double maxCompactChunkExtent = 0.0;
+		if (m_vboManager.compact)
+		{
+			CCVector3 diag = getOwnBB().getDiagVec();
+			maxCompactChunkExtent = 2.0 * std::max(diag.x, std::max(diag.y, diag.z)) / std::sqrt(static_cast<double>(chunksCount));
+		}
+
 		//process each chunk
 		for (size_t chunkIndex = 0; chunkIndex < chunksCount; ++chunkIndex)
 		{
 			int chunkSize = static_cast<int>(ccChunk::Size(chunkIndex, m_points));
 
+			//the whole chunk must be updated for the 'global' flags, and only a sub-range of it for the 'range' ones
 			int chunkUpdateFlags = m_vboManager.updateFlags;
+			vboSet::DirtyRange range;
+			if (m_vboManager.hasDirtyRanges && chunkIndex < m_vboManager.dirtyRanges.size())
+			{
+				range = m_vboManager.dirtyRanges[chunkIndex];
+				range.flags &= ~chunkUpdateFlags;
+				range.last = std::min(range.last, static_cast<unsigned>(chunkSize - 1));
+			}
+
 			bool reallocated = false;
 			if (!m_vboManager.vbos[chunkIndex])
 			{
 				m_vboManager.vbos[chunkIndex] = new VBO;
 			}
+			else if (	m_vboManager.state == vboSet::INITIALIZED
+					&&	chunkUpdateFlags == 0
+					&&	range.flags == 0
+					&&	m_vboManager.vbos[chunkIndex]->sizeBytes > 0 )
+			{
+				//nothing to update in this chunk
+				m_vboManager.totalMemSizeBytes += static_cast<size_t>(m_vboManager.vbos[chunkIndex]->sizeBytes);
+				pointsInVBOs += chunkSize;
+				continue;
+			}
+
+			//the compact layout is only used for the chunks that are spatially coherent, i.e. not much larger than
+			//a chunk of spatially sorted points would be (otherwise the quantization would be too coarse)
+			bool compactChunk = false;
+			if (m_vboManager.compact)
+			{
+				VBO* vbo = m_vboManager.vbos[chunkIndex];
+				if (	vbo->sizeBytes > 0
+					&&	(chunkUpdateFlags & vboSet::UPDATE_POINTS) == 0
+					&&	(range.flags & vboSet::UPDATE_POINTS) == 0 )
+				{
+					//the points have not changed
+					compactChunk = vbo->compact;
+				}
+				else
+				{
+					//quantization parameters (relatively to the chunk bounding-box)
+					const CCVector3* _points = ccChunk::Start(m_points, chunkIndex);
+					CCVector3d bbMin = _points[0].toDouble();
+					CCVector3d bbMax = bbMin;
+					for (int j = 1; j < chunkSize; ++j)
+					{
+						const CCVector3d P = _points[j].toDouble();
+						bbMin.x = std::min(bbMin.x, P.x); bbMax.x = std::max(bbMax.x, P.x);
+						bbMin.y = std::min(bbMin.y, P.y); bbMax.y = std::max(bbMax.y, P.y);
+						bbMin.z = std::min(bbMin.z, P.z); bbMax.z = std::max(bbMax.z, P.z);
+					}
+					const CCVector3d diag = bbMax - bbMin;
+					const double maxExtent = std::max(diag.x, std::max(diag.y, diag.z));
+					compactChunk = (maxExtent <= maxCompactChunkExtent);
+					vbo->origin = (bbMin + bbMax) / 2;
+					vbo->scale = (maxExtent > 0 ? maxExtent / 65534 : 1.0);
+				}
+			}
 
 			//allocate memory for current VBO
-			int vboSizeBytes = m_vboManager.vbos[chunkIndex]->init(chunkSize, m_vboManager.hasColors, m_vboManager.hasNormals, &reallocated);
+			int vboSizeBytes = m_vboManager.vbos[chunkIndex]->init(chunkSize, m_vboManager.hasColors, m_vboManager.hasNormals, compactChunk, &reallocated);
 
 			QOpenGLFunctions_2_1* glFunc = context.glFunctions<QOpenGLFunctions_2_1>(); 
 			if (glFunc)
@@ -4934,17 +5188,67 @@ bool ccPointCloud::updateVBOs(const CC_DRAW_CONTEXT& context, const glDrawParams
 				{
 					//if the vbo is reallocated, then all its content has been cleared!
 					chunkUpdateFlags = vboSet::UPDATE_ALL;
+					range.flags = 0;
+				}
+
+				VBO* vbo = m_vboManager.vbos[chunkIndex];
+				if (vbo->compact && (range.flags & vboSet::UPDATE_POINTS))
+				{
+					//the quantization of the whole chunk may change
+					chunkUpdateFlags |= vboSet::UPDATE_POINTS;
+					range.flags &= ~vboSet::UPDATE_POINTS;
 				}
 
-				m_vboManager.vbos[chunkIndex]->bind();
+				//returns the (relative) range of points to update for a given feature (if any)
+				auto updateRange = [&](int flag, int& first, int& count) -> bool
+				{
+					if (chunkUpdateFlags & flag)
+					{
+						first = 0;
+						count = chunkSize;
+						return true;
+					}
+					else if (range.flags & flag)
+					{
+						first = static_cast<int>(range.first);
+						count = static_cast<int>(range.last - range.first) + 1;
+						return true;
+					}
+					return false;
+				};
+				int first = 0;
+				int count = 0;
+
+				vbo->bind();
 
 				//load points
-				if (chunkUpdateFlags & vboSet::UPDATE_POINTS)
+				if (updateRange(vboSet::UPDATE_POINTS, first, count))
 				{
-					m_vboManager.vbos[chunkIndex]->write(0, ccChunk::Start(m_points, chunkIndex), sizeof(PointCoordinateType)*chunkSize * 3);
+					const CCVector3* _points = ccChunk::Start(m_points, chunkIndex);
+					if (vbo->compact)
+					{
+						assert(first == 0 && count == chunkSize);
+						//quantize the coordinates relatively to the chunk bounding-box (see above)
+						GLshort* _quantized = s_quantizedPointBuffer;
+						for (int j = 0; j < chunkSize; ++j)
+						{
+							const CCVector3d P = (_points[j].toDouble() - vbo->origin) / vbo->scale;
+							for (unsigned d = 0; d < 3; ++d)
+							{
+								*_quantized++ = static_cast<GLshort>(std::max(-32767.0, std::min(std::round(P.u[d]), 32767.0)));
+							}
+						}
+						vbo->write(0, s_quantizedPointBuffer, VBO::PointSize(true) * chunkSize);
+						uploadedBytes += VBO::PointSize(true) * chunkSize;
+					}
+					else
+					{
+						vbo->write(VBO::PointSize(false) * first, _points + first, VBO::PointSize(false) * count);
+						uploadedBytes += VBO::PointSize(false) * count;
+					}
 				}
 				//load colors
-				if (chunkUpdateFlags & vboSet::UPDATE_COLORS)
+				if (updateRange(vboSet::UPDATE_COLORS, first, count))
 				{
 					if (glParams.showSF)
 					{
@@ -4952,8 +5256,8 @@ bool ccPointCloud::updateVBOs(const CC_DRAW_CONTEXT& context, const glDrawParams
 						{
 							assert(m_vboManager.sourceSF);
 							ColorCompType* _sfColors = s_rgbBuffer4ub;
-							ScalarType* _sf = ccChunk::Start(*m_vboManager.sourceSF, chunkIndex);
-							for (int j = 0; j < chunkSize; j++, _sf++)
+							ScalarType* _sf = ccChunk::Start(*m_vboManager.sourceSF, chunkIndex) + first;
+							for (int j = 0; j < count; j++, _sf++)
 							{
 								//we need to convert scalar value to color into a temporary structure
 								const ccColor::Rgb* col = _sf ? m_vboManager.sourceSF->getColor(*_sf) : nullptr;
@@ -4966,30 +5270,33 @@ bool ccPointCloud::updateVBOs(const CC_DRAW_CONTEXT& context, const glDrawParams
 							}
 						}
 						//then send them in VRAM
-						m_vboManager.vbos[chunkIndex]->write(m_vboManager.vbos[chunkIndex]->rgbShift, s_rgbBuffer4ub, sizeof(ColorCompType) * chunkSize * 4);
+						vbo->write(vbo->rgbShift + sizeof(ColorCompType) * first * 4, s_rgbBuffer4ub, sizeof(ColorCompType) * count * 4);
+						uploadedBytes += sizeof(ColorCompType) * count * 4;
 						//upadte 'modification' flag for current displayed SF
 						m_vboManager.sourceSF->setModificationFlag(false);
 					}
 					else if (glParams.showColors)
 					{
-						m_vboManager.vbos[chunkIndex]->write(m_vboManager.vbos[chunkIndex]->rgbShift, ccChunk::Start(*m_rgbaColors, chunkIndex), sizeof(ColorCompType) * chunkSize * 4);
+						vbo->write(vbo->rgbShift + sizeof(ColorCompType) * first * 4, ccChunk::Start(*m_rgbaColors, chunkIndex) + first, sizeof(ColorCompType) * count * 4);
+						uploadedBytes += sizeof(ColorCompType) * count * 4;
 					}
 				}
 #ifndef DONT_LOAD_NORMALS_IN_VBOS
 				//load normals
-				if (glParams.showNorms && (chunkUpdateFlags & UPDATE_NORMALS))
+				if (glParams.showNorms && updateRange(vboSet::UPDATE_NORMALS, first, count))
 				{
 					//we must decode the normals first!
-					CompressedNormType* inNorms = m_normals->chunkStartPtr(chunkIndex);
+					const CompressedNormType* inNorms = ccChunk::Start(*m_normals, chunkIndex) + first;
 					PointCoordinateType* outNorms = s_normalBuffer;
-					for (int j=0; j<chunkSize; ++j)
+					for (int j = 0; j < count; ++j)
 					{
 						const CCVector3& N = ccNormalVectors::GetNormal(*inNorms++);
 						*(outNorms)++ = N.x;
 						*(outNorms)++ = N.y;
 						*(outNorms)++ = N.z;
 					}
-					m_vboManager.vbos[chunkIndex]->write(m_vboManager.vbos[chunkIndex]->normalShift, s_normalBuffer, sizeof(PointCoordinateType)*chunkSize * 3);
+					vbo->write(vbo->normalShift + sizeof(PointCoordinateType) * first * 3, s_normalBuffer, sizeof(PointCoordinateType) * count * 3);
+					uploadedBytes += sizeof(PointCoordinateType) * count * 3;
 				}
 #endif
 				m_vboManager.vbos[chunkIndex]->release();
@@ -5045,29 +5352,52 @@ bool ccPointCloud::updateVBOs(const CC_DRAW_CONTEXT& context, const glDrawParams
 		ccLog::Print(QString("[VBO] VBO(s) (re)initialized for cloud '%1' (%2 Mb = %3% of points could be loaded)")
 			.arg(getName())
 			.arg(static_cast<double>(m_vboManager.totalMemSizeBytes) / (1 << 20), 0, 'f', 2)
-			.arg(static_cast<double>(pointsInVBOs) / size() * 100.0, 0, 'f', 2));
+			.arg(static_cast<double>(pointsInVBOs) / size() * 100.0, 0, 'f', 2)
+			+ (pointsInVBOs != 0 ? QString(" - %1 bytes/point").arg(static_cast<double>(m_vboManager.totalMemSizeBytes) / pointsInVBOs, 0, 'f', 1) : QString()));
 #endif
 
+	if (context.stats)
+	{
+		context.stats->uploadedBytes += uploadedBytes;
+	}
+
+	m_vboManager.pointCount = pointsInVBOs;
 	m_vboManager.state = vboSet::INITIALIZED;
 	m_vboManager.updateFlags = 0;
+	m_vboManager.clearDirtyRanges();
 
 	return true;
 }
 
-int ccPointCloud::VBO::init(int count, bool withColors, bool withNormals, bool* reallocated/*=nullptr*/)
+int ccPointCloud::VBO::PointSize(bool compactLayout)
+{
+	return compactLayout ? static_cast<int>(sizeof(GLshort) * 3) : static_cast<int>(sizeof(PointCoordinateType) * 3);
+}
+
+int ccPointCloud::VBO::init(int count, bool withColors, bool withNormals, bool compactLayout, bool* reallocated/*=nullptr*/)
 {
+	//each array should start on a 4 bytes boundary
+	static const auto Align4 = [](int size) { return (size + 3) & ~3; };
+
 	//required memory
-	int totalSizeBytes = sizeof(PointCoordinateType) * count * 3;
+	int totalSizeBytes = PointSize(compactLayout) * count;
 	if (withColors)
 	{
-		rgbShift = totalSizeBytes;
+		rgbShift = totalSizeBytes = Align4(totalSizeBytes);
 		totalSizeBytes += sizeof(ColorCompType) * count * 4;
 	}
 	if (withNormals)
 	{
-		normalShift = totalSizeBytes;
+		normalShift = totalSizeBytes = Align4(totalSizeBytes);
 		totalSizeBytes += sizeof(PointCoordinateType) * count * 3;
 	}
+	if (compact != compactLayout)
+	{
+		compact = compactLayout;
+		if (reallocated)
+			*reallocated = true; //the whole content must be updated anyway
+	}
+	sizeBytes = -1;
 
 	if (!isCreated())
 	{
@@ -5109,16 +5439,88 @@ int ccPointCloud::VBO::init(int count, bool withColors, bool withNormals, bool*
 
 	release();
 	
+	sizeBytes = totalSizeBytes;
 	return totalSizeBytes;
 }
 
-size_t ccPointCloud::vboSize() const
+size_t ccPointCloud::vboSize(unsigned* loadedPointCount/*=nullptr*/, size_t* lodPagesSize/*=nullptr*/) const
+{
+	if (loadedPointCount)
+	{
+		*loadedPointCount = (m_vboManager.state == vboSet::INITIALIZED ? m_vboManager.pointCount : 0);
+	}
+
+	size_t pagesSize = (m_lodPages ? m_lodPages->memory() : 0);
+	if (lodPagesSize)
+	{
+		*lodPagesSize = pagesSize;
+	}
+
+	return m_vboManager.totalMemSizeBytes + pagesSize;
+}
+
+void ccPointCloud::vboSet::flagRange(int flags, unsigned firstIndex, unsigned lastIndex)
 {
-	return m_vboManager.totalMemSizeBytes;
+	if (state != INITIALIZED || (updateFlags & flags) == flags || firstIndex > lastIndex)
+	{
+		//the whole VBOs will be updated anyway (if any)
+		return;
+	}
+
+	if (dirtyRanges.size() < vbos.size())
+	{
+		try
+		{
+			dirtyRanges.resize(vbos.size());
+		}
+		catch (const std::bad_alloc&)
+		{
+			//not enough memory: we'll update everything
+			updateFlags |= flags;
+			return;
+		}
+	}
+
+	size_t lastChunk = std::min(lastIndex / ccChunk::SIZE, dirtyRanges.size() - 1);
+	for (size_t chunkIndex = firstIndex / ccChunk::SIZE; chunkIndex <= lastChunk; ++chunkIndex)
+	{
+		size_t chunkStart = ccChunk::StartPos(chunkIndex);
+		unsigned first = static_cast<unsigned>(std::max<size_t>(firstIndex, chunkStart) - chunkStart);
+		unsigned last = static_cast<unsigned>(std::min<size_t>(lastIndex, chunkStart + ccChunk::SIZE - 1) - chunkStart);
+
+		DirtyRange& range = dirtyRanges[chunkIndex];
+		if (range.flags == 0)
+		{
+			range.first = first;
+			range.last = last;
+		}
+		else
+		{
+			range.first = std::min(range.first, first);
+			range.last = std::max(range.last, last);
+		}
+		range.flags |= flags;
+	}
+
+	hasDirtyRanges = true;
+}
+
+void ccPointCloud::vboSet::clearDirtyRanges()
+{
+	if (hasDirtyRanges)
+	{
+		std::fill(dirtyRanges.begin(), dirtyRanges.end(), DirtyRange());
+		hasDirtyRanges = false;
+	}
 }
 
 void ccPointCloud::releaseVBOs()
 {
+	if (m_lodPages)
+	{
+		m_lodPages->release();
+	}
+
 	if (m_vboManager.state == vboSet::NEW)
 		return;
 
@@ -5145,7 +5547,10 @@ void ccPointCloud::releaseVBOs()
 	m_vboManager.hasNormals = false;
 	m_vboManager.colorIsSF = false;
 	m_vboManager.sourceSF = nullptr;
+	m_vboManager.compact = false;
 	m_vboManager.totalMemSizeBytes = 0;
+	m_vboManager.pointCount = 0;
+	m_vboManager.clearDirtyRanges();
 	m_vboManager.state = vboSet::NEW;
 }
 
@@ -5647,8 +6052,136 @@ bool ccPointCloud::initLOD()
 	return m_lod->init(this);
 }
 
+void ccPointCloud::PrepareLODVisibility(ccHObject* root, const CC_DRAW_CONTEXT& context, const ccGLMatrixd& modelViewMat, const ccGLMatrixd& projectionMat)
+{
+	if (!root || !context.decimateCloudOnMove || context.currentLODLevel != 0 || context.stereoPassIndex != 0)
+	{
+		return;
+	}
+
+	ccHObject::Container clouds;
+	root->filterChildren(clouds, true, CC_TYPES::POINT_CLOUD, true, context.display);
+
+	std::vector<ccPointCloudLOD::VisibilityJob> jobs;
+	for (ccHObject* entity : clouds)
+	{
+		ccPointCloud* cloud = static_cast<ccPointCloud*>(entity);
+		if (	!cloud->isVisible()
+			||	!cloud->isBranchEnabled()
+			||	cloud->size() <= context.minLODPointCount
+			||	!cloud->m_lod
+			||	!cloud->m_lod->isInitialized() )
+		{
+			continue;
+		}
+
+		ccPointCloudLOD::VisibilityJob job;
+		job.lod = cloud->m_lod;
+		job.modelViewMat = modelViewMat;
+		ccGLMatrix trans;
+		if (cloud->getAbsoluteGLTransformation(trans))
+		{
+			job.modelViewMat = modelViewMat * ccGLMatrixd(trans.data());
+		}
+		job.clipPlanes = cloud->m_clipPlanes.empty() ? nullptr : &cloud->m_clipPlanes;
+
+		try
+		{
+			jobs.push_back(job);
+		}
+		catch (const std::bad_alloc&)
+		{
+			//not enough memory: the visibility of the remaining clouds will be tested at display time
+			break;
+		}
+	}
+
+	//it's only worth it with several clouds (a single cloud is already processed in parallel)
+	if (jobs.size() > 1)
+	{
+		ccPointCloudLOD::PrepareVisibility(jobs, projectionMat);
+	}
+}
+
+bool ccPointCloud::canPickWithLOD()
+{
+	return (size() >= MIN_POINTS_FOR_LOD_PICKING && (!m_lod || !m_lod->isBroken()));
+}
+
+bool ccPointCloud::pointPickingWithLOD(	const CCVector2d& clickPos,
+										const ccGLCameraParameters& camera,
+										int& nearestPointIndex,
+										double& nearestSquareDist,
+										double pickWidth,
+										double pickHeight)
+{
+	if (size() < MIN_POINTS_FOR_LOD_PICKING)
+	{
+		return false;
+	}
+
+	if (!m_lod || m_lod->isNull())
+	{
+		//we start the construction of the LOD structure for the next time
+		initLOD();
+		return false;
+	}
+	if (!m_lod->isInitialized())
+	{
+		//under construction or broken
+		return false;
+	}
+
+	//warning: we have to handle the relative GL transformation!
+	ccGLMatrix trans;
+	bool noGLTrans = !getAbsoluteGLTransformation(trans);
+
+	//visibility table (if any)
+	const VisibilityTableType* visTable = isVisibilityTableInstantiated() ? &getTheVisibilityArray() : nullptr;
+
+	//scalar field with hidden values (if any)
+	ccScalarField* activeSF = nullptr;
+	if (sfShown() && !visTable) //if the visibility table is instantiated, we always display ALL points
+	{
+		ccScalarField* sf = getCurrentDisplayedScalarField();
+		if (sf && sf->mayHaveHiddenValues() && sf->getColorScale())
+		{
+			//we must take this SF display parameters into account as some points may be hidden!
+			activeSF = sf;
+		}
+	}
+
+	std::function<bool(unsigned)> isPickable;
+	if (visTable || activeSF)
+	{
+		isPickable = [&](unsigned index)
+		{
+			return	(!visTable || visTable->at(index) == CCCoreLib::POINT_VISIBLE)
+				&&	(!activeSF || activeSF->getColor(activeSF->getValue(index)));
+		};
+	}
+
+	m_lod->pointPicking(*this,
+						clickPos,
+						camera,
+						noGLTrans ? nullptr : &trans,
+						pickWidth,
+						pickHeight,
+						isPickable,
+						nearestPointIndex,
+						nearestSquareDist);
+
+	return true;
+}
+
 void ccPointCloud::clearLOD()
 {
+	//the LOD pages refer to the LOD nodes
+	if (m_lodPages)
+	{
+		m_lodPages->release();
+	}
+
 	if (m_lod)
 	{
 		m_lod->clear();
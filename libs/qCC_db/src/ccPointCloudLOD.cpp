@@ -18,11 +18,26 @@
 #include "ccPointCloudLOD.h"
 
 //Local
+#include "ccParallel.h"
 #include "ccPointCloud.h"
+#include "ccSerializableObject.h"
 
 //Qt
-#include <QThread>
 #include <QElapsedTimer>
+#include <QFile>
+#include <QThread>
+#include <QtConcurrentRun>
+
+//System
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+//! Number of nodes processed by a single thread for light tasks (geometry computation, visibility reset)
+static const int c_nodeGrainSize = 64;
+
+//! Level of the octree subtrees that are flagged in parallel (see ccPointCloudLOD::flagVisibility)
+static const unsigned char s_parallelFlagLevel = 2;
 
 //! Thread for background computation
 class ccPointCloudLODThread : public QThread
@@ -50,121 +65,105 @@ public:
 	
 protected:
 
-	//! Fills a node (and returns its relative position) + recursive
-	uint8_t fillNode(ccPointCloudLOD::Node& node) const
+	//! Counts the points of a node (and returns its relative position)
+	/** The cell codes being sorted, the end of the node can be found with a binary search
+		(i.e. without visiting the points).
+	**/
+	uint8_t countNode(ccPointCloudLOD::Node& node) const
 	{
 		const ccOctree::cellsContainer& cellCodes = m_octree->pointsAndTheirCellCodes();
 		const unsigned char bitDec = CCCoreLib::DgmOctree::GET_BIT_SHIFT(node.level);
 		const CCCoreLib::DgmOctree::CellCode currentTruncatedCellCode = (cellCodes[node.firstCodeIndex].theCode >> bitDec);
 
-		//first count the number of points and compute their center
+		auto endIt = std::partition_point(	cellCodes.begin() + node.firstCodeIndex,
+											cellCodes.end(),
+											[&](const CCCoreLib::DgmOctree::IndexAndCode& code) { return (code.theCode >> bitDec) == currentTruncatedCellCode; });
+
+		node.pointCount = static_cast<uint32_t>(std::distance(cellCodes.begin(), endIt)) - node.firstCodeIndex;
+
+		//return the node relative position
+		return static_cast<uint8_t>(currentTruncatedCellCode & 7);
+	}
+
+	//! Subdivides a node (the children are only counted)
+	void subdivideNode(ccPointCloudLOD::Node& node)
+	{
+		for (uint32_t i = 0; i < node.pointCount;)
 		{
-			node.pointCount = 0;
-#ifdef COMPUTE_REAL_RADIUS
-			CCVector3d sumP(0, 0, 0);
-#else //otherwise we use the bounding box
-			ccBBox bbox;
-#endif
-			for (uint32_t codeIndex = node.firstCodeIndex; codeIndex < cellCodes.size() && (cellCodes[codeIndex].theCode >> bitDec) == currentTruncatedCellCode; ++codeIndex)
-			{
-				++node.pointCount;
-				const CCVector3* P = m_cloud.getPoint(cellCodes[codeIndex].theIndex);
-#ifdef COMPUTE_REAL_RADIUS
-				sumP += *P;
-#else
-				bbox.add(*P);
-#endif
-			}
+			int32_t childNodeIndex = m_lod.newCell(node.level + 1);
+			ccPointCloudLOD::Node& childNode = m_lod.node(childNodeIndex, node.level + 1);
+			childNode.firstCodeIndex = node.firstCodeIndex + i;
+
+			uint8_t childIndex = countNode(childNode);
+			node.childIndexes[childIndex] = childNodeIndex;
+			node.childCount++;
+			i += childNode.pointCount;
+		}
+	}
 
-			//compute the radius
-#ifdef COMPUTE_REAL_RADIUS
-			if (node.pointCount > 1)
-			{
-				sumP /= node.pointCount;
-				double maxSquareRadius = 0;
-				for (uint32_t i = 0; i < node.pointCount; ++i)
-				{
-					const CCVector3* P = m_cloud.getPoint(cellCodes[node.firstCodeIndex + i].theIndex);
-					double squareRadius = (P->toDouble() - sumP).norm2();
-					if (squareRadius > maxSquareRadius)
-					{
-						maxSquareRadius = squareRadius;
-					}
-				}
-				node.radius = static_cast<float>(sqrt(maxSquareRadius));
-			}
-			//update the center
-			node.center = sumP.toFloat();
-#else
-			if (node.pointCount > 1)
-			{
-				node.radius = static_cast<float>(bbox.getDiagNormd());
-			}
-			node.center = bbox.getCenter().toFloat();
-#endif
+	//! Computes the center and the radius of a leaf node (from its points)
+	void computeLeafGeometry(ccPointCloudLOD::Node& node) const
+	{
+		const ccOctree::cellsContainer& cellCodes = m_octree->pointsAndTheirCellCodes();
+
+		CCVector3d sumP(0, 0, 0);
+		for (uint32_t i = 0; i < node.pointCount; ++i)
+		{
+			const CCVector3* P = m_cloud.getPoint(cellCodes[node.firstCodeIndex + i].theIndex);
+			sumP += P->toDouble();
 		}
 
-		//do we need to subdivide this cell?
-		if (node.pointCount > m_maxCountPerCell && node.level+1 <= m_maxLevel)
+		//compute the radius
+		//(the points of a leaf are still in the cache at this point)
+		if (node.pointCount > 1)
 		{
-			for (uint32_t i = 0; i < node.pointCount; )
+			sumP /= node.pointCount;
+			double maxSquareRadius = 0;
+			for (uint32_t i = 0; i < node.pointCount; ++i)
 			{
-				int32_t childNodeIndex = m_lod.newCell(node.level + 1);
-				ccPointCloudLOD::Node& childNode = m_lod.node(childNodeIndex, node.level + 1);
-				childNode.firstCodeIndex = node.firstCodeIndex + i;
-
-				uint8_t childIndex = fillNode(childNode);
-				node.childIndexes[childIndex] = childNodeIndex;
-				node.childCount++;
-				i += childNode.pointCount;
+				const CCVector3* P = m_cloud.getPoint(cellCodes[node.firstCodeIndex + i].theIndex);
+				double squareRadius = (P->toDouble() - sumP).norm2();
+				if (squareRadius > maxSquareRadius)
+				{
+					maxSquareRadius = squareRadius;
+				}
 			}
+			node.radius = static_cast<float>(sqrt(maxSquareRadius));
 		}
 
-		//return the node relative position
-		return static_cast<uint8_t>(currentTruncatedCellCode & 7);
+		//update the center
+		node.center = sumP.toFloat();
 	}
 
-	//! Fills a node (and returns its relative position)
-	uint8_t fillNode_flat(ccPointCloudLOD::Node& node) const
+	//! Computes the center and the radius of a node from its children
+	/** The radius is the one of the smallest sphere centered on the points barycenter
+		that contains all the children spheres.
+	**/
+	void computeNodeGeometryFromChildren(ccPointCloudLOD::Node& node) const
 	{
-		const ccOctree::cellsContainer& cellCodes = m_octree->pointsAndTheirCellCodes();
-		const unsigned char bitDec = CCCoreLib::DgmOctree::GET_BIT_SHIFT(node.level);
-		const CCCoreLib::DgmOctree::CellCode currentTruncatedCellCode = (cellCodes[node.firstCodeIndex].theCode >> bitDec);
-
-		//first count the number of points and compute their center
+		CCVector3d sumP(0, 0, 0);
+		for (int32_t childIndex : node.childIndexes)
 		{
-			node.pointCount = 0;
-			CCVector3d sumP(0, 0, 0);
-			for (uint32_t codeIndex = node.firstCodeIndex; codeIndex < cellCodes.size() && (cellCodes[codeIndex].theCode >> bitDec) == currentTruncatedCellCode; ++codeIndex)
+			if (childIndex >= 0)
 			{
-				++node.pointCount;
-				const CCVector3* P = m_cloud.getPoint(cellCodes[codeIndex].theIndex);
-				sumP += *P;
+				const ccPointCloudLOD::Node& childNode = m_lod.node(childIndex, node.level + 1);
+				sumP += childNode.center.toDouble() * childNode.pointCount;
 			}
+		}
+		sumP /= node.pointCount;
 
-			//compute the radius
-			if (node.pointCount > 1)
+		double radius = 0;
+		for (int32_t childIndex : node.childIndexes)
+		{
+			if (childIndex >= 0)
 			{
-				sumP /= node.pointCount;
-				double maxSquareRadius = 0;
-				for (uint32_t i = 0; i < node.pointCount; ++i)
-				{
-					const CCVector3* P = m_cloud.getPoint(cellCodes[node.firstCodeIndex + i].theIndex);
-					double squareRadius = (P->toDouble() - sumP).norm2();
-					if (squareRadius > maxSquareRadius)
-					{
-						maxSquareRadius = squareRadius;
-					}
-				}
-				node.radius = static_cast<float>(sqrt(maxSquareRadius));
+				const ccPointCloudLOD::Node& childNode = m_lod.node(childIndex, node.level + 1);
+				radius = std::max(radius, (childNode.center.toDouble() - sumP).norm() + childNode.radius);
 			}
-
-			//update the center
-			node.center = sumP.toFloat();
 		}
 
-		//return the node relative position
-		return static_cast<uint8_t>(currentTruncatedCellCode & 7);
+		node.center = sumP.toFloat();
+		node.radius = static_cast<float>(radius);
 	}
 
 	//reimplemented from QThread
@@ -219,26 +218,13 @@ protected:
 		m_maxLevel = static_cast<uint8_t>(std::max<size_t>(1, m_lod.m_levels.size())) - 1;
 		assert(m_maxLevel <= CCCoreLib::DgmOctree::MAX_OCTREE_LEVEL);
 
-#if 0 //recursive path
-		//recursive
-		fillNode(m_lod.root());
-
-		m_lod.shrink_to_fit();
-		//m_lod.updateMaxRadii();
-		//m_lod.setMaxLevel(m_maxLevel);
-
-		for (size_t i = 1; i < m_lod.m_levels.size(); ++i)
-		{
-			ccLog::Print(QString("[LoD] Level %1: %2 cells").arg(i).arg(m_lod.m_levels[i].data.size()));
-		}
-
-#else //layer by layer
+		//1st step: the structure of the tree (only based on the cell codes)
 
 		//init with root node
-		fillNode_flat(m_lod.root());
+		countNode(m_lod.root());
 
 		//first we allow the division of nodes as deep as possible but with a minimum number of points per cell
-		for (uint8_t currentLevel = 0; currentLevel < m_maxLevel; ++currentLevel)
+		for (uint8_t currentLevel = 0; currentLevel + 1 < m_maxLevel; ++currentLevel)
 		{
 			ccPointCloudLOD::Level& level = m_lod.m_levels[currentLevel];
 			if (level.data.empty())
@@ -246,42 +232,13 @@ protected:
 				break;
 			}
 
-			//update maxRadius for the previous level
-			//{
-			//	float maxRadius = 0;
-			//	for (ccPointCloudLOD::Node& n : level.data)
-			//	{
-			//		if (n.radius > maxRadius)
-			//		{
-			//			maxRadius = n.radius;
-			//		}
-			//	}
-			//	level.maxRadius = maxRadius;
-			//}
-
-			//the previous level is now ready!
-			ccLog::Print(QString("[LoD] Level %1: %2 cells").arg(currentLevel).arg(level.data.size()));
-
 			//now we can create the next level
-			if (currentLevel + 1 < m_maxLevel)
+			for (ccPointCloudLOD::Node& node : level.data)
 			{
-				for (ccPointCloudLOD::Node& node : level.data)
+				//do we need to subdivide this cell?
+				if (node.pointCount > m_maxCountPerCell)
 				{
-					//do we need to subdivide this cell?
-					if (node.pointCount > m_maxCountPerCell)
-					{
-						for (uint32_t i = 0; i < node.pointCount;)
-						{
-							int32_t childNodeIndex = m_lod.newCell(node.level + 1);
-							ccPointCloudLOD::Node& childNode = m_lod.node(childNodeIndex, node.level + 1);
-							childNode.firstCodeIndex = node.firstCodeIndex + i;
-
-							uint8_t childIndex = fillNode_flat(childNode);
-							node.childIndexes[childIndex] = childNodeIndex;
-							node.childCount++;
-							i += childNode.pointCount;
-						}
-					}
+					subdivideNode(node);
 				}
 			}
 		}
@@ -290,7 +247,6 @@ protected:
 		m_maxLevel = static_cast<uint8_t>(std::max<size_t>(1, m_lod.m_levels.size())) - 1;
 
 		//refinement step
-		if (true)
 		{
 			//we look at the 'main' depth level (with the most point)
 			uint8_t biggestLevel = 0;
@@ -302,19 +258,6 @@ protected:
 				}
 			}
 
-			//now compute the mean radius for this level
-			//double meanRadius = 0;
-			//{
-			//	const ccPointCloudLOD::Level& level = m_lod.m_levels[biggestLevel];
-			//	size_t cellCount = level.data.size();
-			//	for (size_t i = 0; i < cellCount; ++i)
-			//	{
-			//		meanRadius += level.data[i].radius;
-			//	}
-
-			//	meanRadius /= cellCount;
-			//}
-
 			//and divide again the cells (with a lower limit on the number of points)
 			biggestLevel = std::min<uint8_t>(biggestLevel, 10);
 			for (uint8_t currentLevel = 0; currentLevel < biggestLevel; ++currentLevel)
@@ -322,34 +265,65 @@ protected:
 				ccPointCloudLOD::Level& level = m_lod.m_levels[currentLevel];
 				assert(!level.data.empty());
 
-				size_t cellCountBefore = m_lod.m_levels[currentLevel+1].data.size();
 				for (ccPointCloudLOD::Node& node : level.data)
 				{
 					//do we need to subdivide this cell?
 					if (node.childCount == 0 && node.pointCount > 16)
 					{
-						for (uint32_t i = 0; i < node.pointCount;)
-						{
-							int32_t childNodeIndex = m_lod.newCell(node.level + 1);
-							ccPointCloudLOD::Node& childNode = m_lod.node(childNodeIndex, node.level + 1);
-							childNode.firstCodeIndex = node.firstCodeIndex + i;
-
-							uint8_t childIndex = fillNode_flat(childNode);
-							node.childIndexes[childIndex] = childNodeIndex;
-							node.childCount++;
-							i += childNode.pointCount;
-						}
+						subdivideNode(node);
 					}
 				}
-
-				size_t cellCountAfter = m_lod.m_levels[currentLevel+1].data.size();
-				ccLog::Print(QString("[LoD][pass 2] Level %1: %2 cells (+%3)").arg(currentLevel+1).arg(cellCountAfter).arg(cellCountAfter - cellCountBefore));
 			}
 
 			m_lod.shrink_to_fit();
-			m_maxLevel = static_cast<uint8_t>(std::max<size_t>(1, m_lod.m_levels.size()))-1;
+			m_maxLevel = static_cast<uint8_t>(std::max<size_t>(1, m_lod.m_levels.size())) - 1;
+		}
+
+		//2nd step: the geometry of the nodes, computed bottom-up (in parallel)
+		//each point is only visited once (by the leaf node it belongs to)
+		std::vector<ccPointCloudLOD::Node*> leaves;
+		try
+		{
+			for (ccPointCloudLOD::Level& level : m_lod.m_levels)
+			{
+				for (ccPointCloudLOD::Node& node : level.data)
+				{
+					if (node.childCount == 0)
+					{
+						leaves.push_back(&node);
+					}
+				}
+			}
+		}
+		catch (const std::bad_alloc&)
+		{
+			//not enough memory
+			ccLog::Warning(QString("[LoD] Failed to compute LOD structure on cloud '%1' (not enough memory)").arg(m_cloud.getName()));
+			m_lod.setState(ccPointCloudLOD::BROKEN);
+			return;
+		}
+
+		ccParallelFor(static_cast<int>(leaves.size()), [&](int i)
+		{
+			computeLeafGeometry(*leaves[i]);
+		}, c_nodeGrainSize);
+
+		for (int currentLevel = static_cast<int>(m_maxLevel) - 1; currentLevel >= 0; --currentLevel)
+		{
+			std::vector<ccPointCloudLOD::Node>& nodes = m_lod.m_levels[currentLevel].data;
+			ccParallelFor(static_cast<int>(nodes.size()), [&](int i)
+			{
+				if (nodes[i].childCount != 0)
+				{
+					computeNodeGeometryFromChildren(nodes[i]);
+				}
+			}, c_nodeGrainSize);
+		}
+
+		for (size_t i = 0; i < m_lod.m_levels.size(); ++i)
+		{
+			ccLog::Print(QString("[LoD] Level %1: %2 cells").arg(i).arg(m_lod.m_levels[i].data.size()));
 		}
-#endif
 
 		m_lod.setState(ccPointCloudLOD::INITIALIZED);
 
@@ -370,6 +344,8 @@ protected:
 ccPointCloudLOD::ccPointCloudLOD()
 	: m_indexMap(0)
 	, m_lastIndexMap(0)
+	, m_indexMapSize(0)
+	, m_nodeUpdates(nullptr)
 	, m_octree(nullptr)
 	, m_thread(nullptr)
 	, m_state(NOT_INITIALIZED)
@@ -393,8 +369,141 @@ size_t ccPointCloudLOD::memory() const
 	}
 	size_t nodeSize = sizeof(Node);
 	size_t nodesSize = totalNodeCount * nodeSize;
+	size_t indexesSize = m_pointIndexes.capacity() * sizeof(unsigned);
+
+	return nodesSize + indexesSize + thisSize;
+}
+
+bool ccPointCloudLOD::pointPicking(	const ccGenericPointCloud& cloud,
+									const CCVector2d& clickPos,
+									const ccGLCameraParameters& camera,
+									const ccGLMatrix* trans,
+									double pickWidth,
+									double pickHeight,
+									const std::function<bool(unsigned)>& isPickable,
+									int& nearestPointIndex,
+									double& nearestSquareDist) const
+{
+	nearestPointIndex = -1;
+	nearestSquareDist = -1.0;
+
+	if (m_levels.empty() || m_levels.front().data.empty())
+	{
+		assert(false);
+		return false;
+	}
+
+	//back project the clicked point in 3D
+	CCVector3d X(0, 0, 0);
+	if (!camera.unproject(CCVector3d(clickPos.x, clickPos.y, 0), X))
+	{
+		return false;
+	}
+
+	//scale factor between the (eye space) radius and the projected radius in pixels
+	const double* P = camera.projectionMat.data();
+	const double* MV = camera.modelViewMat.data();
+	const double pixelScale = P[5] * camera.viewport[3] / 2.0;
+
+	struct Entry
+	{
+		int32_t index;
+		uint8_t level;
+		double minDist; //min. distance between the node and the clicked point
+	};
+	std::vector<Entry> toVisit;
+	toVisit.push_back({ 0, 0, 0.0 });
+
+	while (!toVisit.empty())
+	{
+		Entry entry = toVisit.back();
+		toVisit.pop_back();
+
+		//the node can't contain a closer point
+		if (nearestPointIndex >= 0 && entry.minDist * entry.minDist > nearestSquareDist)
+		{
+			continue;
+		}
+
+		const Node& node = this->node(entry.index, entry.level);
+		CCVector3 C = node.center;
+		if (trans)
+		{
+			trans->apply(C);
+		}
+
+		//projected bounding sphere
+		CCVector3d C2D;
+		camera.project(C, C2D);
+		double projectedRadius = node.radius * pixelScale;
+		if (camera.perspective)
+		{
+			double depth = -(MV[2] * C.x + MV[6] * C.y + MV[10] * C.z + MV[14]);
+			projectedRadius = (depth > node.radius ? projectedRadius / depth : std::numeric_limits<double>::max());
+		}
+		if (	std::abs(C2D.x - clickPos.x) > pickWidth + projectedRadius
+			||	std::abs(C2D.y - clickPos.y) > pickHeight + projectedRadius)
+		{
+			//the node is out of the picking area
+			continue;
+		}
+
+		if (node.childCount == 0)
+		{
+			//leaf: we test the points
+			for (uint32_t i = 0; i < node.pointCount; ++i)
+			{
+				unsigned index = pointIndex(node.firstCodeIndex + i);
+				if (isPickable && !isPickable(index))
+				{
+					continue;
+				}
+
+				CCVector3 P3D = *cloud.getPoint(index);
+				if (trans)
+				{
+					trans->apply(P3D);
+				}
+
+				CCVector3d Q2D;
+				bool insideFrustum = false;
+				camera.project(P3D, Q2D, &insideFrustum);
+				if (	insideFrustum
+					&&	std::abs(Q2D.x - clickPos.x) <= pickWidth
+					&&	std::abs(Q2D.y - clickPos.y) <= pickHeight)
+				{
+					const double squareDist = (X - P3D.toDouble()).norm2d();
+					if (nearestPointIndex < 0 || squareDist < nearestSquareDist)
+					{
+						nearestSquareDist = squareDist;
+						nearestPointIndex = static_cast<int>(index);
+					}
+				}
+			}
+		}
+		else
+		{
+			//the nearest children will be visited first
+			size_t firstChild = toVisit.size();
+			for (int32_t childIndex : node.childIndexes)
+			{
+				if (childIndex >= 0)
+				{
+					const Node& child = this->node(childIndex, node.level + 1);
+					CCVector3 childC = child.center;
+					if (trans)
+					{
+						trans->apply(childC);
+					}
+					double minDist = std::max(0.0, (X - childC.toDouble()).normd() - child.radius);
+					toVisit.push_back({ childIndex, static_cast<uint8_t>(node.level + 1), minDist });
+				}
+			}
+			std::sort(toVisit.begin() + firstChild, toVisit.end(), [](const Entry& a, const Entry& b) { return a.minDist > b.minDist; });
+		}
+	}
 
-	return nodesSize + thisSize;
+	return (nearestPointIndex >= 0);
 }
 
 bool ccPointCloudLOD::init(ccPointCloud* cloud)
@@ -431,6 +540,7 @@ void ccPointCloudLOD::clearData()
 	m_levels.resize(1);
 	m_levels.front().data.resize(1);
 	m_levels.front().data.front() = Node();
+	LODIndexSet().swap(m_pointIndexes);
 }
 
 bool ccPointCloudLOD::initInternal(ccOctree::Shared octree)
@@ -514,8 +624,263 @@ void ccPointCloudLOD::shrink_to_fit()
 	m_levels.shrink_to_fit();
 }
 
+//! LOD node as stored in BIN files (persistent members only)
+struct StoredLODNode
+{
+	uint32_t	pointCount;
+	float		radius;
+	float		center[3];
+	int32_t		childIndexes[8];
+	uint32_t	firstCodeIndex;
+	uint8_t		level;
+	uint8_t		childCount;
+	uint8_t		padding[2];
+};
+static_assert(sizeof(StoredLODNode) == 60, "Unexpected stored LOD node size");
+
+//! Max number of point indexes saved in a single (chunked) array
+static const uint32_t c_storedIndexesBlockSize = (1 << 24);
+
+bool ccPointCloudLOD::toFile(QFile& out) const
+{
+	assert(out.isOpen() && (out.openMode() & QIODevice::WriteOnly));
+
+	//number of levels
+	uint32_t levelCount = static_cast<uint32_t>(m_levels.size());
+	if (out.write((const char*)&levelCount, 4) != 4)
+		return ccSerializableObject::WriteError();
+
+	//nodes (level by level)
+	std::vector<StoredLODNode> storedNodes;
+	for (const Level& level : m_levels)
+	{
+		uint32_t nodeCount = static_cast<uint32_t>(level.data.size());
+		if (out.write((const char*)&nodeCount, 4) != 4)
+			return ccSerializableObject::WriteError();
+
+		try
+		{
+			storedNodes.resize(nodeCount);
+		}
+		catch (const std::bad_alloc&)
+		{
+			return ccSerializableObject::MemoryError();
+		}
+
+		for (uint32_t i = 0; i < nodeCount; ++i)
+		{
+			const Node& node = level.data[i];
+			StoredLODNode& storedNode = storedNodes[i];
+			storedNode.pointCount = node.pointCount;
+			storedNode.radius = node.radius;
+			storedNode.center[0] = node.center.x;
+			storedNode.center[1] = node.center.y;
+			storedNode.center[2] = node.center.z;
+			std::copy(node.childIndexes.begin(), node.childIndexes.end(), storedNode.childIndexes);
+			storedNode.firstCodeIndex = node.firstCodeIndex;
+			storedNode.level = node.level;
+			storedNode.childCount = node.childCount;
+			storedNode.padding[0] = storedNode.padding[1] = 0;
+		}
+
+		if (!ccSerializationHelper::WriteChunkedArrayData(out, reinterpret_cast<const char*>(storedNodes.data()), storedNodes.size(), sizeof(StoredLODNode)))
+			return false;
+	}
+
+	//point indexes in the LOD order (by blocks, to avoid duplicating the octree codes in memory)
+	uint32_t indexCount = static_cast<uint32_t>(m_octree ? m_octree->pointsAndTheirCellCodes().size() : m_pointIndexes.size());
+	if (out.write((const char*)&indexCount, 4) != 4)
+		return ccSerializableObject::WriteError();
+
+	std::vector<uint32_t> indexes;
+	for (uint32_t blockStart = 0; blockStart < indexCount; blockStart += c_storedIndexesBlockSize)
+	{
+		uint32_t blockSize = std::min(c_storedIndexesBlockSize, indexCount - blockStart);
+		try
+		{
+			indexes.resize(blockSize);
+		}
+		catch (const std::bad_alloc&)
+		{
+			return ccSerializableObject::MemoryError();
+		}
+
+		for (uint32_t i = 0; i < blockSize; ++i)
+		{
+			indexes[i] = pointIndex(blockStart + i);
+		}
+
+		if (!ccSerializationHelper::WriteChunkedArrayData(out, reinterpret_cast<const char*>(indexes.data()), indexes.size(), sizeof(uint32_t)))
+			return false;
+	}
+
+	return true;
+}
+
+bool ccPointCloudLOD::fromFile(QFile& in, int flags, unsigned pointCount)
+{
+	assert(in.isOpen() && (in.openMode() & QIODevice::ReadOnly));
+
+	//clear the structure (just in case)
+	clear();
+
+	QMutexLocker locker(&m_mutex);
+
+	//number of levels
+	uint32_t levelCount = 0;
+	if (in.read((char*)&levelCount, 4) != 4)
+		return ccSerializableObject::ReadError();
+	if (levelCount == 0 || levelCount > CCCoreLib::DgmOctree::MAX_OCTREE_LEVEL + 1)
+		return ccSerializableObject::CorruptError();
+
+	try
+	{
+		m_levels.resize(levelCount);
+	}
+	catch (const std::bad_alloc&)
+	{
+		return ccSerializableObject::MemoryError();
+	}
+
+	//nodes (level by level)
+	std::vector<StoredLODNode> storedNodes;
+	for (uint32_t l = 0; l < levelCount; ++l)
+	{
+		uint32_t nodeCount = 0;
+		if (in.read((char*)&nodeCount, 4) != 4)
+		{
+			m_levels.clear();
+			return ccSerializableObject::ReadError();
+		}
+		if ((l == 0 && nodeCount != 1) || (l != 0 && nodeCount == 0))
+		{
+			m_levels.clear();
+			return ccSerializableObject::CorruptError();
+		}
+
+		try
+		{
+			storedNodes.resize(nodeCount);
+			m_levels[l].data.resize(nodeCount, Node(static_cast<uint8_t>(l)));
+		}
+		catch (const std::bad_alloc&)
+		{
+			m_levels.clear();
+			return ccSerializableObject::MemoryError();
+		}
+
+		if (!ccSerializationHelper::ReadChunkedArrayData(in, reinterpret_cast<char*>(storedNodes.data()), storedNodes.size(), sizeof(StoredLODNode), flags))
+		{
+			m_levels.clear();
+			return false;
+		}
+
+		for (uint32_t i = 0; i < nodeCount; ++i)
+		{
+			const StoredLODNode& storedNode = storedNodes[i];
+			Node& node = m_levels[l].data[i];
+			node.pointCount = storedNode.pointCount;
+			node.radius = storedNode.radius;
+			node.center = CCVector3f(storedNode.center[0], storedNode.center[1], storedNode.center[2]);
+			std::copy(storedNode.childIndexes, storedNode.childIndexes + 8, node.childIndexes.begin());
+			node.firstCodeIndex = storedNode.firstCodeIndex;
+			node.childCount = storedNode.childCount;
+
+			//consistency checks
+			if (	storedNode.level != l
+				||	static_cast<uint64_t>(node.firstCodeIndex) + node.pointCount > pointCount)
+			{
+				m_levels.clear();
+				return ccSerializableObject::CorruptError();
+			}
+		}
+	}
+
+	//check the children indexes
+	for (uint32_t l = 0; l < levelCount; ++l)
+	{
+		const int32_t childLevelSize = (l + 1 < levelCount ? static_cast<int32_t>(m_levels[l + 1].data.size()) : 0);
+		for (const Node& node : m_levels[l].data)
+		{
+			uint8_t childCount = 0;
+			for (int32_t childIndex : node.childIndexes)
+			{
+				//-1 = no child
+				if (childIndex < -1 || childIndex >= childLevelSize)
+				{
+					m_levels.clear();
+					return ccSerializableObject::CorruptError();
+				}
+				if (childIndex >= 0)
+				{
+					++childCount;
+				}
+			}
+			if (childCount != node.childCount)
+			{
+				m_levels.clear();
+				return ccSerializableObject::CorruptError();
+			}
+		}
+	}
+
+	//point indexes in the LOD order
+	uint32_t indexCount = 0;
+	if (in.read((char*)&indexCount, 4) != 4)
+	{
+		m_levels.clear();
+		return ccSerializableObject::ReadError();
+	}
+	if (indexCount != pointCount)
+	{
+		m_levels.clear();
+		return ccSerializableObject::CorruptError();
+	}
+
+	try
+	{
+		m_pointIndexes.resize(indexCount);
+	}
+	catch (const std::bad_alloc&)
+	{
+		m_levels.clear();
+		return ccSerializableObject::MemoryError();
+	}
+
+	for (uint32_t blockStart = 0; blockStart < indexCount; blockStart += c_storedIndexesBlockSize)
+	{
+		uint32_t blockSize = std::min(c_storedIndexesBlockSize, indexCount - blockStart);
+		static_assert(sizeof(LODIndexSet::value_type) == sizeof(uint32_t), "Unexpected index size");
+		if (!ccSerializationHelper::ReadChunkedArrayData(in, reinterpret_cast<char*>(m_pointIndexes.data() + blockStart), blockSize, sizeof(uint32_t), flags))
+		{
+			m_levels.clear();
+			LODIndexSet().swap(m_pointIndexes);
+			return false;
+		}
+	}
+
+	for (unsigned index : m_pointIndexes)
+	{
+		if (index >= pointCount)
+		{
+			m_levels.clear();
+			LODIndexSet().swap(m_pointIndexes);
+			return ccSerializableObject::CorruptError();
+		}
+	}
+
+	//no need for an octree
+	m_octree.clear();
+	m_state = INITIALIZED;
+
+	return true;
+}
+
 void ccPointCloudLOD::clear()
 {
+	waitForPreparedIndexMap(true);
+	m_preparedVisibility.valid = false;
+
 	if (m_thread && m_thread->isRunning())
 	{
 		m_thread->terminate();
@@ -531,6 +896,7 @@ void ccPointCloudLOD::clear()
 	}
 
 	m_levels.clear();
+	LODIndexSet().swap(m_pointIndexes);
 	m_state = NOT_INITIALIZED;
 
 	m_mutex.unlock();
@@ -547,11 +913,12 @@ void ccPointCloudLOD::resetVisibility()
 
 	for (size_t l = 0; l < m_levels.size(); ++l)
 	{
-		for (Node& n : m_levels[l].data)
+		std::vector<Node>& data = m_levels[l].data;
+		ccParallelFor(static_cast<int>(data.size()), [&](int i)
 		{
-			n.displayedPointCount = 0;
-			n.intersection = Frustum::INSIDE;
-		}
+			data[i].displayedPointCount = 0;
+			data[i].intersection = Frustum::INSIDE;
+		}, c_nodeGrainSize);
 	}
 }
 
@@ -598,7 +965,7 @@ public:
 		}
 	}
 
-	uint32_t flag(ccPointCloudLOD::Node& node)
+	void test(ccPointCloudLOD::Node& node)
 	{
 		node.intersection = m_frustum.sphereInFrustum(node.center, node.radius);
 		if (m_hasClipPlanes && node.intersection != Frustum::OUTSIDE)
@@ -624,6 +991,11 @@ public:
 				}
 			}
 		}
+	}
+
+	uint32_t flag(ccPointCloudLOD::Node& node)
+	{
+		test(node);
 
 		uint32_t visibleCount = 0;
 		switch (node.intersection)
@@ -670,6 +1042,114 @@ public:
 		return visibleCount;
 	}
 
+	//! Flags the nodes above a given level and collects the (partially visible) subtrees starting at this level
+	void flagTop(ccPointCloudLOD::Node& node, unsigned char subtreeLevel, std::vector<ccPointCloudLOD::Node*>& subtrees)
+	{
+		if (node.level == subtreeLevel)
+		{
+			subtrees.push_back(&node);
+			return;
+		}
+
+		test(node);
+
+		switch (node.intersection)
+		{
+		case Frustum::INTERSECT:
+			if (node.level < m_maxLevel && node.childCount)
+			{
+				for (int i = 0; i < 8; ++i)
+				{
+					if (node.childIndexes[i] >= 0)
+					{
+						flagTop(m_lod.node(node.childIndexes[i], node.level + 1), subtreeLevel, subtrees);
+					}
+				}
+			}
+			break;
+
+		case Frustum::OUTSIDE:
+			propagateFlag(node, Frustum::OUTSIDE);
+			break;
+
+		default:
+			break;
+		}
+	}
+
+	//! Counts the visible points of the nodes above a given level (once the subtrees have been flagged)
+	/** The subtrees must be visited in the same order as in flagTop.
+	**/
+	uint32_t countTop(ccPointCloudLOD::Node& node, unsigned char subtreeLevel, const std::vector<uint32_t>& subtreeCounts, size_t& subtreeIndex)
+	{
+		if (node.level == subtreeLevel)
+		{
+			assert(subtreeIndex < subtreeCounts.size());
+			return subtreeCounts[subtreeIndex++];
+		}
+
+		uint32_t visibleCount = 0;
+		switch (node.intersection)
+		{
+		case Frustum::INSIDE:
+			visibleCount = node.pointCount;
+			break;
+
+		case Frustum::INTERSECT:
+			if (node.level < m_maxLevel && node.childCount)
+			{
+				for (int i = 0; i < 8; ++i)
+				{
+					if (node.childIndexes[i] >= 0)
+					{
+						visibleCount += countTop(m_lod.node(node.childIndexes[i], node.level + 1), subtreeLevel, subtreeCounts, subtreeIndex);
+					}
+				}
+
+				if (visibleCount == 0)
+				{
+					//as no point is visible we can flag this node as being outside/invisible
+					node.intersection = Frustum::OUTSIDE;
+				}
+			}
+			else
+			{
+				visibleCount = node.pointCount;
+			}
+			break;
+
+		default:
+			break;
+		}
+
+		return visibleCount;
+	}
+
+	//! Flags all the nodes (the subtrees starting at a given level are processed in parallel)
+	uint32_t flagParallel(ccPointCloudLOD::Node& root, unsigned char subtreeLevel)
+	{
+		std::vector<ccPointCloudLOD::Node*> subtrees;
+		std::vector<uint32_t> subtreeCounts;
+		try
+		{
+			flagTop(root, subtreeLevel, subtrees);
+			subtreeCounts.resize(subtrees.size(), 0);
+		}
+		catch (const std::bad_alloc&)
+		{
+			//not enough memory: we fall back to the standard process
+			return flag(root);
+		}
+
+		ccParallelFor(static_cast<int>(subtrees.size()), [&](int i)
+		{
+			subtreeCounts[i] = flag(*subtrees[i]);
+		});
+
+		size_t subtreeIndex = 0;
+		return countTop(root, subtreeLevel, subtreeCounts, subtreeIndex);
+	}
+
 	ccPointCloudLOD& m_lod;
 	const Frustum& m_frustum;
 	unsigned char m_maxLevel;
@@ -686,6 +1166,10 @@ uint32_t ccPointCloudLOD::flagVisibility(const Frustum& frustum, ccClipPlaneSet*
 		return 0;
 	}
 
+	//the index map prepared for the previous frame (if any) is now outdated
+	waitForPreparedIndexMap(true);
+	m_preparedVisibility.valid = false;
+
 	resetVisibility();
 
 	PointCloudLODVisibilityFlagger lodVisibility(*this, frustum, static_cast<unsigned char>(m_levels.size()));
@@ -694,19 +1178,104 @@ uint32_t ccPointCloudLOD::flagVisibility(const Frustum& frustum, ccClipPlaneSet*
 		lodVisibility.setClipPlanes(*clipPlanes);
 	}
 
-	m_currentState.visiblePoints = lodVisibility.flag(root());
+	if (m_levels.size() > s_parallelFlagLevel)
+	{
+		m_currentState.visiblePoints = lodVisibility.flagParallel(root(), s_parallelFlagLevel);
+	}
+	else
+	{
+		m_currentState.visiblePoints = lodVisibility.flag(root());
+	}
 
 	return m_currentState.visiblePoints;
 }
 
-uint32_t ccPointCloudLOD::addNPointsToIndexMap(Node& node, uint32_t count)
+void ccPointCloudLOD::prepareVisibility(const ccGLMatrixd& modelViewMat, const ccGLMatrixd& projectionMat, ccClipPlaneSet* clipPlanes/*=nullptr*/)
 {
-	if (m_indexMap.capacity() == 0)
+	if (m_state != INITIALIZED)
 	{
-		assert(false);
-		return 0;
+		return;
 	}
-	
+
+	flagVisibility(Frustum(modelViewMat, projectionMat), clipPlanes);
+
+	m_preparedVisibility.modelViewMat = modelViewMat;
+	m_preparedVisibility.projectionMat = projectionMat;
+	try
+	{
+		m_preparedVisibility.clipPlanes = (clipPlanes ? *clipPlanes : ccClipPlaneSet());
+	}
+	catch (const std::bad_alloc&)
+	{
+		//not enough memory
+		return;
+	}
+	m_preparedVisibility.valid = true;
+}
+
+void ccPointCloudLOD::PrepareVisibility(const std::vector<VisibilityJob>& jobs, const ccGLMatrixd& projectionMat)
+{
+	ccParallelFor(static_cast<int>(jobs.size()), [&](int i)
+	{
+		const VisibilityJob& job = jobs[i];
+		assert(job.lod);
+		job.lod->prepareVisibility(job.modelViewMat, projectionMat, job.clipPlanes);
+	});
+}
+
+//! Returns whether two matrices are the same (up to the float precision of the OpenGL matrix stack)
+static bool SameMatrices(const ccGLMatrixd& A, const ccGLMatrixd& B)
+{
+	const double* a = A.data();
+	const double* b = B.data();
+	for (unsigned i = 0; i < OPENGL_MATRIX_SIZE; ++i)
+	{
+		if (std::abs(a[i] - b[i]) > 1.0e-5 * (1.0 + std::abs(a[i])))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+bool ccPointCloudLOD::usePreparedVisibility(const ccGLMatrixd& modelViewMat, const ccGLMatrixd& projectionMat, const ccClipPlaneSet* clipPlanes/*=nullptr*/)
+{
+	if (!m_preparedVisibility.valid)
+	{
+		return false;
+	}
+
+	//a prepared visibility can only be used once
+	m_preparedVisibility.valid = false;
+
+	if (	m_state != INITIALIZED
+		||	!SameMatrices(modelViewMat, m_preparedVisibility.modelViewMat)
+		||	!SameMatrices(projectionMat, m_preparedVisibility.projectionMat) )
+	{
+		return false;
+	}
+
+	//the clipping planes must be the same as well
+	size_t clipPlaneCount = (clipPlanes ? clipPlanes->size() : 0);
+	if (clipPlaneCount != m_preparedVisibility.clipPlanes.size())
+	{
+		return false;
+	}
+	for (size_t i = 0; i < clipPlaneCount; ++i)
+	{
+		const Tuple4Tpl<double>& eq1 = (*clipPlanes)[i].equation;
+		const Tuple4Tpl<double>& eq2 = m_preparedVisibility.clipPlanes[i].equation;
+		if (eq1.x != eq2.x || eq1.y != eq2.y || eq1.z != eq2.z || eq1.w != eq2.w)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+uint32_t ccPointCloudLOD::addNPointsToIndexMap(Node& node, uint32_t count)
+{
 	uint32_t displayedCount = 0;
 
 	if (node.childCount)
@@ -759,57 +1328,63 @@ uint32_t ccPointCloudLOD::addNPointsToIndexMap(Node& node, uint32_t count)
 		uint32_t iStop = std::min(node.displayedPointCount + count, node.pointCount);
 
 		displayedCount = iStop - node.displayedPointCount;
-		assert(m_indexMap.size() + displayedCount <= m_indexMap.capacity());
 
-		const ccOctree::cellsContainer& cellCodes = m_octree->pointsAndTheirCellCodes();
-		for (uint32_t i = node.displayedPointCount; i < iStop; ++i)
+		if (displayedCount != 0)
 		{
-			unsigned pointIndex = cellCodes[node.firstCodeIndex + i].theIndex;
-			m_indexMap.push_back(pointIndex);
+			//the indexes will be written afterwards (in parallel)
+			m_indexMapRanges.push_back({ node.firstCodeIndex + node.displayedPointCount, displayedCount, m_indexMapSize });
+			m_indexMapSize += displayedCount;
 		}
 	}
 
+	if (m_nodeUpdates && displayedCount != 0)
+	{
+		//the map is prepared in the background: we record the update in case it is discarded
+		m_nodeUpdates->push_back({ &node, displayedCount });
+	}
 	node.displayedPointCount += displayedCount;
 
 	return displayedCount;
 }
 
-LODIndexSet& ccPointCloudLOD::getIndexMap(unsigned char level, unsigned& maxCount, unsigned& remainingPointsAtThisLevel)
+void ccPointCloudLOD::buildIndexMap(unsigned char level, unsigned& maxCount, unsigned& remainingPointsAtThisLevel, LODIndexSet& indexMap)
 {
 	remainingPointsAtThisLevel = 0;
-	m_lastIndexMap.clear();
+	indexMap.clear();
 
-	if (!m_octree || level >= m_levels.size())
+	if ((!m_octree && m_pointIndexes.empty()) || level >= m_levels.size())
 	{
 		assert(false);
 		maxCount = 0;
-		return m_lastIndexMap; //empty
+		return; //empty
 	}
 
 	if (m_state != INITIALIZED)
 	{
 		maxCount = 0;
-		return m_lastIndexMap; //empty
+		return; //empty
 	}
 
 	if (m_currentState.displayedPoints >= m_currentState.visiblePoints)
 	{
 		//assert(false);
 		maxCount = 0;
-		return m_lastIndexMap; //empty
+		return; //empty
 	}
 
-	m_indexMap.clear();
 	try
 	{
-		m_indexMap.reserve(maxCount);
+		indexMap.reserve(maxCount);
 	}
 	catch (const std::bad_alloc&)
 	{
 		//not enough memory
-		return m_lastIndexMap; //empty
+		return; //empty
 	}
 
+	m_indexMapRanges.clear();
+	m_indexMapSize = 0;
+
 	Level& l = m_levels[level];
 	uint32_t thisPassDisplayCount = 0;
 
@@ -845,10 +1420,10 @@ LODIndexSet& ccPointCloudLOD::getIndexMap(unsigned char level, unsigned& maxCoun
 				double ratio = static_cast<double>(nodeRemainingCount) / m_currentState.unfinishedPoints;
 				nodeMaxCount = static_cast<uint32_t>(ceil(ratio * maxCount));
 				//safety check
-				if (m_indexMap.size() + nodeMaxCount >= maxCount)
+				if (m_indexMapSize + nodeMaxCount >= maxCount)
 				{
-					assert(maxCount >= m_indexMap.size());
-					nodeMaxCount = maxCount - static_cast<uint32_t>(m_indexMap.size());
+					assert(maxCount >= m_indexMapSize);
+					nodeMaxCount = maxCount - m_indexMapSize;
 
 					earlyStop = true;
 					earlyStopIndex = i;
@@ -861,7 +1436,7 @@ LODIndexSet& ccPointCloudLOD::getIndexMap(unsigned char level, unsigned& maxCoun
 			assert(nodeDisplayCount <= nodeMaxCount);
 			
 			thisPassDisplayCount += nodeDisplayCount;
-			assert(thisPassDisplayCount == m_indexMap.size());
+			assert(thisPassDisplayCount == m_indexMapSize);
 			remainingPointsAtThisLevel += (node.pointCount - node.displayedPointCount);
 		}
 	}
@@ -903,10 +1478,10 @@ LODIndexSet& ccPointCloudLOD::getIndexMap(unsigned char level, unsigned& maxCoun
 				double ratio = static_cast<double>(nodeRemainingCount) / totalRemainingCount;
 				nodeMaxCount = static_cast<uint32_t>(ceil(ratio * mapFreeSize));
 				//safety check
-				if (m_indexMap.size() + nodeMaxCount >= maxCount)
+				if (m_indexMapSize + nodeMaxCount >= maxCount)
 				{
-					assert(maxCount >= m_indexMap.size());
-					nodeMaxCount = maxCount - static_cast<uint32_t>(m_indexMap.size());
+					assert(maxCount >= m_indexMapSize);
+					nodeMaxCount = maxCount - m_indexMapSize;
 
 					earlyStop = true;
 					earlyStopIndex = i;
@@ -919,7 +1494,7 @@ LODIndexSet& ccPointCloudLOD::getIndexMap(unsigned char level, unsigned& maxCoun
 			assert(nodeDisplayCount <= nodeMaxCount);
 
 			thisPassDisplayCount += nodeDisplayCount;
-			assert(thisPassDisplayCount == m_indexMap.size());
+			assert(thisPassDisplayCount == m_indexMapSize);
 
 			if (node.childCount == 0)
 			{
@@ -928,8 +1503,21 @@ LODIndexSet& ccPointCloudLOD::getIndexMap(unsigned char level, unsigned& maxCoun
 		}
 	}
 
-	maxCount = static_cast<unsigned>(m_indexMap.size());
-	m_currentState.displayedPoints += static_cast<uint32_t>(m_indexMap.size());
+	//now we can write the indexes (in parallel)
+	assert(m_indexMapSize <= indexMap.capacity());
+	indexMap.resize(m_indexMapSize);
+	ccParallelFor(static_cast<int>(m_indexMapRanges.size()), [&](int i)
+	{
+		const CodeRange& range = m_indexMapRanges[i];
+		for (uint32_t j = 0; j < range.count; ++j)
+		{
+			indexMap[range.offset + j] = pointIndex(range.firstCodeIndex + j);
+		}
+	});
+	m_indexMapRanges.clear();
+
+	maxCount = m_indexMapSize;
+	m_currentState.displayedPoints += m_indexMapSize;
 
 	if (earlyStop)
 	{
@@ -960,9 +1548,98 @@ LODIndexSet& ccPointCloudLOD::getIndexMap(unsigned char level, unsigned& maxCoun
 		m_currentState.unfinishedLevel = -1;
 		m_currentState.unfinishedPoints = 0;
 	}
-	
-	m_lastIndexMap = m_indexMap;
-	return m_indexMap;
+}
+
+LODIndexSet& ccPointCloudLOD::getIndexMap(unsigned char level, unsigned& maxCount, unsigned& remainingPointsAtThisLevel)
+{
+	if (m_preparedIndexMap.pending)
+	{
+		waitForPreparedIndexMap(false);
+
+		if (m_preparedIndexMap.level == level && m_preparedIndexMap.requestedCount == maxCount)
+		{
+			//the map has been prepared in the background
+			maxCount = m_preparedIndexMap.count;
+			remainingPointsAtThisLevel = m_preparedIndexMap.remainingPointsAtThisLevel;
+			m_lastIndexMap.swap(m_preparedIndexMap.indexes);
+			m_preparedIndexMap.nodeUpdates.clear();
+			m_preparedIndexMap.pending = false;
+			return m_lastIndexMap;
+		}
+		else
+		{
+			//the map has been prepared for nothing (its points must be displayed by the map we are going to build)
+			discardPreparedIndexMap();
+			ccLog::PrintDebug("[LoD] Prepared index map discarded");
+		}
+	}
+
+	//we build the map in a working buffer, as the last map may still be in use
+	buildIndexMap(level, maxCount, remainingPointsAtThisLevel, m_indexMap);
+	m_lastIndexMap.swap(m_indexMap);
+
+	return m_lastIndexMap;
+}
+
+void ccPointCloudLOD::prepareIndexMap(unsigned char level, unsigned maxCount)
+{
+	waitForPreparedIndexMap(true);
+
+	if (m_state != INITIALIZED || allDisplayed())
+	{
+		return;
+	}
+
+	m_preparedIndexMap.level = level;
+	m_preparedIndexMap.requestedCount = maxCount;
+	m_preparedIndexMap.count = maxCount;
+	m_preparedIndexMap.remainingPointsAtThisLevel = 0;
+	m_preparedIndexMap.previousState = m_currentState;
+	m_preparedIndexMap.nodeUpdates.clear();
+	m_preparedIndexMap.pending = true;
+
+	//the map is built by the global thread pool (shared with the other parallel tasks)
+	m_preparedIndexMap.task = QtConcurrent::run([this]()
+	{
+		m_nodeUpdates = &m_preparedIndexMap.nodeUpdates;
+		buildIndexMap(	m_preparedIndexMap.level,
+						m_preparedIndexMap.count,
+						m_preparedIndexMap.remainingPointsAtThisLevel,
+						m_preparedIndexMap.indexes);
+		m_nodeUpdates = nullptr;
+	});
+}
+
+void ccPointCloudLOD::waitForPreparedIndexMap(bool discard)
+{
+	if (!m_preparedIndexMap.pending)
+	{
+		return;
+	}
+
+	m_preparedIndexMap.task.waitForFinished();
+
+	if (discard)
+	{
+		discardPreparedIndexMap();
+	}
+}
+
+void ccPointCloudLOD::discardPreparedIndexMap()
+{
+	assert(m_preparedIndexMap.task.isFinished());
+
+	//restore the displayed point counts and the render state
+	for (const NodeUpdate& update : m_preparedIndexMap.nodeUpdates)
+	{
+		assert(update.node->displayedPointCount >= update.count);
+		update.node->displayedPointCount -= update.count;
+	}
+	m_currentState = m_preparedIndexMap.previousState;
+
+	m_preparedIndexMap.nodeUpdates.clear();
+	m_preparedIndexMap.indexes.clear();
+	m_preparedIndexMap.pending = false;
 }
 
 #include "ccPointCloudLOD.moc"
@@ -0,0 +1,551 @@
+//##########################################################################
+//#                                                                        #
+//#                              CLOUDCOMPARE                              #
+//#                                                                        #
+//#  This program is free software; you can redistribute it and/or modify  #
+//#  it under the terms of the GNU General Public License as published by  #
+//#  the Free Software Foundation; version 2 or later of the License.      #
+//#                                                                        #
+//#  This program is distributed in the hope that it will be useful,       #
+//#  but WITHOUT ANY WARRANTY; without even the implied warranty of        #
+//#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          #
+//#  GNU General Public License for more details.                          #
+//#                                                                        #
+//#                    COPYRIGHT: CloudCompare project                     #
+//#                                                                        #
+//##########################################################################
+
+#include "ccIncludeGL.h"
+
+#include "ccPointCloudLODPageCache.h"
+
+//Local
+#include "ccLog.h"
+#include "ccPointCloud.h"
+#include "ccScalarField.h"
+
+//Qt
+#include <QOpenGLContext>
+
+//system
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+//! Min number of points displayed per (visible) page
+static const uint32_t c_minDisplayedPointCount = 64;
+
+//! All the page caches (they share the memory budget of their GL context)
+static std::vector<ccPointCloudLODPageCache*> s_pageCaches;
+//! Last frame index (for all the caches)
+static uint64_t s_lastFrame = 0;
+//! First frame index of the current display frame (for all the caches)
+static uint64_t s_displayFrameStart = 0;
+
+ccPointCloudLODPageCache::ccPointCloudLODPageCache(ccPointCloud& cloud)
+	: m_cloud(cloud)
+	, m_queueIndex(0)
+	, m_memory(0)
+	, m_frame(0)
+	, m_context(nullptr)
+	, m_budgetReached(false)
+	, m_failed(false)
+{
+	s_pageCaches.push_back(this);
+}
+
+ccPointCloudLODPageCache::~ccPointCloudLODPageCache()
+{
+	//the buffers should have been released already (in the right GL context)
+	assert(m_lru.empty());
+
+	s_pageCaches.erase(std::remove(s_pageCaches.begin(), s_pageCaches.end(), this), s_pageCaches.end());
+}
+
+size_t ccPointCloudLODPageCache::SharedMemory(const QOpenGLContext* context)
+{
+	size_t memory = 0;
+	for (const ccPointCloudLODPageCache* cache : s_pageCaches)
+	{
+		if (cache->m_context == context)
+		{
+			memory += cache->m_memory;
+		}
+	}
+	return memory;
+}
+
+void ccPointCloudLODPageCache::release()
+{
+	for (uint32_t pageIndex : m_lru)
+	{
+		Page& page = m_pages[pageIndex];
+		page.buffer->destroy();
+		delete page.buffer;
+		page.buffer = nullptr;
+	}
+	m_lru.clear();
+
+	m_pages.clear();
+	m_pages.shrink_to_fit();
+	m_queue.clear();
+	m_queue.shrink_to_fit();
+	m_queueIndex = 0;
+	m_memory = 0;
+	m_context = nullptr;
+	m_content = Content();
+	m_budgetReached = false;
+	m_failed = false;
+}
+
+bool ccPointCloudLODPageCache::buildPages(const ccPointCloudLOD& lod)
+{
+	assert(m_pages.empty());
+
+	//we look for the biggest nodes with less than MAX_PAGE_POINT_COUNT points (or the leaves)
+	try
+	{
+		std::vector<const ccPointCloudLOD::Node*> nodes;
+		nodes.push_back(&lod.root());
+		while (!nodes.empty())
+		{
+			const ccPointCloudLOD::Node* node = nodes.back();
+			nodes.pop_back();
+
+			if (node->pointCount <= MAX_PAGE_POINT_COUNT || node->childCount == 0)
+			{
+				Page page;
+				page.level = node->level;
+				page.nodeIndex = static_cast<int32_t>(node - &lod.node(0, node->level));
+				page.pointCount = node->pointCount;
+				m_pages.push_back(page);
+			}
+			else
+			{
+				for (int32_t childIndex : node->childIndexes)
+				{
+					if (childIndex >= 0)
+					{
+						nodes.push_back(&lod.node(childIndex, node->level + 1));
+					}
+				}
+			}
+		}
+
+		m_queue.reserve(m_pages.size());
+	}
+	catch (const std::bad_alloc&)
+	{
+		m_pages.clear();
+		return false;
+	}
+
+	ccLog::PrintDebug(QString("[LoD] %1 pages for cloud '%2'").arg(m_pages.size()).arg(m_cloud.getName()));
+
+	return true;
+}
+
+bool ccPointCloudLODPageCache::startFrame(ccPointCloudLOD& lod, const ccGLCameraParameters& camera, const Content& content)
+{
+	m_queue.clear();
+	m_queueIndex = 0;
+	m_budgetReached = false;
+
+	if (m_failed)
+	{
+		return false;
+	}
+
+	if (content != m_content)
+	{
+		//the loaded pages are not valid anymore
+		release();
+		m_content = content;
+	}
+
+	if (m_pages.empty() && !buildPages(lod))
+	{
+		return false;
+	}
+
+	//a new display frame starts when a cache starts a second frame in the current one
+	if (m_frame >= s_displayFrameStart)
+	{
+		s_displayFrameStart = s_lastFrame + 1;
+	}
+	m_frame = ++s_lastFrame;
+
+	//scale factor between the (eye space) radius and the projected radius in pixels
+	const double* P = camera.projectionMat.data();
+	const double* MV = camera.modelViewMat.data();
+	const double pixelScale = P[5] * camera.viewport[3] / 2.0;
+
+	for (uint32_t i = 0; i < m_pages.size(); ++i)
+	{
+		Page& page = m_pages[i];
+		const ccPointCloudLOD::Node& node = lod.node(page.nodeIndex, page.level);
+		if (node.intersection == Frustum::OUTSIDE)
+		{
+			continue;
+		}
+
+		//projected radius (in pixels)
+		double projectedRadius = node.radius * pixelScale;
+		if (camera.perspective)
+		{
+			double depth = -(MV[2] * node.center.x + MV[6] * node.center.y + MV[10] * node.center.z + MV[14]);
+			projectedRadius = (depth > node.radius ? projectedRadius / depth : std::numeric_limits<double>::max());
+		}
+
+		//we display about 1 point per pixel
+		double displayedCount = std::min<double>(M_PI * projectedRadius * projectedRadius, page.pointCount);
+		page.displayedCount = std::min(page.pointCount, std::max(c_minDisplayedPointCount, static_cast<uint32_t>(std::ceil(displayedCount))));
+		page.priority = static_cast<float>(std::min<double>(projectedRadius, std::numeric_limits<float>::max()));
+
+		m_queue.push_back(i);
+	}
+
+	//the biggest pages first
+	std::sort(m_queue.begin(), m_queue.end(), [&](uint32_t a, uint32_t b) { return m_pages[a].priority > m_pages[b].priority; });
+
+	return true;
+}
+
+bool ccPointCloudLODPageCache::load(Page& page, const ccPointCloudLOD& lod)
+{
+	//progressive order: round-robin on the leaves of the page
+	std::vector<uint32_t> codeIndexes;
+	try
+	{
+		std::vector<std::pair<uint32_t, uint32_t>> ranges; //first code index + remaining points
+		std::vector<const ccPointCloudLOD::Node*> nodes;
+		nodes.push_back(&lod.node(page.nodeIndex, page.level));
+		while (!nodes.empty())
+		{
+			const ccPointCloudLOD::Node* node = nodes.back();
+			nodes.pop_back();
+			if (node->childCount == 0)
+			{
+				ranges.emplace_back(node->firstCodeIndex, node->pointCount);
+			}
+			else for (int32_t childIndex : node->childIndexes)
+			{
+				if (childIndex >= 0)
+				{
+					nodes.push_back(&lod.node(childIndex, node->level + 1));
+				}
+			}
+		}
+
+		codeIndexes.reserve(page.pointCount);
+		while (!ranges.empty())
+		{
+			for (std::pair<uint32_t, uint32_t>& range : ranges)
+			{
+				codeIndexes.push_back(range.first++);
+				--range.second;
+			}
+			ranges.erase(std::remove_if(ranges.begin(), ranges.end(), [](const std::pair<uint32_t, uint32_t>& range) { return range.second == 0; }), ranges.end());
+		}
+	}
+	catch (const std::bad_alloc&)
+	{
+		return false;
+	}
+	assert(codeIndexes.size() == page.pointCount);
+
+	//required memory (each array should start on a 4 bytes boundary)
+	const int count = static_cast<int>(page.pointCount);
+	int totalSizeBytes = (m_content.compact ? sizeof(GLshort) : sizeof(PointCoordinateType)) * count * 3;
+	if (m_content.hasColors)
+	{
+		page.colorShift = totalSizeBytes = ((totalSizeBytes + 3) & ~3);
+		totalSizeBytes += sizeof(ColorCompType) * count * 4;
+	}
+	if (m_content.hasNormals)
+	{
+		page.normalShift = totalSizeBytes = ((totalSizeBytes + 3) & ~3);
+		totalSizeBytes += sizeof(PointCoordinateType) * count * 3;
+	}
+	assert(static_cast<size_t>(totalSizeBytes) == pageSize(page));
+
+	//quantization parameters (relatively to the page node)
+	if (m_content.compact)
+	{
+		const ccPointCloudLOD::Node& node = lod.node(page.nodeIndex, page.level);
+		page.origin = node.center.toDouble();
+		page.scale = (node.radius > 0 ? static_cast<double>(node.radius) / 32767 : 1.0);
+	}
+
+	//page data
+	std::vector<char> data;
+	try
+	{
+		data.resize(totalSizeBytes);
+	}
+	catch (const std::bad_alloc&)
+	{
+		return false;
+	}
+
+	PointCoordinateType* _points = reinterpret_cast<PointCoordinateType*>(data.data());
+	GLshort* _quantizedPoints = reinterpret_cast<GLshort*>(data.data());
+	ColorCompType* _colors = reinterpret_cast<ColorCompType*>(data.data() + page.colorShift);
+	PointCoordinateType* _normals = reinterpret_cast<PointCoordinateType*>(data.data() + page.normalShift);
+	for (uint32_t codeIndex : codeIndexes)
+	{
+		unsigned pointIndex = lod.pointIndex(codeIndex);
+
+		const CCVector3* P = m_cloud.getPoint(pointIndex);
+		if (m_content.compact)
+		{
+			const CCVector3d Q = (P->toDouble() - page.origin) / page.scale;
+			for (unsigned d = 0; d < 3; ++d)
+			{
+				*_quantizedPoints++ = static_cast<GLshort>(std::max(-32767.0, std::min(std::round(Q.u[d]), 32767.0)));
+			}
+		}
+		else
+		{
+			*_points++ = P->x;
+			*_points++ = P->y;
+			*_points++ = P->z;
+		}
+
+		if (m_content.sourceSF)
+		{
+			const ccColor::Rgb* col = m_content.sourceSF->getValueColor(pointIndex);
+			if (!col)
+				col = &ccColor::lightGreyRGB;
+			*_colors++ = col->r;
+			*_colors++ = col->g;
+			*_colors++ = col->b;
+			*_colors++ = ccColor::MAX;
+		}
+		else if (m_content.hasColors)
+		{
+			const ccColor::Rgba& col = m_cloud.getPointColor(pointIndex);
+			*_colors++ = col.r;
+			*_colors++ = col.g;
+			*_colors++ = col.b;
+			*_colors++ = col.a;
+		}
+
+		if (m_content.hasNormals)
+		{
+			const CCVector3& N = m_cloud.getPointNormal(pointIndex);
+			*_normals++ = N.x;
+			*_normals++ = N.y;
+			*_normals++ = N.z;
+		}
+	}
+
+	//send it to the GPU
+	QGLBuffer* buffer = new QGLBuffer(QGLBuffer::VertexBuffer);
+	if (!buffer->create())
+	{
+		delete buffer;
+		return false;
+	}
+	buffer->setUsagePattern(QGLBuffer::StaticDraw);
+	if (!buffer->bind())
+	{
+		buffer->destroy();
+		delete buffer;
+		return false;
+	}
+	buffer->allocate(data.data(), totalSizeBytes);
+	bool success = (buffer->size() == totalSizeBytes);
+	buffer->release();
+	if (!success)
+	{
+		buffer->destroy();
+		delete buffer;
+		return false;
+	}
+
+	page.buffer = buffer;
+	page.sizeBytes = static_cast<size_t>(totalSizeBytes);
+	m_memory += page.sizeBytes;
+	m_context = QOpenGLContext::currentContext();
+
+	return true;
+}
+
+void ccPointCloudLODPageCache::unload(Page& page)
+{
+	assert(page.buffer);
+	page.buffer->destroy();
+	delete page.buffer;
+	page.buffer = nullptr;
+
+	assert(m_memory >= page.sizeBytes);
+	m_memory -= page.sizeBytes;
+	page.sizeBytes = 0;
+
+	m_lru.erase(page.lruIt);
+}
+
+size_t ccPointCloudLODPageCache::pageSize(const Page& page) const
+{
+	//same layout as in 'load'
+	size_t sizeBytes = (m_content.compact ? sizeof(GLshort) : sizeof(PointCoordinateType)) * page.pointCount * 3;
+	if (m_content.hasColors)
+	{
+		sizeBytes = ((sizeBytes + 3) & ~static_cast<size_t>(3)) + sizeof(ColorCompType) * page.pointCount * 4;
+	}
+	if (m_content.hasNormals)
+	{
+		sizeBytes = ((sizeBytes + 3) & ~static_cast<size_t>(3)) + sizeof(PointCoordinateType) * page.pointCount * 3;
+	}
+	return sizeBytes;
+}
+
+bool ccPointCloudLODPageCache::evictLeastRecentlyUsedPage()
+{
+	const QOpenGLContext* context = QOpenGLContext::currentContext();
+
+	//the least recently used page of each cache is the first of its LRU list
+	ccPointCloudLODPageCache* victim = nullptr;
+	for (ccPointCloudLODPageCache* cache : s_pageCaches)
+	{
+		if (cache->m_context != context || cache->m_lru.empty())
+		{
+			continue;
+		}
+		uint64_t lastFrame = cache->m_pages[cache->m_lru.front()].lastFrame;
+		if (lastFrame < s_displayFrameStart && (!victim || lastFrame < victim->m_pages[victim->m_lru.front()].lastFrame))
+		{
+			victim = cache;
+		}
+	}
+
+	if (!victim)
+	{
+		//all the loaded pages are displayed in the current frame
+		return false;
+	}
+
+	victim->unload(victim->m_pages[victim->m_lru.front()]);
+	return true;
+}
+
+void ccPointCloudLODPageCache::drawPage(QOpenGLFunctions_2_1* glFunc, Page& page, ccRenderingStats* stats)
+{
+	assert(page.buffer);
+	if (!page.buffer->bind())
+	{
+		return;
+	}
+
+	const GLbyte* start = nullptr; //fake pointer used to prevent warnings on Linux
+	glFunc->glVertexPointer(3, m_content.compact ? GL_SHORT : GL_COORD_TYPE, 0, nullptr);
+	if (m_content.hasColors)
+	{
+		glFunc->glColorPointer(4, GL_UNSIGNED_BYTE, 0, static_cast<const GLvoid*>(start + page.colorShift));
+	}
+	if (m_content.hasNormals)
+	{
+		glFunc->glNormalPointer(GL_COORD_TYPE, 0, static_cast<const GLvoid*>(start + page.normalShift));
+	}
+	page.buffer->release();
+
+	if (m_content.compact)
+	{
+		//the coordinates are quantized: we must apply the dequantization transformation
+		glFunc->glMatrixMode(GL_MODELVIEW);
+		glFunc->glPushMatrix();
+		glFunc->glTranslated(page.origin.x, page.origin.y, page.origin.z);
+		glFunc->glScaled(page.scale, page.scale, page.scale);
+	}
+
+	glFunc->glDrawArrays(GL_POINTS, 0, static_cast<GLsizei>(page.displayedCount));
+
+	if (m_content.compact)
+	{
+		glFunc->glPopMatrix();
+	}
+	if (stats)
+	{
+		stats->pointsDrawn += page.displayedCount;
+	}
+
+	//this page is now the most recently used one
+	page.lastFrame = m_frame;
+	m_lru.splice(m_lru.end(), m_lru, page.lruIt);
+}
+
+bool ccPointCloudLODPageCache::draw(QOpenGLFunctions_2_1* glFunc, const ccPointCloudLOD& lod, size_t memoryBudget, bool drawLoadedPages, ccRenderingStats* stats/*=nullptr*/)
+{
+	assert(glFunc);
+
+	//first the pages already loaded
+	if (drawLoadedPages)
+	{
+		for (uint32_t pageIndex : m_queue)
+		{
+			Page& page = m_pages[pageIndex];
+			if (page.buffer)
+			{
+				drawPage(glFunc, page, stats);
+			}
+		}
+	}
+
+	//then we load the missing ones (by priority)
+	uint32_t loadedPointCount = 0;
+	while (m_queueIndex < m_queue.size() && !m_budgetReached && !m_failed)
+	{
+		Page& page = m_pages[m_queue[m_queueIndex]];
+		if (page.buffer)
+		{
+			//already loaded
+			++m_queueIndex;
+			continue;
+		}
+
+		if (loadedPointCount != 0 && loadedPointCount + page.pointCount > MAX_LOADED_POINT_COUNT_PER_PASS)
+		{
+			//we'll continue in the next pass
+			break;
+		}
+
+		//evict the least recently used pages (of all the clouds, but not the ones drawn in this frame) if necessary
+		size_t pageSizeBytes = pageSize(page);
+		size_t sharedMemory = SharedMemory(QOpenGLContext::currentContext());
+		while (sharedMemory + pageSizeBytes > memoryBudget && evictLeastRecentlyUsedPage())
+		{
+			sharedMemory = SharedMemory(QOpenGLContext::currentContext());
+		}
+		if (sharedMemory + pageSizeBytes > memoryBudget)
+		{
+			//the pages displayed in this frame already fill the budget
+			m_budgetReached = true;
+			break;
+		}
+
+		if (!load(page, lod))
+		{
+			ccLog::Warning(QString("[LoD] Failed to load a page on the GPU (cloud '%1'): streaming disabled").arg(m_cloud.getName()));
+			m_failed = true;
+			break;
+		}
+		page.lruIt = m_lru.insert(m_lru.end(), m_queue[m_queueIndex]);
+		loadedPointCount += page.pointCount;
+		++m_queueIndex;
+		if (stats)
+		{
+			stats->uploadedBytes += page.sizeBytes;
+		}
+
+		drawPage(glFunc, page, stats);
+	}
+
+	//skip the pages that are already loaded (so that only the missing ones are reported)
+	while (m_queueIndex < m_queue.size() && m_pages[m_queue[m_queueIndex]].buffer)
+	{
+		++m_queueIndex;
+	}
+
+	return hasPendingPages();
+}
@@ -22,6 +22,7 @@
 
 //qCC_db
 #include "ccGenericPointCloud.h"
+#include "ccParallel.h"
 #include "ccPointCloud.h"
 #include "ccProgressDialog.h"
 #include "ccScalarField.h"
@@ -31,6 +32,7 @@
 #include <QMap>
 
 //System
+#include <atomic>
 #include <cassert>
 
 //default field names
@@ -168,6 +170,13 @@ bool ccRasterGrid::init(unsigned w,
 	return true;
 }
 
+//! Cell index of the points that fall outside of the grid
+static const unsigned c_outsideGrid = std::numeric_limits<unsigned>::max();
+//! Number of points projected between two progress updates
+static const unsigned c_projectionBlockSize = (1 << 20);
+//! Number of points projected by each thread at once
+static const unsigned c_projectionSubBlockSize = (1 << 14);
+
 //! Index and value
 struct IndexAndValue
 {
@@ -253,82 +262,108 @@ bool ccRasterGrid::fillWith(	ccGenericPointCloud* cloud,
 	//we always handle the colors (if any)
 	hasColors = cloud->hasColors();
 
-	//Array of pointers, each coresponding to a point in the cloud.
-	//Pointers are used to chain together points belonging to the same cell.
-	//'cloud->getPoint(n)' coresponds to 'pointRefList[n]'.
-	std::vector<void*> pointRefList;
+	//the points are first projected in the grid (in parallel)
+	std::vector<unsigned> pointCellIndexes;
 	try
 	{
-		pointRefList.resize(pointCount, nullptr);
+		pointCellIndexes.resize(pointCount, c_outsideGrid);
 	}
-	catch (const std::bad_alloc)
+	catch (const std::bad_alloc&)
 	{
 		ccLog::Error("Not enough memory");
 		return false;
 	}
 
-	for (unsigned n = 0; n < pointCount; ++n)
+	for (unsigned blockStart = 0; blockStart < pointCount; blockStart += c_projectionBlockSize)
 	{
-		//for each point
-		const CCVector3* P = cloud->getPoint(n);
-
-		//project it inside the grid
-		CCVector2i cellPos = computeCellPos(*P, X, Y);
+		const unsigned blockSize = std::min(c_projectionBlockSize, pointCount - blockStart);
+		const int subBlockCount = static_cast<int>((blockSize + c_projectionSubBlockSize - 1) / c_projectionSubBlockSize);
 
-		//we skip points that fall outside of the grid!
-		if (	cellPos.x < 0 || cellPos.x >= static_cast<int>(width)
-			||	cellPos.y < 0 || cellPos.y >= static_cast<int>(height) )
+		ccParallelFor(subBlockCount, [&](int k)
 		{
-			if (!nProgress.oneStep())
+			const unsigned start = blockStart + static_cast<unsigned>(k) * c_projectionSubBlockSize;
+			const unsigned stop = std::min(start + c_projectionSubBlockSize, blockStart + blockSize);
+			for (unsigned n = start; n < stop; ++n)
 			{
-				//process cancelled by the user
-				return false;
+				const CCVector3* P = cloud->getPoint(n);
+
+				//project it inside the grid
+				CCVector2i cellPos = computeCellPos(*P, X, Y);
+
+				//we skip points that fall outside of the grid!
+				if (	cellPos.x >= 0 && cellPos.x < static_cast<int>(width)
+					&&	cellPos.y >= 0 && cellPos.y < static_cast<int>(height) )
+				{
+					pointCellIndexes[n] = static_cast<unsigned>(cellPos.y) * width + static_cast<unsigned>(cellPos.x);
+				}
 			}
-			continue;
-		}
+		});
 
-		//update the cell statistics
-		ccRasterCell& aCell = rows[cellPos.y][cellPos.x];
-		
-		//update linked list of point references
-		if (aCell.nbPoints == 0)
+		if (!nProgress.steps(blockSize))
 		{
-			//if first point in cell, set head and tail to this reference
-			aCell.pointRefHead = pointRefList.data() + n;
-			aCell.pointRefTail = pointRefList.data() + n;
-		}
-		else
-		{
-			//else point previous tail ref to this point, and reset tail
-			*(aCell.pointRefTail) = pointRefList.data() + n;
-			aCell.pointRefTail = pointRefList.data() + n;
+			//process cancelled by user
+			return false;
 		}
+	}
 
-		//update the number of points in the cell
-		++aCell.nbPoints;
+	//then we sort the point indexes by cell (counting sort)
+	//DGM: the sort is stable, so that the points of each cell keep the same order as in the cloud
+	std::vector<unsigned> cellStartIndexes;
+	std::vector<unsigned> sortedPointIndexes;
+	try
+	{
+		cellStartIndexes.resize(static_cast<size_t>(gridTotalSize) + 1, 0);
+		sortedPointIndexes.resize(pointCount);
+	}
+	catch (const std::bad_alloc&)
+	{
+		ccLog::Error("Not enough memory");
+		return false;
+	}
 
-		if (!nProgress.oneStep())
+	for (unsigned cellIndex : pointCellIndexes)
+	{
+		if (cellIndex != c_outsideGrid)
 		{
-			//process cancelled by user
-			return false;
+			++cellStartIndexes[cellIndex + 1];
 		}
 	}
 
-	//find maximum needed size for storing per-cell data
+	//update the number of points in each cell and find the maximum needed size for storing per-cell data
 	unsigned maxCellPopuplation = 0;
 	for (unsigned j = 0; j < height; ++j)
 	{
 		Row& row = rows[j];
 		for (unsigned i = 0; i < width; ++i)
 		{
+			const unsigned cellIndex = j * width + i;
 			ccRasterCell& aCell = row[i];
+			aCell.nbPoints = cellStartIndexes[cellIndex + 1];
 			maxCellPopuplation = std::max(maxCellPopuplation, aCell.nbPoints);
+			cellStartIndexes[cellIndex + 1] += cellStartIndexes[cellIndex];
 		}
 	}
 
-	std::vector<IndexAndValue> cellPointIndexedHeight;
-	std::vector<ScalarType> cellPointSF; 
 	{
+		std::vector<unsigned> cellFillIndexes(cellStartIndexes.begin(), cellStartIndexes.end() - 1);
+		for (unsigned n = 0; n < pointCount; ++n)
+		{
+			unsigned cellIndex = pointCellIndexes[n];
+			if (cellIndex != c_outsideGrid)
+			{
+				sortedPointIndexes[cellFillIndexes[cellIndex]++] = n;
+			}
+		}
+	}
+	pointCellIndexes.clear();
+	pointCellIndexes.shrink_to_fit();
+
+	//now we can browse through all points belonging to each cell (in parallel, row by row)
+	std::atomic<bool> notEnoughMemory(false);
+	ccParallelFor(static_cast<int>(height), [&](int j)
+	{
+		std::vector<IndexAndValue> cellPointIndexedHeight;
+		std::vector<ScalarType> cellPointSF;
 		try
 		{
 			cellPointIndexedHeight.resize(maxCellPopuplation);
@@ -339,14 +374,10 @@ bool ccRasterGrid::fillWith(	ccGenericPointCloud* cloud,
 		}
 		catch (const std::bad_alloc&)
 		{
-			ccLog::Error("Not enough memory");
-			return false;
+			notEnoughMemory = true;
+			return;
 		}
-	}
 
-	//now we can browse through all points belonging to each cell 
-	for (unsigned j = 0; j < height; ++j)
-	{
 		Row& row = rows[j];
 		for (unsigned i = 0; i < width; ++i)
 		{
@@ -354,15 +385,13 @@ bool ccRasterGrid::fillWith(	ccGenericPointCloud* cloud,
 			if (aCell.nbPoints)
 			{
 				//Assemble a list of all points in this cell.
-				//Start with first point in cell, and browse through the other points using the linked ref list, and collect point indexes
-				void** pRef = aCell.pointRefHead;
+				const unsigned* cellPointIndexes = sortedPointIndexes.data() + cellStartIndexes[j * width + i];
 				for (unsigned n = 0; n < aCell.nbPoints; ++n)
 				{
-					unsigned pointIndex = static_cast<unsigned>( pRef - pointRefList.data());
+					unsigned pointIndex = cellPointIndexes[n];
 					const CCVector3* P = cloud->getPoint(pointIndex);
 					cellPointIndexedHeight[n].index = pointIndex;
 					cellPointIndexedHeight[n].val = P->u[Z];
-					pRef = reinterpret_cast<void**> (*pRef);
 				}
 
 				auto cellPointIndexedHeightEnd = std::next(cellPointIndexedHeight.begin(), aCell.nbPoints);
@@ -526,6 +555,12 @@ bool ccRasterGrid::fillWith(	ccGenericPointCloud* cloud,
 				}
 			}
 		}
+	});
+
+	if (notEnoughMemory)
+	{
+		ccLog::Error("Not enough memory");
+		return false;
 	}
 
 	//compute the number of non empty cells
@@ -545,13 +580,17 @@ bool ccRasterGrid::fillWith(	ccGenericPointCloud* cloud,
 	return true;
 }
 
-static void InterpolateOnBorder(const std::vector<uint8_t>& pointsOnBorder,
+//! Interpolates a cell on the (top or right) border of the grid
+/** \return whether the cell could be interpolated or not (the cell is only updated if 'update' is true)
+**/
+static bool InterpolateOnBorder(const std::vector<uint8_t>& pointsOnBorder,
 	const CCVector2i P[3],
 	int i, int j,
 	int coord,
 	int dim,
 	ccRasterCell& cell,
-	ccRasterGrid& grid)
+	ccRasterGrid& grid,
+	bool update)
 {
 	uint8_t minIndex = pointsOnBorder[0];
 	uint8_t maxIndex = pointsOnBorder[1];
@@ -569,6 +608,11 @@ static void InterpolateOnBorder(const std::vector<uint8_t>& pointsOnBorder,
 
 	if (P[minIndex][dim] <= coord && coord <= P[maxIndex][dim])
 	{
+		if (!update)
+		{
+			return true;
+		}
+
 		double d = P[maxIndex][dim] - P[minIndex][dim];
 		if (d > 0)
 		{
@@ -617,10 +661,470 @@ static void InterpolateOnBorder(const std::vector<uint8_t>& pointsOnBorder,
 				gridSF[i + j * grid.width] = sfValA;
 			}
 		}
+
+		return true;
+	}
+
+	return false;
+}
+
+//! Size of the blocks (in cells) used to quickly skip the empty areas of the grid
+static const int c_occupancyBlockSize = 64;
+//! Default margin (in cells) around each tile when no max edge length is defined
+static const int c_defaultInterpolationMargin = 256;
+//! Max margin (in cells) around each tile when no max edge length is defined (bounds the memory consumption)
+static const int c_maxInterpolationMargin = 2048;
+
+//! Rectangular set of cells (inclusive bounds)
+struct CellWindow
+{
+	int xMin = 0;
+	int yMin = 0;
+	int xMax = -1;
+	int yMax = -1;
+
+	inline int width() const { return xMax - xMin + 1; }
+	inline int height() const { return yMax - yMin + 1; }
+	inline bool contains(int i, int j) const { return i >= xMin && i <= xMax && j >= yMin && j <= yMax; }
+};
+
+//! Interpolation state of the empty cells of a tile
+enum InterpolationStatus : uint8_t
+{
+	CELL_NOT_COVERED = 0,	//!< not covered by any triangle
+	CELL_INTERPOLATED = 1,	//!< interpolated with a triangle of the global triangulation
+	CELL_UNRESOLVED = 2,	//!< only covered by triangles that may not belong to the global triangulation
+};
+
+//! Data shared by all the tiles during the interpolation of the empty cells
+struct InterpolationContext
+{
+	explicit InterpolationContext(ccRasterGrid& _grid, double _maxSquareEdgeLength)
+		: grid(_grid)
+		, maxSquareEdgeLength(_maxSquareEdgeLength)
+		, blockCountX(0)
+	{}
+
+	//! Checks whether a cell is strictly inside the convex hull of the non-empty cells
+	inline bool isInsideHull(int i, int j) const
+	{
+		const std::pair<double, double>& extents = hullRowExtents[j];
+		return extents.first < i && i < extents.second;
+	}
+
+	ccRasterGrid& grid;
+	double maxSquareEdgeLength;
+	//! Number of non-empty cells per block of c_occupancyBlockSize x c_occupancyBlockSize cells
+	std::vector<unsigned> blockCounts;
+	//! Number of blocks along X
+	int blockCountX;
+	//! Strict interior of the convex hull of the non-empty cells (for each row)
+	std::vector<std::pair<double, double>> hullRowExtents;
+};
+
+//! Checks that no non-empty cell lying outside of a window is inside the circumcircle of a triangle
+/** If the triangle belongs to the Delaunay triangulation of the non-empty cells of the window,
+	this means that it also belongs to the Delaunay triangulation of all the non-empty cells.
+**/
+static bool IsGlobalDelaunayTriangle(const InterpolationContext& context, const CCVector2i P[3], const CellWindow& window)
+{
+	const ccRasterGrid& grid = context.grid;
+
+	const double ax = P[0].x, ay = P[0].y;
+	const double bx = P[1].x, by = P[1].y;
+	const double cx = P[2].x, cy = P[2].y;
+
+	const double d = 2.0 * (ax * (by - cy) + bx * (cy - ay) + cx * (ay - by));
+	if (d == 0.0)
+	{
+		//flat triangle
+		return false;
+	}
+
+	const double a2 = ax * ax + ay * ay;
+	const double b2 = bx * bx + by * by;
+	const double c2 = cx * cx + cy * cy;
+	const double ux = (a2 * (by - cy) + b2 * (cy - ay) + c2 * (ay - by)) / d;
+	const double uy = (a2 * (cx - bx) + b2 * (ax - cx) + c2 * (bx - ax)) / d;
+	const double squareRadius = (ax - ux) * (ax - ux) + (ay - uy) * (ay - uy);
+	//we only look for the cells strictly inside the circle (co-circular cells don't matter)
+	const double maxSquareDist = squareRadius * (1.0 - 1.0e-9);
+	const double radius = sqrt(squareRadius);
+
+	const int gridMaxX = static_cast<int>(grid.width) - 1;
+	const int gridMaxY = static_cast<int>(grid.height) - 1;
+	const int xMin = static_cast<int>(std::max(0.0, std::ceil(ux - radius)));
+	const int yMin = static_cast<int>(std::max(0.0, std::ceil(uy - radius)));
+	const int xMax = static_cast<int>(std::min(static_cast<double>(gridMaxX), std::floor(ux + radius)));
+	const int yMax = static_cast<int>(std::min(static_cast<double>(gridMaxY), std::floor(uy + radius)));
+
+	if (window.contains(xMin, yMin) && window.contains(xMax, yMax))
+	{
+		//the circumcircle is inside the window
+		return true;
+	}
+
+	for (int bj = yMin / c_occupancyBlockSize; bj <= yMax / c_occupancyBlockSize; ++bj)
+	{
+		const int j0 = std::max(yMin, bj * c_occupancyBlockSize);
+		const int j1 = std::min(yMax, (bj + 1) * c_occupancyBlockSize - 1);
+
+		for (int bi = xMin / c_occupancyBlockSize; bi <= xMax / c_occupancyBlockSize; ++bi)
+		{
+			if (context.blockCounts[bj * context.blockCountX + bi] == 0)
+			{
+				//empty block
+				continue;
+			}
+
+			const int i0 = std::max(xMin, bi * c_occupancyBlockSize);
+			const int i1 = std::min(xMax, (bi + 1) * c_occupancyBlockSize - 1);
+			if (window.contains(i0, j0) && window.contains(i1, j1))
+			{
+				//the block is inside the window
+				continue;
+			}
+
+			//distance from the circle center to the block
+			const double dx = std::max(0.0, std::max(i0 - ux, ux - i1));
+			const double dy = std::max(0.0, std::max(j0 - uy, uy - j1));
+			if (dx * dx + dy * dy >= maxSquareDist)
+			{
+				continue;
+			}
+
+			for (int j = j0; j <= j1; ++j)
+			{
+				const ccRasterGrid::Row& row = grid.rows[j];
+				for (int i = i0; i <= i1; ++i)
+				{
+					if (row[i].nbPoints && !window.contains(i, j))
+					{
+						if ((i - ux) * (i - ux) + (j - uy) * (j - uy) < maxSquareDist)
+						{
+							return false;
+						}
+					}
+				}
+			}
+		}
+	}
+
+	return true;
+}
+
+//! Interpolates the empty cells of a tile covered by a given triangle
+/** The cells are only updated if 'update' is true, otherwise they are only flagged as 'unresolved'.
+**/
+static void InterpolateTriangle(ccRasterGrid& grid,
+								const CCVector2i P[3],
+								const CellWindow& tile,
+								bool update,
+								std::vector<uint8_t>& status)
+{
+	//get the triangle bounding box (in grid coordinates)
+	const int xMin = std::max(std::min(std::min(P[0].x, P[1].x), P[2].x), tile.xMin);
+	const int yMin = std::max(std::min(std::min(P[0].y, P[1].y), P[2].y), tile.yMin);
+	const int xMax = std::min(std::max(std::max(P[0].x, P[1].x), P[2].x), tile.xMax);
+	const int yMax = std::min(std::max(std::max(P[0].y, P[1].y), P[2].y), tile.yMax);
+	if (xMin > xMax || yMin > yMax)
+	{
+		//the triangle doesn't overlap the tile
+		return;
+	}
+
+	//std::vector< uint8_t> onBottomBorder;
+	std::vector< uint8_t> onTopBorder;
+	//std::vector< uint8_t> onLeftBorder;
+	std::vector< uint8_t> onRightBorder;
+	for (uint8_t k = 0; k < 3; ++k)
+	{
+		//if (P[k].x == 0)
+		//	onLeftBorder.push_back(k);
+		if (static_cast<unsigned>(P[k].x + 1) == grid.width)
+			onRightBorder.push_back(k);
+		//if (P[k].y == 0)
+		//	onBottomBorder.push_back(k);
+		if (static_cast<unsigned>(P[k].y + 1) == grid.height)
+			onTopBorder.push_back(k);
+	}
+
+	//pre-computation for barycentric coordinates
+	const double& valA = grid.rows[P[0].y][P[0].x].h;
+	const double& valB = grid.rows[P[1].y][P[1].x].h;
+	const double& valC = grid.rows[P[2].y][P[2].x].h;
+
+	int det = (P[1].y - P[2].y) * (P[0].x - P[2].x) - (P[1].x - P[2].x) * (P[0].y - P[2].y);
+
+	//now scan the cells
+	for (int j = yMin; j <= yMax; ++j)
+	{
+		ccRasterGrid::Row& row = grid.rows[static_cast<unsigned>(j)];
+
+		for (int i = xMin; i <= xMax; ++i)
+		{
+			//if the cell is empty
+			if (!row[i].nbPoints)
+			{
+				//we test if it's included or not in the current triangle
+				//Point Inclusion in Polygon Test (inspired from W. Randolph Franklin - WRF)
+				bool inside = false;
+				if (det != 0)
+				{
+					for (int ti = 0; ti < 3; ++ti)
+					{
+						const CCVector2i& P1 = P[ti];
+						const CCVector2i& P2 = P[(ti + 1) % 3];
+						if ((P2.y <= j && j < P1.y) || (P1.y <= j && j < P2.y))
+						{
+							int t = (i - P2.x)*(P1.y - P2.y) - (P1.x - P2.x)*(j - P2.y);
+							if (P1.y < P2.y)
+								t = -t;
+							if (t < 0)
+								inside = !inside;
+						}
+					}
+				}
+
+				//can we interpolate?
+				bool interpolated = inside;
+				if (inside && update)
+				{
+					double l1 = ((P[1].y - P[2].y)*(i - P[2].x) - (P[1].x - P[2].x)*(j - P[2].y)) / static_cast<double>(det);
+					double l2 = ((P[2].y - P[0].y)*(i - P[2].x) - (P[2].x - P[0].x)*(j - P[2].y)) / static_cast<double>(det);
+					double l3 = 1.0 - l1 - l2;
+
+					row[i].h = l1 * valA + l2 * valB + l3 * valC;
+					assert(std::isfinite(row[i].h));
+
+					//interpolate color as well!
+					if (grid.hasColors)
+					{
+						const CCVector3d& colA = grid.rows[P[0].y][P[0].x].color;
+						const CCVector3d& colB = grid.rows[P[1].y][P[1].x].color;
+						const CCVector3d& colC = grid.rows[P[2].y][P[2].x].color;
+						row[i].color = l1 * colA + l2 * colB + l3 * colC;
+					}
+
+					//interpolate the SFs as well!
+					for (auto &gridSF : grid.scalarFields)
+					{
+						assert(!gridSF.empty());
+
+						double sfValA = gridSF[P[0].x + P[0].y * grid.width];
+						double sfValB = gridSF[P[1].x + P[1].y * grid.width];
+						double sfValC = gridSF[P[2].x + P[2].y * grid.width];
+						assert(i + j * grid.width < gridSF.size());
+						gridSF[i + j * grid.width] = l1 * sfValA + l2 * sfValB + l3 * sfValC;
+					}
+				}
+
+				// second test for the borders (only the top and right borders have this issue in fact)
+				if (!inside)
+				{
+					/*if (i == 0 && onLeftBorder.size() > 1)
+					{
+						interpolated |= InterpolateOnBorder(onLeftBorder, P, i, j, j, 1, row[i], grid, update);
+					}
+					else */if (static_cast<unsigned>(i + 1) == grid.width && onRightBorder.size() > 1)
+					{
+						interpolated |= InterpolateOnBorder(onRightBorder, P, i, j, j, 1, row[i], grid, update);
+					}
+
+					/*if (j == 0 && onBottomBorder.size() > 1)
+					{
+						interpolated |= InterpolateOnBorder(onBottomBorder, P, i, j, i, 0, row[i], grid, update);
+					}
+					else*/if (static_cast<unsigned>(j + 1) == grid.height && onTopBorder.size() > 1)
+					{
+						interpolated |= InterpolateOnBorder(onTopBorder, P, i, j, i, 0, row[i], grid, update);
+					}
+				}
+
+				if (interpolated)
+				{
+					uint8_t& cellStatus = status[(j - tile.yMin) * tile.width() + (i - tile.xMin)];
+					if (update)
+						cellStatus = CELL_INTERPOLATED;
+					else if (cellStatus != CELL_INTERPOLATED)
+						cellStatus = CELL_UNRESOLVED;
+				}
+			}
+		}
+	}
+}
+
+//! Interpolates the empty cells of a tile
+/** The non-empty cells of the tile and of a margin around it are triangulated. Only the
+	triangles that are guaranteed to belong to the global triangulation are used. If some
+	cells can't be resolved this way (large holes), the margin is increased up to
+	c_maxInterpolationMargin. Beyond this limit, the remaining cells are interpolated with
+	the local triangulation ('approximated' is then set to true).
+**/
+static bool InterpolateTile(const InterpolationContext& context, const CellWindow& tile, int margin, bool& approximated)
+{
+	ccRasterGrid& grid = context.grid;
+	const int gridMaxX = static_cast<int>(grid.width) - 1;
+	const int gridMaxY = static_cast<int>(grid.height) - 1;
+
+	std::vector<uint8_t> status;
+	std::vector<CCVector2> the2DPoints;
+	try
+	{
+		status.resize(static_cast<size_t>(tile.width()) * tile.height());
+	}
+	catch (const std::bad_alloc&)
+	{
+		//out of memory
+		ccLog::Warning("[Rasterize] Not enough memory to interpolate empty cells!");
+		return false;
+	}
+
+	approximated = false;
+	while (true)
+	{
+		CellWindow window;
+		window.xMin = std::max(0, tile.xMin - margin);
+		window.yMin = std::max(0, tile.yMin - margin);
+		window.xMax = std::min(gridMaxX, tile.xMax + margin);
+		window.yMax = std::min(gridMaxY, tile.yMax + margin);
+		const bool wholeGrid = (window.xMin == 0 && window.yMin == 0 && window.xMax == gridMaxX && window.yMax == gridMaxY);
+
+		std::fill(status.begin(), status.end(), static_cast<uint8_t>(CELL_NOT_COVERED));
+
+		//fill 2D vector with non-empty cell indexes
+		the2DPoints.clear();
+		try
+		{
+			for (int j = window.yMin; j <= window.yMax; ++j)
+			{
+				const ccRasterGrid::Row& row = grid.rows[j];
+				for (int i = window.xMin; i <= window.xMax; ++i)
+				{
+					if (row[i].nbPoints)
+					{
+						//we only use the non-empty cells for interpolation
+						the2DPoints.emplace_back(static_cast<PointCoordinateType>(i), static_cast<PointCoordinateType>(j));
+					}
+				}
+			}
+		}
+		catch (const std::bad_alloc&)
+		{
+			//out of memory
+			ccLog::Warning("[Rasterize] Not enough memory to interpolate empty cells!");
+			return false;
+		}
+
+		if (the2DPoints.size() >= 3)
+		{
+			//mesh the '2D' points
+			CCCoreLib::Delaunay2dMesh delaunayMesh;
+			std::string errorStr;
+			if (delaunayMesh.buildMesh(the2DPoints, CCCoreLib::Delaunay2dMesh::USE_ALL_POINTS, errorStr))
+			{
+				//now we are going to 'project' all triangles on the grid
+				delaunayMesh.placeIteratorAtBeginning();
+				unsigned triNum = delaunayMesh.size();
+				for (unsigned k = 0; k < triNum; ++k)
+				{
+					const CCCoreLib::VerticesIndexes* tsi = delaunayMesh.getNextTriangleVertIndexes();
+
+					if (context.maxSquareEdgeLength > 0.0)
+					{
+						const CCVector2& A2D = the2DPoints[tsi->i[0]];
+						const CCVector2& B2D = the2DPoints[tsi->i[1]];
+
+						if ((B2D - A2D).norm2() > context.maxSquareEdgeLength)
+						{
+							continue;
+						}
+
+						const CCVector2& C2D = the2DPoints[tsi->i[2]];
+						if (	(C2D - A2D).norm2() > context.maxSquareEdgeLength
+							||	(C2D - B2D).norm2() > context.maxSquareEdgeLength)
+						{
+							continue;
+						}
+					}
+
+					CCVector2i P[3];
+					for (uint8_t v = 0; v < 3; ++v)
+					{
+						const CCVector2& P2D = the2DPoints[tsi->i[v]];
+						P[v].x = static_cast<int>(P2D.x);
+						P[v].y = static_cast<int>(P2D.y);
+					}
+
+					//quick rejection of the triangles that don't overlap the tile
+					if (	std::max(std::max(P[0].x, P[1].x), P[2].x) < tile.xMin
+						||	std::min(std::min(P[0].x, P[1].x), P[2].x) > tile.xMax
+						||	std::max(std::max(P[0].y, P[1].y), P[2].y) < tile.yMin
+						||	std::min(std::min(P[0].y, P[1].y), P[2].y) > tile.yMax)
+					{
+						continue;
+					}
+
+					bool isGlobal = wholeGrid || approximated || IsGlobalDelaunayTriangle(context, P, window);
+					InterpolateTriangle(grid, P, tile, isGlobal, status);
+				}
+			}
+			else if (wholeGrid)
+			{
+				ccLog::Warning(QStringLiteral("[Rasterize] Empty cells interpolation failed. Could not compute the 2.5D mesh ('%1')")
+					.arg(QString::fromStdString(errorStr)));
+				return false;
+			}
+		}
+
+		//DGM: if a max edge length is defined, the margin is larger than this length. Therefore, a triangle
+		//of the global triangulation that would have a vertex outside of the window would be filtered anyway.
+		if (wholeGrid || approximated || context.maxSquareEdgeLength > 0.0)
+		{
+			break;
+		}
+
+		//otherwise we look for the cells that could be interpolated with a larger margin
+		bool unresolved = false;
+		for (int j = tile.yMin; j <= tile.yMax && !unresolved; ++j)
+		{
+			const ccRasterGrid::Row& row = grid.rows[j];
+			for (int i = tile.xMin; i <= tile.xMax; ++i)
+			{
+				if (row[i].nbPoints)
+				{
+					continue;
+				}
+				uint8_t cellStatus = status[(j - tile.yMin) * tile.width() + (i - tile.xMin)];
+				if (	cellStatus == CELL_UNRESOLVED
+					||	(cellStatus == CELL_NOT_COVERED && context.isInsideHull(i, j)))
+				{
+					unresolved = true;
+					break;
+				}
+			}
+		}
+
+		if (!unresolved)
+		{
+			break;
+		}
+
+		if (margin >= c_maxInterpolationMargin)
+		{
+			//last pass: the triangles of the local triangulation are used as is
+			approximated = true;
+		}
+		else
+		{
+			margin = std::min(2 * margin, c_maxInterpolationMargin);
+		}
 	}
+
+	return true;
 }
 
-bool ccRasterGrid::interpolateEmptyCells(double maxSquareEdgeLength)
+bool ccRasterGrid::interpolateEmptyCells(double maxSquareEdgeLength, unsigned tileSize/*=1024*/)
 {
 	if (nonEmptyCellCount < 3)
 	{
@@ -634,10 +1138,28 @@ bool ccRasterGrid::interpolateEmptyCells(double maxSquareEdgeLength)
 		return true;
 	}
 
-	std::vector<CCVector2> the2DPoints;
+	InterpolationContext context(*this, maxSquareEdgeLength);
+
+	if (tileSize == 0 || (width <= tileSize && height <= tileSize))
+	{
+		//a single triangulation of the whole grid
+		CellWindow wholeGrid;
+		wholeGrid.xMax = static_cast<int>(width) - 1;
+		wholeGrid.yMax = static_cast<int>(height) - 1;
+		bool approximated = false;
+		return InterpolateTile(context, wholeGrid, 0, approximated);
+	}
+
+	//count the non-empty cells per block (to skip the empty areas quickly)
+	//and compute the convex hull of the non-empty cells
+	context.blockCountX = (static_cast<int>(width) + c_occupancyBlockSize - 1) / c_occupancyBlockSize;
+	const int blockCountY = (static_cast<int>(height) + c_occupancyBlockSize - 1) / c_occupancyBlockSize;
+	std::vector<CCVector2i> rowExtremities;
 	try
 	{
-		the2DPoints.resize(nonEmptyCellCount);
+		context.blockCounts.resize(static_cast<size_t>(context.blockCountX) * blockCountY, 0);
+		context.hullRowExtents.resize(height, { std::numeric_limits<double>::max(), std::numeric_limits<double>::lowest() });
+		rowExtremities.reserve(2 * height);
 	}
 	catch (const std::bad_alloc&)
 	{
@@ -646,195 +1168,127 @@ bool ccRasterGrid::interpolateEmptyCells(double maxSquareEdgeLength)
 		return false;
 	}
 
-	//fill 2D vector with non-empty cell indexes
-	unsigned index = 0;
 	for (unsigned j = 0; j < height; ++j)
 	{
 		const Row& row = rows[j];
+		int firstIndex = -1;
+		int lastIndex = -1;
 		for (unsigned i = 0; i < width; ++i)
 		{
 			if (row[i].nbPoints)
 			{
-				//we only use the non-empty cells for interpolation
-				the2DPoints[index++] = CCVector2(static_cast<PointCoordinateType>(i), static_cast<PointCoordinateType>(j));
+				++context.blockCounts[(j / c_occupancyBlockSize) * context.blockCountX + i / c_occupancyBlockSize];
+				if (firstIndex < 0)
+					firstIndex = static_cast<int>(i);
+				lastIndex = static_cast<int>(i);
 			}
 		}
-	}
-	assert(index == nonEmptyCellCount);
 
-	//mesh the '2D' points
-	CCCoreLib::Delaunay2dMesh delaunayMesh;
-	std::string errorStr;
-	if (!delaunayMesh.buildMesh(the2DPoints, CCCoreLib::Delaunay2dMesh::USE_ALL_POINTS, errorStr))
-	{
-		ccLog::Warning(QStringLiteral("[Rasterize] Empty cells interpolation failed. Could not compute the 2.5D mesh ('%1')")
-			.arg(QString::fromStdString(errorStr)));
-		return false;
+		if (firstIndex >= 0)
+		{
+			rowExtremities.emplace_back(firstIndex, static_cast<int>(j));
+			if (lastIndex != firstIndex)
+				rowExtremities.emplace_back(lastIndex, static_cast<int>(j));
+		}
 	}
 
-	//now we are going to 'project' all triangles on the grid
-	delaunayMesh.placeIteratorAtBeginning();
-	unsigned triNum = delaunayMesh.size();
-	for (unsigned k = 0; k < triNum; ++k)
+	//convex hull of the row extremities (Andrew's monotone chain)
 	{
-		const CCCoreLib::VerticesIndexes* tsi = delaunayMesh.getNextTriangleVertIndexes();
+		std::sort(rowExtremities.begin(), rowExtremities.end(), [](const CCVector2i& a, const CCVector2i& b) { return a.x < b.x || (a.x == b.x && a.y < b.y); });
+		auto cross = [](const CCVector2i& o, const CCVector2i& a, const CCVector2i& b)
+		{
+			return static_cast<double>(a.x - o.x) * (b.y - o.y) - static_cast<double>(a.y - o.y) * (b.x - o.x);
+		};
 
-		if (maxSquareEdgeLength > 0.0)
+		std::vector<CCVector2i> hull(2 * rowExtremities.size());
+		size_t k = 0;
+		for (size_t n = 0; n < rowExtremities.size(); ++n)
+		{
+			while (k >= 2 && cross(hull[k - 2], hull[k - 1], rowExtremities[n]) <= 0)
+				--k;
+			hull[k++] = rowExtremities[n];
+		}
+		for (size_t n = rowExtremities.size() - 1, t = k + 1; n > 0; --n)
 		{
-			const CCVector2& A2D = the2DPoints[tsi->i[0]];
-			const CCVector2& B2D = the2DPoints[tsi->i[1]];
+			while (k >= t && cross(hull[k - 2], hull[k - 1], rowExtremities[n - 1]) <= 0)
+				--k;
+			hull[k++] = rowExtremities[n - 1];
+		}
+		hull.resize(k > 0 ? k - 1 : 0);
 
-			if ((B2D - A2D).norm2() > maxSquareEdgeLength)
-			{
-				continue;
-			}
+		//extents of the hull for each row
+		int hullMinY = std::numeric_limits<int>::max();
+		int hullMaxY = std::numeric_limits<int>::lowest();
+		for (size_t n = 0; n < hull.size(); ++n)
+		{
+			const CCVector2i& A = hull[n];
+			const CCVector2i& B = hull[(n + 1) % hull.size()];
+			hullMinY = std::min(hullMinY, A.y);
+			hullMaxY = std::max(hullMaxY, A.y);
 
-			const CCVector2& C2D = the2DPoints[tsi->i[2]];
-			if (	(C2D - A2D).norm2() > maxSquareEdgeLength
-				||	(C2D - B2D).norm2() > maxSquareEdgeLength)
+			for (int y = std::min(A.y, B.y); y <= std::max(A.y, B.y); ++y)
 			{
-				continue;
+				double x = (A.y == B.y ? A.x : A.x + (y - A.y) * static_cast<double>(B.x - A.x) / (B.y - A.y));
+				std::pair<double, double>& extents = context.hullRowExtents[y];
+				extents.first = std::min(extents.first, x);
+				extents.second = std::max(extents.second, x);
+				if (A.y == B.y)
+				{
+					extents.first = std::min(extents.first, static_cast<double>(B.x));
+					extents.second = std::max(extents.second, static_cast<double>(B.x));
+				}
 			}
 		}
 
-		//get the triangle bounding box (in grid coordinates)
-		CCVector2i P[3];
-		int xMin = 0;
-		int yMin = 0;
-		int xMax = 0;
-		int yMax = 0;
-		//std::vector< uint8_t> onBottomBorder;
-		std::vector< uint8_t> onTopBorder;
-		//std::vector< uint8_t> onLeftBorder;
-		std::vector< uint8_t> onRightBorder;
+		//the first and last rows of the hull are on its border
+		for (int y = 0; y < static_cast<int>(height); ++y)
 		{
-			for (uint8_t k = 0; k < 3; ++k)
+			if (y <= hullMinY || y >= hullMaxY)
 			{
-				const CCVector2& P2D = the2DPoints[tsi->i[k]];
-				P[k].x = static_cast<int>(P2D.x);
-				P[k].y = static_cast<int>(P2D.y);
-
-				//if (P[k].x == 0)
-				//	onLeftBorder.push_back(k);
-				if (static_cast<unsigned>(P[k].x + 1) == width)
-					onRightBorder.push_back(k);
-				//if (P[k].y == 0)
-				//	onBottomBorder.push_back(k);
-				if (static_cast<unsigned>(P[k].y + 1) == height)
-					onTopBorder.push_back(k);
+				context.hullRowExtents[y] = { std::numeric_limits<double>::max(), std::numeric_limits<double>::lowest() };
 			}
-			xMin = std::min(std::min(P[0].x, P[1].x), P[2].x);
-			yMin = std::min(std::min(P[0].y, P[1].y), P[2].y);
-			xMax = std::max(std::max(P[0].x, P[1].x), P[2].x);
-			yMax = std::max(std::max(P[0].y, P[1].y), P[2].y);
 		}
-		
-		//now scan the cells
-		{
-			//pre-computation for barycentric coordinates
-			const double& valA = rows[P[0].y][P[0].x].h;
-			const double& valB = rows[P[1].y][P[1].x].h;
-			const double& valC = rows[P[2].y][P[2].x].h;
-
-			int det = (P[1].y - P[2].y) * (P[0].x - P[2].x) - (P[1].x - P[2].x) * (P[0].y - P[2].y);
-
-			for (int j = yMin; j <= yMax; ++j)
-			{
-				Row& row = rows[static_cast<unsigned>(j)];
-
-				for (int i = xMin; i <= xMax; ++i)
-				{
-					//if the cell is empty
-					if (!row[i].nbPoints)
-					{
-						//we test if it's included or not in the current triangle
-						//Point Inclusion in Polygon Test (inspired from W. Randolph Franklin - WRF)
-						bool inside = false;
-						if (det != 0)
-						{
-							for (int ti = 0; ti < 3; ++ti)
-							{
-								const CCVector2i& P1 = P[ti];
-								const CCVector2i& P2 = P[(ti + 1) % 3];
-								if ((P2.y <= j && j < P1.y) || (P1.y <= j && j < P2.y))
-								{
-									int t = (i - P2.x)*(P1.y - P2.y) - (P1.x - P2.x)*(j - P2.y);
-									if (P1.y < P2.y)
-										t = -t;
-									if (t < 0)
-										inside = !inside;
-								}
-							}
-						}
+	}
 
-						//can we interpolate?
-						if (inside)
-						{
-							double l1 = ((P[1].y - P[2].y)*(i - P[2].x) - (P[1].x - P[2].x)*(j - P[2].y)) / static_cast<double>(det);
-							double l2 = ((P[2].y - P[0].y)*(i - P[2].x) - (P[2].x - P[0].x)*(j - P[2].y)) / static_cast<double>(det);
-							double l3 = 1.0 - l1 - l2;
-							//if (l3 < 0.0 || l3 > 1.0)
-							//{
-							//	// shouldn't happen
-							//	assert(false);
-							//	inside = false;
-							//}
-							//else
-							{
-								row[i].h = l1 * valA + l2 * valB + l3 * valC;
-								assert(std::isfinite(row[i].h));
+	//now we can process the tiles (in parallel)
+	const int margin = (maxSquareEdgeLength > 0.0 ? static_cast<int>(std::ceil(sqrt(maxSquareEdgeLength))) + 1 : c_defaultInterpolationMargin);
+	const int tileCountX = static_cast<int>((width + tileSize - 1) / tileSize);
+	const int tileCountY = static_cast<int>((height + tileSize - 1) / tileSize);
+	std::atomic<bool> success(true);
+	std::atomic<int> approximatedTileCount(0);
 
-								//interpolate color as well!
-								if (hasColors)
-								{
-									const CCVector3d& colA = rows[P[0].y][P[0].x].color;
-									const CCVector3d& colB = rows[P[1].y][P[1].x].color;
-									const CCVector3d& colC = rows[P[2].y][P[2].x].color;
-									row[i].color = l1 * colA + l2 * colB + l3 * colC;
-								}
-
-								//interpolate the SFs as well!
-								for (auto &gridSF : scalarFields)
-								{
-									assert(!gridSF.empty());
+	ccParallelFor(tileCountX * tileCountY, [&](int t)
+	{
+		if (!success)
+		{
+			return;
+		}
 
-									double sfValA = gridSF[P[0].x + P[0].y * width];
-									double sfValB = gridSF[P[1].x + P[1].y * width];
-									double sfValC = gridSF[P[2].x + P[2].y * width];
-									assert(i + j * width < gridSF.size());
-									gridSF[i + j * width] = l1 * sfValA + l2 * sfValB + l3 * sfValC;
-								}
-							}
-						}
+		CellWindow tile;
+		tile.xMin = (t % tileCountX) * static_cast<int>(tileSize);
+		tile.yMin = (t / tileCountX) * static_cast<int>(tileSize);
+		tile.xMax = std::min(tile.xMin + static_cast<int>(tileSize), static_cast<int>(width)) - 1;
+		tile.yMax = std::min(tile.yMin + static_cast<int>(tileSize), static_cast<int>(height)) - 1;
 
-						// second test for the borders (only the top and right borders have this issue in fact)
-						if (!inside)
-						{
-							/*if (i == 0 && onLeftBorder.size() > 1)
-							{
-								InterpolateOnBorder(onLeftBorder, P, i, j, j, 1, row[i], *this);
-							}
-							else */if (static_cast<unsigned>(i + 1) == width && onRightBorder.size() > 1)
-							{
-								InterpolateOnBorder(onRightBorder, P, i, j, j, 1, row[i], *this);
-							}
-							
-							/*if (j == 0 && onBottomBorder.size() > 1)
-							{
-								InterpolateOnBorder(onBottomBorder, P, i, j, i, 0, row[i], *this);
-							}
-							else*/if (static_cast<unsigned>(j + 1) == height && onTopBorder.size() > 1)
-							{
-								InterpolateOnBorder(onTopBorder, P, i, j, i, 0, row[i], *this);
-							}
-						}
-					}
-				}
-			}
+		bool approximated = false;
+		if (!InterpolateTile(context, tile, margin, approximated))
+		{
+			success = false;
 		}
+		else if (approximated)
+		{
+			++approximatedTileCount;
+		}
+	});
+
+	if (approximatedTileCount != 0)
+	{
+		ccLog::Warning(QString("[Rasterize] %1 tile(s) have empty areas larger than %2 cells: their empty cells have been interpolated with a local triangulation (set a max edge length to get the same result as a single triangulation)")
+			.arg(approximatedTileCount.load())
+			.arg(c_maxInterpolationMargin));
 	}
 
-	return true;
+	return success;
 }
 
 unsigned ccRasterGrid::updateNonEmptyCellCount()
@@ -19,18 +19,79 @@
 
 //Local
 #include "ccColorScalesManager.h"
+#include "ccParallel.h"
 
 //CCCoreLib
 #include <CCConst.h>
 
 //system
 #include <algorithm>
+#include <limits>
 
 using namespace CCCoreLib;
 
 //! Default number of classes for associated histogram
 const unsigned MAX_HISTOGRAM_SIZE = 512;
 
+//! Number of values processed by each task when computing the statistics
+static const unsigned c_statsBlockSize = (1 << 20);
+
+//! Partial statistics (of a block of values)
+struct BlockStatistics
+{
+	unsigned validCount = 0;
+	ScalarType minVal = std::numeric_limits<ScalarType>::max();
+	ScalarType maxVal = std::numeric_limits<ScalarType>::lowest();
+	//sums are computed relatively to a 'shift' value (the first valid value) to limit the numerical errors
+	double shift = 0;
+	double sum = 0;
+	double sum2 = 0;
+};
+
+//! Computes the statistics of a block of values
+/** The loops are kept simple (no dependency between iterations) so as to be vectorized by the compiler.
+**/
+static void ComputeBlockStatistics(const ScalarType* values, unsigned count, BlockStatistics& stats)
+{
+	unsigned i = 0;
+	//look for the first valid value
+	while (i < count && !ScalarField::ValidValue(values[i]))
+	{
+		++i;
+	}
+	if (i == count)
+	{
+		return;
+	}
+
+	stats.shift = values[i];
+	const ScalarType shift = values[i];
+	ScalarType minVal = values[i];
+	ScalarType maxVal = values[i];
+	unsigned validCount = 0;
+	double sum = 0;
+	double sum2 = 0;
+	for (; i < count; ++i)
+	{
+		const ScalarType val = values[i];
+		if (ScalarField::ValidValue(val))
+		{
+			minVal = std::min(minVal, val);
+			maxVal = std::max(maxVal, val);
+			const double d = static_cast<double>(val - shift);
+			sum += d;
+			sum2 += d * d;
+			++validCount;
+		}
+	}
+
+	stats.validCount = validCount;
+	stats.minVal = minVal;
+	stats.maxVal = maxVal;
+	stats.sum = sum;
+	stats.sum2 = sum2;
+}
+
 ccScalarField::ccScalarField(const char* name/*=nullptr*/)
 	: ScalarField(name)
 	, m_showNaNValuesInGrey(true)
@@ -39,6 +100,7 @@ ccScalarField::ccScalarField(const char* name/*=nullptr*/)
 	, m_alwaysShowZero(false)
 	, m_colorScale(nullptr)
 	, m_colorRampSteps(0)
+	, m_statisticsValid(false)
 	, m_modified(true)
 	, m_globalShift(0)
 {
@@ -58,10 +120,21 @@ ccScalarField::ccScalarField(const ccScalarField& sf)
 	, m_colorScale(sf.m_colorScale)
 	, m_colorRampSteps(sf.m_colorRampSteps)
 	, m_histogram(sf.m_histogram)
+	, m_statistics(sf.m_statistics)
+	, m_statisticsValid(sf.m_statisticsValid)
 	, m_modified(sf.m_modified)
 	, m_globalShift(sf.m_globalShift)
 {
-	computeMinAndMax();
+	if (m_statisticsValid)
+	{
+		//the values are the same: no need to recompute the statistics
+		m_minVal = sf.m_minVal;
+		m_maxVal = sf.m_maxVal;
+	}
+	else
+	{
+		computeMinAndMax();
+	}
 }
 
 ScalarType ccScalarField::normalize(ScalarType d) const
@@ -162,29 +235,113 @@ void ccScalarField::setLogScale(bool state)
 
 void ccScalarField::computeMinAndMax()
 {
-	ScalarField::computeMinAndMax();
+	const unsigned count = currentSize();
+	const ScalarType* values = (count != 0 ? data() : nullptr);
+	const int blockCount = static_cast<int>((count + c_statsBlockSize - 1) / c_statsBlockSize);
+
+	m_statistics = Statistics();
+	m_statistics.count = count;
+	m_minVal = m_maxVal = 0;
+
+	//first pass: min, max, mean, std. dev. and number of NaN values (per block, in parallel)
+	std::vector<BlockStatistics> blockStats;
+	try
+	{
+		blockStats.resize(blockCount);
+	}
+	catch (const std::bad_alloc&)
+	{
+		//not enough memory: we process all the values as a single (sequential) block
+		blockStats.clear();
+	}
+
+	BlockStatistics globalStats;
+	if (!blockStats.empty())
+	{
+		ccParallelFor(blockCount, [&](int b)
+		{
+			const unsigned start = static_cast<unsigned>(b) * c_statsBlockSize;
+			ComputeBlockStatistics(values + start, std::min(c_statsBlockSize, count - start), blockStats[b]);
+		});
+	}
+	else if (count != 0)
+	{
+		ComputeBlockStatistics(values, count, globalStats);
+	}
+
+	{
+		const BlockStatistics* blocks = (blockStats.empty() ? &globalStats : blockStats.data());
+		const size_t blocksCount = (blockStats.empty() ? 1 : blockStats.size());
+
+		//merge the blocks statistics
+		unsigned validCount = 0;
+		ScalarType minVal = 0;
+		ScalarType maxVal = 0;
+		double sum = 0;
+		for (size_t b = 0; b < blocksCount; ++b)
+		{
+			const BlockStatistics& stats = blocks[b];
+			if (stats.validCount == 0)
+				continue;
+			if (validCount == 0)
+			{
+				minVal = stats.minVal;
+				maxVal = stats.maxVal;
+			}
+			else
+			{
+				minVal = std::min(minVal, stats.minVal);
+				maxVal = std::max(maxVal, stats.maxVal);
+			}
+			validCount += stats.validCount;
+			sum += stats.sum + stats.shift * stats.validCount;
+		}
+
+		m_minVal = minVal;
+		m_maxVal = maxVal;
+		m_statistics.nanCount = count - validCount;
+		if (validCount != 0)
+		{
+			const double mean = sum / validCount;
+			//sum of the squared deviations to the global mean
+			double sumSquaredDev = 0;
+			for (size_t b = 0; b < blocksCount; ++b)
+			{
+				const BlockStatistics& stats = blocks[b];
+				if (stats.validCount == 0)
+					continue;
+				const double blockMean = stats.sum / stats.validCount; //relative to the block shift
+				const double blockSquaredDev = std::max(0.0, stats.sum2 - stats.sum * blockMean);
+				const double delta = stats.shift + blockMean - mean;
+				sumSquaredDev += blockSquaredDev + delta * delta * stats.validCount;
+			}
+			m_statistics.mean = mean;
+			m_statistics.stdDev = sqrt(sumSquaredDev / validCount);
+		}
+	}
 
 	m_displayRange.setBounds(m_minVal, m_maxVal);
 
 	//update histogram
 	{
-		if (m_displayRange.maxRange() == 0 || currentSize() == 0)
+		if (m_displayRange.maxRange() == 0 || count == 0)
 		{
 			//can't build histogram of a flat field
 			m_histogram.clear();
 		}
 		else
 		{
-			unsigned count = currentSize();
 			unsigned numberOfClasses = static_cast<unsigned>(ceil(sqrt(static_cast<double>(count))));
 			numberOfClasses = std::max<unsigned>(std::min<unsigned>(numberOfClasses, MAX_HISTOGRAM_SIZE), 4);
 
 			m_histogram.maxValue = 0;
 
-			//reserve memory
+			//reserve memory (one partial histogram per block)
+			std::vector<unsigned> blockHistograms;
 			try
 			{
 				m_histogram.resize(numberOfClasses);
+				blockHistograms.resize(static_cast<size_t>(numberOfClasses) * blockCount, 0);
 			}
 			catch (const std::bad_alloc&)
 			{
@@ -196,19 +353,33 @@ void ccScalarField::computeMinAndMax()
 			{
 				std::fill(m_histogram.begin(), m_histogram.end(), 0);
 
-				//compute histogram
+				//second pass: compute the histogram (per block, in parallel)
+				const ScalarType minVal = m_displayRange.min();
+				const ScalarType step = static_cast<ScalarType>(numberOfClasses) / m_displayRange.maxRange();
+				ccParallelFor(blockCount, [&](int b)
 				{
-					ScalarType step = static_cast<ScalarType>(numberOfClasses) / m_displayRange.maxRange();
-					for (unsigned i = 0; i < count; ++i)
+					unsigned* histogram = blockHistograms.data() + static_cast<size_t>(b) * numberOfClasses;
+					const unsigned start = static_cast<unsigned>(b) * c_statsBlockSize;
+					const unsigned stop = std::min(start + c_statsBlockSize, count);
+					for (unsigned i = start; i < stop; ++i)
 					{
-						const ScalarType& val = getValue(i);
-
+						const ScalarType val = values[i];
 						if (ValidValue(val))
 						{
-							unsigned bin = static_cast<unsigned>(floor((val - m_displayRange.min())*step));
-							++m_histogram[std::min(bin, numberOfClasses - 1)];
+							unsigned bin = static_cast<unsigned>((val - minVal) * step);
+							++histogram[std::min(bin, numberOfClasses - 1)];
 						}
 					}
+				});
+
+				//merge the partial histograms
+				for (int b = 0; b < blockCount; ++b)
+				{
+					const unsigned* histogram = blockHistograms.data() + static_cast<size_t>(b) * numberOfClasses;
+					for (unsigned k = 0; k < numberOfClasses; ++k)
+					{
+						m_histogram[k] += histogram[k];
+					}
 				}
 
 				//update 'maxValue'
@@ -217,11 +388,35 @@ void ccScalarField::computeMinAndMax()
 		}
 	}
 
+	m_statisticsValid = true;
 	m_modified = true;
 
 	updateSaturationBounds();
 }
 
+bool ccScalarField::resizeSafe(std::size_t count, bool initNewElements/*=false*/, ScalarType valueForNewElements/*=0*/)
+{
+	if (count != size())
+	{
+		m_statisticsValid = false;
+	}
+	return ScalarField::resizeSafe(count, initNewElements, valueForNewElements);
+}
+
+void ccScalarField::fill(ScalarType fillValue/*=0*/)
+{
+	ScalarField::fill(fillValue);
+	m_statisticsValid = false;
+}
+
+void ccScalarField::updateStatistics()
+{
+	if (!m_statisticsValid)
+	{
+		computeMinAndMax();
+	}
+}
+
 void ccScalarField::updateSaturationBounds()
 {
 	if (!m_colorScale || m_colorScale->isRelative()) //Relative scale (default)
@@ -416,15 +611,15 @@ bool ccScalarField::fromFile(QFile& in, short dataVersion, int flags, LoadedIDMa
 		bool fileScalarIsFloat = (flags & ccSerializableObject::DF_SCALAR_VAL_32_BITS);
 		if (fileScalarIsFloat && sizeof(ScalarType) == 8) //file is 'float' and current type is 'double'
 		{
-			result = ccSerializationHelper::GenericArrayFromTypedFile<ScalarType, 1, ScalarType, float>(*this, in, dataVersion);
+			result = ccSerializationHelper::GenericArrayFromTypedFile<ScalarType, 1, ScalarType, float>(*this, in, dataVersion, flags);
 		}
 		else if (!fileScalarIsFloat && sizeof(ScalarType) == 4) //file is 'double' and current type is 'float'
 		{
-			result = ccSerializationHelper::GenericArrayFromTypedFile<ScalarType, 1, ScalarType, double>(*this, in, dataVersion);
+			result = ccSerializationHelper::GenericArrayFromTypedFile<ScalarType, 1, ScalarType, double>(*this, in, dataVersion, flags);
 		}
 		else
 		{
-			result = ccSerializationHelper::GenericArrayFromFile<ScalarType, 1, ScalarType>(*this, in, dataVersion);
+			result = ccSerializationHelper::GenericArrayFromFile<ScalarType, 1, ScalarType>(*this, in, dataVersion, flags);
 		}
 	}
 	if (!result)
@@ -0,0 +1,381 @@
+//##########################################################################
+//#                                                                        #
+//#                              CLOUDCOMPARE                              #
+//#                                                                        #
+//#  This program is free software; you can redistribute it and/or modify  #
+//#  it under the terms of the GNU General Public License as published by  #
+//#  the Free Software Foundation; version 2 or later of the License.      #
+//#                                                                        #
+//#  This program is distributed in the hope that it will be useful,       #
+//#  but WITHOUT ANY WARRANTY; without even the implied warranty of        #
+//#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          #
+//#  GNU General Public License for more details.                          #
+//#                                                                        #
+//#          COPYRIGHT: EDF R&D / TELECOM ParisTech (ENST-TSI)             #
+//#                                                                        #
+//##########################################################################
+
+#include "ccSerializableObject.h"
+
+//Local
+#include "ccChunk.h"
+#include "ccParallel.h"
+
+//Qt
+#include <QByteArray>
+
+//System
+#include <atomic>
+
+//! Chunk header size in file: codec (1 byte) + stored byte count (4 bytes) + checksum (4 bytes)
+static const size_t c_chunkHeaderSize = 9;
+//! Number of chunks processed (compressed or decompressed) at once
+static const size_t c_chunkBatchSize = 64;
+
+//! Compression level of array chunks (-1 = no compression)
+static int s_arrayCompressionLevel = -1;
+
+//! Array chunk header
+struct ChunkHeader
+{
+	::uint8_t codec = ccSerializationHelper::CHUNK_RAW;
+	::uint32_t storedSize = 0;
+	::uint32_t checksum = 0;
+};
+
+void ccSerializationHelper::SetArrayCompressionLevel(int level)
+{
+	s_arrayCompressionLevel = std::max(-1, std::min(level, 9));
+}
+
+int ccSerializationHelper::ArrayCompressionLevel()
+{
+	return s_arrayCompressionLevel;
+}
+
+::uint32_t ccSerializationHelper::Checksum(const char* data, size_t byteCount)
+{
+	//standard CRC-32 (reflected polynomial 0xEDB88320)
+	static const struct CRCTable
+	{
+		CRCTable()
+		{
+			for (::uint32_t i = 0; i < 256; ++i)
+			{
+				::uint32_t c = i;
+				for (int k = 0; k < 8; ++k)
+				{
+					c = (c & 1) ? (0xEDB88320U ^ (c >> 1)) : (c >> 1);
+				}
+				values[i] = c;
+			}
+		}
+		::uint32_t values[256];
+	} s_table;
+
+	::uint32_t crc = 0xFFFFFFFFU;
+	const unsigned char* _data = reinterpret_cast<const unsigned char*>(data);
+	for (size_t i = 0; i < byteCount; ++i)
+	{
+		crc = s_table.values[(crc ^ _data[i]) & 0xFF] ^ (crc >> 8);
+	}
+	return crc ^ 0xFFFFFFFFU;
+}
+
+bool ccSerializationHelper::WriteChunkedArrayData(QFile& out, const char* data, size_t elementCount, size_t elementSize)
+{
+	assert(out.isOpen() && (out.openMode() & QIODevice::WriteOnly));
+
+	const size_t chunkCount = ccChunk::Count(elementCount);
+	if (chunkCount == 0)
+	{
+		return true;
+	}
+
+	std::vector<ChunkHeader> headers;
+	std::vector<QByteArray> compressedChunks;
+	try
+	{
+		headers.resize(chunkCount);
+		compressedChunks.resize(std::min(chunkCount, c_chunkBatchSize));
+	}
+	catch (const std::bad_alloc&)
+	{
+		return ccSerializableObject::MemoryError();
+	}
+
+	//we reserve the space for the chunk table (it will be written at the end)
+	const qint64 tablePos = out.pos();
+	{
+		QByteArray emptyTable(static_cast<int>(chunkCount * c_chunkHeaderSize), 0);
+		if (out.write(emptyTable) < 0)
+			return ccSerializableObject::WriteError();
+	}
+
+	const int compressionLevel = s_arrayCompressionLevel;
+	for (size_t batchStart = 0; batchStart < chunkCount; batchStart += c_chunkBatchSize)
+	{
+		const int batchCount = static_cast<int>(std::min(c_chunkBatchSize, chunkCount - batchStart));
+
+		//compute the checksums and compress the chunks (in parallel)
+		ccParallelFor(batchCount, [&](int i)
+		{
+			const size_t chunkIndex = batchStart + i;
+			const char* chunkData = data + ccChunk::StartPos(chunkIndex) * elementSize;
+			const size_t chunkByteCount = ccChunk::Size(chunkIndex, chunkCount, elementCount) * elementSize;
+
+			ChunkHeader& header = headers[chunkIndex];
+			header.checksum = Checksum(chunkData, chunkByteCount);
+			header.codec = CHUNK_RAW;
+			header.storedSize = static_cast<::uint32_t>(chunkByteCount);
+			compressedChunks[i].clear();
+
+			if (compressionLevel >= 0)
+			{
+				QByteArray compressed = qCompress(reinterpret_cast<const uchar*>(chunkData), static_cast<int>(chunkByteCount), compressionLevel);
+				//we only keep the compressed version if it's worth it
+				if (!compressed.isEmpty() && static_cast<size_t>(compressed.size()) < chunkByteCount)
+				{
+					header.codec = CHUNK_ZLIB;
+					header.storedSize = static_cast<::uint32_t>(compressed.size());
+					compressedChunks[i] = compressed;
+				}
+			}
+		});
+
+		//then write them (sequentially)
+		for (int i = 0; i < batchCount; ++i)
+		{
+			const size_t chunkIndex = batchStart + i;
+			const ChunkHeader& header = headers[chunkIndex];
+			if (header.codec == CHUNK_ZLIB)
+			{
+				if (out.write(compressedChunks[i]) < 0)
+					return ccSerializableObject::WriteError();
+			}
+			else
+			{
+				if (out.write(data + ccChunk::StartPos(chunkIndex) * elementSize, header.storedSize) < 0)
+					return ccSerializableObject::WriteError();
+			}
+			compressedChunks[i].clear();
+		}
+	}
+
+	//now we can write the actual chunk table
+	const qint64 endPos = out.pos();
+	{
+		QByteArray table(static_cast<int>(chunkCount * c_chunkHeaderSize), 0);
+		char* _table = table.data();
+		for (const ChunkHeader& header : headers)
+		{
+			memcpy(_table, &header.codec, 1);
+			memcpy(_table + 1, &header.storedSize, 4);
+			memcpy(_table + 5, &header.checksum, 4);
+			_table += c_chunkHeaderSize;
+		}
+
+		if (!out.seek(tablePos) || out.write(table) < 0 || !out.seek(endPos))
+			return ccSerializableObject::WriteError();
+	}
+
+	return true;
+}
+
+//! Reads the chunk table of an array stored by chunks
+/** \param[out] allRaw whether all the chunks are stored uncompressed
+**/
+static bool ReadChunkTable(QFile& in, size_t elementCount, size_t elementSize, std::vector<ChunkHeader>& headers, bool& allRaw)
+{
+	const size_t chunkCount = ccChunk::Count(elementCount);
+	try
+	{
+		headers.resize(chunkCount);
+	}
+	catch (const std::bad_alloc&)
+	{
+		return ccSerializableObject::MemoryError();
+	}
+
+	allRaw = true;
+	QByteArray table = in.read(static_cast<qint64>(chunkCount * c_chunkHeaderSize));
+	if (static_cast<size_t>(table.size()) != chunkCount * c_chunkHeaderSize)
+		return ccSerializableObject::ReadError();
+
+	const char* _table = table.constData();
+	for (size_t i = 0; i < chunkCount; ++i, _table += c_chunkHeaderSize)
+	{
+		ChunkHeader& header = headers[i];
+		memcpy(&header.codec, _table, 1);
+		memcpy(&header.storedSize, _table + 1, 4);
+		memcpy(&header.checksum, _table + 5, 4);
+
+		const size_t chunkByteCount = ccChunk::Size(i, chunkCount, elementCount) * elementSize;
+		switch (header.codec)
+		{
+		case ccSerializationHelper::CHUNK_RAW:
+			if (header.storedSize != chunkByteCount)
+				return ccSerializableObject::CorruptError();
+			break;
+		case ccSerializationHelper::CHUNK_ZLIB:
+			allRaw = false;
+			break;
+		default:
+			return ccSerializableObject::CorruptError();
+		}
+	}
+
+	return true;
+}
+
+//! Decodes the chunks of an array (by batches) and checks their checksum
+/** The decoded chunks are passed to a function (called in parallel): processChunk(chunk index, decoded data).
+	The decoded data is only valid during the call.
+**/
+template <class Function> static bool DecodeChunks(QFile& in, const std::vector<ChunkHeader>& headers, size_t elementCount, size_t elementSize, int flags, const Function& processChunk)
+{
+	const size_t chunkCount = headers.size();
+	std::atomic<bool> corrupted(false);
+
+	for (size_t batchStart = 0; batchStart < chunkCount; batchStart += c_chunkBatchSize)
+	{
+		const int batchCount = static_cast<int>(std::min(c_chunkBatchSize, chunkCount - batchStart));
+
+		//position of each chunk of the batch in the stored data
+		std::vector<qint64> storedOffsets(batchCount + 1, 0);
+		for (int i = 0; i < batchCount; ++i)
+		{
+			storedOffsets[i + 1] = storedOffsets[i] + headers[batchStart + i].storedSize;
+		}
+		const qint64 batchByteCount = storedOffsets.back();
+
+		//get the stored data (memory-mapped or not)
+		const qint64 batchPos = in.pos();
+		uchar* view = nullptr;
+		QByteArray buffer;
+		if (flags & ccSerializableObject::DF_MAPPED_READ)
+		{
+			view = in.map(batchPos, batchByteCount);
+		}
+		if (!view)
+		{
+			buffer = in.read(batchByteCount);
+			if (buffer.size() != batchByteCount)
+				return ccSerializableObject::ReadError();
+		}
+		const char* storedData = (view ? reinterpret_cast<const char*>(view) : buffer.constData());
+
+		//decode and check the chunks (in parallel)
+		ccParallelFor(batchCount, [&](int i)
+		{
+			const size_t chunkIndex = batchStart + i;
+			const ChunkHeader& header = headers[chunkIndex];
+			const char* chunkData = storedData + storedOffsets[i];
+			const size_t chunkByteCount = ccChunk::Size(chunkIndex, chunkCount, elementCount) * elementSize;
+
+			QByteArray uncompressed;
+			if (header.codec == ccSerializationHelper::CHUNK_ZLIB)
+			{
+				uncompressed = qUncompress(reinterpret_cast<const uchar*>(chunkData), static_cast<int>(header.storedSize));
+				if (static_cast<size_t>(uncompressed.size()) != chunkByteCount)
+				{
+					corrupted = true;
+					return;
+				}
+				chunkData = uncompressed.constData();
+			}
+
+			if (ccSerializationHelper::Checksum(chunkData, chunkByteCount) != header.checksum)
+			{
+				corrupted = true;
+				return;
+			}
+
+			processChunk(chunkIndex, chunkData);
+		});
+
+		if (view)
+		{
+			in.unmap(view);
+			if (!in.seek(batchPos + batchByteCount))
+				return ccSerializableObject::ReadError();
+		}
+
+		if (corrupted)
+		{
+			return ccSerializableObject::CorruptError();
+		}
+	}
+
+	return true;
+}
+
+bool ccSerializationHelper::ReadChunkedArrayData(QFile& in, char* dest, size_t elementCount, size_t elementSize, int flags)
+{
+	assert(in.isOpen() && (in.openMode() & QIODevice::ReadOnly));
+
+	const size_t chunkCount = ccChunk::Count(elementCount);
+	if (chunkCount == 0)
+	{
+		return true;
+	}
+
+	//read the chunk table
+	std::vector<ChunkHeader> headers;
+	bool allRaw = true;
+	if (!ReadChunkTable(in, elementCount, elementSize, headers, allRaw))
+	{
+		return false;
+	}
+
+	if (allRaw)
+	{
+		//the chunks are stored contiguously: we can read them in a row
+		if (!ReadArrayData(in, dest, static_cast<qint64>(elementCount * elementSize)))
+		{
+			return false;
+		}
+
+		//and then check them (in parallel)
+		std::atomic<bool> corrupted(false);
+		ccParallelFor(static_cast<int>(chunkCount), [&](int i)
+		{
+			const char* chunkData = dest + ccChunk::StartPos(i) * elementSize;
+			if (Checksum(chunkData, headers[i].storedSize) != headers[i].checksum)
+			{
+				corrupted = true;
+			}
+		});
+
+		return corrupted ? ccSerializableObject::CorruptError() : true;
+	}
+
+	return DecodeChunks(in, headers, elementCount, elementSize, flags, [&](size_t chunkIndex, const char* chunkData)
+	{
+		memcpy(dest + ccChunk::StartPos(chunkIndex) * elementSize, chunkData, ccChunk::Size(chunkIndex, chunkCount, elementCount) * elementSize);
+	});
+}
+
+bool ccSerializationHelper::ReadChunkedArrayData(QFile& in, size_t elementCount, size_t elementSize, const ChunkFunction& processChunk, int flags)
+{
+	assert(in.isOpen() && (in.openMode() & QIODevice::ReadOnly));
+
+	const size_t chunkCount = ccChunk::Count(elementCount);
+	if (chunkCount == 0)
+	{
+		return true;
+	}
+
+	//read the chunk table
+	std::vector<ChunkHeader> headers;
+	bool allRaw = true;
+	if (!ReadChunkTable(in, elementCount, elementSize, headers, allRaw))
+	{
+		return false;
+	}
+
+	return DecodeChunks(in, headers, elementCount, elementSize, flags, [&](size_t chunkIndex, const char* chunkData)
+	{
+		processChunk(ccChunk::StartPos(chunkIndex), chunkData, ccChunk::Size(chunkIndex, chunkCount, elementCount));
+	});
+}
@@ -0,0 +1,98 @@
+//##########################################################################
+//#                                                                        #
+//#                              CLOUDCOMPARE                              #
+//#                                                                        #
+//#  This program is free software; you can redistribute it and/or modify  #
+//#  it under the terms of the GNU General Public License as published by  #
+//#  the Free Software Foundation; version 2 or later of the License.      #
+//#                                                                        #
+//#  This program is distributed in the hope that it will be useful,       #
+//#  but WITHOUT ANY WARRANTY; without even the implied warranty of        #
+//#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          #
+//#  GNU General Public License for more details.                          #
+//#                                                                        #
+//#                    COPYRIGHT: CloudCompare project                     #
+//#                                                                        #
+//##########################################################################
+
+#include "ccSpatialBatches.h"
+
+//CCCoreLib
+#include <GenericIndexedCloud.h>
+#include <ParallelSort.h>
+
+//System
+#include <cstdint>
+#include <utility>
+
+//! Spreads the 21 lowest bits of a value (with 2 zero bits between each of them)
+static inline uint64_t SpreadBitsBy3(uint64_t v)
+{
+	v &= 0x1FFFFF;
+	v = (v | (v << 32)) & 0x1F00000000FFFFULL;
+	v = (v | (v << 16)) & 0x1F0000FF0000FFULL;
+	v = (v | (v << 8)) & 0x100F00F00F00F00FULL;
+	v = (v | (v << 4)) & 0x10C30C30C30C30C3ULL;
+	v = (v | (v << 2)) & 0x1249249249249249ULL;
+	return v;
+}
+
+bool ccSpatialBatches::SortByMortonCode(CCCoreLib::GenericIndexedCloud* cloud, std::vector<unsigned>& indexes)
+{
+	if (!cloud || indexes.size() < 2)
+	{
+		return true;
+	}
+
+	//bounding box of the points
+	CCVector3 bbMin = *cloud->getPoint(indexes.front());
+	CCVector3 bbMax = bbMin;
+	for (unsigned index : indexes)
+	{
+		const CCVector3* P = cloud->getPoint(index);
+		bbMin.x = std::min(bbMin.x, P->x);
+		bbMin.y = std::min(bbMin.y, P->y);
+		bbMin.z = std::min(bbMin.z, P->z);
+		bbMax.x = std::max(bbMax.x, P->x);
+		bbMax.y = std::max(bbMax.y, P->y);
+		bbMax.z = std::max(bbMax.z, P->z);
+	}
+	CCVector3 diag = bbMax - bbMin;
+	double maxDim = std::max(diag.x, std::max(diag.y, diag.z));
+	if (maxDim <= 0)
+	{
+		//all the points are at the same position
+		return true;
+	}
+	//cubical cells (2^21 per dimension)
+	const double scale = ((1 << 21) - 1) / maxDim;
+
+	std::vector< std::pair<uint64_t, unsigned> > codes;
+	try
+	{
+		codes.resize(indexes.size());
+	}
+	catch (const std::bad_alloc&)
+	{
+		//not enough memory
+		return false;
+	}
+
+	for (size_t i = 0; i < indexes.size(); ++i)
+	{
+		const CCVector3* P = cloud->getPoint(indexes[i]);
+		uint64_t x = static_cast<uint64_t>((P->x - bbMin.x) * scale);
+		uint64_t y = static_cast<uint64_t>((P->y - bbMin.y) * scale);
+		uint64_t z = static_cast<uint64_t>((P->z - bbMin.z) * scale);
+		codes[i] = { SpreadBitsBy3(x) | (SpreadBitsBy3(y) << 1) | (SpreadBitsBy3(z) << 2), indexes[i] };
+	}
+
+	ParallelSort(codes.begin(), codes.end());
+
+	for (size_t i = 0; i < indexes.size(); ++i)
+	{
+		indexes[i] = codes[i].second;
+	}
+
+	return true;
+}
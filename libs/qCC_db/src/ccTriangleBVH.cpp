@@ -0,0 +1,279 @@
+//##########################################################################
+//#                                                                        #
+//#                              CLOUDCOMPARE                              #
+//#                                                                        #
+//#  This program is free software; you can redistribute it and/or modify  #
+//#  it under the terms of the GNU General Public License as published by  #
+//#  the Free Software Foundation; version 2 or later of the License.      #
+//#                                                                        #
+//#  This program is distributed in the hope that it will be useful,       #
+//#  but WITHOUT ANY WARRANTY; without even the implied warranty of        #
+//#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          #
+//#  GNU General Public License for more details.                          #
+//#                                                                        #
+//#                    COPYRIGHT: CloudCompare project                     #
+//#                                                                        #
+//##########################################################################
+
+#include "ccTriangleBVH.h"
+
+//Local
+#include "ccGenericMesh.h"
+#include "ccGenericPointCloud.h"
+
+//system
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+ccTriangleBVH::ccTriangleBVH()
+	: m_triangleCount(0)
+	, m_vertices(nullptr)
+	, m_verticesVersion(0)
+{
+}
+
+bool ccTriangleBVH::build(const ccGenericMesh& mesh)
+{
+	m_nodes.clear();
+	m_triIndexes.clear();
+	m_triangleCount = 0;
+	m_vertices = nullptr;
+	m_verticesVersion = 0;
+
+	const unsigned triCount = mesh.size();
+	if (triCount == 0)
+	{
+		return false;
+	}
+
+	//per-triangle bounding-boxes and centers
+	std::vector<CCVector3f> triMin;
+	std::vector<CCVector3f> triMax;
+	std::vector<CCVector3f> triCenters;
+	try
+	{
+		triMin.resize(triCount);
+		triMax.resize(triCount);
+		triCenters.resize(triCount);
+		m_triIndexes.resize(triCount);
+		//a binary tree with N leaves has 2N-1 nodes
+		m_nodes.reserve(2 * (triCount / MAX_TRIANGLES_PER_LEAF + 1));
+	}
+	catch (const std::bad_alloc&)
+	{
+		m_nodes.clear();
+		m_triIndexes.clear();
+		return false;
+	}
+
+	for (unsigned i = 0; i < triCount; ++i)
+	{
+		CCVector3 A;
+		CCVector3 B;
+		CCVector3 C;
+		mesh.getTriangleVertices(i, A, B, C);
+
+		triMin[i] = CCVector3f(std::min(A.x, std::min(B.x, C.x)), std::min(A.y, std::min(B.y, C.y)), std::min(A.z, std::min(B.z, C.z)));
+		triMax[i] = CCVector3f(std::max(A.x, std::max(B.x, C.x)), std::max(A.y, std::max(B.y, C.y)), std::max(A.z, std::max(B.z, C.z)));
+		triCenters[i] = (triMin[i] + triMax[i]) / 2;
+		m_triIndexes[i] = i;
+	}
+
+	//iterative construction (depth first)
+	struct Range
+	{
+		uint32_t nodeIndex;
+		uint32_t begin;
+		uint32_t end;
+	};
+	std::vector<Range> toProcess;
+	m_nodes.resize(1);
+	toProcess.push_back({ 0, 0, triCount });
+
+	while (!toProcess.empty())
+	{
+		Range range = toProcess.back();
+		toProcess.pop_back();
+
+		//bounding-box of the triangles and of their centers
+		CCVector3f bbMin = triMin[m_triIndexes[range.begin]];
+		CCVector3f bbMax = triMax[m_triIndexes[range.begin]];
+		CCVector3f centerMin = triCenters[m_triIndexes[range.begin]];
+		CCVector3f centerMax = centerMin;
+		for (uint32_t i = range.begin + 1; i < range.end; ++i)
+		{
+			const unsigned triIndex = m_triIndexes[i];
+			for (unsigned d = 0; d < 3; ++d)
+			{
+				bbMin.u[d] = std::min(bbMin.u[d], triMin[triIndex].u[d]);
+				bbMax.u[d] = std::max(bbMax.u[d], triMax[triIndex].u[d]);
+				centerMin.u[d] = std::min(centerMin.u[d], triCenters[triIndex].u[d]);
+				centerMax.u[d] = std::max(centerMax.u[d], triCenters[triIndex].u[d]);
+			}
+		}
+
+		{
+			Node& node = m_nodes[range.nodeIndex];
+			node.bbMin = bbMin;
+			node.bbMax = bbMax;
+		}
+
+		const uint32_t count = range.end - range.begin;
+		if (count <= MAX_TRIANGLES_PER_LEAF)
+		{
+			//leaf
+			Node& node = m_nodes[range.nodeIndex];
+			node.start = range.begin;
+			node.count = count;
+			continue;
+		}
+
+		//median split along the largest dimension (of the centers bounding-box)
+		const CCVector3f diag = centerMax - centerMin;
+		const unsigned splitDim = (diag.x >= diag.y ? (diag.x >= diag.z ? 0 : 2) : (diag.y >= diag.z ? 1 : 2));
+		const uint32_t middle = range.begin + count / 2;
+		std::nth_element(	m_triIndexes.begin() + range.begin,
+							m_triIndexes.begin() + middle,
+							m_triIndexes.begin() + range.end,
+							[&](unsigned a, unsigned b) { return triCenters[a].u[splitDim] < triCenters[b].u[splitDim]; });
+
+		//the two children are stored consecutively
+		const uint32_t firstChildIndex = static_cast<uint32_t>(m_nodes.size());
+		m_nodes.resize(m_nodes.size() + 2);
+		{
+			Node& node = m_nodes[range.nodeIndex];
+			node.start = firstChildIndex;
+			node.count = 0;
+		}
+		toProcess.push_back({ firstChildIndex + 1, middle, range.end });
+		toProcess.push_back({ firstChildIndex, range.begin, middle });
+	}
+
+	m_triangleCount = triCount;
+	m_vertices = mesh.getAssociatedCloud();
+	m_verticesVersion = (m_vertices ? m_vertices->getGeometryVersion() : 0);
+
+	return true;
+}
+
+bool ccTriangleBVH::isValidFor(const ccGenericMesh& mesh) const
+{
+	const ccGenericPointCloud* vertices = mesh.getAssociatedCloud();
+	return (	!m_nodes.empty()
+			&&	m_triangleCount == mesh.size()
+			&&	m_vertices == vertices
+			&&	(!vertices || m_verticesVersion == vertices->getGeometryVersion()) );
+}
+
+size_t ccTriangleBVH::memory() const
+{
+	return m_nodes.capacity() * sizeof(Node) + m_triIndexes.capacity() * sizeof(unsigned);
+}
+
+//! Returns the ray parameter at which a ray enters a box (or a negative value if the ray misses it)
+static double RayEntersBox(const CCVector3d& origin, const CCVector3d& invDir, const CCVector3f& bbMin, const CCVector3f& bbMax)
+{
+	double tNear = 0.0;
+	double tFar = std::numeric_limits<double>::max();
+	for (unsigned d = 0; d < 3; ++d)
+	{
+		//we slightly enlarge the box to cope with rounding errors
+		const double margin = 1.0e-6 * (1.0 + std::abs(bbMax.u[d]) + std::abs(bbMin.u[d]));
+		double t1 = (bbMin.u[d] - margin - origin.u[d]) * invDir.u[d];
+		double t2 = (bbMax.u[d] + margin - origin.u[d]) * invDir.u[d];
+		if (std::isnan(t1) || std::isnan(t2))
+		{
+			//the ray is parallel to the slab and its origin is on its border
+			continue;
+		}
+		if (t1 > t2)
+		{
+			std::swap(t1, t2);
+		}
+		tNear = std::max(tNear, t1);
+		tFar = std::min(tFar, t2);
+		if (tNear > tFar)
+		{
+			return -1.0;
+		}
+	}
+
+	return tNear;
+}
+
+int ccTriangleBVH::intersect(const CCVector3d& origin, const CCVector3d& dir, const HitFunction& hit) const
+{
+	if (m_nodes.empty())
+	{
+		return -1;
+	}
+
+	const CCVector3d invDir(1.0 / dir.x, 1.0 / dir.y, 1.0 / dir.z);
+
+	int nearestTriIndex = -1;
+	double nearestT = std::numeric_limits<double>::max();
+
+	struct Entry
+	{
+		uint32_t nodeIndex;
+		double tNear;
+	};
+	std::vector<Entry> toVisit;
+	{
+		double tRoot = RayEntersBox(origin, invDir, m_nodes.front().bbMin, m_nodes.front().bbMax);
+		if (tRoot < 0)
+		{
+			return -1;
+		}
+		toVisit.push_back({ 0, tRoot });
+	}
+
+	while (!toVisit.empty())
+	{
+		Entry entry = toVisit.back();
+		toVisit.pop_back();
+
+		if (entry.tNear > nearestT)
+		{
+			//we already have a closer hit
+			continue;
+		}
+
+		const Node& node = m_nodes[entry.nodeIndex];
+		if (node.count != 0)
+		{
+			//leaf: we test each triangle
+			for (uint32_t i = node.start; i < node.start + node.count; ++i)
+			{
+				double t = 0.0;
+				if (hit(m_triIndexes[i], t) && t < nearestT)
+				{
+					nearestT = t;
+					nearestTriIndex = static_cast<int>(m_triIndexes[i]);
+				}
+			}
+		}
+		else
+		{
+			double t1 = RayEntersBox(origin, invDir, m_nodes[node.start].bbMin, m_nodes[node.start].bbMax);
+			double t2 = RayEntersBox(origin, invDir, m_nodes[node.start + 1].bbMin, m_nodes[node.start + 1].bbMax);
+
+			//the nearest child will be visited first
+			if (t1 >= 0 && t2 >= 0 && t1 < t2)
+			{
+				toVisit.push_back({ node.start + 1, t2 });
+				toVisit.push_back({ node.start, t1 });
+			}
+			else
+			{
+				if (t1 >= 0)
+					toVisit.push_back({ node.start, t1 });
+				if (t2 >= 0)
+					toVisit.push_back({ node.start + 1, t2 });
+			}
+		}
+	}
+
+	return nearestTriIndex;
+}
@@ -54,11 +54,13 @@ class ccGlFilter;
 class ccHObject;
 class ccInteractor;
 class ccPolyline;
+class ccRenderingProfiler;
 class ccShader;
 
 struct HotZone;
 
 #ifdef CC_GL_WINDOW_USE_QWINDOW
+class QOffscreenSurface;
 class QOpenGLPaintDevice;
 using ccGLWindowParent = QWindow;
 #else
@@ -162,6 +164,21 @@ public:
 	QString windowTitle() const { return title(); }
 #endif
 
+	//! Enables the offscreen mode (headless rendering)
+	/** The window is never shown: the scene is rendered in an offscreen surface
+		(pbuffer or surfaceless context, depending on the Qt platform plugin) or in
+		a widget that is never displayed on screen (QOpenGLWidget version), and the
+		frames can only be retrieved with renderToImage or renderToFile.
+		\warning Must be called before the window is initialized.
+		\param width rendering width (in pixels)
+		\param height rendering height (in pixels)
+		\return success
+	**/
+	bool initOffscreen(int width, int height);
+
+	//! Returns whether the window is in offscreen mode
+	inline bool isOffscreen() const { return m_offscreen; }
+
 	//! Sets 'scene graph' root
 	void setSceneDB(ccHObject* root);
 
@@ -559,6 +576,22 @@ public: //debug traces on screen
 	//! Toggles debug info on screen
 	inline void toggleDebugTrace() { m_showDebugTraces = !m_showDebugTraces; }
 
+public: //rendering profiler
+
+	//! Enables or disables the rendering profiler (and its overlay)
+	/** The recorded frames are kept until the profiler is disabled.
+	**/
+	void enableProfiler(bool state);
+
+	//! Toggles the rendering profiler
+	inline void toggleProfiler() { enableProfiler(!profilerEnabled()); }
+
+	//! Returns whether the rendering profiler is enabled
+	inline bool profilerEnabled() const { return m_profiler != nullptr; }
+
+	//! Returns the rendering profiler (if enabled)
+	inline const ccRenderingProfiler* profiler() const { return m_profiler; }
+
 public: //stereo mode
 
 	//! Seterovision parameters
@@ -1044,8 +1077,14 @@ protected: //members
 	//! Associated widget (we use the WidgetContainer mechanism)
 	QWidget* m_parentWidget;
 
+	//! Offscreen surface (headless rendering mode only)
+	QOffscreenSurface* m_offscreenSurface;
+
 #endif
 
+	//! Whether the window is in offscreen mode (see initOffscreen)
+	bool m_offscreen;
+
 	//! Unique ID
 	int m_uniqueID;
 
@@ -1289,6 +1328,9 @@ protected: //members
 	//! Debug traces visibility
 	bool m_showDebugTraces;
 
+	//! Rendering profiler (if enabled)
+	ccRenderingProfiler* m_profiler;
+
 	//! Picking radius (pixels)
 	int m_pickRadius;
 
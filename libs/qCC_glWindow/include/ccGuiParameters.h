@@ -82,6 +82,12 @@ public:
 		bool displayCross;
 		//! Whether to use VBOs for faster display
 		bool useVBOs;
+		//! Whether to use the compact (quantized) VBO layout
+		bool compactVBOs;
+		//! Whether to stream big clouds on the GPU by pages (LOD)
+		bool streamCloudsLOD;
+		//! GPU memory budget for the streamed clouds (shared by all the clouds of a 3D view, in Mb)
+		unsigned lodStreamingBudgetMb;
 
 		//! Label marker size
 		unsigned labelMarkerSize;
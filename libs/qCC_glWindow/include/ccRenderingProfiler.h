@@ -0,0 +1,165 @@
+#pragma once
+//##########################################################################
+//#                                                                        #
+//#                              CLOUDCOMPARE                              #
+//#                                                                        #
+//#  This program is free software; you can redistribute it and/or modify  #
+//#  it under the terms of the GNU General Public License as published by  #
+//#  the Free Software Foundation; version 2 or later of the License.      #
+//#                                                                        #
+//#  This program is distributed in the hope that it will be useful,       #
+//#  but WITHOUT ANY WARRANTY; without even the implied warranty of        #
+//#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          #
+//#  GNU General Public License for more details.                          #
+//#                                                                        #
+//#                    COPYRIGHT: CloudCompare project                     #
+//#                                                                        #
+//##########################################################################
+
+#include "qCC_glWindow.h"
+
+//qCC_db
+#include <ccGLDrawContext.h>
+
+//Qt
+#include <QElapsedTimer>
+#include <QStringList>
+
+//system
+#include <deque>
+
+//! Records the rendering timings and statistics of a 3D view (frame by frame)
+/** The rendering passes are split in several sections (background, main 3D layer,
+	GL filter (EDL, SSAO, etc.) and foreground). When the profiler is active, the
+	GPU queue is flushed (glFinish) at the end of each section so that the measured
+	times include the actual GPU work (this slightly slows down the display).
+**/
+class CCGLWINDOW_LIB_API ccRenderingProfiler
+{
+public:
+
+	//! Rendering sections
+	enum Section
+	{
+		BACKGROUND = 0,
+		DRAW_3D,
+		GL_FILTER,
+		FOREGROUND,
+		SECTION_COUNT
+	};
+
+	//! Returns the name of a section
+	static QString SectionName(Section section);
+
+	//! Frame record
+	struct FrameRecord
+	{
+		//! Frame index
+		quint64 index = 0;
+		//! Frame start (in ms, since the profiler creation)
+		qint64 timestamp_ms = 0;
+		//! Total frame time (in ms)
+		double total_ms = 0.0;
+		//! Time spent in each section (in ms)
+		double sections_ms[SECTION_COUNT] = { 0.0, 0.0, 0.0, 0.0 };
+		//! Number of rendering passes (2 in stereo mode)
+		unsigned passCount = 0;
+		//! LOD level reached
+		unsigned char lodLevel = 0;
+		//! Whether the LOD display process is still in progress (more levels to come)
+		bool lodInProgress = false;
+		//! Number of points drawn
+		quint64 pointsDrawn = 0;
+		//! Number of bytes uploaded on the GPU
+		quint64 uploadedBytes = 0;
+		//! Slowest entities (see MAX_ENTITIES_PER_FRAME)
+		std::vector<ccRenderingStats::EntityTiming> slowestEntities;
+	};
+
+	//! Default max number of recorded frames
+	static const size_t DEFAULT_MAX_FRAME_COUNT = 1000;
+	//! Max number of entities recorded per frame (the slowest ones)
+	static const size_t MAX_ENTITIES_PER_FRAME = 5;
+
+	//! Default constructor
+	/** \param maxFrameCount max number of recorded frames (the oldest ones are discarded)
+	**/
+	explicit ccRenderingProfiler(size_t maxFrameCount = DEFAULT_MAX_FRAME_COUNT);
+
+	//! Starts a new frame
+	/** \param passCount number of rendering passes (2 in stereo mode)
+	**/
+	void startFrame(unsigned passCount);
+
+	//! Starts a section (of the current frame)
+	void startSection(Section section);
+
+	//! Stops the current section
+	void stopSection();
+
+	//! Stops the current frame
+	/** \param lodLevel LOD level reached
+		\param lodInProgress whether the LOD display process is still in progress
+	**/
+	void stopFrame(unsigned char lodLevel, bool lodInProgress);
+
+	//! Returns whether a frame is being recorded
+	inline bool frameInProgress() const { return m_frameInProgress; }
+
+	//! Returns the statistics of the current frame (to be filled by the entities)
+	inline ccRenderingStats& stats() { return m_stats; }
+
+	//! Returns the recorded frames (the oldest first)
+	inline const std::deque<FrameRecord>& frames() const { return m_frames; }
+
+	//! Clears the recorded frames
+	void clear();
+
+	//! Returns the text to display on screen (last frame and average values)
+	QStringList overlayStrings() const;
+
+	//! Exports the recorded frames
+	/** JSON format if the file extension is 'json', CSV otherwise.
+		\param filename output filename
+		\return success
+	**/
+	bool exportToFile(const QString& filename) const;
+
+protected:
+
+	//! Exports the recorded frames as a CSV file
+	bool exportToCSV(const QString& filename) const;
+
+	//! Exports the recorded frames as a JSON file
+	bool exportToJSON(const QString& filename) const;
+
+	//! Max number of recorded frames
+	size_t m_maxFrameCount;
+
+	//! Recorded frames
+	std::deque<FrameRecord> m_frames;
+
+	//! Current frame
+	FrameRecord m_currentFrame;
+
+	//! Statistics of the current frame
+	ccRenderingStats m_stats;
+
+	//! Whether a frame is being recorded
+	bool m_frameInProgress;
+
+	//! Current section (if any)
+	int m_currentSection;
+
+	//! Frame counter
+	quint64 m_frameCounter;
+
+	//! Internal timer
+	QElapsedTimer m_timer;
+
+	//! Current frame start (in ns)
+	qint64 m_frameStart_ns;
+
+	//! Current section start (in ns)
+	qint64 m_sectionStart_ns;
+};
@@ -17,6 +17,7 @@
 
 //qCC
 #include "ccGLWindow.h"
+#include "ccRenderingProfiler.h"
 #include "ccRenderingTools.h"
 
 //qCC_db
@@ -50,6 +51,7 @@
 #endif
 
 #ifdef CC_GL_WINDOW_USE_QWINDOW
+#include <QOffscreenSurface>
 #include <QOpenGLPaintDevice>
 #endif
 
@@ -331,7 +333,9 @@ ccGLWindow::ccGLWindow(	QSurfaceFormat* format/*=nullptr*/,
 	, m_context(nullptr)
 	, m_device(new QOpenGLPaintDevice)
 	, m_parentWidget(nullptr)
+	, m_offscreenSurface(nullptr)
 #endif
+	, m_offscreen(false)
 	, m_uniqueID(++s_GlWindowNumber) //GL window unique ID
 	, m_initialized(false)
 	, m_trihedronGLList(GL_INVALID_LIST_ID)
@@ -390,6 +394,7 @@ ccGLWindow::ccGLWindow(	QSurfaceFormat* format/*=nullptr*/,
 	, m_formerParent(nullptr)
 	, m_exclusiveFullscreen(false)
 	, m_showDebugTraces(false)
+	, m_profiler(nullptr)
 	, m_pickRadius(DefaultPickRadius)
 	, m_glExtFuncSupported(false)
 	, m_autoRefresh(false)
@@ -554,12 +559,18 @@ ccGLWindow::~ccGLWindow()
 	delete m_fbo2;
 	m_fbo2 = nullptr;
 
+	delete m_profiler;
+	m_profiler = nullptr;
+
 #ifdef CC_GL_WINDOW_USE_QWINDOW
 	if (m_context)
 		m_context->doneCurrent();
 
 	delete m_device;
 	m_device = nullptr;
+
+	delete m_offscreenSurface;
+	m_offscreenSurface = nullptr;
 #endif
 
 	m_pickingPBO.release();
@@ -580,6 +591,57 @@ void ccGLWindow::releaseMouse()
 	setMouseGrabEnabled(false);
 }
 
+bool ccGLWindow::initOffscreen(int width, int height)
+{
+	if (m_context || m_offscreenSurface)
+	{
+		ccLog::Warning("[ccGLWindow] The offscreen mode must be enabled before the 3D view initialization");
+		return false;
+	}
+	if (width <= 0 || height <= 0)
+	{
+		ccLog::Warning("[ccGLWindow] Invalid offscreen rendering size");
+		return false;
+	}
+
+	m_offscreenSurface = new QOffscreenSurface;
+	m_offscreenSurface->setFormat(m_format);
+	m_offscreenSurface->create();
+	if (!m_offscreenSurface->isValid())
+	{
+		ccLog::Warning("[ccGLWindow] Failed to create the offscreen surface (try with the 'offscreen' or 'eglfs' Qt platform plugins)");
+		delete m_offscreenSurface;
+		m_offscreenSurface = nullptr;
+		return false;
+	}
+
+	//the window will never be shown (its size is only used as rendering size)
+	resize(width, height);
+
+	if (!initialize())
+	{
+		return false;
+	}
+	if (!m_glExtFuncSupported)
+	{
+		//the frames can only be retrieved through an FBO
+		ccLog::Warning("[ccGLWindow] FBOs are not supported: offscreen rendering is not possible");
+		return false;
+	}
+
+	//no resize event will be received in offscreen mode
+	resizeGL(width, height);
+
+	//we make sure the main FBO exists, so that renderToImage doesn't need to create a new one for each frame
+	if (!m_fbo)
+	{
+		initFBO(width, height);
+	}
+
+	m_offscreen = true;
+	return true;
+}
+
 void ccGLWindow::setParentWidget(QWidget* widget)
 {
 	m_parentWidget = widget;
@@ -593,6 +655,50 @@ void ccGLWindow::setParentWidget(QWidget* widget)
 	}
 }
 
+#else
+
+bool ccGLWindow::initOffscreen(int width, int height)
+{
+	if (m_initialized || isVisible())
+	{
+		ccLog::Warning("[ccGLWindow] The offscreen mode must be enabled before the 3D view initialization");
+		return false;
+	}
+	if (width <= 0 || height <= 0)
+	{
+		ccLog::Warning("[ccGLWindow] Invalid offscreen rendering size");
+		return false;
+	}
+
+	//the widget needs a native window to get its OpenGL context, but it will never be displayed
+	setAttribute(Qt::WA_DontShowOnScreen, true);
+	resize(width, height);
+	show(); //the context is created and initializeGL is called when the widget is 'shown'
+	if (!m_initialized)
+	{
+		ccLog::Warning("[ccGLWindow] Failed to initialize the offscreen 3D view (try with the 'offscreen' Qt platform plugin)");
+		return false;
+	}
+	if (!m_glExtFuncSupported)
+	{
+		//the frames can only be retrieved through an FBO
+		ccLog::Warning("[ccGLWindow] FBOs are not supported: offscreen rendering is not possible");
+		return false;
+	}
+
+	makeCurrent();
+	resizeGL(width, height);
+
+	//we make sure the main FBO exists, so that renderToImage doesn't need to create a new one for each frame
+	if (!m_fbo)
+	{
+		initFBO(width, height);
+	}
+
+	m_offscreen = true;
+	return true;
+}
+
 #endif
 
 void ccGLWindow::makeCurrent()
@@ -600,7 +706,10 @@ void ccGLWindow::makeCurrent()
 #ifdef CC_GL_WINDOW_USE_QWINDOW
 	if (m_context)
 	{
-		m_context->makeCurrent(this);
+		if (m_offscreenSurface)
+			m_context->makeCurrent(m_offscreenSurface);
+		else
+			m_context->makeCurrent(this);
 	}
 #else
 	QOpenGLWidget::makeCurrent();
@@ -788,7 +897,10 @@ bool ccGLWindow::initialize()
 	{
 		return false;
 	}
-	m_context->makeCurrent(this);
+	if (m_offscreenSurface)
+		m_context->makeCurrent(m_offscreenSurface);
+	else
+		m_context->makeCurrent(this);
 #endif
 
 	ccQOpenGLFunctions* glFunc = functions();
@@ -1644,6 +1756,13 @@ void ccGLWindow::paintGL()
 	renderingParams.draw3DCross = getDisplayParameters().displayCross;
 	renderingParams.passCount = m_stereoModeEnabled ? 2 : 1;
 
+	//rendering profiler
+	if (m_profiler)
+	{
+		m_profiler->startFrame(renderingParams.passCount);
+		CONTEXT.stats = &m_profiler->stats();
+	}
+
 	//clean the outdated messages
 	{
 		std::list<MessageToDisplay>::iterator it = m_messagesToDisplay.begin();
@@ -1677,6 +1796,12 @@ void ccGLWindow::paintGL()
 #endif
 	}
 
+	if (m_profiler)
+	{
+		m_profiler->stopFrame(m_currentLODState.level, renderingParams.nextLODState.inProgress);
+		CONTEXT.stats = nullptr;
+	}
+
 #ifdef CC_GL_WINDOW_USE_QWINDOW
 	if (	!m_stereoModeEnabled
 		||	m_stereoParams.glassType != StereoParams::OCULUS
@@ -1799,6 +1924,27 @@ void ccGLWindow::renderNextLODLevel()
 	}
 }
 
+void ccGLWindow::enableProfiler(bool state)
+{
+	if (state == profilerEnabled())
+	{
+		return;
+	}
+
+	if (state)
+	{
+		m_profiler = new ccRenderingProfiler;
+	}
+	else
+	{
+		delete m_profiler;
+		m_profiler = nullptr;
+	}
+
+	//we need a full redraw to get consistent timings
+	redraw(false, false);
+}
+
 void ccGLWindow::drawBackground(CC_DRAW_CONTEXT& CONTEXT, RenderingParams& renderingParams)
 {
 	ccQOpenGLFunctions* glFunc = functions();
@@ -2051,7 +2197,18 @@ void ccGLWindow::fullRenderingPass(CC_DRAW_CONTEXT& CONTEXT, RenderingParams& re
 			renderingParams.clearColorLayer = false;
 		}
 
+		if (m_profiler)
+		{
+			m_profiler->startSection(ccRenderingProfiler::BACKGROUND);
+		}
+
 		drawBackground(CONTEXT, renderingParams);
+
+		if (m_profiler)
+		{
+			glFunc->glFinish();
+			m_profiler->stopSection();
+		}
 	}
 
 	/*********************/
@@ -2099,8 +2256,19 @@ void ccGLWindow::fullRenderingPass(CC_DRAW_CONTEXT& CONTEXT, RenderingParams& re
 			}
 		}
 
+		if (m_profiler)
+		{
+			m_profiler->startSection(ccRenderingProfiler::DRAW_3D);
+		}
+
 		draw3D(CONTEXT, renderingParams);
 
+		if (m_profiler)
+		{
+			glFunc->glFinish();
+			m_profiler->stopSection();
+		}
+
 		if (m_stereoModeEnabled && m_stereoParams.isAnaglyph())
 		{
 			//restore default color mask
@@ -2185,8 +2353,17 @@ void ccGLWindow::fullRenderingPass(CC_DRAW_CONTEXT& CONTEXT, RenderingParams& re
 					parameters.zNear = m_viewportParams.zNear;
 				}
 				//apply shader
+				if (m_profiler)
+				{
+					m_profiler->startSection(ccRenderingProfiler::GL_FILTER);
+				}
 				m_activeGLFilter->shade(depthTex, colorTex, parameters);
 				logGLError("ccGLWindow::paintGL/glFilter shade");
+				if (m_profiler)
+				{
+					glFunc->glFinish();
+					m_profiler->stopSection();
+				}
 				bindFBO(nullptr); //in case the active filter has used a FBOs!
 
 				//if capture mode is ON: we only want to capture it, not to display it
@@ -2292,7 +2469,61 @@ void ccGLWindow::fullRenderingPass(CC_DRAW_CONTEXT& CONTEXT, RenderingParams& re
 	/******************/
 	if (renderingParams.drawForeground && !oculusMode)
 	{
+		if (m_profiler)
+		{
+			m_profiler->startSection(ccRenderingProfiler::FOREGROUND);
+		}
+
 		drawForeground(CONTEXT, renderingParams);
+
+		if (m_profiler)
+		{
+			glFunc->glFinish();
+			m_profiler->stopSection();
+		}
+	}
+
+	//rendering profiler overlay (statistics of the last complete frame)
+	//(like the other foreground items, it is not drawn in the images rendered with renderToImage)
+	if (m_profiler && renderingParams.drawForeground && !oculusMode && renderingParams.passIndex == MONO_OR_LEFT_RENDERING_PASS)
+	{
+		QStringList profilerStrings = m_profiler->overlayStrings();
+		int x = 0;
+		int y = 0;
+		int width = 0;
+		{
+			QFontMetrics fm(m_font);
+			for (const QString& str : profilerStrings)
+			{
+				width = std::max(width, fm.width(str));
+			}
+			width += 20;
+		}
+
+		setStandardOrthoCorner();
+		glFunc->glPushAttrib(GL_DEPTH_BUFFER_BIT);
+		glFunc->glDisable(GL_DEPTH_TEST);
+
+		//draw black background
+		{
+			int height = (profilerStrings.size() + 1) * 14;
+			glColor4ubv_safe<ccQOpenGLFunctions>(glFunc, ccColor::black.rgba);
+			glFunc->glBegin(GL_QUADS);
+			glFunc->glVertex2i(x, glHeight() - y);
+			glFunc->glVertex2i(x, glHeight() - (y + height));
+			glFunc->glVertex2i(x + width, glHeight() - (y + height));
+			glFunc->glVertex2i(x + width, glHeight() - y);
+			glFunc->glEnd();
+		}
+
+		glColor4ubv_safe<ccQOpenGLFunctions>(glFunc, ccColor::yellow.rgba);
+		for (const QString& str : profilerStrings)
+		{
+			renderText(x + 10, y + 10, str);
+			y += 14;
+		}
+
+		glFunc->glPopAttrib(); //GL_DEPTH_BUFFER_BIT
 	}
 
 	glFunc->glFlush();
@@ -2470,6 +2701,12 @@ void ccGLWindow::draw3D(CC_DRAW_CONTEXT& CONTEXT, RenderingParams& renderingPara
 	//we draw 3D entities
 	if (m_globalDBRoot)
 	{
+		if (MACRO_LODActivated(CONTEXT) && m_currentLODState.level == 0)
+		{
+			//we test the LOD visibility of all the clouds at once (in parallel)
+			ccPointCloud::PrepareLODVisibility(m_globalDBRoot, CONTEXT, modelViewMat, projectionMat);
+		}
+
 		m_globalDBRoot->draw(CONTEXT);
 	}
 
@@ -2520,8 +2757,11 @@ void ccGLWindow::draw3D(CC_DRAW_CONTEXT& CONTEXT, RenderingParams& renderingPara
 				}
 				else
 				{
-					//or the level
-					renderingParams.nextLODState.level++;
+					//or the level (DGM: the streamed LOD pages may need more than 255 passes)
+					if (renderingParams.nextLODState.level < 255)
+					{
+						renderingParams.nextLODState.level++;
+					}
 					renderingParams.nextLODState.startIndex = 0;
 				}
 			}
@@ -3666,6 +3906,9 @@ void ccGLWindow::getContext(CC_DRAW_CONTEXT& CONTEXT)
 
 	//display acceleration
 	CONTEXT.useVBOs = guiParams.useVBOs;
+	CONTEXT.useCompactVBOs = guiParams.compactVBOs;
+	CONTEXT.lodStreaming = guiParams.useVBOs && guiParams.streamCloudsLOD;
+	CONTEXT.lodStreamingBudget = static_cast<size_t>(guiParams.lodStreamingBudgetMb) << 20;
 
 	//other options
 	CONTEXT.drawRoundedPoints = guiParams.drawRoundedPoints;
@@ -5113,7 +5356,10 @@ void ccGLWindow::startCPUBasedPointPicking(const PickingParameters& params)
 				{
 					ccGenericPointCloud* cloud = static_cast<ccGenericPointCloud*>(ent);
 
-					if (firstCloudWithoutOctree && !cloud->getOctree() && cloud->size() > MIN_POINTS_FOR_OCTREE_COMPUTATION) //no need to use the octree for a few points!
+					//big clouds rely on their LOD structure instead (unless it is broken, see ccPointCloud::canPickWithLOD)
+					bool useLOD = cloud->canPickWithLOD();
+
+					if (firstCloudWithoutOctree && !useLOD && !cloud->getOctree() && cloud->size() > MIN_POINTS_FOR_OCTREE_COMPUTATION) //no need to use the octree for a few points!
 					{
 						//can we compute an octree for picking?
 						ccGui::ParamStruct::ComputeOctreeForPicking behavior = getDisplayParameters().autoComputeOctree;
@@ -5187,7 +5433,7 @@ void ccGLWindow::startCPUBasedPointPicking(const PickingParameters& params)
 						nearestSquareDist,
 						params.pickWidth,
 						params.pickHeight,
-						autoComputeOctree && cloud->size() > MIN_POINTS_FOR_OCTREE_COMPUTATION))
+						autoComputeOctree && !useLOD && cloud->size() > MIN_POINTS_FOR_OCTREE_COMPUTATION))
 					{
 						if (nearestElementIndex < 0 || (nearestPointIndex >= 0 && nearestSquareDist < nearestElementSquareDist))
 						{
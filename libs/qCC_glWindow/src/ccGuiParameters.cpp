@@ -85,6 +85,9 @@ void ccGui::ParamStruct::reset()
 	decimateCloudOnMove			= true;
 	minLoDCloudSize				= 10000000;
 	useVBOs						= true;
+	compactVBOs					= false;
+	streamCloudsLOD				= false;
+	lodStreamingBudgetMb		= 1024;
 	displayCross				= true;
 
 	labelMarkerSize				= 5;
@@ -141,6 +144,9 @@ void ccGui::ParamStruct::fromPersistentSettings()
 	decimateCloudOnMove			=                                      settings.value("cloudDecimation",         true ).toBool();
 	minLoDCloudSize				=                                      settings.value("minLoDCloudSize",     10000000 ).toUInt();
 	useVBOs						=                                      settings.value("useVBOs",                 true ).toBool();
+	compactVBOs					=                                      settings.value("compactVBOs",             false).toBool();
+	streamCloudsLOD				=                                      settings.value("streamCloudsLOD",         false).toBool();
+	lodStreamingBudgetMb		= static_cast<unsigned>(std::max(64,   settings.value("lodStreamingBudgetMb",    1024 ).toInt()));
 	displayCross				=                                      settings.value("crossDisplayed",          true ).toBool();
 	labelMarkerSize				= static_cast<unsigned>(std::max(0,    settings.value("labelMarkerSize",         5    ).toInt()));
 	colorScaleShowHistogram		=                                      settings.value("colorScaleShowHistogram", true ).toBool();
@@ -181,6 +187,9 @@ void ccGui::ParamStruct::toPersistentSettings() const
 	settings.setValue("cloudDecimation",          decimateCloudOnMove);
 	settings.setValue("minLoDCloudSize",	      minLoDCloudSize);
 	settings.setValue("useVBOs",                  useVBOs);
+	settings.setValue("compactVBOs",              compactVBOs);
+	settings.setValue("streamCloudsLOD",          streamCloudsLOD);
+	settings.setValue("lodStreamingBudgetMb",     lodStreamingBudgetMb);
 	settings.setValue("crossDisplayed",           displayCross);
 	settings.setValue("labelMarkerSize",          labelMarkerSize);
 	settings.setValue("colorScaleShowHistogram",  colorScaleShowHistogram);
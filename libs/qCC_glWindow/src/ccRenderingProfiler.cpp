@@ -0,0 +1,297 @@
+//##########################################################################
+//#                                                                        #
+//#                              CLOUDCOMPARE                              #
+//#                                                                        #
+//#  This program is free software; you can redistribute it and/or modify  #
+//#  it under the terms of the GNU General Public License as published by  #
+//#  the Free Software Foundation; version 2 or later of the License.      #
+//#                                                                        #
+//#  This program is distributed in the hope that it will be useful,       #
+//#  but WITHOUT ANY WARRANTY; without even the implied warranty of        #
+//#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          #
+//#  GNU General Public License for more details.                          #
+//#                                                                        #
+//#                    COPYRIGHT: CloudCompare project                     #
+//#                                                                        #
+//##########################################################################
+
+#include "ccRenderingProfiler.h"
+
+//qCC_db
+#include <ccLog.h>
+
+//Qt
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTextStream>
+
+//system
+#include <algorithm>
+#include <cassert>
+
+//! Number of frames used to compute the average values (overlay)
+static const size_t s_averageFrameCount = 30;
+
+QString ccRenderingProfiler::SectionName(Section section)
+{
+	switch (section)
+	{
+	case BACKGROUND:
+		return "background";
+	case DRAW_3D:
+		return "3D";
+	case GL_FILTER:
+		return "GL filter";
+	case FOREGROUND:
+		return "foreground";
+	default:
+		assert(false);
+		break;
+	}
+
+	return QString();
+}
+
+ccRenderingProfiler::ccRenderingProfiler(size_t maxFrameCount/*=DEFAULT_MAX_FRAME_COUNT*/)
+	: m_maxFrameCount(std::max<size_t>(maxFrameCount, 1))
+	, m_frameInProgress(false)
+	, m_currentSection(-1)
+	, m_frameCounter(0)
+	, m_frameStart_ns(0)
+	, m_sectionStart_ns(0)
+{
+	m_timer.start();
+}
+
+void ccRenderingProfiler::startFrame(unsigned passCount)
+{
+	m_currentFrame = FrameRecord();
+	m_currentFrame.index = m_frameCounter++;
+	m_currentFrame.passCount = passCount;
+	m_currentFrame.timestamp_ms = m_timer.elapsed();
+	m_stats.reset();
+	m_currentSection = -1;
+	m_frameStart_ns = m_timer.nsecsElapsed();
+	m_frameInProgress = true;
+}
+
+void ccRenderingProfiler::startSection(Section section)
+{
+	if (!m_frameInProgress)
+	{
+		return;
+	}
+
+	assert(section < SECTION_COUNT);
+	if (m_currentSection >= 0)
+	{
+		//the previous section hasn't been stopped
+		stopSection();
+	}
+
+	m_currentSection = section;
+	m_sectionStart_ns = m_timer.nsecsElapsed();
+}
+
+void ccRenderingProfiler::stopSection()
+{
+	if (!m_frameInProgress || m_currentSection < 0)
+	{
+		return;
+	}
+
+	m_currentFrame.sections_ms[m_currentSection] += (m_timer.nsecsElapsed() - m_sectionStart_ns) / 1.0e6;
+	m_currentSection = -1;
+}
+
+void ccRenderingProfiler::stopFrame(unsigned char lodLevel, bool lodInProgress)
+{
+	if (!m_frameInProgress)
+	{
+		return;
+	}
+
+	stopSection();
+
+	m_currentFrame.total_ms = (m_timer.nsecsElapsed() - m_frameStart_ns) / 1.0e6;
+	m_currentFrame.lodLevel = lodLevel;
+	m_currentFrame.lodInProgress = lodInProgress;
+	m_currentFrame.pointsDrawn = m_stats.pointsDrawn;
+	m_currentFrame.uploadedBytes = m_stats.uploadedBytes;
+
+	//we only keep the slowest entities
+	std::vector<ccRenderingStats::EntityTiming>& entities = m_stats.entities;
+	size_t entityCount = std::min(entities.size(), MAX_ENTITIES_PER_FRAME);
+	std::partial_sort(	entities.begin(),
+						entities.begin() + entityCount,
+						entities.end(),
+						[](const ccRenderingStats::EntityTiming& a, const ccRenderingStats::EntityTiming& b) { return a.drawTime_ns > b.drawTime_ns; });
+	m_currentFrame.slowestEntities.assign(entities.begin(), entities.begin() + entityCount);
+
+	if (m_frames.size() >= m_maxFrameCount)
+	{
+		m_frames.pop_front();
+	}
+	m_frames.push_back(m_currentFrame);
+
+	m_stats.reset();
+	m_frameInProgress = false;
+}
+
+void ccRenderingProfiler::clear()
+{
+	m_frames.clear();
+}
+
+QStringList ccRenderingProfiler::overlayStrings() const
+{
+	QStringList strings;
+	strings << "Rendering profiler";
+
+	if (m_frames.empty())
+	{
+		strings << "(no frame recorded yet)";
+		return strings;
+	}
+
+	const FrameRecord& last = m_frames.back();
+	strings << QString("Frame #%1: %2 ms").arg(last.index).arg(last.total_ms, 0, 'f', 2);
+	for (int i = 0; i < SECTION_COUNT; ++i)
+	{
+		strings << QString("  %1: %2 ms").arg(SectionName(static_cast<Section>(i))).arg(last.sections_ms[i], 0, 'f', 2);
+	}
+	strings << QString("Points drawn: %1").arg(last.pointsDrawn);
+	strings << QString("Uploaded: %1 KB").arg(last.uploadedBytes / 1024.0, 0, 'f', 1);
+	strings << QString("LOD level: %1%2").arg(last.lodLevel).arg(last.lodInProgress ? " (in progress)" : "");
+	for (const ccRenderingStats::EntityTiming& entity : last.slowestEntities)
+	{
+		strings << QString("  [%1] %2: %3 ms").arg(entity.uniqueID).arg(entity.name).arg(entity.drawTime_ns / 1.0e6, 0, 'f', 2);
+	}
+
+	//average values
+	size_t count = std::min(m_frames.size(), s_averageFrameCount);
+	double avgTotal_ms = 0.0;
+	double avgPoints = 0.0;
+	for (size_t i = m_frames.size() - count; i < m_frames.size(); ++i)
+	{
+		avgTotal_ms += m_frames[i].total_ms;
+		avgPoints += m_frames[i].pointsDrawn;
+	}
+	avgTotal_ms /= count;
+	avgPoints /= count;
+	strings << QString("Average (%1 frames): %2 ms - %3 M points").arg(count).arg(avgTotal_ms, 0, 'f', 2).arg(avgPoints / 1.0e6, 0, 'f', 2);
+
+	return strings;
+}
+
+bool ccRenderingProfiler::exportToFile(const QString& filename) const
+{
+	if (QFileInfo(filename).suffix().compare("json", Qt::CaseInsensitive) == 0)
+	{
+		return exportToJSON(filename);
+	}
+	else
+	{
+		return exportToCSV(filename);
+	}
+}
+
+bool ccRenderingProfiler::exportToCSV(const QString& filename) const
+{
+	QFile file(filename);
+	if (!file.open(QFile::WriteOnly | QFile::Text))
+	{
+		ccLog::Warning(QString("[ccRenderingProfiler] Failed to open file '%1' for writing").arg(filename));
+		return false;
+	}
+
+	QTextStream stream(&file);
+	stream << "Frame;Timestamp (ms);Total (ms)";
+	for (int i = 0; i < SECTION_COUNT; ++i)
+	{
+		stream << ';' << SectionName(static_cast<Section>(i)) << " (ms)";
+	}
+	stream << ";Passes;LOD level;LOD in progress;Points drawn;Uploaded bytes;Slowest entities" << endl;
+
+	for (const FrameRecord& frame : m_frames)
+	{
+		stream << frame.index << ';' << frame.timestamp_ms << ';' << frame.total_ms;
+		for (int i = 0; i < SECTION_COUNT; ++i)
+		{
+			stream << ';' << frame.sections_ms[i];
+		}
+		stream << ';' << frame.passCount;
+		stream << ';' << static_cast<unsigned>(frame.lodLevel);
+		stream << ';' << (frame.lodInProgress ? 1 : 0);
+		stream << ';' << frame.pointsDrawn;
+		stream << ';' << frame.uploadedBytes;
+		stream << ';';
+		for (size_t i = 0; i < frame.slowestEntities.size(); ++i)
+		{
+			const ccRenderingStats::EntityTiming& entity = frame.slowestEntities[i];
+			if (i != 0)
+			{
+				stream << " | ";
+			}
+			//we don't want the CSV separator in the entity names
+			stream << QString(entity.name).replace(';', ',') << " [" << entity.uniqueID << "] = " << entity.drawTime_ns / 1.0e6 << " ms";
+		}
+		stream << endl;
+	}
+
+	return (file.error() == QFile::NoError);
+}
+
+bool ccRenderingProfiler::exportToJSON(const QString& filename) const
+{
+	QJsonArray frames;
+	for (const FrameRecord& frame : m_frames)
+	{
+		QJsonObject sections;
+		for (int i = 0; i < SECTION_COUNT; ++i)
+		{
+			sections.insert(SectionName(static_cast<Section>(i)), frame.sections_ms[i]);
+		}
+
+		QJsonArray entities;
+		for (const ccRenderingStats::EntityTiming& entity : frame.slowestEntities)
+		{
+			QJsonObject jsonEntity;
+			jsonEntity.insert("id", static_cast<qint64>(entity.uniqueID));
+			jsonEntity.insert("name", entity.name);
+			jsonEntity.insert("time_ms", entity.drawTime_ns / 1.0e6);
+			jsonEntity.insert("pointsDrawn", static_cast<qint64>(entity.pointsDrawn));
+			entities.append(jsonEntity);
+		}
+
+		QJsonObject jsonFrame;
+		jsonFrame.insert("frame", static_cast<qint64>(frame.index));
+		jsonFrame.insert("timestamp_ms", frame.timestamp_ms);
+		jsonFrame.insert("total_ms", frame.total_ms);
+		jsonFrame.insert("sections_ms", sections);
+		jsonFrame.insert("passes", static_cast<int>(frame.passCount));
+		jsonFrame.insert("lodLevel", static_cast<int>(frame.lodLevel));
+		jsonFrame.insert("lodInProgress", frame.lodInProgress);
+		jsonFrame.insert("pointsDrawn", static_cast<qint64>(frame.pointsDrawn));
+		jsonFrame.insert("uploadedBytes", static_cast<qint64>(frame.uploadedBytes));
+		jsonFrame.insert("slowestEntities", entities);
+		frames.append(jsonFrame);
+	}
+
+	QJsonObject root;
+	root.insert("frames", frames);
+
+	QFile file(filename);
+	if (!file.open(QFile::WriteOnly))
+	{
+		ccLog::Warning(QString("[ccRenderingProfiler] Failed to open file '%1' for writing").arg(filename));
+		return false;
+	}
+
+	file.write(QJsonDocument(root).toJson());
+
+	return (file.error() == QFile::NoError);
+}
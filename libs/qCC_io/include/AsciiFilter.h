@@ -27,6 +27,11 @@
 #include <QTextStream>
 #include <QByteArray>
 
+//System
+#include <functional>
+
+class ccPointCloud;
+
 //! ASCII point cloud I/O filter
 class QCC_IO_LIB_API AsciiFilter : public FileIOFilter
 {
@@ -44,11 +49,39 @@ public:
 	//! Loads a cloud from a QByteArray
 	CC_FILE_ERROR loadAsciiData(const QByteArray& data, QString sourceName, ccHObject& container, LoadParameters& parameters);
 
+public: // Streaming
+
+	//! Chunk handler (for streamed loading)
+	/** The handler takes the ownership of the chunk. The second parameter is the
+		approximate ratio of the input file that has been read so far (in [0 ; 1]).
+		\return CC_FERR_NO_ERROR to continue, or an error code to stop the loading process (it is then returned by loadFile)
+	**/
+	using ChunkHandler = std::function<CC_FILE_ERROR(ccPointCloud* chunk, double progress)>;
+
+	//! Sets a handler to receive the loaded points chunk by chunk
+	/** The clouds are then passed to the handler instead of being added to
+		the container, so that only one chunk resides in memory at a time.
+		Only local files without labels can be loaded this way.
+		\param handler chunk handler (or an empty function to restore the standard behavior)
+		\param chunkSize max. number of points per chunk
+	**/
+	void setChunkHandler(ChunkHandler handler, unsigned chunkSize);
+
+	//! Sets whether the points should be appended to the output file (default is false)
+	/** In this mode, the headers (columns names and point count) are never written.
+	**/
+	void setAppendMode(bool state) { m_appendMode = state; }
+
 public: // Default / persistent settings
 
 	//! Sets the default number of skipped lines (at loading time)
 	static void SetDefaultSkippedLineCount(int count);
 
+	//! Sets whether local files should be parsed in parallel (default is true)
+	/** The file is memory-mapped, split in blocks of lines and parsed on all cores.
+	**/
+	static void SetParallelLoading(bool state);
+
 	//! Sets the default output coords precision (as saving time)
 	static void SetOutputCoordsPrecision(int prec);
 	//! Sets the default output scalar values precision (as saving time)
@@ -89,4 +122,28 @@ protected:
 													unsigned skipLines,
 													LoadParameters& parameters,
 													bool showLabelsIn2D = false);
+
+	//! Loads (memory-mapped) ASCII data with a predefined format (multi-threaded)
+	/** Labels are not supported.
+	**/
+	CC_FILE_ERROR loadCloudFromFormatedAsciiData(	const char* data,
+													qint64 dataSize,
+													QString filenameOrTitle,
+													ccHObject& container,
+													const AsciiOpenDlg::Sequence& openSequence,
+													char separator,
+													bool commaAsDecimal,
+													unsigned approximateNumberOfLines,
+													unsigned maxCloudSize,
+													unsigned skipLines,
+													LoadParameters& parameters);
+
+protected: //members
+
+	//! Chunk handler (streamed loading)
+	ChunkHandler m_chunkHandler;
+	//! Max. number of points per chunk (streamed loading)
+	unsigned m_chunkSize;
+	//! Append mode (saving)
+	bool m_appendMode;
 };
@@ -20,6 +20,8 @@
 
 #include "FileIOFilter.h"
 
+//Qt
+#include <QFuture>
 
 //! CloudCompare dedicated binary point cloud I/O filter
 class QCC_IO_LIB_API BinFilter : public FileIOFilter
@@ -43,8 +45,71 @@ public:
 	//! new style BIN loading
 	static CC_FILE_ERROR LoadFileV2(QFile& in, ccHObject& container, int flags);
 
+	//! Table of contents entry (BIN version >= 5.3)
+	struct TOCEntry
+	{
+		unsigned uniqueID = 0;		//!< entity unique ID (as saved in the file)
+		CC_CLASS_ENUM classID = 0;	//!< entity class ID
+		unsigned parentID = 0;		//!< parent entity unique ID (as saved in the file)
+		qint64 offset = 0;			//!< entity position in the file
+		QString name;				//!< entity name
+	};
+
+	//! Table of contents (BIN version >= 5.3)
+	using TableOfContents = std::vector<TOCEntry>;
+
+	//! Reads the table of contents of a BIN file (BIN version >= 5.3)
+	/** \warning the file position is modified
+		\return whether the file has a (valid) table of contents
+	**/
+	static bool ReadTableOfContents(QFile& in, TableOfContents& toc);
+
+	//! Loads a single entity (and its children) from a BIN file (BIN version >= 5.3)
+	/** The entity is directly read at its position in the file (see ReadTableOfContents).
+		\param filename BIN file
+		\param uniqueID entity unique ID (as saved in the file)
+		\param container container to store the loaded entity
+		\return error
+	**/
+	static CC_FILE_ERROR LoadEntityV2(const QString& filename, unsigned uniqueID, ccHObject& container);
+
 	//! new style BIN saving
 	static CC_FILE_ERROR SaveFileV2(QFile& out, ccHObject* object);
+
+	//! Saves an entity (and its children) in a BIN file, in a separate thread
+	/** Several files can be saved at the same time. The progress (in percent of the
+		estimated file size) is reported by the returned future, with the number of
+		bytes already written as progress text (see QFutureWatcher::progressValueChanged
+		and QFutureWatcher::progressTextChanged).
+		\warning the entities must not be modified (or deleted) before the end of the process
+		\param root entity to save
+		\param filename output filename
+		\return future result (error code)
+	**/
+	static QFuture<CC_FILE_ERROR> SaveFileAsync(ccHObject* root, const QString& filename);
+
+	//! Sets whether large arrays (points, colors, normals, scalar fields, etc.) should be read through a memory-mapped view of the file
+	/** Enabled by default. Falls back automatically to standard reading if the file can't be mapped.
+	**/
+	static void SetMemoryMappedLoading(bool state);
+
+	//! Returns whether large arrays are read through a memory-mapped view of the file
+	static bool MemoryMappedLoading();
+
+	//! Sets the unique ID (as saved in the file) of the only entity to load from the next BIN files
+	/** The entity (and its children) is then directly read at its position in the file
+		(see LoadEntityV2). Only BIN files with a table of contents (version >= 5.3) can be loaded this way.
+		\param uniqueID entity unique ID (0 = load the whole file, default)
+	**/
+	static void SetEntityToLoad(unsigned uniqueID);
+
+	//! Returns the unique ID of the only entity to load from BIN files (0 = the whole file)
+	static unsigned EntityToLoad();
+
+protected:
+
+	//! Loads the entity stored at the current file position (and its children) then restores the links between entities
+	static CC_FILE_ERROR LoadEntitiesV2(QFile& in, ccHObject& container, int flags, uint32_t binVersion);
 };
 
 #endif //CC_BIN_FILTER_HEADER
@@ -22,6 +22,8 @@
 #include <QFileInfo>
 #include <QSharedPointer>
 #include <QTextStream>
+#include <QThread>
+#include <QtConcurrentMap>
 
 //CClib
 #include <ScalarField.h>
@@ -37,6 +39,7 @@
 //System
 #include <cassert>
 #include <cstring>
+#include <limits>
 
 //Qt
 #include <QScopedPointer>
@@ -49,12 +52,18 @@ static int s_outputSeparatorIndex = 0;
 static bool s_saveSFBeforeColor = false;
 static bool s_saveColumnsNamesHeader = false;
 static bool s_savePointCountHeader = false;
+static bool s_parallelLoading = true;
 
 void AsciiFilter::SetDefaultSkippedLineCount(int count)
 {
 	s_defaultSkippedLineCount = count;
 }
 
+void AsciiFilter::SetParallelLoading(bool state)
+{
+	s_parallelLoading = state;
+}
+
 void AsciiFilter::SetOutputCoordsPrecision(int prec)
 {
 	s_outputCoordPrecision = prec;
@@ -95,7 +104,15 @@ AsciiFilter::AsciiFilter()
 					QStringList{ GetFileFilter() },
 					Import | Export | BuiltIn
 					} )
+	, m_chunkSize(0)
+	, m_appendMode(false)
+{
+}
+
+void AsciiFilter::setChunkHandler(ChunkHandler handler, unsigned chunkSize)
 {
+	m_chunkHandler = handler;
+	m_chunkSize = std::max(1u, chunkSize);
 }
 
 bool AsciiFilter::canSave(CC_CLASS_ENUM type, bool& multiple, bool& exclusive) const
@@ -211,7 +228,7 @@ CC_FILE_ERROR AsciiFilter::saveToFile(ccHObject* entity, const QString& filename
 	}
 
 	QFile file(filename);
-	if (!file.open(QFile::WriteOnly | QFile::Truncate))
+	if (!file.open(m_appendMode ? QFile::WriteOnly | QFile::Append : QFile::WriteOnly | QFile::Truncate))
 		return CC_FERR_WRITING;
 	QTextStream stream(&file);
 
@@ -246,7 +263,7 @@ CC_FILE_ERROR AsciiFilter::saveToFile(ccHObject* entity, const QString& filename
 	bool saveFloatColors = saveDialog.saveFloatColors();
 	bool saveAlphaChannel = saveDialog.saveAlphaChannel();
 
-	if (s_saveColumnsNamesHeader)
+	if (s_saveColumnsNamesHeader && !m_appendMode)
 	{
 		QString header("//");
 		header.append(AsciiHeaderColumns::X());
@@ -310,7 +327,7 @@ CC_FILE_ERROR AsciiFilter::saveToFile(ccHObject* entity, const QString& filename
 		stream << header << "\n";
 	}
 
-	if (s_savePointCountHeader)
+	if (s_savePointCountHeader && !m_appendMode)
 	{
 		stream << QString::number(numberOfPoints) << "\n";
 	}
@@ -787,6 +804,622 @@ cloudAttributesDescriptor prepareCloud(	const AsciiOpenDlg::Sequence &openSequen
 	return cloudDesc;
 }
 
+//! Parsing context shared by all the ASCII blocks
+struct AsciiParsingContext
+{
+	cloudAttributesDescriptor desc;
+	int maxPartIndex = -1;
+	char separator = ' ';
+	const QLocale* locale = nullptr;
+	bool commaAsDecimal = false;
+};
+
+//! Block of (newline aligned) ASCII data, parsed independently of the others
+struct AsciiBlock
+{
+	const char* begin = nullptr;
+	const char* end = nullptr;
+	const AsciiParsingContext* context = nullptr;
+
+	//parsed data
+	std::vector<CCVector3d> points;
+	std::vector<CCVector3> normals;
+	std::vector<ccColor::Rgba> colors;
+	std::vector<ScalarType> scalars; //one value per scalar field for each point
+	unsigned corruptedLineCount = 0;
+	bool memoryError = false;
+};
+
+static inline bool IsWhiteSpace(char c)
+{
+	return (c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\v' || c == '\f');
+}
+
+//! Fast (allocation-free) number parsing
+/** Only the exact 'fast path' is handled here (at most 19 significant digits,
+	mantissa <= 2^53 and |exponent| <= 22) so that the result is the same as the
+	one returned by QLocale::toDouble. Any other case falls back to QLocale.
+**/
+static double ParseDouble(const char* begin, const char* end, const AsciiParsingContext& context, bool* ok = nullptr)
+{
+	static const double s_powersOf10[23] = {	1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+												1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+
+	while (begin != end && IsWhiteSpace(*begin))
+		++begin;
+	while (end != begin && IsWhiteSpace(*(end - 1)))
+		--end;
+
+	const char* c = begin;
+	bool negative = false;
+	if (c != end && (*c == '-' || *c == '+'))
+	{
+		negative = (*c == '-');
+		++c;
+	}
+
+	uint64_t mantissa = 0;
+	int significantDigits = 0;
+	int intDigits = 0;
+	for (; c != end && *c >= '0' && *c <= '9'; ++c, ++intDigits)
+	{
+		if (mantissa != 0 || *c != '0')
+		{
+			mantissa = mantissa * 10 + static_cast<uint64_t>(*c - '0');
+			++significantDigits;
+		}
+	}
+
+	int exponent = 0;
+	bool fastPath = (intDigits != 0);
+	if (fastPath && c != end && *c == (context.commaAsDecimal ? ',' : '.'))
+	{
+		++c;
+		int fracDigits = 0;
+		for (; c != end && *c >= '0' && *c <= '9'; ++c, ++fracDigits)
+		{
+			if (mantissa != 0 || *c != '0')
+			{
+				mantissa = mantissa * 10 + static_cast<uint64_t>(*c - '0');
+				++significantDigits;
+			}
+			--exponent;
+		}
+		fastPath = (fracDigits != 0);
+	}
+	if (fastPath && c != end && (*c == 'e' || *c == 'E'))
+	{
+		++c;
+		bool negativeExp = false;
+		if (c != end && (*c == '-' || *c == '+'))
+		{
+			negativeExp = (*c == '-');
+			++c;
+		}
+		int expValue = 0;
+		int expDigits = 0;
+		for (; c != end && *c >= '0' && *c <= '9' && expDigits < 6; ++c, ++expDigits)
+		{
+			expValue = expValue * 10 + (*c - '0');
+		}
+		fastPath = (expDigits != 0);
+		exponent += (negativeExp ? -expValue : expValue);
+	}
+
+	if (	fastPath
+		&&	c == end
+		&&	significantDigits <= 19
+		&&	mantissa <= (static_cast<uint64_t>(1) << 53)
+		&&	exponent >= -22
+		&&	exponent <= 22 )
+	{
+		if (ok)
+			*ok = true;
+		double value = static_cast<double>(mantissa);
+		value = (exponent < 0 ? value / s_powersOf10[-exponent] : value * s_powersOf10[exponent]);
+		return (negative ? -value : value);
+	}
+
+	//fall back to the (slow but complete) standard method
+	return context.locale->toDouble(QString::fromLatin1(begin, static_cast<int>(end - begin)), ok);
+}
+
+//! Fast (allocation-free) integer parsing (same behavior as QString::toInt: returns 0 on failure)
+static int ParseInt(const char* begin, const char* end)
+{
+	while (begin != end && IsWhiteSpace(*begin))
+		++begin;
+	while (end != begin && IsWhiteSpace(*(end - 1)))
+		--end;
+
+	bool negative = false;
+	if (begin != end && (*begin == '-' || *begin == '+'))
+	{
+		negative = (*begin == '-');
+		++begin;
+	}
+	if (begin == end)
+		return 0;
+
+	int64_t value = 0;
+	for (const char* c = begin; c != end; ++c)
+	{
+		if (*c < '0' || *c > '9')
+			return 0;
+		value = value * 10 + (*c - '0');
+		if (value > static_cast<int64_t>(std::numeric_limits<int>::max()) + 1)
+			return 0;
+	}
+	if (negative)
+		value = -value;
+
+	return (value < std::numeric_limits<int>::min() || value > std::numeric_limits<int>::max() ? 0 : static_cast<int>(value));
+}
+
+//! Parses a block of ASCII lines (see AsciiBlock)
+static void ParseAsciiBlock(AsciiBlock& block)
+{
+	assert(block.context);
+	const AsciiParsingContext& context = *block.context;
+	const cloudAttributesDescriptor& desc = context.desc;
+	const bool whiteSpaceSeparator = IsWhiteSpace(context.separator);
+	const size_t sfCount = desc.scalarIndexes.size();
+
+	//token boundaries (we only need the first 'maxPartIndex + 1' ones)
+	std::vector< std::pair<const char*, const char*> > parts;
+	try
+	{
+		parts.resize(static_cast<size_t>(context.maxPartIndex) + 1);
+
+		//rough estimation of the number of lines (to limit reallocations)
+		size_t approxLineCount = static_cast<size_t>(block.end - block.begin) / (8 * parts.size()) + 1;
+		block.points.reserve(approxLineCount);
+		if (desc.hasNorms)
+			block.normals.reserve(approxLineCount);
+		if (desc.hasRGBColors || desc.greyIndex >= 0)
+			block.colors.reserve(approxLineCount);
+		if (sfCount != 0)
+			block.scalars.reserve(approxLineCount * sfCount);
+	}
+	catch (const std::bad_alloc&)
+	{
+		block.memoryError = true;
+		return;
+	}
+
+	CCVector3d P(0, 0, 0);
+	CCVector3 N(0, 0, 0);
+	ccColor::Rgba col(0, 0, 0, 255);
+
+	const char* lineStart = block.begin;
+	while (lineStart < block.end)
+	{
+		const char* lineEnd = static_cast<const char*>(memchr(lineStart, '\n', block.end - lineStart));
+		if (!lineEnd)
+			lineEnd = block.end;
+		const char* nextLine = lineEnd + 1;
+		if (lineEnd != lineStart && *(lineEnd - 1) == '\r')
+			--lineEnd;
+
+		if (lineEnd == lineStart || (lineEnd - lineStart >= 2 && lineStart[0] == '/' && lineStart[1] == '/'))
+		{
+			//empty lines and comments are ignored
+			lineStart = nextLine;
+			continue;
+		}
+
+		//we split the current line
+		int nParts = 0;
+		const char* c = lineStart;
+		while (c < lineEnd && nParts <= context.maxPartIndex)
+		{
+			if (whiteSpaceSeparator)
+			{
+				while (c < lineEnd && IsWhiteSpace(*c))
+					++c;
+				if (c == lineEnd)
+					break;
+				const char* tokenStart = c;
+				while (c < lineEnd && !IsWhiteSpace(*c))
+					++c;
+				parts[nParts++] = { tokenStart, c };
+			}
+			else
+			{
+				const char* tokenStart = c;
+				while (c < lineEnd && *c != context.separator)
+					++c;
+				if (c != tokenStart)
+				{
+					parts[nParts++] = { tokenStart, c };
+				}
+				if (c < lineEnd)
+					++c; //skip the separator
+			}
+		}
+		lineStart = nextLine;
+
+		if (nParts <= context.maxPartIndex)
+		{
+			++block.corruptedLineCount;
+			continue;
+		}
+
+		//read the point coordinates
+		{
+			bool ok = true;
+			if (desc.xCoordIndex >= 0 && ok)
+				P.x = ParseDouble(parts[desc.xCoordIndex].first, parts[desc.xCoordIndex].second, context, &ok);
+			if (desc.yCoordIndex >= 0 && ok)
+				P.y = ParseDouble(parts[desc.yCoordIndex].first, parts[desc.yCoordIndex].second, context, &ok);
+			if (desc.zCoordIndex >= 0 && ok)
+				P.z = ParseDouble(parts[desc.zCoordIndex].first, parts[desc.zCoordIndex].second, context, &ok);
+
+			if (!ok)
+			{
+				++block.corruptedLineCount;
+				continue;
+			}
+		}
+
+		try
+		{
+			block.points.push_back(P);
+
+			//Normal vector
+			if (desc.hasNorms)
+			{
+				if (desc.xNormIndex >= 0)
+					N.x = static_cast<PointCoordinateType>(ParseDouble(parts[desc.xNormIndex].first, parts[desc.xNormIndex].second, context));
+				if (desc.yNormIndex >= 0)
+					N.y = static_cast<PointCoordinateType>(ParseDouble(parts[desc.yNormIndex].first, parts[desc.yNormIndex].second, context));
+				if (desc.zNormIndex >= 0)
+					N.z = static_cast<PointCoordinateType>(ParseDouble(parts[desc.zNormIndex].first, parts[desc.zNormIndex].second, context));
+				block.normals.push_back(N);
+			}
+
+			//Colors
+			if (desc.hasRGBColors)
+			{
+				if (desc.iRgbaIndex >= 0)
+				{
+					const uint32_t rgba = static_cast<uint32_t>(ParseInt(parts[desc.iRgbaIndex].first, parts[desc.iRgbaIndex].second));
+					col.a = ((rgba >> 24) & 0x0000ff);
+					col.r = ((rgba >> 16) & 0x0000ff);
+					col.g = ((rgba >>  8) & 0x0000ff);
+					col.b = ((rgba      ) & 0x0000ff);
+				}
+				else if (desc.fRgbaIndex >= 0)
+				{
+					const float rgbaf = static_cast<float>(ParseDouble(parts[desc.fRgbaIndex].first, parts[desc.fRgbaIndex].second, context));
+					uint32_t rgba = 0;
+					memcpy(&rgba, &rgbaf, 4);
+					col.a = ((rgba >> 24) & 0x0000ff);
+					col.r = ((rgba >> 16) & 0x0000ff);
+					col.g = ((rgba >>  8) & 0x0000ff);
+					col.b = ((rgba      ) & 0x0000ff);
+				}
+				else
+				{
+					const int rgbaIndexes[4] = { desc.redIndex, desc.greenIndex, desc.blueIndex, desc.alphaIndex };
+					ColorCompType* rgbaValues[4] = { &col.r, &col.g, &col.b, &col.a };
+					for (int k = 0; k < 4; ++k)
+					{
+						if (rgbaIndexes[k] >= 0)
+						{
+							float multiplier = desc.hasFloatRGBColors[k] ? static_cast<float>(ccColor::MAX) : 1.0f;
+							float value = static_cast<float>(ParseDouble(parts[rgbaIndexes[k]].first, parts[rgbaIndexes[k]].second, context));
+							*rgbaValues[k] = static_cast<ColorCompType>(value * multiplier);
+						}
+					}
+				}
+				block.colors.push_back(col);
+			}
+			else if (desc.greyIndex >= 0)
+			{
+				col.r = col.g = col.b = static_cast<ColorCompType>(ParseInt(parts[desc.greyIndex].first, parts[desc.greyIndex].second));
+				col.a = ccColor::MAX;
+				block.colors.push_back(col);
+			}
+
+			//Scalar values
+			for (size_t j = 0; j < sfCount; ++j)
+			{
+				const auto& part = parts[desc.scalarIndexes[j]];
+				block.scalars.push_back(static_cast<ScalarType>(ParseDouble(part.first, part.second, context)));
+			}
+		}
+		catch (const std::bad_alloc&)
+		{
+			block.memoryError = true;
+			return;
+		}
+	}
+}
+
+CC_FILE_ERROR AsciiFilter::loadCloudFromFormatedAsciiData(	const char* data,
+															qint64 dataSize,
+															QString filenameOrTitle,
+															ccHObject& container,
+															const AsciiOpenDlg::Sequence& openSequence,
+															char separator,
+															bool commaAsDecimal,
+															unsigned approximateNumberOfLines,
+															unsigned maxCloudSize,
+															unsigned skipLines,
+															LoadParameters& parameters)
+{
+	//we may have to "slice" clouds when opening them if they are too big!
+	maxCloudSize = std::min(maxCloudSize, CC_MAX_NUMBER_OF_POINTS_PER_CLOUD);
+	if (m_chunkHandler)
+	{
+		maxCloudSize = std::min(maxCloudSize, m_chunkSize);
+	}
+	unsigned chunkRank = 1;
+
+	//we initialize the loading accelerator structure and point cloud
+	int maxPartIndex = -1;
+	cloudAttributesDescriptor cloudDesc = prepareCloud(openSequence, std::min(maxCloudSize, approximateNumberOfLines), maxPartIndex, chunkRank);
+	if (!cloudDesc.cloud)
+	{
+		return CC_FERR_NOT_ENOUGH_MEMORY;
+	}
+
+	QLocale locale(commaAsDecimal ? QLocale::French : QLocale::English);
+
+	AsciiParsingContext context;
+	context.desc = cloudDesc;
+	context.maxPartIndex = maxPartIndex;
+	context.separator = separator;
+	context.locale = &locale;
+	context.commaAsDecimal = commaAsDecimal;
+
+	const char* dataBegin = data;
+	const char* dataEnd = data + dataSize;
+
+	//a complete cloud is either passed to the chunk handler (streaming) or added to the container
+	auto releaseCloud = [&](ccPointCloud* cloud, const char* readPos) -> CC_FILE_ERROR
+	{
+		if (!m_chunkHandler)
+		{
+			container.addChild(cloud);
+			return CC_FERR_NO_ERROR;
+		}
+		return m_chunkHandler(cloud, dataSize > 0 ? static_cast<double>(readPos - dataBegin) / dataSize : 1.0);
+	};
+
+	//we skip the UTF-8 BOM (if any)
+	if (dataSize >= 3 && static_cast<unsigned char>(data[0]) == 0xEF && static_cast<unsigned char>(data[1]) == 0xBB && static_cast<unsigned char>(data[2]) == 0xBF)
+	{
+		data += 3;
+	}
+
+	//we skip lines as defined on input
+	for (unsigned i = 0; i < skipLines && data < dataEnd;)
+	{
+		const char* lineEnd = static_cast<const char*>(memchr(data, '\n', dataEnd - data));
+		if (!lineEnd)
+			lineEnd = dataEnd;
+		bool isEmpty = (lineEnd == data || (lineEnd == data + 1 && *data == '\r'));
+		data = lineEnd + 1;
+		if (!isEmpty)
+		{
+			//empty lines are ignored
+			++i;
+		}
+	}
+
+	//we split the data in (newline aligned) blocks
+	static const qint64 BlockSize = (static_cast<qint64>(1) << 24); //16 Mb
+	std::vector<std::pair<const char*, const char*>> blockLimits;
+	try
+	{
+		const char* blockStart = data;
+		while (blockStart < dataEnd)
+		{
+			const char* blockEnd = dataEnd;
+			if (dataEnd - blockStart > BlockSize)
+			{
+				const char* newLine = static_cast<const char*>(memchr(blockStart + BlockSize, '\n', dataEnd - (blockStart + BlockSize)));
+				blockEnd = (newLine ? newLine + 1 : dataEnd);
+			}
+			blockLimits.emplace_back(blockStart, blockEnd);
+			blockStart = blockEnd;
+		}
+	}
+	catch (const std::bad_alloc&)
+	{
+		clearStructure(cloudDesc);
+		return CC_FERR_NOT_ENOUGH_MEMORY;
+	}
+
+	//progress indicator
+	QScopedPointer<ccProgressDialog> pDlg(nullptr);
+	if (parameters.parentWidget)
+	{
+		pDlg.reset(new ccProgressDialog(true, parameters.parentWidget));
+		pDlg->setMethodTitle(QObject::tr("Open ASCII data [%1]").arg(filenameOrTitle));
+		pDlg->setInfo(QObject::tr("Approximate number of points: %1").arg(approximateNumberOfLines));
+		pDlg->start();
+	}
+	CCCoreLib::NormalizedProgress nprogress(pDlg.data(), static_cast<unsigned>(blockLimits.size()));
+
+	CCVector3d Pshift(0, 0, 0);
+	bool preserveCoordinateShift = true;
+	unsigned pointsRead = 0;
+	CC_FILE_ERROR result = CC_FERR_NO_ERROR;
+
+	//the blocks are parsed in parallel, by batches (to limit the memory consumption)
+	//and then merged sequentially (in the file order)
+	const size_t batchSize = static_cast<size_t>(std::max(1, QThread::idealThreadCount())) * 2;
+	std::vector<AsciiBlock> blocks;
+	for (size_t batchStart = 0; batchStart < blockLimits.size() && result == CC_FERR_NO_ERROR; batchStart += batchSize)
+	{
+		size_t batchCount = std::min(batchSize, blockLimits.size() - batchStart);
+		blocks.clear();
+		blocks.resize(batchCount);
+		for (size_t i = 0; i < batchCount; ++i)
+		{
+			blocks[i].begin = blockLimits[batchStart + i].first;
+			blocks[i].end = blockLimits[batchStart + i].second;
+			blocks[i].context = &context;
+		}
+
+		QtConcurrent::blockingMap(blocks, ParseAsciiBlock);
+
+		for (const AsciiBlock& block : blocks)
+		{
+			if (block.memoryError)
+			{
+				result = CC_FERR_NOT_ENOUGH_MEMORY;
+				break;
+			}
+			if (block.corruptedLineCount != 0)
+			{
+				ccLog::Warning("[AsciiFilter::Load] %u corrupted line(s) found (non numerical values or not enough parts)", block.corruptedLineCount);
+			}
+
+			const size_t sfStride = context.desc.scalarIndexes.size();
+			size_t blockPos = 0;
+			while (blockPos < block.points.size())
+			{
+				//if we have reached the max. number of points per cloud
+				if (cloudDesc.cloud->size() == maxCloudSize)
+				{
+					ccLog::PrintDebug("[ASCII] Point %i -> end of chunk (%i points)", pointsRead, maxCloudSize);
+
+					if (!cloudDesc.scalarFields.empty())
+					{
+						for (unsigned k = 0; k < cloudDesc.scalarFields.size(); ++k)
+							cloudDesc.scalarFields[k]->computeMinAndMax();
+						cloudDesc.cloud->setCurrentDisplayedScalarField(0);
+						cloudDesc.cloud->showSF(true);
+					}
+					//we add this cloud to the output container
+					ccPointCloud* fullCloud = cloudDesc.cloud;
+					cloudDesc.reset();
+					result = releaseCloud(fullCloud, block.begin + (block.end - block.begin) * blockPos / block.points.size());
+					if (result != CC_FERR_NO_ERROR)
+					{
+						break;
+					}
+
+					//and create new one
+					unsigned remainingPoints = (approximateNumberOfLines > pointsRead ? approximateNumberOfLines - pointsRead : 0);
+					cloudDesc = prepareCloud(openSequence, std::max(1u, std::min(maxCloudSize, remainingPoints)), maxPartIndex, ++chunkRank);
+					if (!cloudDesc.cloud)
+					{
+						ccLog::Error("Not enough memory! Process stopped ...");
+						result = CC_FERR_NOT_ENOUGH_MEMORY;
+						break;
+					}
+					if (preserveCoordinateShift)
+					{
+						cloudDesc.cloud->setGlobalShift(Pshift);
+					}
+				}
+
+				//make sure the cloud is big enough for the remaining points of this block
+				ccPointCloud* cloud = cloudDesc.cloud;
+				unsigned count = static_cast<unsigned>(std::min(block.points.size() - blockPos, static_cast<size_t>(maxCloudSize - cloud->size())));
+				if (cloud->size() + count > cloud->capacity())
+				{
+					//geometric growth (to avoid too many reallocations)
+					unsigned newCapacity = std::max(cloud->size() + count, std::min(maxCloudSize, cloud->capacity() + cloud->capacity() / 2));
+					if (!cloud->reserve(newCapacity))
+					{
+						ccLog::Error("Not enough memory! Process stopped ...");
+						result = CC_FERR_NOT_ENOUGH_MEMORY;
+						break;
+					}
+				}
+
+				for (unsigned i = 0; i < count; ++i, ++blockPos)
+				{
+					const CCVector3d& P = block.points[blockPos];
+
+					//first point: check for 'big' coordinates
+					if (pointsRead == 0)
+					{
+						if (HandleGlobalShift(P, Pshift, preserveCoordinateShift, parameters))
+						{
+							if (preserveCoordinateShift)
+							{
+								cloud->setGlobalShift(Pshift);
+							}
+							ccLog::Warning("[ASCIIFilter::loadFile] Cloud has been recentered! Translation: (%.2f ; %.2f ; %.2f)", Pshift.x, Pshift.y, Pshift.z);
+						}
+					}
+
+					cloud->addPoint((P + Pshift).toPC());
+					if (!block.normals.empty())
+					{
+						cloud->addNorm(block.normals[blockPos]);
+					}
+					if (!block.colors.empty())
+					{
+						cloud->addColor(block.colors[blockPos]);
+					}
+					for (size_t j = 0; j < cloudDesc.scalarFields.size(); ++j)
+					{
+						cloudDesc.scalarFields[j]->emplace_back(block.scalars[blockPos * sfStride + j]);
+					}
+
+					++pointsRead;
+				}
+			}
+
+			if (result != CC_FERR_NO_ERROR)
+			{
+				break;
+			}
+
+			if (pDlg && !nprogress.oneStep())
+			{
+				//cancel requested
+				result = CC_FERR_CANCELED_BY_USER;
+				break;
+			}
+		}
+	}
+
+	if (cloudDesc.cloud)
+	{
+		if (cloudDesc.cloud->size() < cloudDesc.cloud->capacity())
+			cloudDesc.cloud->resize(cloudDesc.cloud->size());
+
+		//add cloud to output
+		if (!cloudDesc.scalarFields.empty())
+		{
+			for (size_t j = 0; j < cloudDesc.scalarFields.size(); ++j)
+			{
+				cloudDesc.scalarFields[j]->resizeSafe(cloudDesc.cloud->size(), true, CCCoreLib::NAN_VALUE);
+				cloudDesc.scalarFields[j]->computeMinAndMax();
+			}
+			cloudDesc.cloud->setCurrentDisplayedScalarField(0);
+			cloudDesc.cloud->showSF(true);
+		}
+
+		ccPointCloud* lastCloud = cloudDesc.cloud;
+		cloudDesc.reset();
+		if (result == CC_FERR_NO_ERROR || !m_chunkHandler)
+		{
+			CC_FILE_ERROR releaseResult = releaseCloud(lastCloud, dataEnd);
+			if (result == CC_FERR_NO_ERROR)
+			{
+				result = releaseResult;
+			}
+		}
+		else
+		{
+			//the handler won't get anything after an error
+			delete lastCloud;
+		}
+	}
+
+	return result;
+}
+
 CC_FILE_ERROR AsciiFilter::loadCloudFromFormatedAsciiStream(QTextStream& stream,
 															QString filenameOrTitle,
 															ccHObject& container,
@@ -800,6 +1433,55 @@ CC_FILE_ERROR AsciiFilter::loadCloudFromFormatedAsciiStream(QTextStream& stream,
 															LoadParameters& parameters,
 															bool showLabelsIn2D/*=false*/)
 {
+	//local files can be parsed in parallel (unless labels are expected)
+	QFile* file = qobject_cast<QFile*>(stream.device());
+	if (s_parallelLoading && file && fileSize > 0)
+	{
+		bool hasLabels = false;
+		for (const AsciiOpenDlg::SequenceItem& item : openSequence)
+		{
+			if (item.type == ASCII_OPEN_DLG_Label)
+			{
+				hasLabels = true;
+				break;
+			}
+		}
+
+		if (!hasLabels)
+		{
+			uchar* data = file->map(0, fileSize);
+			if (data && fileSize >= 2 && ((data[0] == 0xFF && data[1] == 0xFE) || (data[0] == 0xFE && data[1] == 0xFF)))
+			{
+				//UTF-16/32 files are not handled by the fast parser
+				file->unmap(data);
+				data = nullptr;
+			}
+			if (data)
+			{
+				CC_FILE_ERROR result = loadCloudFromFormatedAsciiData(	reinterpret_cast<const char*>(data),
+																		fileSize,
+																		filenameOrTitle,
+																		container,
+																		openSequence,
+																		separator,
+																		commaAsDecimal,
+																		approximateNumberOfLines,
+																		maxCloudSize,
+																		skipLines,
+																		parameters);
+				file->unmap(data);
+				return result;
+			}
+			//otherwise we fall back to the standard (stream based) method
+		}
+	}
+
+	if (m_chunkHandler)
+	{
+		ccLog::Warning("[ASCII] Streamed loading is only possible with local (UTF-8) files without labels");
+		return CC_FERR_NOT_IMPLEMENTED;
+	}
+
 	//we may have to "slice" clouds when opening them if they are too big!
 	maxCloudSize = std::min(maxCloudSize, CC_MAX_NUMBER_OF_POINTS_PER_CLOUD);
 	unsigned cloudChunkSize = std::min(maxCloudSize, approximateNumberOfLines);
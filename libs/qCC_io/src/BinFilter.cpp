@@ -19,7 +19,10 @@
 
 //Qt
 #include <QApplication>
+#include <QEventLoop>
 #include <QFileInfo>
+#include <QFutureInterface>
+#include <QFutureWatcher>
 #include <QMessageBox>
 #include <QtConcurrentRun>
 
@@ -45,13 +48,6 @@
 #include <cstring>
 #include <unordered_set>
 
-#if defined(CC_WINDOWS)
-#include <windows.h>
-#else
-#include <ctime>
-#include <unistd.h>
-#endif
-
 
 BinFilter::BinFilter()
 	: FileIOFilter( {
@@ -145,18 +141,198 @@ static int ReadEntityHeader(QFile& in, unsigned &numberOfPoints, HeaderFlags& he
 	return 0;
 }
 
-static QFile* s_file = nullptr;
-static int s_flags = 0;
-static ccHObject* s_container = nullptr;
+static bool s_memoryMappedLoading = true;
+
+void BinFilter::SetMemoryMappedLoading(bool state)
+{
+	s_memoryMappedLoading = state;
+}
+
+bool BinFilter::MemoryMappedLoading()
+{
+	return s_memoryMappedLoading;
+}
+
+//! Unique ID of the only entity to load (0 = the whole file)
+static unsigned s_entityToLoad = 0;
+
+void BinFilter::SetEntityToLoad(unsigned uniqueID)
+{
+	s_entityToLoad = uniqueID;
+}
+
+unsigned BinFilter::EntityToLoad()
+{
+	return s_entityToLoad;
+}
+
+//! File that reports the number of bytes written so far (to a future)
+class ProgressFile : public QFile
+{
+public:
+	ProgressFile(const QString& filename, QFutureInterface<CC_FILE_ERROR>& futureInterface, qint64 estimatedSize)
+		: QFile(filename)
+		, m_futureInterface(futureInterface)
+		, m_estimatedSize(std::max<qint64>(1, estimatedSize))
+		, m_bytesWritten(0)
+	{}
+
+protected:
+	qint64 writeData(const char* data, qint64 len) override
+	{
+		qint64 written = QFile::writeData(data, len);
+		if (written > 0)
+		{
+			m_bytesWritten += written;
+			//the estimation may be wrong (compression, etc.): we stay below 100% until the end
+			int percent = static_cast<int>(std::min<qint64>(99, (100 * m_bytesWritten) / m_estimatedSize));
+			m_futureInterface.setProgressValueAndText(percent, QObject::tr("%1 Mb written").arg(m_bytesWritten / (1 << 20)));
+		}
+		return written;
+	}
+
+	QFutureInterface<CC_FILE_ERROR>& m_futureInterface;
+	qint64 m_estimatedSize;
+	qint64 m_bytesWritten;
+};
 
-CC_FILE_ERROR _LoadFileV2()
+//! Returns the approximate size of the (uncompressed) arrays of an entity and its children once saved
+static qint64 EstimateFileSize(const ccHObject* root)
 {
-	return (s_file && s_container ? BinFilter::LoadFileV2(*s_file,*s_container,s_flags) : CC_FERR_BAD_ARGUMENT);
+	qint64 size = 0;
+	ccHObject::Container toVisit{ const_cast<ccHObject*>(root) };
+	while (!toVisit.empty())
+	{
+		ccHObject* object = toVisit.back();
+		toVisit.pop_back();
+
+		size += 1024; //header, name, metadata, etc.
+		if (object->isA(CC_TYPES::POINT_CLOUD))
+		{
+			const ccPointCloud* cloud = static_cast<const ccPointCloud*>(object);
+			qint64 pointSize = sizeof(CCVector3);
+			if (cloud->hasColors())
+				pointSize += sizeof(ccColor::Rgba);
+			if (cloud->hasNormals())
+				pointSize += sizeof(CompressedNormType);
+			pointSize += static_cast<qint64>(cloud->getNumberOfScalarFields()) * sizeof(ScalarType);
+			size += pointSize * cloud->size();
+		}
+		else if (object->isA(CC_TYPES::MESH))
+		{
+			size += static_cast<qint64>(static_cast<const ccMesh*>(object)->size()) * 3 * sizeof(unsigned);
+		}
+
+		for (unsigned i = 0; i < object->getChildrenNumber(); ++i)
+		{
+			toVisit.push_back(object->getChild(i));
+		}
+	}
+	return size;
 }
 
-CC_FILE_ERROR _SaveFileV2()
+//! Table of contents trailer tag (BIN version >= 5.3)
+static const char c_tocTag[5] = "CCTC";
+
+//! Writes the table of contents (at the end of the file)
+/** Format: entry count + entries + trailer (TOC offset + "CCTC" tag)
+**/
+static bool WriteTableOfContents(QFile& out, const ccHObject::FileOffsets& offsets)
 {
-	return (s_file && s_container ? BinFilter::SaveFileV2(*s_file,s_container) : CC_FERR_BAD_ARGUMENT);
+	qint64 tocPos = out.pos();
+
+	uint32_t entryCount = static_cast<uint32_t>(offsets.size());
+	if (out.write((const char*)&entryCount, 4) < 0)
+		return false;
+
+	for (const auto& entityOffset : offsets)
+	{
+		const ccHObject* entity = entityOffset.first;
+
+		uint32_t uniqueID = static_cast<uint32_t>(entity->getUniqueID());
+		uint64_t classID = static_cast<uint64_t>(entity->getClassID());
+		uint32_t parentID = static_cast<uint32_t>(entity->getParent() ? entity->getParent()->getUniqueID() : 0);
+		uint64_t offset = static_cast<uint64_t>(entityOffset.second);
+		if (	out.write((const char*)&uniqueID, 4) < 0
+			||	out.write((const char*)&classID, 8) < 0
+			||	out.write((const char*)&parentID, 4) < 0
+			||	out.write((const char*)&offset, 8) < 0 )
+		{
+			return false;
+		}
+
+		QDataStream outStream(&out);
+		outStream << entity->getName();
+	}
+
+	uint64_t tocOffset = static_cast<uint64_t>(tocPos);
+	if (out.write((const char*)&tocOffset, 8) < 0 || out.write(c_tocTag, 4) < 0)
+		return false;
+
+	return true;
+}
+
+bool BinFilter::ReadTableOfContents(QFile& in, TableOfContents& toc)
+{
+	assert(in.isOpen());
+	toc.clear();
+
+	//trailer
+	if (in.size() < 20 || !in.seek(in.size() - 12))
+		return false;
+
+	uint64_t tocOffset = 0;
+	char tag[4] = { 0 };
+	if (in.read((char*)&tocOffset, 8) != 8 || in.read(tag, 4) != 4 || strncmp(tag, c_tocTag, 4) != 0)
+	{
+		//no table of contents (BIN version < 5.3)
+		return false;
+	}
+
+	if (tocOffset >= static_cast<uint64_t>(in.size()) || !in.seek(static_cast<qint64>(tocOffset)))
+		return false;
+
+	uint32_t entryCount = 0;
+	if (in.read((char*)&entryCount, 4) != 4)
+		return false;
+
+	try
+	{
+		toc.reserve(entryCount);
+	}
+	catch (const std::bad_alloc&)
+	{
+		return false;
+	}
+
+	for (uint32_t i = 0; i < entryCount; ++i)
+	{
+		uint32_t uniqueID = 0;
+		uint64_t classID = 0;
+		uint32_t parentID = 0;
+		uint64_t offset = 0;
+		if (	in.read((char*)&uniqueID, 4) != 4
+			||	in.read((char*)&classID, 8) != 8
+			||	in.read((char*)&parentID, 4) != 4
+			||	in.read((char*)&offset, 8) != 8 )
+		{
+			toc.clear();
+			return false;
+		}
+
+		TOCEntry entry;
+		entry.uniqueID = uniqueID;
+		entry.classID = static_cast<CC_CLASS_ENUM>(classID);
+		entry.parentID = parentID;
+		entry.offset = static_cast<qint64>(offset);
+
+		QDataStream inStream(&in);
+		inStream >> entry.name;
+
+		toc.push_back(entry);
+	}
+
+	return true;
 }
 
 CC_FILE_ERROR BinFilter::saveToFile(ccHObject* root, const QString& filename, const SaveParameters& parameters)
@@ -164,47 +340,69 @@ CC_FILE_ERROR BinFilter::saveToFile(ccHObject* root, const QString& filename, co
 	if (!root || filename.isNull())
 		return CC_FERR_BAD_ARGUMENT;
 
-	QFile out(filename);
-	if (!out.open(QIODevice::WriteOnly))
-		return CC_FERR_WRITING;
+	if (!parameters.parentWidget)
+	{
+		//no need for a separate thread
+		QFile out(filename);
+		if (!out.open(QIODevice::WriteOnly))
+			return CC_FERR_WRITING;
 
-	QScopedPointer<ccProgressDialog> pDlg(nullptr);
-	if (parameters.parentWidget)
+		return SaveFileV2(out, root);
+	}
+
+	ccProgressDialog pDlg(false, parameters.parentWidget);
+	pDlg.setMethodTitle(QObject::tr("BIN file"));
+	pDlg.setInfo(QObject::tr("Saving: %1").arg(QFileInfo(filename).fileName()));
+	pDlg.setRange(0, 100);
+	pDlg.setModal(true); //the entities must not be modified in the meantime
+	pDlg.start();
+
+	//the file is saved in a separate thread while the GUI remains responsive
+	QFutureWatcher<CC_FILE_ERROR> watcher;
+	QEventLoop loop;
+	QObject::connect(&watcher, &QFutureWatcher<CC_FILE_ERROR>::finished, &loop, &QEventLoop::quit);
+	QObject::connect(&watcher, &QFutureWatcher<CC_FILE_ERROR>::progressValueChanged, &pDlg, &ccProgressDialog::setValue);
+	QObject::connect(&watcher, &QFutureWatcher<CC_FILE_ERROR>::progressTextChanged, &pDlg, [&](const QString& text)
 	{
-		pDlg.reset(new ccProgressDialog(false, parameters.parentWidget));
-		pDlg->setMethodTitle(QObject::tr("BIN file"));
-		pDlg->setInfo(QObject::tr("Please wait... saving in progress"));
-		pDlg->setRange(0, 0);
-		pDlg->setModal(true);
-		pDlg->start();
+		pDlg.setInfo(QObject::tr("Saving: %1 (%2)").arg(QFileInfo(filename).fileName(), text));
+	});
+	watcher.setFuture(SaveFileAsync(root, filename));
+	if (!watcher.isFinished())
+	{
+		loop.exec();
 	}
 
-	//concurrent call
-	s_file = &out;
-	s_container = root;
+	return watcher.result();
+}
 
-	QFuture<CC_FILE_ERROR> future = QtConcurrent::run(_SaveFileV2);
+QFuture<CC_FILE_ERROR> BinFilter::SaveFileAsync(ccHObject* root, const QString& filename)
+{
+	QFutureInterface<CC_FILE_ERROR> futureInterface;
+	futureInterface.setProgressRange(0, 100);
+	futureInterface.reportStarted();
+	QFuture<CC_FILE_ERROR> future = futureInterface.future();
 
-	while (!future.isFinished())
+	if (!root || filename.isEmpty())
 	{
-#if defined(CC_WINDOWS)
-		::Sleep(500);
-#else
-		usleep(500 * 1000);
-#endif
-		if (pDlg)
-		{
-			pDlg->setValue(pDlg->value() + 1);
-		}
-		QApplication::processEvents();
+		CC_FILE_ERROR result = CC_FERR_BAD_ARGUMENT;
+		futureInterface.reportFinished(&result);
+		return future;
 	}
-	
-	s_file = nullptr;
-	s_container = nullptr;
 
-	CC_FILE_ERROR result = future.result();
+	const qint64 estimatedSize = EstimateFileSize(root);
+	QtConcurrent::run([futureInterface, root, filename, estimatedSize]() mutable
+	{
+		CC_FILE_ERROR result = CC_FERR_WRITING;
+		ProgressFile out(filename, futureInterface, estimatedSize);
+		if (out.open(QIODevice::WriteOnly))
+		{
+			result = SaveFileV2(out, root);
+		}
+		futureInterface.setProgressValue(100);
+		futureInterface.reportFinished(&result);
+	});
 
-	return result;
+	return future;
 }
 
 CC_FILE_ERROR BinFilter::SaveFileV2(QFile& out, ccHObject* object)
@@ -330,8 +528,13 @@ CC_FILE_ERROR BinFilter::SaveFileV2(QFile& out, ccHObject* object)
 	}
 
 	if (result == CC_FERR_NO_ERROR)
-		if (!object->toFile(out))
+	{
+		ccHObject::FileOffsets offsets;
+		if (!object->toFile(out, &offsets))
 			result = CC_FERR_CONSOLE_ERROR;
+		else if (!WriteTableOfContents(out, offsets))
+			result = CC_FERR_WRITING;
+	}
 
 	out.close();
 
@@ -371,6 +574,19 @@ CC_FILE_ERROR BinFilter::loadFile(const QString& filename, ccHObject& container,
 			}
 		}
 
+		//runtime flag (not stored in the file)
+		if (s_memoryMappedLoading)
+		{
+			flags |= ccSerializableObject::DF_MAPPED_READ;
+		}
+
+		//selective loading (thanks to the table of contents)
+		if (s_entityToLoad != 0)
+		{
+			in.close();
+			return LoadEntityV2(filename, s_entityToLoad, container);
+		}
+
 		//if (sizeof(PointCoordinateType) == 8 && strncmp((char*)&firstBytes,"CCB3",4) != 0)
 		//{
 		//	QMessageBox::information(nullptr, QString("Wrong version"), QString("This file has been generated with the standard 'float' version!\nAt this time it cannot be read with the 'double' version."),QMessageBox::Ok);
@@ -382,44 +598,25 @@ CC_FILE_ERROR BinFilter::loadFile(const QString& filename, ccHObject& container,
 		//	return CC_FERR_WRONG_FILE_TYPE;
 		//}
 
-		if (parameters.alwaysDisplayLoadDialog)
+		if (parameters.alwaysDisplayLoadDialog && parameters.parentWidget)
 		{
-			QScopedPointer<ccProgressDialog> pDlg(nullptr);
-			if (parameters.parentWidget)
+			ccProgressDialog pDlg(false, parameters.parentWidget);
+			pDlg.setMethodTitle(QObject::tr("BIN file"));
+			pDlg.setInfo(QObject::tr("Loading: %1").arg(QFileInfo(filename).fileName()));
+			pDlg.setRange(0, 0);
+			pDlg.show();
+
+			//the file is loaded in a separate thread while the GUI remains responsive
+			QFutureWatcher<CC_FILE_ERROR> watcher;
+			QEventLoop loop;
+			QObject::connect(&watcher, &QFutureWatcher<CC_FILE_ERROR>::finished, &loop, &QEventLoop::quit);
+			watcher.setFuture(QtConcurrent::run([&in, &container, flags]() { return BinFilter::LoadFileV2(in, container, flags); }));
+			if (!watcher.isFinished())
 			{
-				pDlg.reset(new ccProgressDialog(false, parameters.parentWidget));
-				pDlg->setMethodTitle(QObject::tr("BIN file"));
-				pDlg->setInfo(QObject::tr("Loading: %1").arg(QFileInfo(filename).fileName()));
-				pDlg->setRange(0, 0);
-				pDlg->show();
+				loop.exec();
 			}
 
-			//concurrent call in a separate thread
-			s_file = &in;
-			s_container = &container;
-			s_flags = flags;
-
-			QFuture<CC_FILE_ERROR> future = QtConcurrent::run(_LoadFileV2);
-
-			while (!future.isFinished())
-			{
-#if defined(CC_WINDOWS)
-				::Sleep(500);
-#else
-				usleep(500 * 1000);
-#endif
-				if (pDlg)
-				{
-					pDlg->setValue(pDlg->value() + 1);
-				}
-				//pDlg.setValue(static_cast<int>(in.pos())); //DGM: in fact, the file reading part is just half of the work!
-				QApplication::processEvents();
-			}
-	
-			s_file = nullptr;
-			s_container = nullptr;
-
-			return future.result();
+			return watcher.result();
 		}
 		else
 		{
@@ -491,9 +688,71 @@ CC_FILE_ERROR BinFilter::LoadFileV2(QFile& in, ccHObject& container, int flags)
 		return CC_FERR_CONSOLE_ERROR;
 	}
 
-	//we keep track of the last unique ID before load
-	unsigned lastUniqueIDBeforeLoad = ccObject::GetLastUniqueID();
+	return LoadEntitiesV2(in, container, flags, binVersion);
+}
 
+CC_FILE_ERROR BinFilter::LoadEntityV2(const QString& filename, unsigned uniqueID, ccHObject& container)
+{
+	QFile in(filename);
+	if (!in.open(QIODevice::ReadOnly))
+		return CC_FERR_READING;
+
+	char firstBytes[4] = { 0 };
+	if (in.read(firstBytes, 4) != 4)
+		return CC_FERR_READING;
+	if (strncmp(firstBytes, "CCB", 3) != 0)
+		return CC_FERR_WRONG_FILE_TYPE;
+
+	int flags = firstBytes[3] - 48; //48 = ASCII("0")
+	if (flags < 0 || flags > 8)
+	{
+		ccLog::Error(QString("Invalid file header (4th byte is '%1'?!)").arg(firstBytes[3]));
+		return CC_FERR_WRONG_FILE_TYPE;
+	}
+	if (s_memoryMappedLoading)
+	{
+		flags |= ccSerializableObject::DF_MAPPED_READ;
+	}
+
+	uint32_t binVersion = 20;
+	if (in.read((char*)&binVersion, 4) < 0)
+		return CC_FERR_READING;
+	if (ccObject::GetCurrentDBVersion() < binVersion)
+	{
+		ccLog::Error("This version of CloudCompare is too old and can't load this file, sorry");
+		return CC_FERR_CONSOLE_ERROR;
+	}
+
+	TableOfContents toc;
+	if (binVersion < 53 || !ReadTableOfContents(in, toc))
+	{
+		ccLog::Error("[BIN] This file has no table of contents (BIN version < 5.3)");
+		return CC_FERR_NOT_IMPLEMENTED;
+	}
+
+	for (const TOCEntry& entry : toc)
+	{
+		if (entry.uniqueID == uniqueID)
+		{
+			if (!in.seek(entry.offset))
+				return CC_FERR_READING;
+
+			ccLog::Print(QString("[BIN] Loading entity '%1' (ID=%2)").arg(entry.name).arg(uniqueID));
+			return LoadEntitiesV2(in, container, flags, binVersion);
+		}
+	}
+
+	ccLog::Print(QString("[BIN] Entity ID=%1 not found in file. Available entities:").arg(uniqueID));
+	for (const TOCEntry& entry : toc)
+	{
+		ccLog::Print(QString("\t- '%1' (ID=%2)").arg(entry.name).arg(entry.uniqueID));
+	}
+	ccLog::Error(QString("[BIN] Entity ID=%1 not found in file").arg(uniqueID));
+	return CC_FERR_BAD_ARGUMENT;
+}
+
+CC_FILE_ERROR BinFilter::LoadEntitiesV2(QFile& in, ccHObject& container, int flags, uint32_t binVersion)
+{
 	//we read first entity type
 	CC_CLASS_ENUM classID = ccObject::ReadClassIDFromFile(in, static_cast<short>(binVersion));
 	if (classID == CC_TYPES::OBJECT)
@@ -0,0 +1,281 @@
+#include "TestBinFilter.h"
+
+#include "BinFilter.h"
+#include "ccHObject.h"
+#include "ccPointCloud.h"
+#include "ccPointCloudLOD.h"
+#include "ccScalarField.h"
+
+#include <QElapsedTimer>
+#include <QFile>
+#include <QTemporaryDir>
+#include <QThread>
+
+//! Creates a (pseudo-random) cloud with a scalar field
+static ccPointCloud* CreateCloud(const QString& name, unsigned pointCount, uint32_t seed)
+{
+	ccPointCloud* cloud = new ccPointCloud(name);
+	if (!cloud->reserve(pointCount))
+	{
+		delete cloud;
+		return nullptr;
+	}
+
+	//simple LCG, so that the test is deterministic
+	auto nextValue = [&seed]() -> PointCoordinateType
+	{
+		seed = seed * 1664525u + 1013904223u;
+		return static_cast<PointCoordinateType>(seed >> 8) / (1 << 24);
+	};
+
+	for (unsigned i = 0; i < pointCount; ++i)
+	{
+		CCVector3 P(nextValue() * 100, nextValue() * 50, nextValue() * 10);
+		cloud->addPoint(P);
+	}
+
+	int sfIdx = cloud->addScalarField("height");
+	if (sfIdx < 0)
+	{
+		delete cloud;
+		return nullptr;
+	}
+	CCCoreLib::ScalarField* sf = cloud->getScalarField(sfIdx);
+	for (unsigned i = 0; i < pointCount; ++i)
+	{
+		sf->setValue(i, static_cast<ScalarType>(cloud->getPoint(i)->z));
+	}
+	sf->computeMinAndMax();
+
+	return cloud;
+}
+
+//! Builds the LOD structure of a cloud and waits for its completion
+static bool BuildLOD(ccPointCloud* cloud)
+{
+	if (!cloud->initLOD())
+	{
+		return false;
+	}
+
+	ccPointCloudLOD* lod = cloud->getLOD();
+	QElapsedTimer timer;
+	timer.start();
+	while (!lod->isInitialized() && !lod->isBroken() && timer.elapsed() < 60000)
+	{
+		QThread::msleep(10);
+	}
+
+	return lod->isInitialized();
+}
+
+//! Saves a hierarchy (root group + 2 clouds, the first one with a LOD structure)
+static bool SaveTestFile(const QString& filename, ccHObject& root, ccPointCloud*& cloudWithLOD, ccPointCloud*& cloudWithoutLOD)
+{
+	cloudWithLOD = CreateCloud("cloud with LOD", 100000, 1);
+	cloudWithoutLOD = CreateCloud("cloud without LOD", 1000, 2);
+	if (!cloudWithLOD || !cloudWithoutLOD)
+	{
+		return false;
+	}
+	root.addChild(cloudWithLOD);
+	root.addChild(cloudWithoutLOD);
+
+	if (!BuildLOD(cloudWithLOD))
+	{
+		return false;
+	}
+
+	FileIOFilter::SaveParameters saveParams;
+	saveParams.alwaysDisplaySaveDialog = false;
+	BinFilter filter;
+	return (filter.saveToFile(&root, filename, saveParams) == CC_FERR_NO_ERROR);
+}
+
+//! Returns the (only) cloud of a given name in a container
+static ccPointCloud* FindCloud(const ccHObject& container, const QString& name)
+{
+	ccHObject::Container clouds;
+	container.filterChildren(clouds, true, CC_TYPES::POINT_CLOUD, true);
+	for (ccHObject* cloud : clouds)
+	{
+		if (cloud->getName() == name)
+		{
+			return static_cast<ccPointCloud*>(cloud);
+		}
+	}
+	return nullptr;
+}
+
+void TestBinFilter::testTableOfContents() const
+{
+	QTemporaryDir tmpDir;
+	QString filename = tmpDir.filePath("toc.bin");
+
+	ccHObject root("root");
+	ccPointCloud* cloudWithLOD = nullptr;
+	ccPointCloud* cloudWithoutLOD = nullptr;
+	QVERIFY(SaveTestFile(filename, root, cloudWithLOD, cloudWithoutLOD));
+
+	QFile in(filename);
+	QVERIFY(in.open(QIODevice::ReadOnly));
+
+	//header
+	char firstBytes[4] = { 0 };
+	QCOMPARE(in.read(firstBytes, 4), qint64(4));
+	QVERIFY(strncmp(firstBytes, "CCB", 3) == 0);
+	uint32_t binVersion = 0;
+	QCOMPARE(in.read((char*)&binVersion, 4), qint64(4));
+	QCOMPARE(binVersion, static_cast<uint32_t>(ccObject::GetCurrentDBVersion()));
+	QVERIFY(binVersion >= 54); //table of contents (5.3) + LOD structure (5.4)
+
+	//table of contents
+	BinFilter::TableOfContents toc;
+	QVERIFY(BinFilter::ReadTableOfContents(in, toc));
+	QCOMPARE(toc.size(), size_t(3));
+
+	QCOMPARE(toc[0].uniqueID, root.getUniqueID());
+	QVERIFY(toc[0].classID == CC_TYPES::HIERARCHY_OBJECT);
+	QCOMPARE(toc[0].parentID, 0u);
+	QCOMPARE(toc[0].offset, qint64(8));
+	QCOMPARE(toc[0].name, root.getName());
+
+	const ccPointCloud* clouds[2] = { cloudWithLOD, cloudWithoutLOD };
+	for (size_t i = 0; i < 2; ++i)
+	{
+		const BinFilter::TOCEntry& entry = toc[i + 1];
+		QCOMPARE(entry.uniqueID, clouds[i]->getUniqueID());
+		QVERIFY(entry.classID == CC_TYPES::POINT_CLOUD);
+		QCOMPARE(entry.parentID, root.getUniqueID());
+		QCOMPARE(entry.name, clouds[i]->getName());
+		QVERIFY(entry.offset > toc[i].offset);
+		QVERIFY(entry.offset < in.size());
+	}
+}
+
+void TestBinFilter::testRoundTripWithLOD() const
+{
+	QTemporaryDir tmpDir;
+	QString filename = tmpDir.filePath("lod.bin");
+
+	ccHObject root("root");
+	ccPointCloud* cloudWithLOD = nullptr;
+	ccPointCloud* cloudWithoutLOD = nullptr;
+	QVERIFY(SaveTestFile(filename, root, cloudWithLOD, cloudWithoutLOD));
+
+	ccHObject container;
+	FileIOFilter::LoadParameters loadParams;
+	loadParams.alwaysDisplayLoadDialog = false;
+	BinFilter filter;
+	QCOMPARE(filter.loadFile(filename, container, loadParams), CC_FERR_NO_ERROR);
+
+	//points and scalar field
+	ccPointCloud* loadedCloud = FindCloud(container, cloudWithLOD->getName());
+	QVERIFY(loadedCloud);
+	QCOMPARE(loadedCloud->size(), cloudWithLOD->size());
+	QCOMPARE(loadedCloud->getNumberOfScalarFields(), 1u);
+	for (unsigned i = 0; i < loadedCloud->size(); ++i)
+	{
+		const CCVector3* P = cloudWithLOD->getPoint(i);
+		const CCVector3* loadedP = loadedCloud->getPoint(i);
+		QCOMPARE(loadedP->x, P->x);
+		QCOMPARE(loadedP->y, P->y);
+		QCOMPARE(loadedP->z, P->z);
+		QCOMPARE(loadedCloud->getScalarField(0)->getValue(i), cloudWithLOD->getScalarField(0)->getValue(i));
+	}
+
+	//the LOD structure ('withLOD' nodes) is loaded directly
+	ccPointCloudLOD* lod = cloudWithLOD->getLOD();
+	ccPointCloudLOD* loadedLOD = loadedCloud->getLOD();
+	QVERIFY(loadedLOD);
+	QVERIFY(loadedLOD->isInitialized());
+	QCOMPARE(loadedLOD->maxLevel(), lod->maxLevel());
+	QVERIFY(lod->maxLevel() > 1);
+
+	for (unsigned char level = 0; level <= lod->maxLevel(); ++level)
+	{
+		QCOMPARE(loadedLOD->nodeCount(level), lod->nodeCount(level));
+		for (size_t i = 0; i < lod->nodeCount(level); ++i)
+		{
+			const ccPointCloudLOD::Node& node = lod->node(static_cast<int32_t>(i), level);
+			const ccPointCloudLOD::Node& loadedNode = loadedLOD->node(static_cast<int32_t>(i), level);
+			QCOMPARE(loadedNode.pointCount, node.pointCount);
+			QCOMPARE(loadedNode.radius, node.radius);
+			QCOMPARE(loadedNode.center.x, node.center.x);
+			QCOMPARE(loadedNode.center.y, node.center.y);
+			QCOMPARE(loadedNode.center.z, node.center.z);
+			QVERIFY(loadedNode.childIndexes == node.childIndexes);
+			QCOMPARE(loadedNode.firstCodeIndex, node.firstCodeIndex);
+			QCOMPARE(loadedNode.level, node.level);
+			QCOMPARE(loadedNode.childCount, node.childCount);
+		}
+	}
+
+	//point indexes in the LOD order (m_pointIndexes, instead of the octree codes)
+	for (uint32_t i = 0; i < cloudWithLOD->size(); ++i)
+	{
+		QCOMPARE(loadedLOD->pointIndex(i), lod->pointIndex(i));
+	}
+
+	//no LOD structure saved with the second cloud
+	ccPointCloud* loadedCloud2 = FindCloud(container, cloudWithoutLOD->getName());
+	QVERIFY(loadedCloud2);
+	QCOMPARE(loadedCloud2->size(), cloudWithoutLOD->size());
+	QVERIFY(!loadedCloud2->getLOD() || !loadedCloud2->getLOD()->isInitialized());
+}
+
+void TestBinFilter::testLoadSingleEntity() const
+{
+	QTemporaryDir tmpDir;
+	QString filename = tmpDir.filePath("entity.bin");
+
+	ccHObject root("root");
+	ccPointCloud* cloudWithLOD = nullptr;
+	ccPointCloud* cloudWithoutLOD = nullptr;
+	QVERIFY(SaveTestFile(filename, root, cloudWithLOD, cloudWithoutLOD));
+
+	FileIOFilter::LoadParameters loadParams;
+	loadParams.alwaysDisplayLoadDialog = false;
+	BinFilter filter;
+
+	//load the second cloud only
+	{
+		ccHObject container;
+		BinFilter::SetEntityToLoad(cloudWithoutLOD->getUniqueID());
+		CC_FILE_ERROR error = filter.loadFile(filename, container, loadParams);
+		BinFilter::SetEntityToLoad(0);
+		QCOMPARE(error, CC_FERR_NO_ERROR);
+
+		QCOMPARE(container.getChildrenNumber(), 1u);
+		QVERIFY(container.getChild(0)->isA(CC_TYPES::POINT_CLOUD));
+		ccPointCloud* loadedCloud = static_cast<ccPointCloud*>(container.getChild(0));
+		QCOMPARE(loadedCloud->getName(), cloudWithoutLOD->getName());
+		QCOMPARE(loadedCloud->size(), cloudWithoutLOD->size());
+		for (unsigned i = 0; i < loadedCloud->size(); ++i)
+		{
+			const CCVector3* P = cloudWithoutLOD->getPoint(i);
+			const CCVector3* loadedP = loadedCloud->getPoint(i);
+			QCOMPARE(loadedP->x, P->x);
+			QCOMPARE(loadedP->y, P->y);
+			QCOMPARE(loadedP->z, P->z);
+		}
+	}
+
+	//the first cloud (with its LOD structure)
+	{
+		ccHObject container;
+		QCOMPARE(BinFilter::LoadEntityV2(filename, cloudWithLOD->getUniqueID(), container), CC_FERR_NO_ERROR);
+		ccPointCloud* loadedCloud = FindCloud(container, cloudWithLOD->getName());
+		QVERIFY(loadedCloud);
+		QCOMPARE(loadedCloud->size(), cloudWithLOD->size());
+		QVERIFY(loadedCloud->getLOD() && loadedCloud->getLOD()->isInitialized());
+	}
+
+	//unknown entity
+	{
+		ccHObject container;
+		QCOMPARE(BinFilter::LoadEntityV2(filename, root.getUniqueID() + 1000, container), CC_FERR_BAD_ARGUMENT);
+	}
+}
+
+QTEST_MAIN(TestBinFilter)
@@ -0,0 +1,25 @@
+#ifndef CC_TEST_BIN_FILTER_HEADER
+#define CC_TEST_BIN_FILTER_HEADER
+
+#include <QObject>
+#include <QtTest/QtTest>
+
+class TestBinFilter : public QObject
+{
+Q_OBJECT
+private Q_SLOTS:
+	/*
+	 * Save/load round-trip tests (current BIN version):
+	 * 1) create a hierarchy of clouds (one of them with a LOD structure)
+	 * 2) save it
+	 * 3) check the table of contents, then load the whole file or a single entity back
+	 */
+	void testTableOfContents() const;
+
+	void testRoundTripWithLOD() const;
+
+	void testLoadSingleEntity() const;
+};
+
+
+#endif //CC_TEST_BIN_FILTER_HEADER
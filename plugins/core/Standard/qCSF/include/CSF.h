@@ -38,6 +38,8 @@
 
 class ccMainAppInterface;
 class QWidget;
+class QProgressDialog;
+class QString;
 class ccMesh;
 
 class CSF
@@ -54,6 +56,7 @@ public:
 	void saveOffGroundPoints(const std::vector<int>& grp, std::string path = "");
 	
 	//The main program: Do filtering
+	//(the cloud is processed by tiles if params.tile_size > 0 and the cloud is bigger than a tile)
 	bool do_filtering(	std::vector<unsigned>& groundIndexes,
 						std::vector<unsigned>& offGroundIndexes,
 						bool exportClothMesh,
@@ -62,6 +65,32 @@ public:
 						QWidget* parent = nullptr);
 
 private:
+
+	//Runs the cloth simulation on a single cloud (the whole cloud or a tile)
+	//(if a reference bounding-box is set, the cloth is aligned with its grid and starts just above the tile)
+	bool filterCloud(	wl::PointCloud& cloud,
+						std::vector<unsigned>& groundIndexes,
+						std::vector<unsigned>& offGroundIndexes,
+						bool exportClothMesh,
+						ccMesh* &clothMesh,
+						ccMainAppInterface* app,
+						QProgressDialog& pDlg,
+						const QString& stepInfo,
+						const wl::Point* refBBMin = nullptr,
+						const wl::Point* refBBMax = nullptr);
+
+	//Processes the cloud by overlapping tiles (each tile is simulated independently)
+	/** Each point gets the label computed by the tile whose core contains it (i.e. the tile
+		in which it is the farthest from the borders). The points of the overlap are only
+		used to support the cloth near the borders of the neighboring tiles.
+	**/
+	bool do_tiled_filtering(std::vector<unsigned>& groundIndexes,
+							std::vector<unsigned>& offGroundIndexes,
+							const wl::Point& bbMin,
+							const wl::Point& bbMax,
+							ccMainAppInterface* app,
+							QProgressDialog& pDlg);
+
 	wl::PointCloud& point_cloud;
 
 public:
@@ -82,6 +111,12 @@ public:
 		int rigidness;
 
 		int iterations;
+
+		//tile size (in the horizontal plane) - 0 = no tiling
+		double tile_size;
+
+		//overlap between the tiles (< 0 = automatic: 10% of the tile size)
+		double tile_overlap;
 	};
 	
 	Parameters params;
@@ -48,7 +48,6 @@
 
 //local
 #include "Vec3.h"
-#include "Particle.h"
 
 //system
 #include <vector>
@@ -56,27 +55,33 @@
 
 class ccMesh;
 
-struct XY
-{
-	XY(int x1, int y1)
-		: x(x1)
-		, y(y1)
-	{}
-	int x;
-	int y;
-};
-
+/* Some physics constants */
+#define DAMPING 0.01 // how much to damp the cloth simulation each frame
+#define MAX_INF 9999999999 
+#define MIN_INF -9999999999
+
+//! Cloth (regular grid of particles)
+/** The particles are stored as a structure of arrays (one array per attribute) in row-major
+	order (index = y * num_particles_width + x). They only move vertically (i.e. along the Y
+	axis): their X and Z coordinates are given by their position in the grid.
+	Each particle is linked to its neighbors up to 2 cells away (see NeighborOffsets).
+**/
 class Cloth
 {
 private:
 
 	// total number of particles is num_particles_width*num_particles_height
-	int constraint_iterations;
+	double time_step2; //squared time step
 
-	double time_step;
+	//overall displacement of a particle (constraints) according to the rigidness
+	double singleMove; //when only one of the two particles can move
+	double doubleMove; //when both particles can move
 
-	std::vector<Particle> particles; // all particles that are part of this cloth
-//	std::vector<Constraint> constraints; // alle constraints between particles as part of this cloth
+	//particles (structure of arrays)
+	std::vector<double> pos_y; // the current height of each particle
+	std::vector<double> old_pos_y; // the height of each particle in the previous time step, used as part of the verlet numerical integration scheme
+	std::vector<unsigned char> movable; // can the particle move or not ? used to pin parts of the cloth
+	double acceleration_y; // the current (vertical) acceleration of the particles
 
 	//parameters of slope postpocessing
 	double smoothThreshold;
@@ -85,23 +90,18 @@ private:
 	//heightvalues
 	std::vector<double> heightvals;
 
-	//movable particle index
-	std::vector<int> movableIndex;
-	std::vector< std::vector<int> > particle_edges;
-	
-	//record 
-	inline void addConstraint(Particle *p1, Particle *p2) 
-	{ /*constraints.push_back(Constraint(p1, p2));*/ 
-		p1->neighborsList.push_back(p2);  //record the neighbor for each particle
-		p2->neighborsList.push_back(p1);
-	}
+	//satisfies the constraints between a particle and its neighbors
+	void satisfyConstraints(int x, int y);
+
+	//satisfies the constraints of all the particles (in parallel, by bands of rows)
+	void satisfyConstraints();
 
 public:
 
-	inline Particle& getParticle(int x, int y) { return particles[y*num_particles_width + x]; }
-	inline const Particle& getParticle(int x, int y) const { return particles[y*num_particles_width + x]; }
-	inline Particle& getParticleByIndex(int index) { return particles[index]; }
-	inline const Particle getParticleByIndex(int index) const { return particles[index]; }
+	//! Number of neighbors of each particle (constraints)
+	static const int NEIGHBOR_COUNT = 16;
+	//! Relative positions (x, y) of the neighbors of a particle in the grid
+	static const int NeighborOffsets[NEIGHBOR_COUNT][2];
 
 	int num_particles_width; // number of particles in "width" direction
 	int num_particles_height; // number of particles in "height" direction
@@ -110,6 +110,19 @@ public:
 
 	inline int getSize() const { return num_particles_width * num_particles_height; }
 
+	inline int getIndex(int x, int y) const { return y * num_particles_width + x; }
+
+	inline double getParticleHeight(int x, int y) const { return pos_y[getIndex(x, y)]; }
+
+	inline Vec3 getParticlePos(int index) const
+	{
+		return Vec3(	origin_pos.x + (index % num_particles_width) * step_x,
+						pos_y[index],
+						origin_pos.z + (index / num_particles_width) * step_y);
+	}
+
+	inline bool isMovable(int index) const { return movable[index] != 0; }
+
 	inline std::vector<double>& getHeightvals() { return heightvals; }
 
 public:
@@ -131,28 +144,34 @@ public:
 	}
 
 	/** This is an important methods where the time is progressed one time step for the entire cloth.
-		This includes calling satisfyConstraint() for every constraint, and calling timeStep() for all particles
+		This includes the verlet integration of all particles, then the constraints satisfaction.
+		\return the maximum (vertical) displacement of the movable particles
 	**/
 	double timeStep();
 
-	/* used to add gravity (or any other arbitrary vector) to all particles */
+	/* used to add gravity (or any other arbitrary vector) to all particles (only the vertical component is considered) */
 	void addForce(const Vec3& direction);
 
 	//detecting collision of cloth and terrain
 	void terrainCollision();
 
 	//implementing postpocessing to movable particles
+	/** The groups of connected movable particles are processed in parallel.
+		Throws std::bad_alloc if there's not enough memory.
+	**/
 	void movableFilter();
 	//ҵÿƶ㣬ͨΧĲƶ㡣мƽ
-	void findUnmovablePoint(const std::vector<XY>& connected,
-							const std::vector<double>& heightvals,
+	void findUnmovablePoint(const int* connected,
+							int connectedCount,
 							std::vector<int>& edgePoints);
 	
 	//ֱӶͨб´
 	void handle_slop_connected(	const std::vector<int>& edgePoints,
-								const std::vector<XY>& connected,
-								const std::vector< std::vector<int> >& neighbors,
-								const std::vector<double> &heightvals);
+								const int* connected,
+								int connectedCount,
+								int component,
+								const std::vector<int>& components,
+								const std::vector<int>& memberIndexes);
 
 	//saving the cloth to file
 	void saveToFile(std::string path = "");
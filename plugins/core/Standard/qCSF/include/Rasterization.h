@@ -40,8 +40,8 @@ public:
 
 	//for a cloth particle, if no corresponding lidar point are found. 
 	//the heightval are set as its neighbor's
-	double static findHeightValByNeighbor(Particle *p, Cloth &cloth);
-	double static findHeightValByScanline(Particle *p, Cloth &cloth);
+	double static findHeightValByNeighbor(int x, int y, const Cloth& cloth, const std::vector<double>& nearestHeights);
+	double static findHeightValByScanline(int x, int y, const Cloth& cloth, const std::vector<double>& nearestHeights);
 
 	//ԵƽٽѰΧN  
 	static bool RasterTerrain(Cloth& cloth, const wl::PointCloud& pc, std::vector<double>& heightVal, unsigned KNN = 1);
@@ -50,6 +50,8 @@ static const char COMMAND_CSF_MAX_ITERATION[] = "MAX_ITERATION";
 static const char COMMAND_CSF_CLASS_THRESHOLD[] = "CLASS_THRESHOLD";
 static const char COMMAND_CSF_EXPORT_GROUND[] = "EXPORT_GROUND";
 static const char COMMAND_CSF_EXPORT_OFFGROUND[] = "EXPORT_OFFGROUND";
+static const char COMMAND_CSF_TILE_SIZE[] = "TILE_SIZE";
+static const char COMMAND_CSF_TILE_OVERLAP[] = "TILE_OVERLAP";
 
 
 struct CommandCSF : public ccCommandLineInterface::Command
@@ -98,6 +100,8 @@ struct CommandCSF : public ccCommandLineInterface::Command
 		int maxIteration = 500;
 		bool exportGround = false;
 		bool exportOffground = false;
+		double tileSize = 0;
+		double tileOverlap = -1; //default: 10% of the tile size
 
 		while (!cmd.arguments().empty())
 		{
@@ -178,6 +182,28 @@ struct CommandCSF : public ccCommandLineInterface::Command
 				cmd.print("Off-ground will be exported");
 				exportOffground = true;
 			}
+			else if (ccCommandLineInterface::IsCommand(ARGUMENT, COMMAND_CSF_TILE_SIZE))
+			{
+				cmd.arguments().pop_front();
+				bool conv = false;
+				tileSize = cmd.arguments().takeFirst().toDouble(&conv);
+				if (!conv || tileSize <= 0)
+				{
+					return cmd.error(QObject::tr("Invalid parameter: value after \"-%1\"").arg(COMMAND_CSF_TILE_SIZE));
+				}
+				cmd.print(QString("Tile size set: %1").arg(tileSize));
+			}
+			else if (ccCommandLineInterface::IsCommand(ARGUMENT, COMMAND_CSF_TILE_OVERLAP))
+			{
+				cmd.arguments().pop_front();
+				bool conv = false;
+				tileOverlap = cmd.arguments().takeFirst().toDouble(&conv);
+				if (!conv || tileOverlap < 0)
+				{
+					return cmd.error(QObject::tr("Invalid parameter: value after \"-%1\"").arg(COMMAND_CSF_TILE_OVERLAP));
+				}
+				cmd.print(QString("Tile overlap set: %1").arg(tileOverlap));
+			}
 			else
 			{
 				cmd.print("Set all parameters");
@@ -196,6 +222,8 @@ struct CommandCSF : public ccCommandLineInterface::Command
 		csf.params.cloth_resolution = clothResolution;
 		csf.params.rigidness = csfRigidness;
 		csf.params.iterations = maxIteration;
+		csf.params.tile_size = tileSize;
+		csf.params.tile_overlap = tileOverlap;
 
 		std::vector<unsigned> groundIndexes;
 		std::vector<unsigned> offGroundIndexes;
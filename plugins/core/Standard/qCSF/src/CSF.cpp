@@ -34,6 +34,7 @@
 #include "Cloud2CloudDist.h"
 
 //CC (for debug)
+#include <ccLog.h>
 #include <ccMainAppInterface.h>
 
 //Qt
@@ -42,6 +43,8 @@
 #include <QElapsedTimer>
 
 //system
+#include <algorithm>
+#include <assert.h>
 #include <cmath>
 #include <iomanip>
 #include <fstream>
@@ -58,6 +61,8 @@ CSF::CSF(wl::PointCloud& cloud)
 	params.cloth_resolution = 1.5;
 	params.rigidness = 3;
 	params.iterations = 500;
+	params.tile_size = 0;
+	params.tile_overlap = -1.0; //automatic
 }
 
 bool CSF::readPointsFromFile(std::string filename)
@@ -105,138 +110,352 @@ bool CSF::do_filtering(	std::vector<unsigned>& groundIndexes,
 						ccMesh* &clothMesh,
 						ccMainAppInterface* app/*=nullptr*/,
 						QWidget* parent/*=nullptr*/)
+{
+	try
+	{
+		QProgressDialog pDlg(parent);
+		pDlg.setWindowTitle("CSF");
+
+		if (params.tile_size > 0)
+		{
+			//compute the terrain (cloud) bounding-box
+			wl::Point bbMin;
+			wl::Point bbMax;
+			point_cloud.computeBoundingBox(bbMin, bbMax);
+
+			if (bbMax.x - bbMin.x > params.tile_size || bbMax.z - bbMin.z > params.tile_size)
+			{
+				if (exportClothMesh && app)
+				{
+					app->dispToConsole("[CSF] The cloth mesh can't be exported in tiled mode", ccMainAppInterface::WRN_CONSOLE_MESSAGE);
+				}
+				return do_tiled_filtering(groundIndexes, offGroundIndexes, bbMin, bbMax, app, pDlg);
+			}
+		}
+
+		return filterCloud(point_cloud, groundIndexes, offGroundIndexes, exportClothMesh, clothMesh, app, pDlg, QString());
+	}
+	catch (const std::bad_alloc&)
+	{
+		//not enough memory
+		return false;
+	}
+}
+
+bool CSF::filterCloud(	wl::PointCloud& cloud,
+						std::vector<unsigned>& groundIndexes,
+						std::vector<unsigned>& offGroundIndexes,
+						bool exportClothMesh,
+						ccMesh* &clothMesh,
+						ccMainAppInterface* app,
+						QProgressDialog& pDlg,
+						const QString& stepInfo,
+						const wl::Point* refBBMin/*=nullptr*/,
+						const wl::Point* refBBMax/*=nullptr*/)
 {
 	//constants
 	static const double cloth_y_height = 0.05; //origin cloth height
 	static const int clothbuffer = 2; //set the cloth buffer (grid margin size)
 	static const double gravity = 0.2;
 
-	try
+	QElapsedTimer timer;
+	timer.start();
+
+	//compute the terrain (cloud) bounding-box
+	wl::Point bbMin;
+	wl::Point bbMax;
+	cloud.computeBoundingBox(bbMin, bbMax);
+
+	//computing the number of cloth node
+	Vec3 origin_pos(	bbMin.x - clothbuffer * params.cloth_resolution,
+						bbMax.y + cloth_y_height,
+						bbMin.z - clothbuffer * params.cloth_resolution);
+
+	int width_num = static_cast<int>(floor((bbMax.x - bbMin.x) / params.cloth_resolution)) + 2 * clothbuffer;
+	int height_num = static_cast<int>(floor((bbMax.z - bbMin.z) / params.cloth_resolution)) + 2 * clothbuffer;
+
+	if (refBBMin && refBBMax)
 	{
-		QElapsedTimer timer;
-		timer.start();
-
-		//compute the terrain (cloud) bounding-box
-		wl::Point bbMin;
-		wl::Point bbMax;
-		point_cloud.computeBoundingBox(bbMin, bbMax);
-
-		//computing the number of cloth node
-		Vec3 origin_pos(	bbMin.x - clothbuffer * params.cloth_resolution,
-							bbMax.y + cloth_y_height,
-							bbMin.z - clothbuffer * params.cloth_resolution);
+		//the cloth is aligned with the grid of the reference bounding-box (so that the cloths of
+		//neighboring tiles are consistent), and starts just above the (local) terrain
+		origin_pos.x = refBBMin->x + (floor((bbMin.x - refBBMin->x) / params.cloth_resolution) - clothbuffer) * params.cloth_resolution;
+		origin_pos.y = refBBMin->y + ceil((bbMax.y - refBBMin->y) / params.cloth_resolution) * params.cloth_resolution + cloth_y_height;
+		origin_pos.z = refBBMin->z + (floor((bbMin.z - refBBMin->z) / params.cloth_resolution) - clothbuffer) * params.cloth_resolution;
+		width_num = static_cast<int>(floor((bbMax.x - origin_pos.x) / params.cloth_resolution)) + 1 + clothbuffer;
+		height_num = static_cast<int>(floor((bbMax.z - origin_pos.z) / params.cloth_resolution)) + 1 + clothbuffer;
+	}
 	
-		int width_num = static_cast<int>(floor((bbMax.x - bbMin.x) / params.cloth_resolution)) + 2 * clothbuffer;
-		int height_num = static_cast<int>(floor((bbMax.z - bbMin.z) / params.cloth_resolution)) + 2 * clothbuffer;
-		
-		//Cloth object
-		Cloth cloth(origin_pos, 
-					width_num,
-					height_num,
-					params.cloth_resolution,
-					params.cloth_resolution,
-					0.3,
-					9999,
-					params.rigidness,
-					params.time_step);
-		if (app)
+	//Cloth object
+	Cloth cloth(origin_pos, 
+				width_num,
+				height_num,
+				params.cloth_resolution,
+				params.cloth_resolution,
+				0.3,
+				9999,
+				params.rigidness,
+				params.time_step);
+	if (app)
+	{
+		app->dispToConsole(QString("[CSF] Cloth creation: %1 ms").arg(timer.restart()));
+	}
+
+	if (!Rasterization::RasterTerrain(cloth, cloud, cloth.getHeightvals(), params.k_nearest_points))
+	{
+		return false;
+	}
+	//app->dispToConsole("raster cloth", ccMainAppInterface::ERR_CONSOLE_MESSAGE);
+
+	if (app)
+	{
+		app->dispToConsole(QString("[CSF] Rasterization: %1 ms").arg(timer.restart()));
+	}
+
+	double time_step2 = params.time_step * params.time_step;
+
+	//do the filtering
+	QString labelText = QObject::tr("Cloth deformation\n%1 x %2 particles").arg(cloth.num_particles_width).arg(cloth.num_particles_height);
+	if (!stepInfo.isEmpty())
+	{
+		labelText.prepend(stepInfo + "\n");
+	}
+	pDlg.setLabelText(labelText);
+	pDlg.setRange(0, params.iterations);
+	pDlg.setValue(0);
+	pDlg.show();
+	QCoreApplication::processEvents();
+
+	bool wasCancelled = false;
+	cloth.addForce(Vec3(0, -gravity, 0) * time_step2);
+	for (int i = 0; i < params.iterations; i++)
+	{
+		//cloth.addForce(Vec3(0, -gravity, 0) * time_step2); //move this outside the main loop
+		double maxDiff = cloth.timeStep();
+		cloth.terrainCollision();
+
+		//if (app && (i % 50) == 0)
+		//{
+		//	app->dispToConsole(QString("[CSF] Iteration %1: max delta = %2").arg(i+1).arg(maxDiff));
+		//}
+
+		if (maxDiff != 0 && maxDiff < 0.005)
 		{
-			app->dispToConsole(QString("[CSF] Cloth creation: %1 ms").arg(timer.restart()));
+			//early stop
+			break;
 		}
 
-		if (!Rasterization::RasterTerrain(cloth, point_cloud, cloth.getHeightvals(), params.k_nearest_points))
+		pDlg.setValue(i);
+		QCoreApplication::processEvents();
+
+		if (pDlg.wasCanceled())
 		{
-			return false;
+			wasCancelled = true;
+			break;
 		}
-		//app->dispToConsole("raster cloth", ccMainAppInterface::ERR_CONSOLE_MESSAGE);
+	}
 	
+	if (app)
+	{
+		app->dispToConsole(QString("[CSF] Iterations: %1 ms").arg(timer.restart()));
+	}
+
+	if (wasCancelled)
+	{
+		return false;
+	}
+
+	//slope processing
+	if (params.bSloopSmooth)
+	{
+		cloth.movableFilter();
+
 		if (app)
 		{
-			app->dispToConsole(QString("[CSF] Rasterization: %1 ms").arg(timer.restart()));
+			app->dispToConsole(QString("[CSF] Movable filter: %1 ms").arg(timer.restart()));
 		}
+	}
 
-		double time_step2 = params.time_step * params.time_step;
+	//classification of the points
+	bool result = Cloud2CloudDist::Compute(cloth, cloud, params.class_threshold, groundIndexes, offGroundIndexes);
+	if (app)
+	{
+		app->dispToConsole(QString("[CSF] Distance computation: %1 ms").arg(timer.restart()));
+	}
 
-		//do the filtering
-		QProgressDialog pDlg(parent);
-		pDlg.setWindowTitle("CSF");
-		pDlg.setLabelText(QObject::tr("Cloth deformation\n%1 x %2 particles").arg(cloth.num_particles_width).arg(cloth.num_particles_height));
-		pDlg.setRange(0, params.iterations);
-		pDlg.show();
-		QCoreApplication::processEvents();
+	if (exportClothMesh)
+	{
+		clothMesh = cloth.toMesh();
+	}
+
+	return result;
+}
+
+bool CSF::do_tiled_filtering(	std::vector<unsigned>& groundIndexes,
+								std::vector<unsigned>& offGroundIndexes,
+								const wl::Point& bbMin,
+								const wl::Point& bbMax,
+								ccMainAppInterface* app,
+								QProgressDialog& pDlg)
+{
+	assert(params.tile_size > 0);
+
+	QElapsedTimer timer;
+	timer.start();
+
+	const double tileSize = params.tile_size;
+	const double overlap = (params.tile_overlap < 0 ? tileSize / 10 : params.tile_overlap);
+	const double tileCountXd = std::max(1.0, ceil((bbMax.x - bbMin.x) / tileSize));
+	const double tileCountZd = std::max(1.0, ceil((bbMax.z - bbMin.z) / tileSize));
+	if (tileCountXd * tileCountZd > (1 << 24))
+	{
+		ccLog::Error("[CSF] Tile size is too small!");
+		return false;
+	}
+	const int tileCountX = static_cast<int>(tileCountXd);
+	const int tileCountZ = static_cast<int>(tileCountZd);
+	const size_t tileCount = static_cast<size_t>(tileCountX) * tileCountZ;
+	const size_t pointCount = point_cloud.size();
+
+	//index of the tile whose core contains a given point
+	auto coreTileIndex = [&](const wl::Point& P)
+	{
+		int i = std::min(tileCountX - 1, static_cast<int>((P.x - bbMin.x) / tileSize));
+		int j = std::min(tileCountZ - 1, static_cast<int>((P.z - bbMin.z) / tileSize));
+		return static_cast<size_t>(j) * tileCountX + i;
+	};
 
-		bool wasCancelled = false;
-		cloth.addForce(Vec3(0, -gravity, 0) * time_step2);
-		for (int i = 0; i < params.iterations; i++)
+	//sort the points by (core) tile, so that each tile (and its neighbors) can be extracted
+	//without going through the whole cloud each time (counting sort)
+	std::vector<unsigned> tileStart(tileCount + 1, 0);
+	std::vector<unsigned> sortedIndexes(pointCount);
+	for (size_t n = 0; n < pointCount; ++n)
+	{
+		++tileStart[coreTileIndex(point_cloud[n]) + 1];
+	}
+	for (size_t t = 0; t < tileCount; ++t)
+	{
+		tileStart[t + 1] += tileStart[t];
+	}
+	{
+		std::vector<unsigned> tileFill(tileStart.begin(), tileStart.end() - 1);
+		for (size_t n = 0; n < pointCount; ++n)
 		{
-			//cloth.addForce(Vec3(0, -gravity, 0) * time_step2); //move this outside the main loop
-			double maxDiff = cloth.timeStep();
-			cloth.terrainCollision();
+			sortedIndexes[tileFill[coreTileIndex(point_cloud[n])]++] = static_cast<unsigned>(n);
+		}
+	}
+
+	//number of neighboring tiles (in each direction) that may intersect the overlap
+	const int neighborRange = static_cast<int>(ceil(overlap / tileSize));
 
-			//if (app && (i % 50) == 0)
-			//{
-			//	app->dispToConsole(QString("[CSF] Iteration %1: max delta = %2").arg(i+1).arg(maxDiff));
-			//}
+	//each point gets the label computed by its own (core) tile
+	std::vector<unsigned char> isGround(pointCount, 0);
 
-			if (maxDiff != 0 && maxDiff < 0.005)
+	wl::PointCloud tileCloud;
+	std::vector<unsigned> tileIndexes;
+	std::vector<unsigned> tileGroundIndexes;
+	std::vector<unsigned> tileOffGroundIndexes;
+	size_t processedTileCount = 0;
+
+	for (int j = 0; j < tileCountZ; ++j)
+	{
+		for (int i = 0; i < tileCountX; ++i)
+		{
+			const size_t tileIndex = static_cast<size_t>(j) * tileCountX + i;
+			const unsigned coreCount = tileStart[tileIndex + 1] - tileStart[tileIndex];
+			if (coreCount == 0)
 			{
-				//early stop
-				break;
+				//empty tile
+				continue;
 			}
 
-			pDlg.setValue(i);
-			QCoreApplication::processEvents();
+			//extended tile bounding-box (core + overlap)
+			const double minX = bbMin.x + i * tileSize - overlap;
+			const double maxX = bbMin.x + (i + 1) * tileSize + overlap;
+			const double minZ = bbMin.z + j * tileSize - overlap;
+			const double maxZ = bbMin.z + (j + 1) * tileSize + overlap;
 
-			if (pDlg.wasCanceled())
+			//the core points come first
+			tileCloud.clear();
+			tileIndexes.clear();
+			tileIndexes.insert(tileIndexes.end(), sortedIndexes.begin() + tileStart[tileIndex], sortedIndexes.begin() + tileStart[tileIndex + 1]);
+
+			//then the points of the neighboring tiles that lie in the overlap
+			for (int nj = std::max(0, j - neighborRange); nj <= std::min(tileCountZ - 1, j + neighborRange); ++nj)
 			{
-				wasCancelled = true;
-				break;
+				for (int ni = std::max(0, i - neighborRange); ni <= std::min(tileCountX - 1, i + neighborRange); ++ni)
+				{
+					const size_t neighborIndex = static_cast<size_t>(nj) * tileCountX + ni;
+					if (neighborIndex == tileIndex)
+					{
+						continue;
+					}
+					for (unsigned k = tileStart[neighborIndex]; k < tileStart[neighborIndex + 1]; ++k)
+					{
+						const wl::Point& P = point_cloud[sortedIndexes[k]];
+						if (P.x >= minX && P.x <= maxX && P.z >= minZ && P.z <= maxZ)
+						{
+							tileIndexes.push_back(sortedIndexes[k]);
+						}
+					}
+				}
 			}
-		}
-		
-		pDlg.close();
-		QCoreApplication::processEvents();
-
-		if (app)
-		{
-			app->dispToConsole(QString("[CSF] Iterations: %1 ms").arg(timer.restart()));
-		}
 
-		if (wasCancelled)
-		{
-			return false;
-		}
+			tileCloud.reserve(tileIndexes.size());
+			for (unsigned index : tileIndexes)
+			{
+				tileCloud.push_back(point_cloud[index]);
+			}
 
-		//slope processing
-		if (params.bSloopSmooth)
-		{
-			cloth.movableFilter();
+			++processedTileCount;
+			tileGroundIndexes.clear();
+			tileOffGroundIndexes.clear();
+			ccMesh* noMesh = nullptr;
+			QString stepInfo = QObject::tr("Tile %1 / %2 (%3 points)").arg(tileIndex + 1).arg(tileCount).arg(tileIndexes.size());
+			if (!filterCloud(tileCloud, tileGroundIndexes, tileOffGroundIndexes, false, noMesh, nullptr, pDlg, stepInfo, &bbMin, &bbMax))
+			{
+				return false;
+			}
 
-			if (app)
+			//only the labels of the core points are kept
+			for (unsigned localIndex : tileGroundIndexes)
 			{
-				app->dispToConsole(QString("[CSF] Movable filter: %1 ms").arg(timer.restart()));
+				if (localIndex < coreCount)
+				{
+					isGround[tileIndexes[localIndex]] = 1;
+				}
 			}
 		}
-	
-		//classification of the points
-		bool result = Cloud2CloudDist::Compute(cloth, point_cloud, params.class_threshold, groundIndexes, offGroundIndexes);
-		if (app)
+	}
+
+	pDlg.close();
+	QCoreApplication::processEvents();
+
+	//release the memory before building the output
+	tileCloud = wl::PointCloud();
+	tileIndexes = std::vector<unsigned>();
+	sortedIndexes = std::vector<unsigned>();
+
+	size_t groundCount = std::count(isGround.begin(), isGround.end(), 1);
+	groundIndexes.reserve(groundCount);
+	offGroundIndexes.reserve(pointCount - groundCount);
+	for (size_t n = 0; n < pointCount; ++n)
+	{
+		if (isGround[n])
 		{
-			app->dispToConsole(QString("[CSF] Distance computation: %1 ms").arg(timer.restart()));
+			groundIndexes.push_back(static_cast<unsigned>(n));
 		}
-
-		if (exportClothMesh)
+		else
 		{
-			clothMesh = cloth.toMesh();
+			offGroundIndexes.push_back(static_cast<unsigned>(n));
 		}
-
-		return result;
 	}
-	catch (const std::bad_alloc&)
+
+	if (app)
 	{
-		//not enough memory
-		return false;
+		app->dispToConsole(QString("[CSF] %1 tiles processed (grid: %2 x %3, size: %4, overlap: %5) in %6 s.").arg(processedTileCount).arg(tileCountX).arg(tileCountZ).arg(tileSize).arg(overlap).arg(timer.elapsed() / 1000.0, 0, 'f', 1));
 	}
+
+	return true;
 }
 
 void CSF::saveGroundPoints(const std::vector<int>& grp, std::string path)
@@ -33,14 +33,35 @@
 #include <ccPointCloud.h>
 
 //system
+#include <algorithm>
+#include <atomic>
 #include <assert.h>
 #include <cmath>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
+#include <new>
 #include <sstream>
 #include <queue>
 
+//we precompute the overall displacement of a particle accroding to the rigidness
+//const double singleMove1[15] = {0, 0.4, 0.64, 0.784, 0.8704, 0.92224, 0.95334, 0.97201, 0.9832, 0.98992, 0.99395, 0.99637, 0.99782, 0.99869, 0.99922 };
+static const double singleMove1[15] = { 0, 0.3, 0.51, 0.657, 0.7599, 0.83193, 0.88235, 0.91765, 0.94235, 0.95965, 0.97175, 0.98023, 0.98616, 0.99031, 0.99322 };
+//ƶʱ
+//const double doubleMove1[15] = {0, 0.4, 0.48, 0.496, 0.4992, 0.49984, 0.49997, 0.49999, 0.5, 0.5, 0.5, 0.5, 0.5, 0.5, 0.5 };
+static const double doubleMove1[15] = { 0, 0.3, 0.42, 0.468, 0.4872, 0.4949, 0.498, 0.4992, 0.4997, 0.4999, 0.4999, 0.5, 0.5, 0.5, 0.5 };
+
+//Number of rows of particles per band (see Cloth::satisfyConstraints)
+//A particle modifies its neighbors up to 2 rows away: the bands must be at least 4 rows high
+static const int ROWS_PER_BAND = 8;
+
+//Immediate neighbors (distance 1 and sqrt(2) in the grid) then secondary neighbors (distance 2 and 2*sqrt(2))
+//(same order as the former per-particle neighbors lists)
+const int Cloth::NeighborOffsets[Cloth::NEIGHBOR_COUNT][2] = {	{ -1, -1 }, { -1, 0 }, { -1, 1 }, { 0, -1 },
+																{  1, -1 }, {  1, 0 }, {  0, 1 }, { 1,  1 },
+																{ -2, -2 }, { -2, 0 }, { -2, 2 }, { 0, -2 },
+																{  2, -2 }, {  2, 0 }, {  0, 2 }, { 2,  2 } };
+
 Cloth::Cloth(	const Vec3& _origin_pos,
 				int _num_particles_width,
 				int _num_particles_height,
@@ -50,8 +71,10 @@ Cloth::Cloth(	const Vec3& _origin_pos,
 				double _heightThreshold,
 				int rigidness,
 				double time_step)
-	: constraint_iterations(rigidness)
-	, time_step(time_step)
+	: time_step2(time_step * time_step)
+	, singleMove(rigidness > 14 ? 1.0 : singleMove1[std::max(rigidness, 0)])
+	, doubleMove(rigidness > 14 ? 0.5 : doubleMove1[std::max(rigidness, 0)])
+	, acceleration_y(0)
 	, smoothThreshold(_smoothThreshold)
 	, heightThreshold(_heightThreshold)
 	, num_particles_width(_num_particles_width)
@@ -60,72 +83,10 @@ Cloth::Cloth(	const Vec3& _origin_pos,
 	, step_x(_step_x)
 	, step_y(_step_y)
 {
-	particles.resize(num_particles_width*num_particles_height); //I am essentially using this vector as an array with room for num_particles_width*num_particles_height particles
-
-	double time_step2 = time_step*time_step;
-
-	// creating particles in a grid
-	for (int i = 0; i < num_particles_width; i++)
-	{
-		for (int j = 0; j < num_particles_height; j++)
-		{
-			Vec3 pos(	origin_pos.x + i * step_x,
-						origin_pos.y,
-						origin_pos.z + j * step_y);
-
-			particles[j*num_particles_width + i] = Particle(pos, time_step2); // insert particle in column i at j'th row
-			particles[j*num_particles_width + i].pos_x = i;
-			particles[j*num_particles_width + i].pos_y = j;
-		}
-	}
-
-	// Connecting immediate neighbor particles with constraints (distance 1 and sqrt(2) in the grid)
-	for (int x = 0; x<num_particles_width; x++)
-	{
-		for (int y = 0; y<num_particles_height; y++)
-		{
-			if (x < num_particles_width - 1)
-			{
-				addConstraint(&getParticle(x, y), &getParticle(x + 1, y));
-			}
-
-			if (y < num_particles_height - 1)
-			{
-				addConstraint(&getParticle(x, y), &getParticle(x, y + 1));
-			}
-
-			if (x < num_particles_width - 1 && y < num_particles_height - 1)
-			{
-				addConstraint(&getParticle(x, y), &getParticle(x + 1, y + 1));
-				addConstraint(&getParticle(x + 1, y), &getParticle(x, y + 1));
-			}
-		}
-	}
-
-	// Connecting secondary neighbors with constraints (distance 2 and sqrt(4) in the grid)
-	for (int x = 0; x < num_particles_width; x++)
-	{
-		for (int y = 0; y < num_particles_height; y++)
-		{
-			if (x < num_particles_width - 2)
-			{
-				addConstraint(&getParticle(x, y), &getParticle(x + 2, y));
-			}
-
-
-			if (y < num_particles_height - 2)
-			{
-				addConstraint(&getParticle(x, y), &getParticle(x, y + 2));
-			}
-
-
-			if (x < num_particles_width - 2 && y < num_particles_height - 2)
-			{
-				addConstraint(&getParticle(x, y), &getParticle(x + 2, y + 2));
-				addConstraint(&getParticle(x + 2, y), &getParticle(x, y + 2));
-			}
-		}
-	}
+	//all the particles start at the same height (the X and Z coordinates are implicit)
+	pos_y.resize(getSize(), origin_pos.y);
+	old_pos_y.resize(getSize(), origin_pos.y);
+	movable.resize(getSize(), 1);
 }
 
 ccMesh* Cloth::toMesh() const
@@ -148,10 +109,10 @@ ccMesh* Cloth::toMesh() const
 	//copy the vertices (particles)
 	for (int i = 0; i < getSize(); ++i)
 	{
-		const Particle& particle = particles[i];
-		vertices->addPoint(CCVector3(	static_cast<PointCoordinateType>(particle.pos.x),
-										static_cast<PointCoordinateType>(particle.pos.z),
-										static_cast<PointCoordinateType>(-particle.pos.y)));
+		Vec3 pos = getParticlePos(i);
+		vertices->addPoint(CCVector3(	static_cast<PointCoordinateType>(pos.x),
+										static_cast<PointCoordinateType>(pos.z),
+										static_cast<PointCoordinateType>(-pos.y)));
 	}
 
 	//and create the triangles
@@ -174,46 +135,114 @@ ccMesh* Cloth::toMesh() const
 	return mesh;
 }
 
+void Cloth::satisfyConstraints(int x, int y)
+{
+	const int i1 = getIndex(x, y);
+	for (const int* offset : NeighborOffsets)
+	{
+		const int nx = x + offset[0];
+		const int ny = y + offset[1];
+		if (nx < 0 || ny < 0 || nx >= num_particles_width || ny >= num_particles_height)
+		{
+			continue;
+		}
+		const int i2 = getIndex(nx, ny);
+
+		double correction = pos_y[i2] - pos_y[i1];
+		if (movable[i1])
+		{
+			if (movable[i2])
+			{
+				// we move BOTH particles (half of the correction each, depending on the rigidness)
+				pos_y[i1] += correction * doubleMove;
+				pos_y[i2] -= correction * doubleMove;
+			}
+			else
+			{
+				pos_y[i1] += correction * singleMove;
+			}
+		}
+		else if (movable[i2])
+		{
+			pos_y[i2] -= correction * singleMove;
+		}
+	}
+}
+
+void Cloth::satisfyConstraints()
+{
+	//a particle modifies its neighbors up to 2 rows away: the even bands are processed
+	//first (in parallel), then the odd ones, so that two bands processed at the same time
+	//never modify the same particles (and the result doesn't depend on the thread count)
+	const int bandCount = (num_particles_height + ROWS_PER_BAND - 1) / ROWS_PER_BAND;
+	for (int parity = 0; parity < 2; ++parity)
+	{
+#pragma omp parallel for schedule(dynamic)
+		for (int b = parity; b < bandCount; b += 2)
+		{
+			const int yStart = b * ROWS_PER_BAND;
+			const int yStop = std::min(num_particles_height, yStart + ROWS_PER_BAND);
+			for (int y = yStart; y < yStop; ++y)
+			{
+				for (int x = 0; x < num_particles_width; ++x)
+				{
+					satisfyConstraints(x, y);
+				}
+			}
+		}
+	}
+}
+
 double Cloth::timeStep()
 {
-	int particleCount = static_cast<int>(particles.size());
+	const int particleCount = getSize();
 
+	/* This is one of the important methods, where the time is progressed a single step size
+	Given the equation "force = mass * acceleration" the next position is found through verlet integration*/
+	const double acceleration = acceleration_y * time_step2;
 #pragma omp parallel for
 	for (int i = 0; i < particleCount; i++)
 	{
-		particles[i].timeStep();
+		if (movable[i])
+		{
+			double temp = pos_y[i];
+			pos_y[i] = pos_y[i] + (pos_y[i] - old_pos_y[i]) * (1.0 - DAMPING) + acceleration;
+			old_pos_y[i] = temp;
+		}
 	}
+
 /*
 Instead of interating over all the constraints several times, we 
 compute the overall displacement of a particle accroding to the rigidness
 */
+	satisfyConstraints();
 
+	//the max. displacement is computed per band of rows, then the bands are merged
+	//(no concurrent access, see https://github.com/CloudCompare/CloudCompare/issues/909)
+	const int bandCount = (num_particles_height + ROWS_PER_BAND - 1) / ROWS_PER_BAND;
+	std::vector<double> bandMaxDiff(bandCount, 0.0);
 #pragma omp parallel for
-	for (int j = 0; j < particleCount; j++)
+	for (int b = 0; b < bandCount; ++b)
 	{
-		particles[j].satisfyConstraintSelf(constraint_iterations);
+		const int start = b * ROWS_PER_BAND * num_particles_width;
+		const int stop = std::min(particleCount, start + ROWS_PER_BAND * num_particles_width);
+		double maxDiff = 0;
+		for (int i = start; i < stop; ++i)
+		{
+			if (movable[i])
+			{
+				double diff = std::abs(old_pos_y[i] - pos_y[i]);
+				if (diff > maxDiff)
+					maxDiff = diff;
+			}
+		}
+		bandMaxDiff[b] = maxDiff;
 	}
 
-
-//	for (int i = 0; i<constraint_iterations; i++) // iterate over all constraints several times
-//	{
-//#pragma omp parallel for
-//		for (int j = 0; j < constraints.size(); j++)
-//		{
-//			constraints[j].satisfyConstraint();
-//		}
-//	}
-
 	double maxDiff = 0;
-//#pragma omp parallel for //see https://github.com/CloudCompare/CloudCompare/issues/909
-	for (int i = 0; i < particleCount; i++)
+	for (double diff : bandMaxDiff)
 	{
-		if (particles[i].isMovable())
-		{
-			double diff = std::abs(particles[i].old_pos.y - particles[i].pos.y);
-			if (diff > maxDiff)
-				maxDiff = diff;
-		}
+		maxDiff = std::max(maxDiff, diff);
 	}
 
 	return maxDiff;
@@ -221,234 +250,144 @@ compute the overall displacement of a particle accroding to the rigidness
 
 void Cloth::addForce(const Vec3& direction)
 {
-	int particleCount = static_cast<int>(particles.size());
-
-	// add the forces to each particle
-#pragma omp parallel for
-	for (int i = 0; i < particleCount; i++)
-	{
-		particles[i].addForce(direction);
-	}
+	// the particles only move vertically
+	acceleration_y += direction.y;
 }
 
 //testing the collision
 void Cloth::terrainCollision()
 {
-	assert(particles.size() == heightvals.size());
+	assert(pos_y.size() == heightvals.size());
 
-	int particleCount = static_cast<int>(particles.size());
+	const int particleCount = getSize();
 #pragma omp parallel for
 	for (int i = 0; i < particleCount; i++)
 	{
-		Particle& particle = particles[i];
-		if (particle.pos.y < heightvals[i]) // if the particle is inside the ball
+		if (pos_y[i] < heightvals[i]) // if the particle is inside the ball
 		{
-			particle.offsetPos(Vec3(0, heightvals[i] - particle.pos.y, 0));
-			particle.makeUnmovable();
+			if (movable[i])
+			{
+				pos_y[i] = heightvals[i];
+			}
+			movable[i] = 0;
 		}
 	}
 }
 
 void Cloth::movableFilter()
 {
+	const int particleCount = getSize();
+
+	//we first extract the groups of connected movable particles (4-connectivity)
+	std::vector<int> components(particleCount, -1); //component index of each movable particle
+	std::vector<int> memberIndexes(particleCount, 0); //index of each movable particle in its component
+	std::vector<int> members; //the particles of each component (stored contiguously, in BFS order)
+	std::vector<int> componentStarts;
+	members.reserve(particleCount);
+
 	for (int x = 0; x < num_particles_width; x++)
 	{
 		for (int y = 0; y < num_particles_height; y++)
 		{
-			Particle& ptc = getParticle(x, y);
-			if (ptc.isMovable() && !ptc.isVisited)
+			int index = getIndex(x, y);
+			if (!movable[index] || components[index] >= 0)
 			{
-				std::queue<int> que;
-				std::vector<XY> connected; //store the connected component
-				std::vector< std::vector<int> > neibors;
-				int sum = 1;
-				int index = y*num_particles_width + x;
-				// visit the init node
-				connected.push_back(XY(x,y));
-				particles[index].isVisited = true;
-				//enqueue the init node
-				que.push(index);
-				while (!que.empty())
-				{
-					Particle& ptc_f = particles[que.front()];
-					que.pop();
-					int cur_x = ptc_f.pos_x;
-					int cur_y = ptc_f.pos_y;
-					std::vector<int> neighbor;
+				continue;
+			}
 
-					if (cur_x > 0)
-					{
-						Particle& ptc_left = getParticle(cur_x - 1, cur_y);
-						if (ptc_left.isMovable())
-						{
-							if (!ptc_left.isVisited)
-							{
-								sum++;
-								ptc_left.isVisited = true;
-								connected.push_back(XY(cur_x - 1, cur_y));
-								que.push(num_particles_width*cur_y + cur_x - 1);
-								neighbor.push_back(sum - 1);
-								ptc_left.c_pos = sum - 1;
-							}
-							else
-							{
-								neighbor.push_back(ptc_left.c_pos);
-							}
-						}
-					}
+			const int component = static_cast<int>(componentStarts.size());
+			const int start = static_cast<int>(members.size());
+			componentStarts.push_back(start);
 
-					if (cur_x < num_particles_width - 1)
-					{
-						Particle& ptc_right = getParticle(cur_x + 1, cur_y);
-						if (ptc_right.isMovable())
-						{
-							if (!ptc_right.isVisited)
-							{
-								sum++;
-								ptc_right.isVisited = true;
-								connected.push_back(XY(cur_x + 1, cur_y));
-								que.push(num_particles_width*cur_y + cur_x + 1);
-								neighbor.push_back(sum - 1);
-								ptc_right.c_pos = sum - 1;
-							}
-							else
-							{
-								neighbor.push_back(ptc_right.c_pos);
-							}
-						}
-					}
+			// visit the init node
+			components[index] = component;
+			memberIndexes[index] = 0;
+			members.push_back(index);
 
-					if (cur_y > 0)
-					{
-						Particle& ptc_bottom = getParticle(cur_x, cur_y - 1);
-						if (ptc_bottom.isMovable())
-						{
-							if (!ptc_bottom.isVisited)
-							{
-								sum++;
-								ptc_bottom.isVisited = true;
-								connected.push_back(XY(cur_x, cur_y - 1));
-								que.push(num_particles_width*(cur_y - 1) + cur_x);
-								neighbor.push_back(sum - 1);
-								ptc_bottom.c_pos = sum - 1;
-							}
-							else
-							{
-								neighbor.push_back(ptc_bottom.c_pos);
-							}
-						}
-					}
+			//the members list is used as a queue
+			for (size_t head = start; head < members.size(); ++head)
+			{
+				const int current = members[head];
+				const int cur_x = current % num_particles_width;
+				const int cur_y = current / num_particles_width;
 
-					if (cur_y < num_particles_height - 1)
-					{
-						Particle& ptc_top = getParticle(cur_x, cur_y + 1);
-						if (ptc_top.isMovable())
-						{
-							if (!ptc_top.isVisited)
-							{
-								sum++;
-								ptc_top.isVisited = true;
-								connected.push_back(XY(cur_x, cur_y + 1));
-								que.push(num_particles_width*(cur_y + 1) + cur_x);
-								neighbor.push_back(sum - 1);
-								ptc_top.c_pos = sum - 1;
-							}
-							else
-							{
-								neighbor.push_back(ptc_top.c_pos);
-							}
-						}
-					}
-					neibors.push_back(neighbor);
-				}
+				//left, right, bottom and top neighbors
+				const int neighbors[4] = {	cur_x > 0 ? current - 1 : -1,
+											cur_x < num_particles_width - 1 ? current + 1 : -1,
+											cur_y > 0 ? current - num_particles_width : -1,
+											cur_y < num_particles_height - 1 ? current + num_particles_width : -1 };
 
-				//Slope postprocessing
-				if (sum > 100)
+				for (int neighbor : neighbors)
 				{
-					std::vector<int> edgePoints;
-					findUnmovablePoint(connected, heightvals, edgePoints);
-					handle_slop_connected(edgePoints, connected, neibors, heightvals);
+					if (neighbor >= 0 && movable[neighbor] && components[neighbor] < 0)
+					{
+						components[neighbor] = component;
+						memberIndexes[neighbor] = static_cast<int>(members.size()) - start;
+						members.push_back(neighbor);
+					}
 				}
 			}
 		}
 	}
-}
-
-void Cloth::findUnmovablePoint(	const std::vector<XY>& connected,
-								const std::vector<double>& heightvals,
-								std::vector<int>& edgePoints)
-{
-	for (size_t i = 0; i < connected.size(); i++)
+	componentStarts.push_back(static_cast<int>(members.size()));
+
+	//Slope postprocessing
+	//(the components are independent: a component only modifies its own particles, and
+	//the other particles it looks at are unmovable from the start)
+	const int componentCount = static_cast<int>(componentStarts.size()) - 1;
+	std::atomic<bool> notEnoughMemory(false);
+#pragma omp parallel for schedule(dynamic)
+	for (int c = 0; c < componentCount; ++c)
 	{
-		int x = connected[i].x;
-		int y = connected[i].y;
-		int index = y*num_particles_width + x;
-		Particle& ptc = getParticle(x, y);
-		if (x > 0)
+		const int start = componentStarts[c];
+		const int count = componentStarts[c + 1] - start;
+		if (count > 100)
 		{
-			const Particle& ptc_x = getParticle(x - 1, y);
-			if (!ptc_x.isMovable())
+			try
 			{
-				int index_ref = y*num_particles_width + x - 1;
-				if (std::abs(heightvals[index] - heightvals[index_ref]) < smoothThreshold && ptc.pos.y - heightvals[index] < heightThreshold)
-				{
-					Vec3 offsetVec(0, heightvals[index] - ptc.pos.y, 0);
-					particles[index].offsetPos(offsetVec);
-					ptc.makeUnmovable();
-					edgePoints.push_back(static_cast<int>(i));
-					continue;
-				}
+				std::vector<int> edgePoints;
+				findUnmovablePoint(members.data() + start, count, edgePoints);
+				handle_slop_connected(edgePoints, members.data() + start, count, c, components, memberIndexes);
 			}
-		}
-
-		if (x < num_particles_width - 1)
-		{
-			const Particle& ptc_x = getParticle(x + 1, y);
-			if (!ptc_x.isMovable())
+			catch (const std::bad_alloc&)
 			{
-				int index_ref = y*num_particles_width + x + 1;
-				if (std::abs(heightvals[index] - heightvals[index_ref]) < smoothThreshold && ptc.pos.y - heightvals[index] < heightThreshold)
-				{
-					Vec3 offsetVec(0, heightvals[index] - ptc.pos.y, 0);
-					particles[index].offsetPos(offsetVec);
-					ptc.makeUnmovable();
-					edgePoints.push_back(static_cast<int>(i));
-					continue;
-				}
+				notEnoughMemory = true;
 			}
 		}
+	}
 
-		if (y > 0)
-		{
-			const Particle& ptc_y = getParticle(x, y - 1);
-			if (!ptc_y.isMovable())
-			{
-				int index_ref = (y - 1)*num_particles_width + x;
-				if (std::abs(heightvals[index] - heightvals[index_ref]) < smoothThreshold && ptc.pos.y - heightvals[index] < heightThreshold)
-				{
-					Vec3 offsetVec(0, heightvals[index] - ptc.pos.y, 0);
-					particles[index].offsetPos(offsetVec);
-					ptc.makeUnmovable();
-					edgePoints.push_back(static_cast<int>(i));
-					continue;
-				}
-			}
+	if (notEnoughMemory)
+	{
+		throw std::bad_alloc();
+	}
+}
 
-		}
+void Cloth::findUnmovablePoint(	const int* connected,
+								int connectedCount,
+								std::vector<int>& edgePoints)
+{
+	for (int i = 0; i < connectedCount; i++)
+	{
+		const int index = connected[i];
+		const int x = index % num_particles_width;
+		const int y = index / num_particles_width;
+
+		//left, right, bottom and top neighbors
+		const int neighbors[4] = {	x > 0 ? index - 1 : -1,
+									x < num_particles_width - 1 ? index + 1 : -1,
+									y > 0 ? index - num_particles_width : -1,
+									y < num_particles_height - 1 ? index + num_particles_width : -1 };
 
-		if (y < num_particles_height - 1)
+		for (int index_ref : neighbors)
 		{
-			const Particle& ptc_y = getParticle(x, y + 1);
-			if (!ptc_y.isMovable())
+			if (index_ref >= 0 && !movable[index_ref])
 			{
-				int index_ref = (y + 1)*num_particles_width + x;
-				if (std::abs(heightvals[index] - heightvals[index_ref]) < smoothThreshold && ptc.pos.y - heightvals[index] < heightThreshold)
+				if (std::abs(heightvals[index] - heightvals[index_ref]) < smoothThreshold && pos_y[index] - heightvals[index] < heightThreshold)
 				{
-					Vec3 offsetVec(0, heightvals[index] - ptc.pos.y, 0);
-					particles[index].offsetPos(offsetVec);
-					ptc.makeUnmovable();
-					edgePoints.push_back(static_cast<int>(i));
-					continue;
+					pos_y[index] = heightvals[index];
+					movable[index] = 0;
+					edgePoints.push_back(i);
+					break;
 				}
 			}
 		}
@@ -457,11 +396,13 @@ void Cloth::findUnmovablePoint(	const std::vector<XY>& connected,
 
 //implementing postprocessing to every group of movable points
 void Cloth::handle_slop_connected(	const std::vector<int>& edgePoints,
-									const std::vector<XY>& connected,
-									const std::vector< std::vector<int> >& neibors,
-									const std::vector<double>& heightvals)
+									const int* connected,
+									int connectedCount,
+									int component,
+									const std::vector<int>& components,
+									const std::vector<int>& memberIndexes)
 {
-	std::vector<bool> visited(connected.size(), false);
+	std::vector<bool> visited(connectedCount, false);
 
 	std::queue<int> que;
 	for (size_t i = 0; i < edgePoints.size(); i++)
@@ -475,19 +416,37 @@ void Cloth::handle_slop_connected(	const std::vector<int>& edgePoints,
 		int index = que.front();
 		que.pop();
 		//ÅÐ¶ÏÖÜ±ßµãÊÇ·ñÐèÒª´¦Àí
-		int index_center = connected[index].y*num_particles_width + connected[index].x;
-		for (size_t i = 0; i < neibors[index].size(); i++)
+		const int index_center = connected[index];
+		const int x = index_center % num_particles_width;
+		const int y = index_center / num_particles_width;
+
+		//left, right, bottom and top neighbors
+		const int neighbors[4] = {	x > 0 ? index_center - 1 : -1,
+									x < num_particles_width - 1 ? index_center + 1 : -1,
+									y > 0 ? index_center - num_particles_width : -1,
+									y < num_particles_height - 1 ? index_center + num_particles_width : -1 };
+
+		for (int index_neibor : neighbors)
 		{
-			int index_neibor = connected[neibors[index][i]].y*num_particles_width + connected[neibors[index][i]].x;
-			if (std::abs(heightvals[index_center] - heightvals[index_neibor]) < smoothThreshold && std::abs(particles[index_neibor].pos.y - heightvals[index_neibor]) < heightThreshold)
+			if (index_neibor < 0 || components[index_neibor] != component)
 			{
-				Vec3 offsetVec(0, heightvals[index_neibor] - particles[index_neibor].pos.y, 0);
-				particles[index_neibor].offsetPos(offsetVec);
-				particles[index_neibor].makeUnmovable();
-				if (visited[neibors[index][i]] == false)
+				//not in the same group of (originally) movable particles
+				continue;
+			}
+
+			if (std::abs(heightvals[index_center] - heightvals[index_neibor]) < smoothThreshold && std::abs(pos_y[index_neibor] - heightvals[index_neibor]) < heightThreshold)
+			{
+				if (movable[index_neibor])
+				{
+					pos_y[index_neibor] = heightvals[index_neibor];
+				}
+				movable[index_neibor] = 0;
+
+				int member = memberIndexes[index_neibor];
+				if (visited[member] == false)
 				{
-					que.push(neibors[index][i]);
-					visited[neibors[index][i]] = true;
+					que.push(member);
+					visited[member] = true;
 				}
 			}
 		}
@@ -508,10 +467,10 @@ void Cloth::saveToFile(std::string path)
 	std::ofstream f1(filepath);
 	if (!f1)
 		return;
-	for (size_t i = 0; i < particles.size(); i++)
+	for (int i = 0; i < getSize(); i++)
 	{
-		//if (!particles[i].isMovable())
-		f1 << std::fixed << std::setprecision(8) << particles[i].pos.x << "	" << particles[i].pos.z << "	" << -particles[i].pos.y << std::endl;
+		Vec3 pos = getParticlePos(i);
+		f1 << std::fixed << std::setprecision(8) << pos.x << "	" << pos.z << "	" << -pos.y << std::endl;
 	}
 	f1.close();
 }
@@ -530,10 +489,13 @@ void Cloth::saveMovableToFile(std::string path)
 	std::ofstream f1(filepath);
 	if (!f1)
 		return;
-	for (size_t i = 0; i < particles.size(); i++)
+	for (int i = 0; i < getSize(); i++)
 	{
-		if (particles[i].isMovable())
-			f1 << std::fixed << std::setprecision(8) << particles[i].pos.x << "	" << particles[i].pos.z << "	" << -particles[i].pos.y << std::endl;
+		if (movable[i])
+		{
+			Vec3 pos = getParticlePos(i);
+			f1 << std::fixed << std::setprecision(8) << pos.x << "	" << pos.z << "	" << -pos.y << std::endl;
+		}
 	}
 	f1.close();
 }
@@ -74,10 +74,10 @@ bool Cloud2CloudDist::Compute(	const Cloth& cloth,
 			//cout << subdeltaX << " " << subdeltaZ << endl;
 			//˫Բֵ bilinear interpolation;
 			//f(x,y)=f(0,0)(1-x)(1-y)+f(0,1)(1-x)y+f(1,1)xy+f(1,0)x(1-y)
-			double fxy = cloth.getParticle(col0, row0).pos.y * (1 - subdeltaX)*(1 - subdeltaZ)
-				+ cloth.getParticle(col3, row3).pos.y * (1 - subdeltaX)*subdeltaZ
-				+ cloth.getParticle(col2, row2).pos.y * subdeltaX*subdeltaZ
-				+ cloth.getParticle(col1, row1).pos.y * subdeltaX*(1 - subdeltaZ);
+			double fxy = cloth.getParticleHeight(col0, row0) * (1 - subdeltaX)*(1 - subdeltaZ)
+				+ cloth.getParticleHeight(col3, row3) * (1 - subdeltaX)*subdeltaZ
+				+ cloth.getParticleHeight(col2, row2) * subdeltaX*subdeltaZ
+				+ cloth.getParticleHeight(col1, row1) * subdeltaX*(1 - subdeltaZ);
 			double height_var = fxy - pc[i].y;
 			if (std::abs(height_var) < class_threshold)
 			{
@@ -27,107 +27,112 @@
 //#######################################################################################
 
 #include "Rasterization.h"
+
+//system
+#include <atomic>
+#include <cstdint>
+#include <cstring>
 #include <iostream>
+#include <limits>
 #include <queue>
+#include <unordered_set>
 
 using namespace std;
 
 //Since all the particles in cloth are formed as a regular grid, 
 //for each lidar point, its nearest Cloth point can be simply found by Rounding operation
-//then record all the correspoinding lidar point for each cloth particle
 
 #if 1
 
-double Rasterization::findHeightValByScanline(Particle *p, Cloth &cloth)
+double Rasterization::findHeightValByScanline(int xpos, int ypos, const Cloth& cloth, const std::vector<double>& nearestHeights)
 {
-	int xpos = p->pos_x;
-	int ypos = p->pos_y;
 	//ɨ
 	for (int i = xpos + 1; i < cloth.num_particles_width; i++)
 	{
-		double crresHeight = cloth.getParticle(i, ypos).nearestPointHeight;
+		double crresHeight = nearestHeights[cloth.getIndex(i, ypos)];
 		if (crresHeight > MIN_INF)
 			return crresHeight;
 	}
 	//ɨ
 	for (int i = xpos - 1; i >= 0; i--)
 	{
-		double crresHeight = cloth.getParticle(i, ypos).nearestPointHeight;
+		double crresHeight = nearestHeights[cloth.getIndex(i, ypos)];
 		if (crresHeight > MIN_INF)
 			return crresHeight;
 	}
 	//ɨ
 	for (int j = ypos - 1; j >= 0; j--)
 	{
-		double crresHeight = cloth.getParticle(xpos, j).nearestPointHeight;
+		double crresHeight = nearestHeights[cloth.getIndex(xpos, j)];
 		if (crresHeight > MIN_INF)
 			return crresHeight;
 	}
 	//ɨ
 	for (int j = ypos + 1; j < cloth.num_particles_height; j++)
 	{
-		double crresHeight = cloth.getParticle(xpos, j).nearestPointHeight;
+		double crresHeight = nearestHeights[cloth.getIndex(xpos, j)];
 		if (crresHeight > MIN_INF)
 			return crresHeight;
 	}
 
-	return findHeightValByNeighbor(p, cloth);
+	return findHeightValByNeighbor(xpos, ypos, cloth, nearestHeights);
 }
 
-double Rasterization::findHeightValByNeighbor(Particle *p, Cloth &cloth)
+double Rasterization::findHeightValByNeighbor(int xpos, int ypos, const Cloth& cloth, const std::vector<double>& nearestHeights)
 {
-	queue<Particle*> nqueue;
-	vector<Particle *> pbacklist;
-	size_t neiborsize = p->neighborsList.size();
-	for (size_t i = 0; i < neiborsize; i++)
-	{
-		p->isVisited = true;
-		nqueue.push(p->neighborsList[i]);
-	}
+	//breadth-first search in the cloth grid (the visited particles are stored locally,
+	//so that several particles can be processed at the same time)
+	queue<int> nqueue;
+	unordered_set<int> visited;
+	nqueue.push(cloth.getIndex(xpos, ypos));
+	visited.insert(nqueue.front());
 
 	//iterate over the nqueue
 	while (!nqueue.empty())
 	{
-		Particle *pneighbor = nqueue.front();
+		int index = nqueue.front();
 		nqueue.pop();
-		pbacklist.push_back(pneighbor);
-		if (pneighbor->nearestPointHeight > MIN_INF)
+		if (nearestHeights[index] > MIN_INF)
 		{
-			for (int i = 0; i < pbacklist.size(); i++)
-				pbacklist[i]->isVisited = false;
-			while (!nqueue.empty())
-			{
-				Particle *pp = nqueue.front();
-				pp->isVisited = false;
-				nqueue.pop();
-			}
-			return pneighbor->nearestPointHeight;
+			return nearestHeights[index];
 		}
-		else
+
+		int x = index % cloth.num_particles_width;
+		int y = index / cloth.num_particles_width;
+		for (const int* offset : Cloth::NeighborOffsets)
 		{
-			size_t nsize = pneighbor->neighborsList.size();
-			for (size_t i = 0; i < nsize; i++)
+			int nx = x + offset[0];
+			int ny = y + offset[1];
+			if (nx >= 0 && ny >= 0 && nx < cloth.num_particles_width && ny < cloth.num_particles_height)
 			{
-				Particle *ptmp = pneighbor->neighborsList[i];
-				if (!ptmp->isVisited)
+				int neighborIndex = cloth.getIndex(nx, ny);
+				if (visited.insert(neighborIndex).second)
 				{
-					ptmp->isVisited = true;
-					nqueue.push(ptmp);
+					nqueue.push(neighborIndex);
 				}
 			}
-
 		}
 	}
 	return MIN_INF;
 }
 
+//Returns the bits of a positive double value (their order is the same as the values order)
+static inline uint64_t DoubleToOrderedBits(double value)
+{
+	uint64_t bits = 0;
+	memcpy(&bits, &value, sizeof(double));
+	return bits;
+}
+
 bool Rasterization::RasterTerrain(Cloth& cloth, const wl::PointCloud& pc, std::vector<double>& heightVal, unsigned KNN)
 {
 	try
 	{
-		//ȶÿlidarҵڲжӦĽڵ㣬¼
-		//find the nearest cloth particle for each lidar point by Rounding operation
-		for (int i = 0; i < pc.size(); i++)
+		const int particleCount = cloth.getSize();
+		const int pointCount = static_cast<int>(pc.size());
+
+		//returns the index of the particle corresponding to a lidar point (or -1), and the (squared) distance to this particle
+		auto findParticle = [&](int i, double& pc2particleDist) -> int
 		{
 			double pc_x = pc[i].x;
 			double pc_z = pc[i].z;
@@ -136,28 +141,79 @@ bool Rasterization::RasterTerrain(Cloth& cloth, const wl::PointCloud& pc, std::v
 			double deltaZ = pc_z - cloth.origin_pos.z;
 			int col = int(deltaX / cloth.step_x + 0.5);
 			int row = int(deltaZ / cloth.step_y + 0.5);
-			if (col >= 0 && row >= 0 )
+			if (col < 0 || row < 0 || col >= cloth.num_particles_width || row >= cloth.num_particles_height)
+			{
+				return -1;
+			}
+			pc2particleDist = SQUARE_DIST(pc_x, pc_z, cloth.origin_pos.x + col * cloth.step_x, cloth.origin_pos.z + row * cloth.step_y);
+			return (pc2particleDist < MAX_INF ? cloth.getIndex(col, row) : -1);
+		};
+
+		//ȶÿlidarҵڲжӦĽڵ㣬¼
+		//find the nearest lidar point of each cloth particle (by Rounding operation), in parallel:
+		//1) the min. distance is determined for each particle
+		std::vector< std::atomic<uint64_t> > minDist(particleCount);
+		const uint64_t noDist = std::numeric_limits<uint64_t>::max();
+#pragma omp parallel for
+		for (int i = 0; i < particleCount; i++)
+		{
+			minDist[i].store(noDist, std::memory_order_relaxed);
+		}
+
+#pragma omp parallel for
+		for (int i = 0; i < pointCount; i++)
+		{
+			double pc2particleDist = 0;
+			int index = findParticle(i, pc2particleDist);
+			if (index >= 0)
 			{
-				Particle& pt = cloth.getParticle(col, row);
-				//Particle pt = cloth.getParticle(col, row); this give wrong results, since it made a copy
-				pt.correspondingLidarPointList.push_back(i);
-				double pc2particleDist = SQUARE_DIST(pc_x, pc_z, pt.pos.x, pt.pos.z);
-				if (pc2particleDist < pt.tmpDist)
+				uint64_t dist = DoubleToOrderedBits(pc2particleDist);
+				uint64_t current = minDist[index].load(std::memory_order_relaxed);
+				while (dist < current && !minDist[index].compare_exchange_weak(current, dist, std::memory_order_relaxed))
 				{
-					pt.tmpDist = pc2particleDist;
-					pt.nearestPointHeight = pc[i].y;
-					pt.nearestPointIndex = i;
 				}
 			}
 		}
-		
 
-		heightVal.resize(cloth.getSize());
-		//#pragma omp parallel for
-		for (int i = 0; i < cloth.getSize(); i++)
+		//2) the first point (= smallest index) at this distance is kept (as with a sequential process)
+		std::vector< std::atomic<unsigned> > nearestPoint(particleCount);
+		const unsigned noPoint = std::numeric_limits<unsigned>::max();
+#pragma omp parallel for
+		for (int i = 0; i < particleCount; i++)
 		{
-			Particle& pcur = cloth.getParticleByIndex(i);
-			double nearestHeight = pcur.nearestPointHeight;
+			nearestPoint[i].store(noPoint, std::memory_order_relaxed);
+		}
+
+#pragma omp parallel for
+		for (int i = 0; i < pointCount; i++)
+		{
+			double pc2particleDist = 0;
+			int index = findParticle(i, pc2particleDist);
+			if (index >= 0 && DoubleToOrderedBits(pc2particleDist) == minDist[index].load(std::memory_order_relaxed))
+			{
+				unsigned pointIndex = static_cast<unsigned>(i);
+				unsigned current = nearestPoint[index].load(std::memory_order_relaxed);
+				while (pointIndex < current && !nearestPoint[index].compare_exchange_weak(current, pointIndex, std::memory_order_relaxed))
+				{
+				}
+			}
+		}
+
+		//height of the nearest lidar point of each particle
+		std::vector<double> nearestHeights(particleCount);
+#pragma omp parallel for
+		for (int i = 0; i < particleCount; i++)
+		{
+			unsigned pointIndex = nearestPoint[i].load(std::memory_order_relaxed);
+			nearestHeights[i] = (pointIndex != noPoint ? pc[pointIndex].y : MIN_INF);
+		}
+
+		//the particles without any lidar point take the height of their neighbors
+		heightVal.resize(particleCount);
+#pragma omp parallel for schedule(dynamic, 4096)
+		for (int i = 0; i < particleCount; i++)
+		{
+			double nearestHeight = nearestHeights[i];
 			
 			if (nearestHeight > MIN_INF)
 			{
@@ -165,7 +221,7 @@ bool Rasterization::RasterTerrain(Cloth& cloth, const wl::PointCloud& pc, std::v
 			}
 			else
 			{
-				heightVal[i] = findHeightValByScanline(&pcur, cloth);
+				heightVal[i] = findHeightValByScanline(i % cloth.num_particles_width, i / cloth.num_particles_width, cloth, nearestHeights);
 			}
 		
 		}
@@ -184,7 +240,6 @@ bool Rasterization::RasterTerrain(Cloth& cloth, const wl::PointCloud& pc, std::v
 
 
 
-
 #else
 
 //CGAL is slow but more stable, especially when the point cloud is sparse (relatively to the rectangular raster grid!)
@@ -220,8 +275,8 @@ bool Rasterization::RasterTerrain(Cloth& cloth, const wl::PointCloud& pc, std::v
 		heightVal.resize(cloth.getSize());
 		for (int i = 0; i < cloth.getSize(); i++)
 		{
-			const Particle& particle = cloth.getParticleByIndex(i);
-			Point_d query(particle.pos.x, particle.pos.z);
+			Vec3 pos = cloth.getParticlePos(i);
+			Point_d query(pos.x, pos.z);
 			Neighbor_search search(tree, query, KNN);
 			double search_max = 0;
 			for (Neighbor_search::iterator it = search.begin(); it != search.end(); it++)
@@ -312,8 +367,8 @@ bool Rasterization::RasterTerrain(Cloth& cloth, const wl::PointCloud& pc, std::v
 	}
 	for (int i = 0; i < cloth.getSize(); i++)
 	{
-		const Particle& particle = cloth.getParticleByIndex(i);
-		particlePoints.addPoint(CCVector3(static_cast<PointCoordinateType>(particle.pos.x), 0, static_cast<PointCoordinateType>(particle.pos.z)));
+		Vec3 pos = cloth.getParticlePos(i);
+		particlePoints.addPoint(CCVector3(static_cast<PointCoordinateType>(pos.x), 0, static_cast<PointCoordinateType>(pos.z)));
 	}
 
 	//test
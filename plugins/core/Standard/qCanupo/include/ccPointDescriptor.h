@@ -24,8 +24,10 @@
 
 //CCCoreLib
 #include <ReferenceCloud.h>
+#include <SquareMatrix.h>
 
 //system
+#include <cassert>
 #include <vector>
 #include <math.h>
 
@@ -75,6 +77,11 @@ public:
 	//! Returns whether the computer requires a scalar field or not
 	virtual bool needSF() const { return false; }
 
+	//! Returns a new instance of this computer (with the same state)
+	/** The computers are not thread-safe (see reset): each thread must use its own instance.
+	**/
+	virtual ScaleParamsComputer* clone() const = 0;
+
 	//! Called once before computing parameters at first scale
 	virtual void reset() = 0;
 	
@@ -87,6 +94,22 @@ public:
 	**/
 	virtual void computeScaleParams(CCCoreLib::ReferenceCloud& neighbors, double radius, float params[], bool& invalidScale) = 0;
 
+	//! Returns whether the parameters only depend on the covariance matrix of the neighbors
+	/** In which case the covariance matrices of all the scales can be computed in a single
+		pass over the neighbors (see computeScaleParamsFromCovariance).
+	**/
+	virtual bool usesCovarianceOnly() const { return false; }
+
+	//! Computes the parameters at a given scale from the covariance matrix of the neighbors
+	/** Only called if usesCovarianceOnly returns true. Scales are always called in decreasing order.
+		\param[in] covMat the covariance matrix of the neighbors at the current scale
+		\param[in] neighborCount the number of neighbors at the current scale
+		\param[in] radius current radius (half scale) value
+		\param[out] params the computed parameters
+		\param[out] invalidScale whether this scale is 'invalid' (i.e. parameters couldn't be computed, default one have been returned instead)
+	**/
+	virtual void computeScaleParamsFromCovariance(const CCCoreLib::SquareMatrixd& covMat, unsigned neighborCount, double radius, float params[], bool& invalidScale) { assert(false); }
+
 protected:
 };
 
@@ -59,6 +59,9 @@ public:
 	//inherited from ScaleParamsComputer
 	unsigned dimPerScale() const override { return 2; }
 
+	//inherited from ScaleParamsComputer
+	ScaleParamsComputer* clone() const override { return new DimensionalityScaleParamsComputer(*this); }
+
 	//inherited from ScaleParamsComputer
 	void reset() override
 	{
@@ -76,14 +79,31 @@ public:
 	//inherited from ScaleParamsComputer
 	void computeScaleParams(CCCoreLib::ReferenceCloud& neighbors, double radius, float params[], bool& invalidScale) override
 	{
-		//PCA analysis
 		if (neighbors.size() >= 3)
 		{
 			CCCoreLib::Neighbourhood Z(&neighbors);
+			computeScaleParamsFromCovariance(Z.computeCovarianceMatrix(), neighbors.size(), radius, params, invalidScale);
+		}
+		else if (m_firstScale) //less than 3 points at the biggest scale?!
+		{
+			invalidScale = true;
+			params[0] = m_defaultParams[0];
+			params[1] = m_defaultParams[1];
+		}
+	}
+
+	//inherited from ScaleParamsComputer
+	bool usesCovarianceOnly() const override { return true; }
 
+	//inherited from ScaleParamsComputer
+	void computeScaleParamsFromCovariance(const CCCoreLib::SquareMatrixd& covMat, unsigned neighborCount, double radius, float params[], bool& invalidScale) override
+	{
+		//PCA analysis
+		if (neighborCount >= 3)
+		{
 			CCCoreLib::SquareMatrixd eigVectors;
 			std::vector<double> eigValues;
-			if (CCCoreLib::Jacobi<double>::ComputeEigenValuesAndVectors(Z.computeCovarianceMatrix(), eigVectors, eigValues, true))
+			if (CCCoreLib::Jacobi<double>::ComputeEigenValuesAndVectors(covMat, eigVectors, eigValues, true))
 			{
 				CCCoreLib::Jacobi<double>::SortEigenValuesAndVectors(eigVectors, eigValues); //decreasing order of their associated eigenvalues
 
@@ -165,6 +185,9 @@ public:
 	//inherited from ScaleParamsComputer
 	bool needSF() const override { return true; }
 
+	//inherited from ScaleParamsComputer
+	ScaleParamsComputer* clone() const override { return new DimensionalityAndSFScaleParamsComputer(*this); }
+
 	//inherited from ScaleParamsComputer
 	void reset() override
 	{
@@ -293,6 +316,9 @@ public:
 	//inherited from ScaleParamsComputer
 	unsigned dimPerScale() const override { return 1; }
 
+	//inherited from ScaleParamsComputer
+	ScaleParamsComputer* clone() const override { return new CurvatureScaleParamsComputer(*this); }
+
 	//inherited from ScaleParamsComputer
 	void reset() override
 	{
@@ -345,6 +371,9 @@ public:
 	//inherited from ScaleParamsComputer
 	unsigned dimPerScale() const override { return 1; }
 
+	//inherited from ScaleParamsComputer
+	ScaleParamsComputer* clone() const override { return new CustomScaleParamsComputer(*this); }
+
 	//inherited from ScaleParamsComputer
 	void reset() override
 	{
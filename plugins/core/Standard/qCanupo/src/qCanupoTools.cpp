@@ -28,6 +28,7 @@
 //qCC_db
 #include <ccPointCloud.h>
 #include <ccProgressDialog.h>
+#include <ccSpatialBatches.h>
 #include <ccScalarField.h>
 
 //qCC_plugins
@@ -39,67 +40,187 @@
 #include <QMainWindow>
 #include <QtConcurrentMap>
 
-//ComputeCorePointsDescriptors parameters
-static struct
+//system
+#include <algorithm>
+#include <atomic>
+#include <memory>
+
+//! ComputeCorePointsDescriptors parameters
+struct CorePointsDescParams
 {
-	CCCoreLib::GenericIndexedCloud* corePoints;
-	ccGenericPointCloud* sourceCloud;
-	CCCoreLib::DgmOctree* octree;
-	unsigned char octreeLevel;
-	CorePointDescSet* descriptors;
-	bool invalidDescriptors;
+	CCCoreLib::GenericIndexedCloud* corePoints = nullptr;
+	ccGenericPointCloud* sourceCloud = nullptr;
+	CCCoreLib::DgmOctree* octree = nullptr;
+	unsigned char octreeLevel = 0;
+	CorePointDescSet* descriptors = nullptr;
+	std::atomic<bool> invalidDescriptors { false };
 
-	CCCoreLib::NormalizedProgress* nProgress;
-	bool processCanceled;
-	bool errorOccurred;
+	CCCoreLib::NormalizedProgress* nProgress = nullptr;
+	std::atomic<bool> processCanceled { false };
+	std::atomic<bool> errorOccurred { false };
 
-	ScaleParamsComputer* computer; //the per-scale parameters computer 
+	const ScaleParamsComputer* computer = nullptr; //the per-scale parameters computer (prototype)
 
-	std::vector<ccScalarField*>* roughnessSFs; //for test
+	std::vector<ccScalarField*>* roughnessSFs = nullptr; //for test
+};
 
+//! First and second order moments of a set of points (relatively to a given origin)
+struct NeighbourhoodMoments
+{
+	//! Sums of the coordinates (X, Y, Z)
+	double s[3] = { 0, 0, 0 };
+	//! Sums of the coordinates products (XX, XY, XZ, YY, YZ, ZZ)
+	double s2[6] = { 0, 0, 0, 0, 0, 0 };
 
-} s_computeCorePointsDescParams;
+	//! Adds a point
+	inline void add(double x, double y, double z)
+	{
+		s[0] += x; s[1] += y; s[2] += z;
+		s2[0] += x * x; s2[1] += x * y; s2[2] += x * z;
+		s2[3] += y * y; s2[4] += y * z;
+		s2[5] += z * z;
+	}
 
-//! Per-point descriptor computer (all the parameters are stored in s_computeCorePointsDescParams)
-void ComputeCorePointDescriptor(unsigned index)
+	//! Returns the covariance matrix of the points (same as CCCoreLib::Neighbourhood::computeCovarianceMatrix)
+	void toCovarianceMatrix(unsigned count, CCCoreLib::SquareMatrixd& covMat) const
+	{
+		assert(count != 0 && covMat.size() == 3);
+		const double mx = s[0] / count;
+		const double my = s[1] / count;
+		const double mz = s[2] / count;
+
+		covMat.m_values[0][0] = s2[0] / count - mx * mx;
+		covMat.m_values[1][1] = s2[3] / count - my * my;
+		covMat.m_values[2][2] = s2[5] / count - mz * mz;
+		covMat.m_values[1][0] = covMat.m_values[0][1] = s2[1] / count - mx * my;
+		covMat.m_values[2][0] = covMat.m_values[0][2] = s2[2] / count - mx * mz;
+		covMat.m_values[2][1] = covMat.m_values[1][2] = s2[4] / count - my * mz;
+	}
+};
+
+//! Per-thread resources reused from one core point to the next
+struct CorePointsDescWorkspace
+{
+	explicit CorePointsDescWorkspace(const CorePointsDescParams& params)
+		: computer(params.computer->clone())
+		, subset(params.sourceCloud)
+		, covMat(3)
+	{}
+
+	//! Per-scale parameters computer (not thread-safe)
+	std::unique_ptr<ScaleParamsComputer> computer;
+	//! Neighbours buffer
+	CCCoreLib::DgmOctree::NeighboursSet neighbours;
+	//! Neighbourhood subset
+	CCCoreLib::ReferenceCloud subset;
+	//! Number of neighbours at each scale
+	std::vector<unsigned> counts;
+	//! Moments of the neighbours at each scale
+	std::vector<NeighbourhoodMoments> moments;
+	//! Covariance matrix (of the current scale)
+	CCCoreLib::SquareMatrixd covMat;
+};
+
+//! Per-point descriptor computer
+static void ComputeCorePointDescriptor(CorePointsDescParams& params, unsigned index, CorePointsDescWorkspace& workspace)
 {
-	if (s_computeCorePointsDescParams.processCanceled)
+	if (params.processCanceled)
 		return;
 
-	const CCVector3* P = s_computeCorePointsDescParams.corePoints->getPoint(index);
-	CCCoreLib::DgmOctree::NeighboursSet neighbours;
+	const CCVector3* P = params.corePoints->getPoint(index);
+	CCCoreLib::DgmOctree::NeighboursSet& neighbours = workspace.neighbours;
+	neighbours.clear(); //the capacity is kept
 
 	//extract the neighbors (maximum radius)
-	float maxRadius = s_computeCorePointsDescParams.descriptors->scales().front() / 2;
-	int n = s_computeCorePointsDescParams.octree->getPointsInSphericalNeighbourhood(*P,
+	float maxRadius = params.descriptors->scales().front() / 2;
+	int n = params.octree->getPointsInSphericalNeighbourhood(*P,
 																				maxRadius,
 																				neighbours,
-																				s_computeCorePointsDescParams.octreeLevel);
+																				params.octreeLevel);
 
 	if (n != 0)
 	{
-		size_t scaleCount = s_computeCorePointsDescParams.descriptors->scales().size();
+		size_t scaleCount = params.descriptors->scales().size();
 
 		//get reference on corresponding descriptor
-		assert(s_computeCorePointsDescParams.descriptors->size() > index);
-		CorePointDesc& desc = s_computeCorePointsDescParams.descriptors->at(index);
+		assert(params.descriptors->size() > index);
+		CorePointDesc& desc = params.descriptors->at(index);
 
-		unsigned dimPerScale = s_computeCorePointsDescParams.descriptors->dimPerScale();
+		unsigned dimPerScale = params.descriptors->dimPerScale();
 		assert(desc.params.size() == scaleCount * dimPerScale);
 
-		//init the whole neighborhood subset (we will prune it each time)
-		CCCoreLib::ReferenceCloud subset(s_computeCorePointsDescParams.sourceCloud);
+		//sort the neighbors by increasing distance (once for all the scales)
+		ParallelSort(neighbours.begin(), neighbours.end(), CCCoreLib::DgmOctree::PointDescriptor::distComp);
+
+		std::vector<unsigned>& counts = workspace.counts;
+		std::vector<NeighbourhoodMoments>& moments = workspace.moments;
+		try
 		{
-			if (!subset.reserve(n))
+			counts.resize(scaleCount);
+		}
+		catch (const std::bad_alloc&)
+		{
+			//not enough memory!
+			params.errorOccurred = true;
+			params.processCanceled = true; //to make the loop stop!
+			return;
+		}
+
+		//number of neighbors at each scale (the scales are sorted in decreasing order)
+		counts[0] = static_cast<unsigned>(n);
+		for (size_t i = 1; i < scaleCount; ++i)
+		{
+			const double radius = params.descriptors->scales()[i] / 2;
+			double squareRadius = radius * radius;
+			CCCoreLib::DgmOctree::PointDescriptor fakeDesc(nullptr, 0, squareRadius);
+			CCCoreLib::DgmOctree::NeighboursSet::iterator end = neighbours.begin() + counts[i - 1];
+			CCCoreLib::DgmOctree::NeighboursSet::iterator up = std::upper_bound(neighbours.begin(), end, fakeDesc, CCCoreLib::DgmOctree::PointDescriptor::distComp);
+			counts[i] = (up != end ? std::max<unsigned>(1, static_cast<unsigned>(up - neighbours.begin())) : counts[i - 1]);
+		}
+
+		//if the descriptor only depends on the covariance matrix, we accumulate the moments of the
+		//neighbors progressively (from the smallest scale to the biggest) in a single pass
+		const bool useMoments = workspace.computer->usesCovarianceOnly();
+		if (useMoments)
+		{
+			try
+			{
+				moments.resize(scaleCount);
+			}
+			catch (const std::bad_alloc&)
 			{
 				//not enough memory!
-				s_computeCorePointsDescParams.errorOccurred = true;
-				s_computeCorePointsDescParams.processCanceled = true; //to make the loop stop!
+				params.errorOccurred = true;
+				params.processCanceled = true; //to make the loop stop!
 				return;
 			}
 
-			//sort the neighbors by increasing distance
-			ParallelSort(neighbours.begin(), neighbours.end(), CCCoreLib::DgmOctree::PointDescriptor::distComp);
+			//the coordinates are expressed relatively to the core point (for a better accuracy)
+			NeighbourhoodMoments current;
+			unsigned k = 0;
+			for (size_t i = scaleCount; i-- > 0;)
+			{
+				for (; k < counts[i]; ++k)
+				{
+					const CCVector3* Q = neighbours[k].point;
+					current.add(static_cast<double>(Q->x) - P->x, static_cast<double>(Q->y) - P->y, static_cast<double>(Q->z) - P->z);
+				}
+				moments[i] = current;
+			}
+		}
+
+		//the neighborhood subset is only required by the other descriptors (or to compute the roughness)
+		CCCoreLib::ReferenceCloud& subset = workspace.subset;
+		subset.clear(false);
+		if (!useMoments || params.roughnessSFs)
+		{
+			if (!subset.reserve(n))
+			{
+				//not enough memory!
+				params.errorOccurred = true;
+				params.processCanceled = true; //to make the loop stop!
+				return;
+			}
 
 			for (int j = 0; j < n; ++j)
 			{
@@ -107,29 +228,20 @@ void ComputeCorePointDescriptor(unsigned index)
 			}
 		}
 
-		s_computeCorePointsDescParams.computer->reset();
+		workspace.computer->reset();
 
 		for (size_t i = 0; i < scaleCount; ++i)
 		{
-			const double radius = s_computeCorePointsDescParams.descriptors->scales()[i] / 2; //we start from the biggest
+			const double radius = params.descriptors->scales()[i] / 2; //we start from the biggest
 
-			if (i != 0)
+			if (subset.size() > counts[i])
 			{
 				//trim the points that don't fall in the current neighborhood
-				double squareRadius = radius * radius;
-				CCCoreLib::DgmOctree::PointDescriptor fakeDesc(nullptr, 0, squareRadius);
-				CCCoreLib::DgmOctree::NeighboursSet::iterator up = std::upper_bound(neighbours.begin(), neighbours.end(), fakeDesc, CCCoreLib::DgmOctree::PointDescriptor::distComp);
-				if (up != neighbours.end())
-				{
-					size_t count = std::max<size_t>(1, up - neighbours.begin());
-
-					neighbours.resize(count);
-					subset.resize(static_cast<unsigned>(count));
-				}
+				subset.resize(counts[i]);
 			}
 
 			//optional: compute per-level roughness
-			if (s_computeCorePointsDescParams.roughnessSFs)
+			if (params.roughnessSFs)
 			{
 				ScalarType roughness = CCCoreLib::NAN_VALUE;
 
@@ -150,7 +262,7 @@ void ComputeCorePointDescriptor(unsigned index)
 					if (lsPlane)
 					{
 						//distance to the LS plane fitted on the nearest neighbors
-						const CCVector3* centralPoint = s_computeCorePointsDescParams.sourceCloud->getPoint(globalIndex);
+						const CCVector3* centralPoint = params.sourceCloud->getPoint(globalIndex);
 						roughness = std::abs(CCCoreLib::DistanceComputationTools::computePoint2PlaneDistance(centralPoint, lsPlane));
 					}
 
@@ -159,18 +271,26 @@ void ComputeCorePointDescriptor(unsigned index)
 					subset.swap(0, lastIndex);
 				}
 
-				assert(s_computeCorePointsDescParams.roughnessSFs->size() == scaleCount);
-				ccScalarField* sf = s_computeCorePointsDescParams.roughnessSFs->at(i);
+				assert(params.roughnessSFs->size() == scaleCount);
+				ccScalarField* sf = params.roughnessSFs->at(i);
 				assert(sf && sf->currentSize() > index);
 				sf->setValue(index, roughness);
 			}
 
 			bool invalidScale = false;
-			s_computeCorePointsDescParams.computer->computeScaleParams(subset, radius, &(desc.params[i*dimPerScale]), invalidScale);
+			if (useMoments)
+			{
+				moments[i].toCovarianceMatrix(counts[i], workspace.covMat);
+				workspace.computer->computeScaleParamsFromCovariance(workspace.covMat, counts[i], radius, &(desc.params[i*dimPerScale]), invalidScale);
+			}
+			else
+			{
+				workspace.computer->computeScaleParams(subset, radius, &(desc.params[i*dimPerScale]), invalidScale);
+			}
 
 			if (invalidScale)
 			{
-				s_computeCorePointsDescParams.invalidDescriptors = true;
+				params.invalidDescriptors = true;
 				//no need to compute the remaining scales!
 				for (size_t j = i + 1; j < scaleCount; ++j)
 				{
@@ -186,13 +306,13 @@ void ComputeCorePointDescriptor(unsigned index)
 	else
 	{
 		//if the widest neighborhood has less than 3 points, we can't compute a valid descriptor!
-		s_computeCorePointsDescParams.invalidDescriptors = true;
+		params.invalidDescriptors = true;
 	}
 	
 	//progress notification
-	if (s_computeCorePointsDescParams.nProgress && !s_computeCorePointsDescParams.nProgress->oneStep())
+	if (params.nProgress && !params.nProgress->oneStep())
 	{
-		s_computeCorePointsDescParams.processCanceled = true;
+		params.processCanceled = true;
 	}
 }
 
@@ -228,20 +348,21 @@ bool qCanupoTools::ComputeCorePointsDescriptors(CCCoreLib::GenericIndexedCloud*
 	}
 
 	//descriptor (computer)
-	s_computeCorePointsDescParams.computer = ScaleParamsComputer::GetByID(descriptorID);
-	if (!s_computeCorePointsDescParams.computer)
+	CorePointsDescParams params;
+	params.computer = ScaleParamsComputer::GetByID(descriptorID);
+	if (!params.computer)
 	{
 		error = QString("Unhandled descriptor ID (%1)!").arg(descriptorID);
 		return false;
 	}
-	if (s_computeCorePointsDescParams.computer->needSF() && !corePoints->enableScalarField())
+	if (params.computer->needSF() && !corePoints->enableScalarField())
 	{
 		error = "Couldn't allocate a scalar field for core points!";
 		return false;
 	}
 
 	corePointsDescriptors.setDescriptorID(descriptorID);
-	corePointsDescriptors.setDimPerScale(s_computeCorePointsDescParams.computer->dimPerScale());
+	corePointsDescriptors.setDimPerScale(params.computer->dimPerScale());
 
 	CCCoreLib::DgmOctree* theOctree = inputOctree;
 	if (!theOctree)
@@ -291,16 +412,13 @@ bool qCanupoTools::ComputeCorePointsDescriptors(CCCoreLib::GenericIndexedCloud*
 	PointCoordinateType biggestRadius = sortedScales.front() / 2; //we extract the biggest neighborhood
 	unsigned char octreeLevel = theOctree->findBestLevelForAGivenNeighbourhoodSizeExtraction(biggestRadius);
 
-	s_computeCorePointsDescParams.corePoints = corePoints;
-	s_computeCorePointsDescParams.descriptors = &corePointsDescriptors;
-	s_computeCorePointsDescParams.sourceCloud = sourceCloud;
-	s_computeCorePointsDescParams.octree = theOctree;
-	s_computeCorePointsDescParams.octreeLevel = octreeLevel;
-	s_computeCorePointsDescParams.nProgress = progressCb ? &nProgress : nullptr;
-	s_computeCorePointsDescParams.processCanceled = false;
-	s_computeCorePointsDescParams.errorOccurred = false;
-	s_computeCorePointsDescParams.invalidDescriptors = false;
-	s_computeCorePointsDescParams.roughnessSFs = roughnessSFs;
+	params.corePoints = corePoints;
+	params.descriptors = &corePointsDescriptors;
+	params.sourceCloud = sourceCloud;
+	params.octree = theOctree;
+	params.octreeLevel = octreeLevel;
+	params.nProgress = progressCb ? &nProgress : nullptr;
+	params.roughnessSFs = roughnessSFs;
 
 	//we try the parallel way (if we have enough memory)
 	bool useParallelStrategy = true;
@@ -308,64 +426,62 @@ bool qCanupoTools::ComputeCorePointsDescriptors(CCCoreLib::GenericIndexedCloud*
 	useParallelStrategy = false;
 #endif
 
-	std::vector<unsigned> corePointsIndexes;
-	if (useParallelStrategy)
+	if (maxThreadCount == 0)
 	{
-		try
-		{
-			corePointsIndexes.resize(corePtsCount);
-		}
-		catch (const std::bad_alloc&)
-		{
-			//not enough memory
-			useParallelStrategy = false;
-		}
+		maxThreadCount = QThread::idealThreadCount();
 	}
+	assert(maxThreadCount > 0 && maxThreadCount <= QThread::idealThreadCount());
 
-	if (useParallelStrategy)
+	//the core points are processed in Morton order, by batches of contiguous points
+	//(so that each thread works on a compact area of the source cloud and reuses its buffers)
+	std::vector<unsigned> corePointsIndexes;
+	try
 	{
+		corePointsIndexes.resize(corePtsCount);
 		for (unsigned i = 0; i < corePtsCount; ++i)
 		{
 			corePointsIndexes[i] = i;
 		}
+		ccSpatialBatches::SortByMortonCode(corePoints, corePointsIndexes); //not critical if it fails
+	}
+	catch (const std::bad_alloc&)
+	{
+		//not enough memory
+		corePointsIndexes.clear();
+		useParallelStrategy = false;
+	}
 
-		if (maxThreadCount == 0)
+	if (useParallelStrategy)
+	{
+		useParallelStrategy = ccSpatialBatches::Process(corePtsCount, maxThreadCount, [&](unsigned start, unsigned stop)
 		{
-			maxThreadCount = QThread::idealThreadCount();
-		}
-		assert(maxThreadCount <= QThread::idealThreadCount());
-		QThreadPool::globalInstance()->setMaxThreadCount(maxThreadCount);
-		QtConcurrent::blockingMap(corePointsIndexes, ComputeCorePointDescriptor);
+			CorePointsDescWorkspace workspace(params);
+			for (unsigned i = start; i < stop && !params.processCanceled; ++i)
+			{
+				ComputeCorePointDescriptor(params, corePointsIndexes[i], workspace);
+			}
+		});
 	}
-	else
+
+	if (!useParallelStrategy)
 	{
-		//manually call the static per-point method!
+		//manually call the per-point method!
+		CorePointsDescWorkspace workspace(params);
+		bool ordered = (corePointsIndexes.size() == corePtsCount);
 		for (unsigned i = 0; i < corePtsCount; ++i)
 		{
-			ComputeCorePointDescriptor(i);
+			ComputeCorePointDescriptor(params, ordered ? corePointsIndexes[i] : i, workspace);
 		}
 	}
 
 	//output flags
-	bool wasCanceled = s_computeCorePointsDescParams.processCanceled;
-	bool errorOccurred = s_computeCorePointsDescParams.errorOccurred;
+	bool wasCanceled = params.processCanceled;
+	bool errorOccurred = params.errorOccurred;
 	if (errorOccurred)
 		error = "An error occurred during descriptors computation!";
 	else if (wasCanceled)
 		error = "Process has been cancelled by the user";
-	invalidDescriptors = s_computeCorePointsDescParams.invalidDescriptors;
-
-	//reset static parameters (just to be clean ;)
-	s_computeCorePointsDescParams.corePoints = nullptr;
-	s_computeCorePointsDescParams.descriptors = nullptr;
-	s_computeCorePointsDescParams.sourceCloud = nullptr;
-	s_computeCorePointsDescParams.octree = nullptr;
-	s_computeCorePointsDescParams.octreeLevel = 0;
-	s_computeCorePointsDescParams.nProgress = nullptr;
-	s_computeCorePointsDescParams.processCanceled = false;
-	s_computeCorePointsDescParams.errorOccurred = false;
-	s_computeCorePointsDescParams.invalidDescriptors = false;
-	s_computeCorePointsDescParams.computer = nullptr;
+	invalidDescriptors = params.invalidDescriptors;
 
 	if (progressCb)
 	{
@@ -24,22 +24,114 @@
 //Local
 #include "qM3C2Process.h"
 
+//qCC_db
+#include <ccProgressDialog.h>
+
+//Qt
+#include <QThreadPool>
+#include <QtConcurrentRun>
+
 static const char COMMAND_M3C2[] = "M3C2";
+static const char COMMAND_M3C2_TILE_SIZE[] = "TILE_SIZE";
+static const char COMMAND_M3C2_EPOCHS[] = "EPOCHS";
+static const char COMMAND_M3C2_EPOCHS_PREVIOUS[] = "PREVIOUS";
+static const char COMMAND_M3C2_EPOCHS_FIRST[] = "FIRST";
+static const char COMMAND_M3C2_MAX_JOBS[] = "MAX_JOBS";
 
 struct CommandM3C2 : public ccCommandLineInterface::Command
 {
 	CommandM3C2() : ccCommandLineInterface::Command("M3C2", COMMAND_M3C2) {}
 
+	//! M3C2 job (= one pair of clouds)
+	struct Job
+	{
+		qM3C2Process::Parameters params;
+		int cloud1Index = 0;
+		int cloud2Index = 1;
+		ccPointCloud* outputCloud = nullptr;
+		QString errorMessage;
+		bool success = false;
+	};
+
 	virtual bool process(ccCommandLineInterface& cmd) override
 	{
 		cmd.print("[M3C2]");
-		if (cmd.arguments().empty())
+
+		double tileSize = 0.0;
+		int maxJobs = 1;
+		enum EpochsMode { NO_EPOCHS, EPOCHS_PREVIOUS, EPOCHS_FIRST };
+		EpochsMode epochsMode = NO_EPOCHS;
+		QString paramFilename;
+
+		//optional parameters
+		while (!cmd.arguments().empty())
 		{
-			return cmd.error(QString("Missing parameter: parameters filename after \"-%1\"").arg(COMMAND_M3C2));
+			QString argument = cmd.arguments().front();
+			if (ccCommandLineInterface::IsCommand(argument, COMMAND_M3C2_TILE_SIZE))
+			{
+				//local option confirmed, we can move on
+				cmd.arguments().pop_front();
+
+				bool ok = false;
+				if (!cmd.arguments().empty())
+				{
+					tileSize = cmd.arguments().takeFirst().toDouble(&ok);
+				}
+				if (!ok || tileSize <= 0.0)
+				{
+					return cmd.error(QString("Invalid parameter: tile size after '%1'").arg(COMMAND_M3C2_TILE_SIZE));
+				}
+				cmd.print(QString("Tile size: %1").arg(tileSize));
+			}
+			else if (ccCommandLineInterface::IsCommand(argument, COMMAND_M3C2_EPOCHS))
+			{
+				//local option confirmed, we can move on
+				cmd.arguments().pop_front();
+
+				QString mode = (cmd.arguments().empty() ? QString() : cmd.arguments().takeFirst().toUpper());
+				if (mode == COMMAND_M3C2_EPOCHS_PREVIOUS)
+				{
+					epochsMode = EPOCHS_PREVIOUS;
+				}
+				else if (mode == COMMAND_M3C2_EPOCHS_FIRST)
+				{
+					epochsMode = EPOCHS_FIRST;
+				}
+				else
+				{
+					return cmd.error(QString("Invalid parameter: epochs mode after '%1' (%2 or %3 expected)").arg(COMMAND_M3C2_EPOCHS).arg(COMMAND_M3C2_EPOCHS_PREVIOUS).arg(COMMAND_M3C2_EPOCHS_FIRST));
+				}
+				cmd.print(QString("Epochs mode: %1").arg(mode));
+			}
+			else if (ccCommandLineInterface::IsCommand(argument, COMMAND_M3C2_MAX_JOBS))
+			{
+				//local option confirmed, we can move on
+				cmd.arguments().pop_front();
+
+				bool ok = false;
+				if (!cmd.arguments().empty())
+				{
+					maxJobs = cmd.arguments().takeFirst().toInt(&ok);
+				}
+				if (!ok || maxJobs < 1)
+				{
+					return cmd.error(QString("Invalid parameter: number of jobs after '%1'").arg(COMMAND_M3C2_MAX_JOBS));
+				}
+				cmd.print(QString("Max number of parallel jobs: %1").arg(maxJobs));
+			}
+			else
+			{
+				//we assume the parameter is the parameters filename
+				paramFilename = argument;
+				cmd.arguments().pop_front();
+				break;
+			}
 		}
 
-		//open specified file
-		QString paramFilename(cmd.arguments().takeFirst());
+		if (paramFilename.isEmpty())
+		{
+			return cmd.error(QString("Missing parameter: parameters filename after \"-%1\"").arg(COMMAND_M3C2));
+		}
 		cmd.print(QString("Parameters file: '%1'").arg(paramFilename));
 
 		if (cmd.clouds().size() < 2)
@@ -48,38 +140,132 @@ struct CommandM3C2 : public ccCommandLineInterface::Command
 			return false;
 		}
 
-		ccPointCloud* cloud1 = ccHObjectCaster::ToPointCloud(cmd.clouds()[0].pc);
-		ccPointCloud* cloud2 = ccHObjectCaster::ToPointCloud(cmd.clouds()[1].pc);
-		ccPointCloud* corePointsCloud = (cmd.clouds().size() > 2 ? cmd.clouds()[2].pc : nullptr);
+		//pairs of clouds to compare
+		std::vector<Job> jobs;
+		if (epochsMode == NO_EPOCHS)
+		{
+			jobs.resize(1);
+		}
+		else
+		{
+			//all the loaded clouds are considered as successive epochs
+			jobs.resize(cmd.clouds().size() - 1);
+			for (size_t i = 0; i < jobs.size(); ++i)
+			{
+				jobs[i].cloud1Index = (epochsMode == EPOCHS_FIRST ? 0 : static_cast<int>(i));
+				jobs[i].cloud2Index = static_cast<int>(i + 1);
+			}
+		}
 
-		//display dialog
-		qM3C2Dialog dlg(cloud1, cloud2, nullptr);
-		if (!dlg.loadParamsFromFile(paramFilename))
+		for (Job& job : jobs)
 		{
-			return false;
+			ccPointCloud* cloud1 = ccHObjectCaster::ToPointCloud(cmd.clouds()[job.cloud1Index].pc);
+			ccPointCloud* cloud2 = ccHObjectCaster::ToPointCloud(cmd.clouds()[job.cloud2Index].pc);
+			ccPointCloud* corePointsCloud = (epochsMode == NO_EPOCHS && cmd.clouds().size() > 2 ? cmd.clouds()[2].pc : nullptr);
+
+			//the dialog is only used to read the parameters
+			qM3C2Dialog dlg(cloud1, cloud2, nullptr);
+			if (!dlg.loadParamsFromFile(paramFilename))
+			{
+				return false;
+			}
+			dlg.setCorePointsCloud(corePointsCloud);
+
+			QString errorMessage;
+			if (!qM3C2Process::GetParameters(dlg, job.params, errorMessage, epochsMode == NO_EPOCHS && !cmd.silentMode(), cmd.widgetParent()))
+			{
+				return cmd.error(errorMessage);
+			}
+			job.params.tileSize = tileSize;
+
+			if (epochsMode != NO_EPOCHS && job.params.keepOriginalCloud)
+			{
+				//the same cloud could be modified by several jobs
+				cmd.warning("The core points can't be used as output cloud in epochs mode (a new cloud will be created for each pair)");
+				job.params.keepOriginalCloud = false;
+			}
 		}
-		dlg.setCorePointsCloud(corePointsCloud);
 
-		QString errorMessage;
-		ccPointCloud* outputCloud = nullptr; //only necessary for the command line version in fact
-		if (!qM3C2Process::Compute(dlg, errorMessage, outputCloud, !cmd.silentMode(), cmd.widgetParent()))
+		maxJobs = std::min(maxJobs, static_cast<int>(jobs.size()));
+		if (maxJobs > 1)
 		{
-			return cmd.error(errorMessage);
+			//the shared structures are computed before running the jobs in parallel
+			for (CLCloudDesc& desc : cmd.clouds())
+			{
+				CCVector3 bbMin;
+				CCVector3 bbMax;
+				desc.pc->getBoundingBox(bbMin, bbMax);
+
+				if (tileSize <= 0.0 && !desc.pc->getOctree() && !desc.pc->computeOctree())
+				{
+					return cmd.error(QString("Failed to compute the octree of cloud '%1'").arg(desc.pc->getName()));
+				}
+			}
+
+			cmd.print(QString("Running %1 comparisons (%2 at a time)").arg(jobs.size()).arg(maxJobs));
+
+			QThreadPool jobPool;
+			jobPool.setMaxThreadCount(maxJobs);
+			std::vector< QFuture<void> > futures;
+			for (Job& job : jobs)
+			{
+				futures.push_back(QtConcurrent::run(&jobPool, [&job]()
+				{
+					job.success = qM3C2Process::Compute(job.params, job.errorMessage, job.outputCloud);
+				}));
+			}
+			for (QFuture<void>& future : futures)
+			{
+				future.waitForFinished();
+			}
+		}
+		else
+		{
+			for (Job& job : jobs)
+			{
+				ccProgressDialog pDlg(cmd.widgetParent());
+				job.success = qM3C2Process::Compute(job.params, job.errorMessage, job.outputCloud, &pDlg);
+			}
 		}
 
-		if (outputCloud)
+		QString errorMessage;
+		for (Job& job : jobs)
 		{
-			CLCloudDesc cloudDesc(outputCloud, cmd.clouds()[0].basename + QObject::tr("_M3C2"), cmd.clouds()[0].path);
-			if (cmd.autoSaveMode())
+			const CLCloudDesc& desc1 = cmd.clouds()[job.cloud1Index];
+			const CLCloudDesc& desc2 = cmd.clouds()[job.cloud2Index];
+			if (!job.success)
+			{
+				if (errorMessage.isEmpty())
+				{
+					errorMessage = job.errorMessage;
+				}
+				if (epochsMode != NO_EPOCHS)
+				{
+					cmd.warning(QString("Comparison '%1' / '%2' failed: %3").arg(desc1.basename, desc2.basename, job.errorMessage));
+				}
+				continue;
+			}
+
+			if (job.outputCloud)
 			{
-				QString errorStr = cmd.exportEntity(cloudDesc, QString(), 0, ccCommandLineInterface::ExportOption::ForceNoTimestamp);
-				if (!errorStr.isEmpty())
+				QString basename = (epochsMode == NO_EPOCHS ? desc1.basename + QObject::tr("_M3C2") : QString("%1_%2_M3C2").arg(desc1.basename, desc2.basename));
+				CLCloudDesc cloudDesc(job.outputCloud, basename, desc1.path);
+				if (cmd.autoSaveMode())
 				{
-					cmd.error(errorStr);
+					QString errorStr = cmd.exportEntity(cloudDesc, QString(), 0, ccCommandLineInterface::ExportOption::ForceNoTimestamp);
+					if (!errorStr.isEmpty())
+					{
+						cmd.error(errorStr);
+					}
 				}
+				//add cloud to the current pool
+				cmd.clouds().push_back(cloudDesc);
 			}
-			//add cloud to the current pool
-			cmd.clouds().push_back(cloudDesc);
+		}
+
+		if (!errorMessage.isEmpty())
+		{
+			return cmd.error(errorMessage);
 		}
 
 		return true;
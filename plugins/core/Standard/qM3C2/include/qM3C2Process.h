@@ -23,6 +23,12 @@
 
 class ccMainAppInterface;
 
+namespace CCCoreLib
+{
+	class GenericProgressCallback;
+	class ScalarField;
+}
+
 //! M3C2 process
 /** See "Accurate 3D comparison of complex topography with terrestrial laser scanner:
 	application to the Rangitikei canyon (N-Z)", Lague, D., Brodu, N. and Leroux, J.,
@@ -31,7 +37,72 @@ class ccMainAppInterface;
 class qM3C2Process
 {
 public:
-	
+
+	//! M3C2 parameters
+	/** Independent from the dialog, so that several comparisons can be run at the same time
+		(with different parameters).
+	**/
+	struct Parameters
+	{
+		//input clouds
+		ccPointCloud* cloud1 = nullptr;
+		ccPointCloud* cloud2 = nullptr;
+		ccPointCloud* corePoints = nullptr;		//if null, the core points are sub-sampled from cloud #1 (see samplingDist)
+		double samplingDist = 0.0;
+
+		//normals
+		qM3C2Normals::ComputationMode normMode = qM3C2Normals::DEFAULT_MODE;
+		double normalScale = 0.0;
+		double normMinScale = 0.0;				//multi-scale mode only
+		double normStep = 0.0;					//multi-scale mode only
+		double normMaxScale = 0.0;				//multi-scale mode only
+		bool normUseCorePoints = false;
+		bool normUsePreferredOrientation = true;
+		int normPreferredOrientation = 0;		//see ccNormalVectors::Orientation
+		ccPointCloud* normOrientationCloud = nullptr;
+
+		//projection
+		double projectionScale = 0.0;			//cylinder diameter
+		double projectionDepth = 0.0;			//cylinder half height
+		bool useMedian = false;
+		bool progressiveSearch = true;
+		bool onlyPositiveSearch = false;
+		unsigned minPoints4Stats = 5;
+		double registrationRms = 0.0;
+
+		//precision maps (sigma X, Y and Z scalar fields)
+		bool usePrecisionMaps = false;
+		CCCoreLib::ScalarField* cloud1PM[3] = { nullptr, nullptr, nullptr };
+		double cloud1PMScale = 1.0;
+		CCCoreLib::ScalarField* cloud2PM[3] = { nullptr, nullptr, nullptr };
+		double cloud2PMScale = 1.0;
+
+		//export
+		qM3C2Dialog::ExportOptions exportOption = qM3C2Dialog::PROJECT_ON_CORE_POINTS;
+		bool keepOriginalCloud = false;
+		bool exportStdDevInfo = false;
+		bool exportDensityAtProjScale = false;
+
+		//processing
+		int maxThreadCount = 0;					//0 = all the available threads
+		double tileSize = 0.0;					//if > 0, the core points are processed by tiles (bounded memory)
+	};
+
+	//! Reads the parameters from the dialog
+	/** \param dlg M3C2 dialog
+		\param params output parameters
+		\param errorMessage error message (if any)
+		\param allowDialogs whether the user can be asked for confirmation (precision maps)
+		\param parentWidget parent widget (for the confirmation dialog)
+		\return success
+	**/
+	static bool GetParameters(	const qM3C2Dialog& dlg,
+								Parameters& params,
+								QString& errorMessage,
+								bool allowDialogs,
+								QWidget* parentWidget = nullptr);
+
+	//! Computes the M3C2 distances with the dialog parameters
 	static bool Compute(const qM3C2Dialog& dlg,
 						QString& errorMessage,
 						ccPointCloud*& outputCloud,
@@ -39,6 +110,31 @@ public:
 						QWidget* parentWidget = nullptr,
 						ccMainAppInterface* app = nullptr);
 
+	//! Computes the M3C2 distances
+	/** This method is reentrant: several comparisons can be run at the same time
+		(as long as no octree has to be computed on a shared cloud, and the output
+		clouds are not shared).
+
+		If params.tileSize > 0, the core points are processed by (XY) tiles. For each tile,
+		only the points of both clouds inside the tile (+ the projection cylinder extent)
+		are indexed by a temporary octree. The normals are computed by tiles as well (unless
+		the source cloud already has an octree). However, if the core points are generated by
+		sub-sampling cloud #1, this step still requires an octree on the whole cloud #1 (a
+		temporary one is computed if none exists).
+
+		\param params parameters
+		\param errorMessage error message (if any)
+		\param outputCloud output cloud (command line mode only, i.e. if app is null)
+		\param progressCb progress callback (optional)
+		\param app main application interface (optional)
+		\return success
+	**/
+	static bool Compute(const Parameters& params,
+						QString& errorMessage,
+						ccPointCloud*& outputCloud,
+						CCCoreLib::GenericProgressCallback* progressCb = nullptr,
+						ccMainAppInterface* app = nullptr);
+
 };
 
 #endif //Q_M3C2_PROCESS_HEADER
@@ -20,6 +20,7 @@
 
 //CCCoreLib
 #include <GenericIndexedCloud.h>
+#include <GenericIndexedCloudPersist.h>
 #include <GenericProgressCallback.h>
 #include <DgmOctree.h>
 
@@ -53,7 +54,7 @@ public:
 	**/
 	static bool ComputeCorePointsNormals(	CCCoreLib::GenericIndexedCloud* corePoints,
 											NormsIndexesTableType* corePointsNormals,
-											ccGenericPointCloud* sourceCloud,
+											CCCoreLib::GenericIndexedCloudPersist* sourceCloud,
 											const std::vector<PointCoordinateType>& sortedRadii,
 											bool& invalidNormals,
 											int maxThreadCount = 0,
@@ -23,6 +23,7 @@
 
 //CCCoreLib
 #include <CloudSamplingTools.h>
+#include <ReferenceCloud.h>
 
 //qCC_plugins
 #include <ccMainAppInterface.h>
@@ -36,15 +37,22 @@
 #include <ccProgressDialog.h>
 #include <ccNormalVectors.h>
 #include <ccScalarField.h>
+#include <ccSpatialBatches.h>
 
 //Qt
 #include <QtGui>
 #include <QtCore>
 #include <QApplication>
 #include <QElapsedTimer>
-#include <QtConcurrentMap>
 #include <QMessageBox>
 
+//system
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <utility>
+
 //! Default name for M3C2 scalar fields
 static const char M3C2_DIST_SF_NAME[]			= "M3C2 distance";
 static const char DIST_UNCERTAINTY_SF_NAME[]	= "distance uncertainty";
@@ -77,7 +85,8 @@ struct PrecisionMaps
 };
 
 // Computes the uncertainty based on 'precision maps' (as scattered scalar fields)
-static double ComputePMUncertainty(CCCoreLib::DgmOctree::NeighboursSet& set, const CCVector3& N, const PrecisionMaps& PM)
+// (the neighbours indexes are relative to 'subset' if it is defined - see the tiled mode)
+static double ComputePMUncertainty(CCCoreLib::DgmOctree::NeighboursSet& set, const CCVector3& N, const PrecisionMaps& PM, const CCCoreLib::ReferenceCloud* subset)
 {
 	size_t count = set.size();
 	if (count == 0)
@@ -125,6 +134,10 @@ static double ComputePMUncertainty(CCCoreLib::DgmOctree::NeighboursSet& set, con
 	
 	assert(minIndex >= 0);
 	unsigned pointIndex = set[minIndex].pointIndex;
+	if (subset)
+	{
+		pointIndex = subset->getPointGlobalIndex(pointIndex);
+	}
 	CCVector3d sigma(	PM.sX->getValue(pointIndex) * PM.scale,
 						PM.sY->getValue(pointIndex) * PM.scale,
 						PM.sZ->getValue(pointIndex) * PM.scale);
@@ -160,12 +173,16 @@ struct M3C2Params
 	qM3C2Dialog::ExportOptions exportOption;
 	bool keepOriginalCloud = false;
 
-	//octrees
-	ccOctree::Shared cloud1Octree;
+	//octrees (on the whole clouds, or on the current tile only)
+	CCCoreLib::DgmOctree* cloud1Octree = nullptr;
 	unsigned char level1 = 0;
-	ccOctree::Shared cloud2Octree;
+	CCCoreLib::DgmOctree* cloud2Octree = nullptr;
 	unsigned char level2 = 0;
 
+	//current tile (tiled mode only)
+	CCCoreLib::ReferenceCloud* cloud1Tile = nullptr;
+	CCCoreLib::ReferenceCloud* cloud2Tile = nullptr;
+
 	//scalar fields
 	ccScalarField* m3c2DistSF = nullptr;		//M3C2 distance
 	ccScalarField* distUncertaintySF = nullptr;	//distance uncertainty
@@ -181,26 +198,52 @@ struct M3C2Params
 
 	//progress notification
 	CCCoreLib::NormalizedProgress* nProgress = nullptr;
-	bool processCanceled = false;
+	std::atomic<bool> processCanceled { false };
+};
+
+// Neighbourhood buffers reused from one core point to the next (by the same thread)
+struct M3C2Workspace
+{
+	CCCoreLib::DgmOctree::NeighboursSet neighbours1, candidates1;
+	CCCoreLib::DgmOctree::NeighboursSet neighbours2, candidates2;
 };
-static M3C2Params s_M3C2Params;
 
-void ComputeM3C2DistForPoint(unsigned index)
+//! Lends the workspace buffers to a (new) cylindrical neighbourhood structure
+static inline void AcquireBuffers(	CCCoreLib::DgmOctree::ProgressiveCylindricalNeighbourhood& cn,
+									CCCoreLib::DgmOctree::NeighboursSet& neighbours,
+									CCCoreLib::DgmOctree::NeighboursSet& candidates)
+{
+	cn.neighbours.swap(neighbours);
+	cn.neighbours.clear(); //the capacity is kept
+	cn.potentialCandidates.swap(candidates);
+	cn.potentialCandidates.clear();
+}
+
+//! Gives the buffers back to the workspace
+static inline void ReleaseBuffers(	CCCoreLib::DgmOctree::ProgressiveCylindricalNeighbourhood& cn,
+									CCCoreLib::DgmOctree::NeighboursSet& neighbours,
+									CCCoreLib::DgmOctree::NeighboursSet& candidates)
 {
-	if (s_M3C2Params.processCanceled)
+	cn.neighbours.swap(neighbours);
+	cn.potentialCandidates.swap(candidates);
+}
+
+static void ComputeM3C2DistForPoint(M3C2Params& params, unsigned index, M3C2Workspace& workspace)
+{
+	if (params.processCanceled)
 		return;
 
 	ScalarType dist = CCCoreLib::NAN_VALUE;
 
 	//get core point #i
 	CCVector3 P;
-	s_M3C2Params.corePoints->getPoint(index, P);
+	params.corePoints->getPoint(index, P);
 
 	//get core point's normal #i
 	CCVector3 N(0, 0, 1);
-	if (s_M3C2Params.updateNormal) //i.e. all cases but the VERTICAL mode
+	if (params.updateNormal) //i.e. all cases but the VERTICAL mode
 	{
-		N = ccNormalVectors::GetNormal(s_M3C2Params.coreNormals->getValue(index));
+		N = ccNormalVectors::GetNormal(params.coreNormals->getValue(index));
 	}
 
 	//output point
@@ -216,24 +259,29 @@ void ComputeM3C2DistForPoint(unsigned index)
 		CCCoreLib::DgmOctree::ProgressiveCylindricalNeighbourhood cn1;
 		cn1.center = P;
 		cn1.dir = N;
-		cn1.level = s_M3C2Params.level1;
-		cn1.maxHalfLength = s_M3C2Params.projectionDepth;
-		cn1.radius = s_M3C2Params.projectionRadius;
-		cn1.onlyPositiveDir = s_M3C2Params.onlyPositiveSearch;
+		cn1.level = params.level1;
+		cn1.maxHalfLength = params.projectionDepth;
+		cn1.radius = params.projectionRadius;
+		cn1.onlyPositiveDir = params.onlyPositiveSearch;
+		AcquireBuffers(cn1, workspace.neighbours1, workspace.candidates1);
 
-		if (s_M3C2Params.progressiveSearch)
+		if (!params.cloud1Octree)
+		{
+			//empty tile: no neighbour
+		}
+		else if (params.progressiveSearch)
 		{
 			//progressive search
 			size_t previousNeighbourCount = 0;
 			while (cn1.currentHalfLength < cn1.maxHalfLength)
 			{
-				size_t neighbourCount = s_M3C2Params.cloud1Octree->getPointsInCylindricalNeighbourhoodProgressive(cn1);
+				size_t neighbourCount = params.cloud1Octree->getPointsInCylindricalNeighbourhoodProgressive(cn1);
 				if (neighbourCount != previousNeighbourCount)
 				{
 					//do we have enough points for computing stats?
-					if (neighbourCount >= s_M3C2Params.minPoints4Stats)
+					if (neighbourCount >= params.minPoints4Stats)
 					{
-						qM3C2Tools::ComputeStatistics(cn1.neighbours, s_M3C2Params.useMedian, mean1, stdDev1);
+						qM3C2Tools::ComputeStatistics(cn1.neighbours, params.useMedian, mean1, stdDev1);
 						validStats1 = true;
 						//do we have a sharp enough 'mean' to stop?
 						if (std::abs(mean1) + 2 * stdDev1 < static_cast<double>(cn1.currentHalfLength))
@@ -245,7 +293,7 @@ void ComputeM3C2DistForPoint(unsigned index)
 		}
 		else
 		{
-			s_M3C2Params.cloud1Octree->getPointsInCylindricalNeighbourhood(cn1);
+			params.cloud1Octree->getPointsInCylindricalNeighbourhood(cn1);
 		}
 		
 		size_t n1 = cn1.neighbours.size();
@@ -254,41 +302,41 @@ void ComputeM3C2DistForPoint(unsigned index)
 			//compute stat. dispersion on cloud #1 neighbours (if necessary)
 			if (!validStats1)
 			{
-				qM3C2Tools::ComputeStatistics(cn1.neighbours, s_M3C2Params.useMedian, mean1, stdDev1);
+				qM3C2Tools::ComputeStatistics(cn1.neighbours, params.useMedian, mean1, stdDev1);
 			}
 
-			if (s_M3C2Params.usePrecisionMaps && (s_M3C2Params.computeConfidence || s_M3C2Params.stdDevCloud1SF))
+			if (params.usePrecisionMaps && (params.computeConfidence || params.stdDevCloud1SF))
 			{
 				//compute the Precision Maps derived sigma
-				stdDev1 = ComputePMUncertainty(cn1.neighbours, N, s_M3C2Params.cloud1PM);
+				stdDev1 = ComputePMUncertainty(cn1.neighbours, N, params.cloud1PM, params.cloud1Tile);
 			}
 
-			if (s_M3C2Params.exportOption == qM3C2Dialog::PROJECT_ON_CLOUD1)
+			if (params.exportOption == qM3C2Dialog::PROJECT_ON_CLOUD1)
 			{
 				//shift output point on the 1st cloud
 				outputP += static_cast<PointCoordinateType>(mean1) * N;
 			}
 
 			//save cloud #1's std. dev.
-			if (s_M3C2Params.stdDevCloud1SF)
+			if (params.stdDevCloud1SF)
 			{
 				ScalarType val = static_cast<ScalarType>(stdDev1);
-				s_M3C2Params.stdDevCloud1SF->setValue(index, val);
+				params.stdDevCloud1SF->setValue(index, val);
 			}
 		}
 
 		//save cloud #1's density
-		if (s_M3C2Params.densityCloud1SF)
+		if (params.densityCloud1SF)
 		{
 			ScalarType val = static_cast<ScalarType>(n1);
-			s_M3C2Params.densityCloud1SF->setValue(index, val);
+			params.densityCloud1SF->setValue(index, val);
 		}
 
 		//now we can process cloud #2
 		if (	n1 != 0
-			||	s_M3C2Params.exportOption == qM3C2Dialog::PROJECT_ON_CLOUD2
-			||	s_M3C2Params.stdDevCloud2SF
-			||	s_M3C2Params.densityCloud2SF
+			||	params.exportOption == qM3C2Dialog::PROJECT_ON_CLOUD2
+			||	params.stdDevCloud2SF
+			||	params.densityCloud2SF
 			)
 		{
 			double mean2 = 0;
@@ -299,24 +347,29 @@ void ComputeM3C2DistForPoint(unsigned index)
 			CCCoreLib::DgmOctree::ProgressiveCylindricalNeighbourhood cn2;
 			cn2.center = P;
 			cn2.dir = N;
-			cn2.level = s_M3C2Params.level2;
-			cn2.maxHalfLength = s_M3C2Params.projectionDepth;
-			cn2.radius = s_M3C2Params.projectionRadius;
-			cn2.onlyPositiveDir = s_M3C2Params.onlyPositiveSearch;
+			cn2.level = params.level2;
+			cn2.maxHalfLength = params.projectionDepth;
+			cn2.radius = params.projectionRadius;
+			cn2.onlyPositiveDir = params.onlyPositiveSearch;
+			AcquireBuffers(cn2, workspace.neighbours2, workspace.candidates2);
 
-			if (s_M3C2Params.progressiveSearch)
+			if (!params.cloud2Octree)
+			{
+				//empty tile: no neighbour
+			}
+			else if (params.progressiveSearch)
 			{
 				//progressive search
 				size_t previousNeighbourCount = 0;
 				while (cn2.currentHalfLength < cn2.maxHalfLength)
 				{
-					size_t neighbourCount = s_M3C2Params.cloud2Octree->getPointsInCylindricalNeighbourhoodProgressive(cn2);
+					size_t neighbourCount = params.cloud2Octree->getPointsInCylindricalNeighbourhoodProgressive(cn2);
 					if (neighbourCount != previousNeighbourCount)
 					{
 						//do we have enough points for computing stats?
-						if (neighbourCount >= s_M3C2Params.minPoints4Stats)
+						if (neighbourCount >= params.minPoints4Stats)
 						{
-							qM3C2Tools::ComputeStatistics(cn2.neighbours, s_M3C2Params.useMedian, mean2, stdDev2);
+							qM3C2Tools::ComputeStatistics(cn2.neighbours, params.useMedian, mean2, stdDev2);
 							validStats2 = true;
 							//do we have a sharp enough 'mean' to stop?
 							if (std::abs(mean2) + 2 * stdDev2 < static_cast<double>(cn2.currentHalfLength))
@@ -328,7 +381,7 @@ void ComputeM3C2DistForPoint(unsigned index)
 			}
 			else
 			{
-				s_M3C2Params.cloud2Octree->getPointsInCylindricalNeighbourhood(cn2);
+				params.cloud2Octree->getPointsInCylindricalNeighbourhood(cn2);
 			}
 
 			size_t n2 = cn2.neighbours.size();
@@ -337,38 +390,38 @@ void ComputeM3C2DistForPoint(unsigned index)
 				//compute stat. dispersion on cloud #2 neighbours (if necessary)
 				if (!validStats2)
 				{
-					qM3C2Tools::ComputeStatistics(cn2.neighbours, s_M3C2Params.useMedian, mean2, stdDev2);
+					qM3C2Tools::ComputeStatistics(cn2.neighbours, params.useMedian, mean2, stdDev2);
 				}
 				assert(stdDev2 != stdDev2 || stdDev2 >= 0); //first inequality fails if stdDev2 is NaN ;)
 
-				if (s_M3C2Params.exportOption == qM3C2Dialog::PROJECT_ON_CLOUD2)
+				if (params.exportOption == qM3C2Dialog::PROJECT_ON_CLOUD2)
 				{
 					//shift output point on the 2nd cloud
 					outputP += static_cast<PointCoordinateType>(mean2) * N;
 				}
 
-				if (s_M3C2Params.usePrecisionMaps && (s_M3C2Params.computeConfidence || s_M3C2Params.stdDevCloud2SF))
+				if (params.usePrecisionMaps && (params.computeConfidence || params.stdDevCloud2SF))
 				{
 					//compute the Precision Maps derived sigma
-					stdDev2 = ComputePMUncertainty(cn2.neighbours, N, s_M3C2Params.cloud2PM);
+					stdDev2 = ComputePMUncertainty(cn2.neighbours, N, params.cloud2PM, params.cloud2Tile);
 				}
 
 				if (n1 != 0)
 				{
 					//m3c2 dist = distance between i1 and i2 (i.e. either the mean or the median of both neighborhoods)
 					dist = static_cast<ScalarType>(mean2 - mean1);
-					s_M3C2Params.m3c2DistSF->setValue(index, dist);
+					params.m3c2DistSF->setValue(index, dist);
 
 					//confidence interval
-					if (s_M3C2Params.computeConfidence)
+					if (params.computeConfidence)
 					{
 						ScalarType LODStdDev = CCCoreLib::NAN_VALUE;
-						if (s_M3C2Params.usePrecisionMaps)
+						if (params.usePrecisionMaps)
 						{
 							LODStdDev = stdDev1*stdDev1 + stdDev2*stdDev2; //equation (2) in M3C2-PM article
 						}
 						//standard M3C2 algortihm: have we enough points for computing the confidence interval?
-						else if (n1 >= s_M3C2Params.minPoints4Stats && n2 >= s_M3C2Params.minPoints4Stats)
+						else if (n1 >= params.minPoints4Stats && n2 >= params.minPoints4Stats)
 						{
 							LODStdDev = (stdDev1*stdDev1) / n1 + (stdDev2*stdDev2) / n2;
 						}
@@ -376,19 +429,19 @@ void ComputeM3C2DistForPoint(unsigned index)
 						if (!std::isnan(LODStdDev))
 						{
 							//distance uncertainty (see eq. (1) in M3C2 article)
-							ScalarType LOD = static_cast<ScalarType>(1.96 * (sqrt(LODStdDev) + s_M3C2Params.registrationRms));
+							ScalarType LOD = static_cast<ScalarType>(1.96 * (sqrt(LODStdDev) + params.registrationRms));
 
-							if (s_M3C2Params.distUncertaintySF)
+							if (params.distUncertaintySF)
 							{
-								s_M3C2Params.distUncertaintySF->setValue(index, LOD);
+								params.distUncertaintySF->setValue(index, LOD);
 							}
 
-							if (s_M3C2Params.sigChangeSF)
+							if (params.sigChangeSF)
 							{
 								bool significant = (dist < -LOD || dist > LOD);
 								if (significant)
 								{
-									s_M3C2Params.sigChangeSF->setValue(index, SCALAR_ONE); //already equal to SCALAR_ZERO otherwise
+									params.sigChangeSF->setValue(index, SCALAR_ONE); //already equal to SCALAR_ZERO otherwise
 								}
 							}
 						}
@@ -403,145 +456,741 @@ void ComputeM3C2DistForPoint(unsigned index)
 				}
 
 				//save cloud #2's std. dev.
-				if (s_M3C2Params.stdDevCloud2SF)
+				if (params.stdDevCloud2SF)
 				{
 					ScalarType val = static_cast<ScalarType>(stdDev2);
-					s_M3C2Params.stdDevCloud2SF->setValue(index, val);
+					params.stdDevCloud2SF->setValue(index, val);
 				}
 			}
 
 			//save cloud #2's density
-			if (s_M3C2Params.densityCloud2SF)
+			if (params.densityCloud2SF)
 			{
 				ScalarType val = static_cast<ScalarType>(n2);
-				s_M3C2Params.densityCloud2SF->setValue(index, val);
+				params.densityCloud2SF->setValue(index, val);
 			}
+
+			ReleaseBuffers(cn2, workspace.neighbours2, workspace.candidates2);
 		}
+
+		ReleaseBuffers(cn1, workspace.neighbours1, workspace.candidates1);
 	}
 
 	//output point
-	if (s_M3C2Params.outputCloud != s_M3C2Params.corePoints)
+	if (params.outputCloud != params.corePoints)
 	{
-		*const_cast<CCVector3*>(s_M3C2Params.outputCloud->getPoint(index)) = outputP;
+		*const_cast<CCVector3*>(params.outputCloud->getPoint(index)) = outputP;
 	}
-	if (s_M3C2Params.exportNormal)
+	if (params.exportNormal)
 	{
-		s_M3C2Params.outputCloud->setPointNormal(index, N);
+		params.outputCloud->setPointNormal(index, N);
 	}
 
 	//progress notification
-	if (s_M3C2Params.nProgress && !s_M3C2Params.nProgress->oneStep())
+	if (params.nProgress && !params.nProgress->oneStep())
 	{
-		s_M3C2Params.processCanceled = true;
+		params.processCanceled = true;
 	}
 }
 
-bool qM3C2Process::Compute(const qM3C2Dialog& dlg, QString& errorMessage, ccPointCloud*& outputCloud, bool allowDialogs, QWidget* parentWidget/*=nullptr*/, ccMainAppInterface* app/*=nullptr*/)
+// Computes the M3C2 distances for a set of core points (in parallel if possible)
+/** The core points are processed in Morton order, by batches of contiguous points
+	(one batch = one job), so that each thread works on a compact area of the clouds
+	and reuses its neighbourhood buffers. Each core point is still processed
+	independently from the others (i.e. the results don't depend on the order).
+**/
+static void ComputeM3C2Dist(M3C2Params& params, std::vector<unsigned>& corePointIndexes, int maxThreadCount)
+{
+	//spatially ordered scheduling (not critical if it fails)
+	ccSpatialBatches::SortByMortonCode(params.corePoints, corePointIndexes);
+
+	bool useParallelStrategy = true;
+#ifdef _DEBUG
+	useParallelStrategy = false;
+#endif
+
+	if (maxThreadCount == 0)
+	{
+		maxThreadCount = QThread::idealThreadCount();
+	}
+	assert(maxThreadCount > 0 && maxThreadCount <= QThread::idealThreadCount());
+
+	if (useParallelStrategy)
+	{
+		useParallelStrategy = ccSpatialBatches::Process(static_cast<unsigned>(corePointIndexes.size()), maxThreadCount, [&](unsigned start, unsigned stop)
+		{
+			M3C2Workspace workspace;
+			for (unsigned i = start; i < stop && !params.processCanceled; ++i)
+			{
+				ComputeM3C2DistForPoint(params, corePointIndexes[i], workspace);
+			}
+		});
+	}
+
+	if (!useParallelStrategy)
+	{
+		//manually call the per-point method!
+		M3C2Workspace workspace;
+		for (unsigned index : corePointIndexes)
+		{
+			ComputeM3C2DistForPoint(params, index, workspace);
+		}
+	}
+}
+
+//! Tile visitor (see VisitTiles)
+/** \param tileCorePoints indexes of the core points inside the tile (can be re-ordered)
+	\param tile1 points of the first cloud inside the tile (+ margin)
+	\param tile2 points of the second cloud inside the tile (+ margin) - if any
+	\return false to stop the process
+**/
+using TileVisitor = std::function<bool(std::vector<unsigned>& tileCorePoints, CCCoreLib::ReferenceCloud& tile1, CCCoreLib::ReferenceCloud* tile2)>;
+
+// Visits the (XY) tiles of core points
+/** For each tile containing core points, the visitor receives the points of the cloud(s)
+	that lie inside the tile extended by a given margin. The points of the cloud(s) are
+	first sorted by strip (= one row of tiles, + margin) in a single pass.
+**/
+static bool VisitTiles(	ccGenericPointCloud* corePoints,
+						ccGenericPointCloud* cloud1,
+						ccGenericPointCloud* cloud2,
+						PointCoordinateType tileSize,
+						PointCoordinateType margin,
+						const TileVisitor& visitor,
+						QString& errorMessage)
+{
+	assert(corePoints && cloud1 && tileSize > 0);
+
+	unsigned corePointCount = corePoints->size();
+	if (corePointCount == 0)
+	{
+		return true;
+	}
+
+	CCVector3 bbMin;
+	CCVector3 bbMax;
+	corePoints->getBoundingBox(bbMin, bbMax);
+
+	unsigned tileCountX = std::max(1u, static_cast<unsigned>(std::ceil((bbMax.x - bbMin.x) / tileSize)));
+	unsigned tileCountY = std::max(1u, static_cast<unsigned>(std::ceil((bbMax.y - bbMin.y) / tileSize)));
+	if (static_cast<uint64_t>(tileCountX) * tileCountY > (1 << 24))
+	{
+		errorMessage = "Tile size is too small!";
+		return false;
+	}
+	unsigned tileCount = tileCountX * tileCountY;
+
+	auto tileIndex = [&](const CCVector3* P)
+	{
+		unsigned i = std::min(tileCountX - 1, static_cast<unsigned>((P->x - bbMin.x) / tileSize));
+		unsigned j = std::min(tileCountY - 1, static_cast<unsigned>((P->y - bbMin.y) / tileSize));
+		return j * tileCountX + i;
+	};
+
+	//sort the core points by tile (counting sort)
+	std::vector<unsigned> tileStart;
+	std::vector<unsigned> sortedCorePoints;
+	try
+	{
+		tileStart.resize(static_cast<size_t>(tileCount) + 1, 0);
+		sortedCorePoints.resize(corePointCount);
+	}
+	catch (const std::bad_alloc&)
+	{
+		errorMessage = "Not enough memory!";
+		return false;
+	}
+	{
+		for (unsigned i = 0; i < corePointCount; ++i)
+		{
+			++tileStart[tileIndex(corePoints->getPoint(i)) + 1];
+		}
+		for (unsigned t = 0; t < tileCount; ++t)
+		{
+			tileStart[t + 1] += tileStart[t];
+		}
+		std::vector<unsigned> tileFill(tileStart.begin(), tileStart.end() - 1);
+		for (unsigned i = 0; i < corePointCount; ++i)
+		{
+			sortedCorePoints[tileFill[tileIndex(corePoints->getPoint(i))]++] = i;
+		}
+	}
+
+	//whether a row of tiles contains core points
+	auto rowHasCorePoints = [&](unsigned j)
+	{
+		return (tileStart[(j + 1) * tileCountX] != tileStart[j * tileCountX]);
+	};
+
+	//sorts the points of a cloud by strip (counting sort)
+	/** A point can belong to several strips (because of the margin). Only the strips
+		with core points are considered. The returned strips are a (slight) superset
+		of the actual ones, as the points are filtered again by tile afterwards.
+	**/
+	auto sortByStrip = [&](ccGenericPointCloud* cloud, std::vector<unsigned>& stripStart, std::vector<unsigned>& stripPoints)
+	{
+		stripStart.resize(static_cast<size_t>(tileCountY) + 1, 0);
+
+		//range of strips of a point (returns false if the point is outside of all strips)
+		auto stripRange = [&](const CCVector3* P, unsigned& jMin, unsigned& jMax)
+		{
+			if (	P->x < bbMin.x - margin || P->x > bbMax.x + margin
+				||	P->z < bbMin.z - margin || P->z > bbMax.z + margin)
+			{
+				return false;
+			}
+			double dy = static_cast<double>(P->y) - bbMin.y;
+			double first = std::floor((dy - margin) / tileSize) - 1.0;
+			double last = std::floor((dy + margin) / tileSize);
+			if (last < 0.0 || first > tileCountY - 1.0)
+			{
+				return false;
+			}
+			jMin = static_cast<unsigned>(std::max(first, 0.0));
+			jMax = static_cast<unsigned>(std::min(last, tileCountY - 1.0));
+			return true;
+		};
+
+		unsigned pointCount = cloud->size();
+		for (unsigned k = 0; k < pointCount; ++k)
+		{
+			unsigned jMin = 0;
+			unsigned jMax = 0;
+			if (stripRange(cloud->getPoint(k), jMin, jMax))
+			{
+				for (unsigned j = jMin; j <= jMax; ++j)
+				{
+					if (rowHasCorePoints(j))
+					{
+						++stripStart[j + 1];
+					}
+				}
+			}
+		}
+		for (unsigned j = 0; j < tileCountY; ++j)
+		{
+			stripStart[j + 1] += stripStart[j];
+		}
+
+		stripPoints.resize(stripStart.back());
+		std::vector<unsigned> stripFill(stripStart.begin(), stripStart.end() - 1);
+		for (unsigned k = 0; k < pointCount; ++k)
+		{
+			unsigned jMin = 0;
+			unsigned jMax = 0;
+			if (stripRange(cloud->getPoint(k), jMin, jMax))
+			{
+				for (unsigned j = jMin; j <= jMax; ++j)
+				{
+					if (rowHasCorePoints(j))
+					{
+						stripPoints[stripFill[j]++] = k;
+					}
+				}
+			}
+		}
+	};
+
+	//extracts the points of a cloud inside a box
+	auto extractPoints = [](ccGenericPointCloud* cloud, const unsigned* indexes, unsigned count, const CCVector3& boxMin, const CCVector3& boxMax, std::vector<unsigned>& inside)
+	{
+		inside.clear();
+		for (unsigned k = 0; k < count; ++k)
+		{
+			unsigned index = indexes[k];
+			const CCVector3* P = cloud->getPoint(index);
+			if (	P->x >= boxMin.x && P->x <= boxMax.x
+				&&	P->y >= boxMin.y && P->y <= boxMax.y
+				&&	P->z >= boxMin.z && P->z <= boxMax.z)
+			{
+				inside.push_back(index);
+			}
+		}
+	};
+
+	//extracts the points of a cloud strip inside a box, as a reference cloud
+	auto extractTile = [&](ccGenericPointCloud* cloud, const std::vector<unsigned>& stripStart, const std::vector<unsigned>& stripPoints, unsigned j, const CCVector3& boxMin, const CCVector3& boxMax, std::vector<unsigned>& buffer, CCCoreLib::ReferenceCloud& tile)
+	{
+		extractPoints(cloud, stripPoints.data() + stripStart[j], stripStart[j + 1] - stripStart[j], boxMin, boxMax, buffer);
+		if (!buffer.empty() && !tile.reserve(static_cast<unsigned>(buffer.size())))
+		{
+			return false;
+		}
+		for (unsigned index : buffer)
+		{
+			tile.addPointIndex(index);
+		}
+		return true;
+	};
+
+	try
+	{
+		//sort the points of the cloud(s) by strip (+ margin)
+		std::vector<unsigned> stripStart1;
+		std::vector<unsigned> stripPoints1;
+		sortByStrip(cloud1, stripStart1, stripPoints1);
+		std::vector<unsigned> stripStart2;
+		std::vector<unsigned> stripPoints2;
+		if (cloud2)
+		{
+			sortByStrip(cloud2, stripStart2, stripPoints2);
+		}
+
+		std::vector<unsigned> tileIndexes;
+		std::vector<unsigned> tileCorePoints;
+
+		for (unsigned j = 0; j < tileCountY; ++j)
+		{
+			if (!rowHasCorePoints(j))
+			{
+				//no core point in this row
+				continue;
+			}
+
+			//current strip (+ margin)
+			CCVector3 stripMin(bbMin.x - margin, bbMin.y + j * tileSize - margin, bbMin.z - margin);
+			CCVector3 stripMax(bbMax.x + margin, bbMin.y + (j + 1) * tileSize + margin, bbMax.z + margin);
+
+			for (unsigned i = 0; i < tileCountX; ++i)
+			{
+				unsigned t = j * tileCountX + i;
+				if (tileStart[t + 1] == tileStart[t])
+				{
+					//no core point in this tile
+					continue;
+				}
+
+				CCVector3 tileMin(bbMin.x + i * tileSize - margin, stripMin.y, stripMin.z);
+				CCVector3 tileMax(bbMin.x + (i + 1) * tileSize + margin, stripMax.y, stripMax.z);
+
+				//extract the points of the cloud(s) in the current tile (+ margin)
+				CCCoreLib::ReferenceCloud tile1(cloud1);
+				if (!extractTile(cloud1, stripStart1, stripPoints1, j, tileMin, tileMax, tileIndexes, tile1))
+				{
+					errorMessage = "Not enough memory!";
+					return false;
+				}
+				CCCoreLib::ReferenceCloud tile2(cloud2 ? cloud2 : cloud1);
+				if (cloud2 && !extractTile(cloud2, stripStart2, stripPoints2, j, tileMin, tileMax, tileIndexes, tile2))
+				{
+					errorMessage = "Not enough memory!";
+					return false;
+				}
+
+				tileCorePoints.assign(sortedCorePoints.begin() + tileStart[t], sortedCorePoints.begin() + tileStart[t + 1]);
+				if (!visitor(tileCorePoints, tile1, cloud2 ? &tile2 : nullptr))
+				{
+					return false;
+				}
+			}
+		}
+	}
+	catch (const std::bad_alloc&)
+	{
+		errorMessage = "Not enough memory!";
+		return false;
+	}
+
+	return true;
+}
+
+// Computes the M3C2 distances by (XY) tiles of core points
+/** For each tile, only the points of both clouds that lie inside the tile (extended by
+	the projection cylinder extent) are indexed by a temporary octree.
+**/
+static bool ComputeM3C2DistByTiles(	M3C2Params& params,
+									ccPointCloud* cloud1,
+									ccPointCloud* cloud2,
+									PointCoordinateType tileSize,
+									int maxThreadCount,
+									QString& errorMessage,
+									ccMainAppInterface* app)
+{
+	assert(params.corePoints && cloud1 && cloud2 && tileSize > 0);
+
+	//any point inside the projection cylinder of a core point is inside the sphere of radius 'margin'
+	PointCoordinateType margin = std::sqrt(params.projectionRadius * params.projectionRadius + params.projectionDepth * params.projectionDepth);
+	PointCoordinateType equivalentRadius = pow(params.projectionDepth * params.projectionDepth * params.projectionRadius, CCCoreLib::PC_ONE / 3);
+
+	if (app)
+		app->dispToConsole(QString("[M3C2] Tiles: size = %1, margin = %2").arg(tileSize).arg(margin), ccMainAppInterface::STD_CONSOLE_MESSAGE);
+
+	bool success = VisitTiles(params.corePoints, cloud1, cloud2, tileSize, margin, [&](std::vector<unsigned>& tileCorePoints, CCCoreLib::ReferenceCloud& tile1, CCCoreLib::ReferenceCloud* tile2)
+	{
+		assert(tile2);
+
+		//build the (temporary) octrees
+		CCCoreLib::DgmOctree octree1(&tile1);
+		CCCoreLib::DgmOctree octree2(tile2);
+		if (tile1.size() != 0 && octree1.build() <= 0)
+		{
+			errorMessage = "Not enough memory!";
+			return false;
+		}
+		if (tile2->size() != 0 && octree2.build() <= 0)
+		{
+			errorMessage = "Not enough memory!";
+			return false;
+		}
+
+		params.cloud1Octree = (tile1.size() != 0 ? &octree1 : nullptr);
+		params.level1 = (tile1.size() != 0 ? octree1.findBestLevelForAGivenNeighbourhoodSizeExtraction(equivalentRadius) : 0);
+		params.cloud1Tile = &tile1;
+		params.cloud2Octree = (tile2->size() != 0 ? &octree2 : nullptr);
+		params.level2 = (tile2->size() != 0 ? octree2.findBestLevelForAGivenNeighbourhoodSizeExtraction(equivalentRadius) : 0);
+		params.cloud2Tile = tile2;
+
+		//process the tile core points
+		ComputeM3C2Dist(params, tileCorePoints, maxThreadCount);
+
+		params.cloud1Octree = params.cloud2Octree = nullptr;
+		params.cloud1Tile = params.cloud2Tile = nullptr;
+
+		return !params.processCanceled;
+	},
+	errorMessage);
+
+	params.cloud1Octree = params.cloud2Octree = nullptr;
+	params.cloud1Tile = params.cloud2Tile = nullptr;
+
+	//a cancellation is not an error (it is handled by the caller)
+	return success || params.processCanceled;
+}
+
+// Computes the core points normals by (XY) tiles of core points
+/** For each tile, only the points of the source cloud that lie inside the tile (extended
+	by the biggest normal radius) are indexed by a temporary octree.
+**/
+static bool ComputeCorePointsNormalsByTiles(ccPointCloud* corePoints,
+											NormsIndexesTableType* corePointsNormals,
+											ccPointCloud* sourceCloud,
+											const std::vector<PointCoordinateType>& sortedRadii,
+											PointCoordinateType tileSize,
+											bool& invalidNormals,
+											int maxThreadCount,
+											ccScalarField* normalScale,
+											CCCoreLib::GenericProgressCallback* progressCb,
+											QString& errorMessage)
+{
+	assert(corePoints && corePointsNormals && sourceCloud && !sortedRadii.empty());
+
+	invalidNormals = false;
+
+	unsigned corePointCount = corePoints->size();
+	if (!corePointsNormals->resizeSafe(corePointCount))
+	{
+		errorMessage = "Not enough memory!";
+		return false;
+	}
+	if (normalScale && !normalScale->resizeSafe(corePointCount, true, CCCoreLib::NAN_VALUE))
+	{
+		errorMessage = "Not enough memory!";
+		return false;
+	}
+
+	CCCoreLib::NormalizedProgress nProgress(progressCb, corePointCount);
+	if (progressCb)
+	{
+		if (progressCb->textCanBeEdited())
+		{
+			progressCb->setMethodTitle("Computing normals");
+			progressCb->setInfo(qPrintable(QString("Core points: %1\nSource points: %2").arg(corePointCount).arg(sourceCloud->size())));
+		}
+		progressCb->update(0);
+		progressCb->start();
+	}
+
+	//per-tile buffers
+	NormsIndexesTableType* tileNormals = new NormsIndexesTableType();
+	tileNormals->link();
+	ccScalarField* tileNormalScale = nullptr;
+	if (normalScale)
+	{
+		tileNormalScale = new ccScalarField(NORMAL_SCALE_SF_NAME);
+		tileNormalScale->link();
+	}
+
+	bool success = VisitTiles(corePoints, sourceCloud, nullptr, tileSize, sortedRadii.back(), [&](const std::vector<unsigned>& tileCorePoints, CCCoreLib::ReferenceCloud& tile, CCCoreLib::ReferenceCloud*)
+	{
+		if (tile.size() != 0)
+		{
+			CCCoreLib::ReferenceCloud tileCore(corePoints);
+			if (!tileCore.reserve(static_cast<unsigned>(tileCorePoints.size())))
+			{
+				errorMessage = "Not enough memory!";
+				return false;
+			}
+			for (unsigned index : tileCorePoints)
+			{
+				tileCore.addPointIndex(index);
+			}
+
+			//build the (temporary) octree
+			CCCoreLib::DgmOctree octree(&tile);
+			if (octree.build() <= 0)
+			{
+				errorMessage = "Not enough memory!";
+				return false;
+			}
+
+			bool tileInvalidNormals = false;
+			if (!qM3C2Normals::ComputeCorePointsNormals(&tileCore,
+														tileNormals,
+														&tile,
+														sortedRadii,
+														tileInvalidNormals,
+														maxThreadCount,
+														tileNormalScale,
+														nullptr,
+														&octree))
+			{
+				errorMessage = "Failed to compute normals!";
+				return false;
+			}
+			invalidNormals |= tileInvalidNormals;
+
+			//copy the normals (and scales) of the tile core points
+			for (unsigned k = 0; k < static_cast<unsigned>(tileCorePoints.size()); ++k)
+			{
+				corePointsNormals->setValue(tileCorePoints[k], tileNormals->getValue(k));
+				if (normalScale)
+				{
+					normalScale->setValue(tileCorePoints[k], tileNormalScale->getValue(k));
+				}
+			}
+		}
+		else
+		{
+			//no source point around these core points
+			invalidNormals = true;
+			CompressedNormType nullNormCode = ccNormalVectors::GetNormIndex(CCVector3(0, 0, 0).u);
+			for (unsigned index : tileCorePoints)
+			{
+				corePointsNormals->setValue(index, nullNormCode);
+			}
+		}
+
+		if (progressCb && !nProgress.steps(static_cast<unsigned>(tileCorePoints.size())))
+		{
+			errorMessage = "Process cancelled by user";
+			return false;
+		}
+
+		return true;
+	},
+	errorMessage);
+
+	tileNormals->release();
+	if (tileNormalScale)
+	{
+		tileNormalScale->release();
+	}
+
+	if (progressCb)
+	{
+		progressCb->stop();
+	}
+
+	return success;
+}
+
+bool qM3C2Process::GetParameters(const qM3C2Dialog& dlg, Parameters& params, QString& errorMessage, bool allowDialogs, QWidget* parentWidget/*=nullptr*/)
 {
 	errorMessage.clear();
-	outputCloud = nullptr;
+	params = Parameters();
 
 	//get the clouds in the right order
-	ccPointCloud* cloud1 = dlg.getCloud1();
-	ccPointCloud* cloud2 = dlg.getCloud2();
+	params.cloud1 = dlg.getCloud1();
+	params.cloud2 = dlg.getCloud2();
 
-	if (!cloud1 || !cloud2)
+	if (!params.cloud1 || !params.cloud2)
 	{
 		assert(false);
 		return false;
 	}
 
+	//core points
+	params.corePoints = dlg.getCorePointsCloud();
+	params.samplingDist = dlg.cpSubsamplingDoubleSpinBox->value();
+
 	//normals computation parameters
-	double normalScale = dlg.normalScaleDoubleSpinBox->value();
-	double projectionScale = dlg.cylDiameterDoubleSpinBox->value();
-	qM3C2Normals::ComputationMode normMode = dlg.getNormalsComputationMode();
-	double samplingDist = dlg.cpSubsamplingDoubleSpinBox->value();
-	ccScalarField* normalScaleSF = nullptr; //normal scale (multi-scale mode only)
+	params.normMode = dlg.getNormalsComputationMode();
+	params.normalScale = dlg.normalScaleDoubleSpinBox->value();
+	params.normMinScale = dlg.minScaleDoubleSpinBox->value();
+	params.normStep = dlg.stepScaleDoubleSpinBox->value();
+	params.normMaxScale = dlg.maxScaleDoubleSpinBox->value();
+	params.normUseCorePoints = dlg.normUseCorePointsCheckBox->isChecked();
+	params.normUsePreferredOrientation = dlg.normOriPreferredRadioButton->isChecked();
+	params.normPreferredOrientation = dlg.normOriPreferredComboBox->currentIndex();
+	if (!params.normUsePreferredOrientation)
+	{
+		params.normOrientationCloud = dlg.getNormalsOrientationCloud();
+	}
 
-	//other parameters are stored in 's_M3C2Params' for parallel call
-	s_M3C2Params = M3C2Params();
-	s_M3C2Params.projectionRadius = static_cast<PointCoordinateType>(projectionScale / 2); //we want the radius in fact ;)
-	s_M3C2Params.projectionDepth = static_cast<PointCoordinateType>(dlg.cylHalfHeightDoubleSpinBox->value());
-	s_M3C2Params.corePoints = dlg.getCorePointsCloud();
-	s_M3C2Params.registrationRms = dlg.rmsCheckBox->isChecked() ? dlg.rmsDoubleSpinBox->value() : 0.0;
-	s_M3C2Params.exportOption = dlg.getExportOption();
-	s_M3C2Params.keepOriginalCloud = dlg.keepOriginalCloud();
-	s_M3C2Params.useMedian = dlg.useMedianCheckBox->isChecked();
-	s_M3C2Params.minPoints4Stats = dlg.getMinPointsForStats();
-	s_M3C2Params.progressiveSearch = !dlg.useSinglePass4DepthCheckBox->isChecked();
-	s_M3C2Params.onlyPositiveSearch = dlg.positiveSearchOnlyCheckBox->isChecked();
+	//projection parameters
+	params.projectionScale = dlg.cylDiameterDoubleSpinBox->value();
+	params.projectionDepth = dlg.cylHalfHeightDoubleSpinBox->value();
+	params.registrationRms = dlg.rmsCheckBox->isChecked() ? dlg.rmsDoubleSpinBox->value() : 0.0;
+	params.useMedian = dlg.useMedianCheckBox->isChecked();
+	params.minPoints4Stats = dlg.getMinPointsForStats();
+	params.progressiveSearch = !dlg.useSinglePass4DepthCheckBox->isChecked();
+	params.onlyPositiveSearch = dlg.positiveSearchOnlyCheckBox->isChecked();
+
+	//export
+	params.exportOption = dlg.getExportOption();
+	params.keepOriginalCloud = dlg.keepOriginalCloud();
+	params.exportStdDevInfo = dlg.exportStdDevInfoCheckBox->isChecked();
+	params.exportDensityAtProjScale = dlg.exportDensityAtProjScaleCheckBox->isChecked();
+
+	//max thread count
+	params.maxThreadCount = dlg.getMaxThreadCount();
 
 	//precision maps
 	{
-		s_M3C2Params.usePrecisionMaps = dlg.precisionMapsGroupBox->isEnabled() && dlg.precisionMapsGroupBox->isChecked();
-		if (s_M3C2Params.usePrecisionMaps)
+		params.usePrecisionMaps = dlg.precisionMapsGroupBox->isEnabled() && dlg.precisionMapsGroupBox->isChecked();
+		if (params.usePrecisionMaps)
 		{
 			if (allowDialogs && QMessageBox::question(parentWidget, "Precision Maps", "Are you sure you want to compute the M3C2 distances with precision maps?", QMessageBox::Yes, QMessageBox::No) == QMessageBox::No)
 			{
-				s_M3C2Params.usePrecisionMaps = false;
+				params.usePrecisionMaps = false;
 				dlg.precisionMapsGroupBox->setChecked(false);
 			}
 		}
-		if (s_M3C2Params.usePrecisionMaps)
+		if (params.usePrecisionMaps)
 		{
-			s_M3C2Params.cloud1PM.sX = cloud1->getScalarField(dlg.c1SxComboBox->currentIndex());
-			s_M3C2Params.cloud1PM.sY = cloud1->getScalarField(dlg.c1SyComboBox->currentIndex());
-			s_M3C2Params.cloud1PM.sZ = cloud1->getScalarField(dlg.c1SzComboBox->currentIndex());
-			s_M3C2Params.cloud1PM.scale = dlg.pm1ScaleDoubleSpinBox->value();
+			params.cloud1PM[0] = params.cloud1->getScalarField(dlg.c1SxComboBox->currentIndex());
+			params.cloud1PM[1] = params.cloud1->getScalarField(dlg.c1SyComboBox->currentIndex());
+			params.cloud1PM[2] = params.cloud1->getScalarField(dlg.c1SzComboBox->currentIndex());
+			params.cloud1PMScale = dlg.pm1ScaleDoubleSpinBox->value();
 
-			s_M3C2Params.cloud2PM.sX = cloud2->getScalarField(dlg.c2SxComboBox->currentIndex());
-			s_M3C2Params.cloud2PM.sY = cloud2->getScalarField(dlg.c2SyComboBox->currentIndex());
-			s_M3C2Params.cloud2PM.sZ = cloud2->getScalarField(dlg.c2SzComboBox->currentIndex());
-			s_M3C2Params.cloud2PM.scale = dlg.pm2ScaleDoubleSpinBox->value();
+			params.cloud2PM[0] = params.cloud2->getScalarField(dlg.c2SxComboBox->currentIndex());
+			params.cloud2PM[1] = params.cloud2->getScalarField(dlg.c2SyComboBox->currentIndex());
+			params.cloud2PM[2] = params.cloud2->getScalarField(dlg.c2SzComboBox->currentIndex());
+			params.cloud2PMScale = dlg.pm2ScaleDoubleSpinBox->value();
 
-			if (!s_M3C2Params.cloud1PM.valid() || !s_M3C2Params.cloud2PM.valid())
+			for (unsigned i = 0; i < 3; ++i)
 			{
-				errorMessage = "Invalid 'Precision maps' settings!";
-				return false;
+				if (!params.cloud1PM[i] || !params.cloud2PM[i])
+				{
+					errorMessage = "Invalid 'Precision maps' settings!";
+					return false;
+				}
 			}
 		}
 	}
 
+	return true;
+}
 
-	//max thread count
-	int maxThreadCount = dlg.getMaxThreadCount();
+bool qM3C2Process::Compute(const qM3C2Dialog& dlg, QString& errorMessage, ccPointCloud*& outputCloud, bool allowDialogs, QWidget* parentWidget/*=nullptr*/, ccMainAppInterface* app/*=nullptr*/)
+{
+	outputCloud = nullptr;
+
+	Parameters params;
+	if (!GetParameters(dlg, params, errorMessage, allowDialogs, parentWidget))
+	{
+		return false;
+	}
 
 	//progress dialog
 	ccProgressDialog pDlg(parentWidget);
 
+	return Compute(params, errorMessage, outputCloud, &pDlg, app);
+}
+
+bool qM3C2Process::Compute(const Parameters& inputParams, QString& errorMessage, ccPointCloud*& outputCloud, CCCoreLib::GenericProgressCallback* progressCb/*=nullptr*/, ccMainAppInterface* app/*=nullptr*/)
+{
+	errorMessage.clear();
+	outputCloud = nullptr;
+
+	ccPointCloud* cloud1 = inputParams.cloud1;
+	ccPointCloud* cloud2 = inputParams.cloud2;
+
+	if (!cloud1 || !cloud2)
+	{
+		assert(false);
+		return false;
+	}
+
+	//normals computation parameters
+	double normalScale = inputParams.normalScale;
+	double projectionScale = inputParams.projectionScale;
+	qM3C2Normals::ComputationMode normMode = inputParams.normMode;
+	double samplingDist = inputParams.samplingDist;
+	ccScalarField* normalScaleSF = nullptr; //normal scale (multi-scale mode only)
+	bool tiledMode = (inputParams.tileSize > 0);
+
+	//other parameters are stored in 'params' for parallel call
+	M3C2Params params;
+	params.projectionRadius = static_cast<PointCoordinateType>(projectionScale / 2); //we want the radius in fact ;)
+	params.projectionDepth = static_cast<PointCoordinateType>(inputParams.projectionDepth);
+	params.corePoints = inputParams.corePoints;
+	params.registrationRms = inputParams.registrationRms;
+	params.exportOption = inputParams.exportOption;
+	params.keepOriginalCloud = inputParams.keepOriginalCloud;
+	params.useMedian = inputParams.useMedian;
+	params.minPoints4Stats = inputParams.minPoints4Stats;
+	params.progressiveSearch = inputParams.progressiveSearch;
+	params.onlyPositiveSearch = inputParams.onlyPositiveSearch;
+
+	//precision maps
+	params.usePrecisionMaps = inputParams.usePrecisionMaps;
+	if (params.usePrecisionMaps)
+	{
+		params.cloud1PM.sX = inputParams.cloud1PM[0];
+		params.cloud1PM.sY = inputParams.cloud1PM[1];
+		params.cloud1PM.sZ = inputParams.cloud1PM[2];
+		params.cloud1PM.scale = inputParams.cloud1PMScale;
+
+		params.cloud2PM.sX = inputParams.cloud2PM[0];
+		params.cloud2PM.sY = inputParams.cloud2PM[1];
+		params.cloud2PM.sZ = inputParams.cloud2PM[2];
+		params.cloud2PM.scale = inputParams.cloud2PMScale;
+
+		if (!params.cloud1PM.valid() || !params.cloud2PM.valid())
+		{
+			errorMessage = "Invalid 'Precision maps' settings!";
+			return false;
+		}
+	}
+
+	//max thread count
+	int maxThreadCount = inputParams.maxThreadCount;
+
 	//Duration: initialization & normals computation
 	QElapsedTimer initTimer;
 	initTimer.start();
 
 	//compute octree(s) if necessary
-	s_M3C2Params.cloud1Octree = cloud1->getOctree();
-	if (!s_M3C2Params.cloud1Octree)
+	//(in tiled mode, temporary octrees are computed on each tile instead)
+	ccOctree::Shared cloud1Octree = cloud1->getOctree();
+	if (!cloud1Octree && !tiledMode)
 	{
-		s_M3C2Params.cloud1Octree = cloud1->computeOctree(&pDlg);
-		if (s_M3C2Params.cloud1Octree && cloud1->getParent() && app)
+		cloud1Octree = cloud1->computeOctree(progressCb);
+		if (cloud1Octree && cloud1->getParent() && app)
 		{
 			app->addToDB(cloud1->getOctreeProxy());
 		}
-	}
-	if (!s_M3C2Params.cloud1Octree)
-	{
-		errorMessage = "Failed to compute cloud #1's octree!";
-		return false;
+		if (!cloud1Octree)
+		{
+			errorMessage = "Failed to compute cloud #1's octree!";
+			return false;
+		}
 	}
 
-	s_M3C2Params.cloud2Octree = cloud2->getOctree();
-	if (!s_M3C2Params.cloud2Octree)
+	ccOctree::Shared cloud2Octree = cloud2->getOctree();
+	if (!cloud2Octree && !tiledMode)
 	{
-		s_M3C2Params.cloud2Octree = cloud2->computeOctree(&pDlg);
-		if (s_M3C2Params.cloud2Octree && cloud2->getParent() && app)
+		cloud2Octree = cloud2->computeOctree(progressCb);
+		if (cloud2Octree && cloud2->getParent() && app)
 		{
 			app->addToDB(cloud2->getOctreeProxy());
 		}
-	}
-	if (!s_M3C2Params.cloud2Octree)
-	{
-		errorMessage = "Failed to compute cloud #2's octree!";
-		return false;
+		if (!cloud2Octree)
+		{
+			errorMessage = "Failed to compute cloud #2's octree!";
+			return false;
+		}
 	}
 
 	//start the job
@@ -549,33 +1198,34 @@ bool qM3C2Process::Compute(const qM3C2Dialog& dlg, QString& errorMessage, ccPoin
 
 	//should we generate the core points?
 	bool corePointsHaveBeenSubsampled = false;
-	if (!s_M3C2Params.corePoints && samplingDist > 0)
+	if (!params.corePoints && samplingDist > 0)
 	{
+		//(in tiled mode, a temporary octree is computed on the whole cloud #1 if it doesn't have one)
 		CCCoreLib::CloudSamplingTools::SFModulationParams modParams(false);
 		CCCoreLib::ReferenceCloud* subsampled = CCCoreLib::CloudSamplingTools::resampleCloudSpatially(cloud1,
 			static_cast<PointCoordinateType>(samplingDist),
 			modParams,
-			s_M3C2Params.cloud1Octree.data(),
-			&pDlg);
+			cloud1Octree.data(),
+			progressCb);
 
 		if (subsampled)
 		{
-			s_M3C2Params.corePoints = static_cast<ccPointCloud*>(cloud1)->partialClone(subsampled);
+			params.corePoints = static_cast<ccPointCloud*>(cloud1)->partialClone(subsampled);
 
 			//don't need those references anymore
 			delete subsampled;
 			subsampled = nullptr;
 		}
 
-		if (s_M3C2Params.corePoints)
+		if (params.corePoints)
 		{
-			s_M3C2Params.corePoints->setName(QString("%1.subsampled [min dist. = %2]").arg(cloud1->getName()).arg(samplingDist));
-			s_M3C2Params.corePoints->setVisible(true);
-			s_M3C2Params.corePoints->setDisplay(cloud1->getDisplay());
+			params.corePoints->setName(QString("%1.subsampled [min dist. = %2]").arg(cloud1->getName()).arg(samplingDist));
+			params.corePoints->setVisible(true);
+			params.corePoints->setDisplay(cloud1->getDisplay());
 			if (app)
 			{
-				app->dispToConsole(QString("[M3C2] Sub-sampled cloud has been saved ('%1')").arg(s_M3C2Params.corePoints->getName()), ccMainAppInterface::STD_CONSOLE_MESSAGE);
-				app->addToDB(s_M3C2Params.corePoints);
+				app->dispToConsole(QString("[M3C2] Sub-sampled cloud has been saved ('%1')").arg(params.corePoints->getName()), ccMainAppInterface::STD_CONSOLE_MESSAGE);
+				app->addToDB(params.corePoints);
 			}
 			corePointsHaveBeenSubsampled = true;
 		}
@@ -587,28 +1237,28 @@ bool qM3C2Process::Compute(const qM3C2Dialog& dlg, QString& errorMessage, ccPoin
 	}
 
 	//output
-	QString outputName(s_M3C2Params.usePrecisionMaps ? "M3C2-PM output" : "M3C2 output");
+	QString outputName(params.usePrecisionMaps ? "M3C2-PM output" : "M3C2 output");
 
 	if (!error)
 	{
 		//whatever the case, at this point we should have core points
-		assert(s_M3C2Params.corePoints);
+		assert(params.corePoints);
 		if (app)
-			app->dispToConsole(QString("[M3C2] Core points: %1").arg(s_M3C2Params.corePoints->size()), ccMainAppInterface::STD_CONSOLE_MESSAGE);
+			app->dispToConsole(QString("[M3C2] Core points: %1").arg(params.corePoints->size()), ccMainAppInterface::STD_CONSOLE_MESSAGE);
 
-		if (s_M3C2Params.keepOriginalCloud)
+		if (params.keepOriginalCloud)
 		{
-			s_M3C2Params.outputCloud = s_M3C2Params.corePoints;
+			params.outputCloud = params.corePoints;
 		}
 		else
 		{
-			s_M3C2Params.outputCloud = new ccPointCloud(/*outputName*/); //setName will be called at the end
-			if (!s_M3C2Params.outputCloud->resize(s_M3C2Params.corePoints->size())) //resize as we will 'set' the new points positions in 'ComputeM3C2DistForPoint'
+			params.outputCloud = new ccPointCloud(/*outputName*/); //setName will be called at the end
+			if (!params.outputCloud->resize(params.corePoints->size())) //resize as we will 'set' the new points positions in 'ComputeM3C2DistForPoint'
 			{
 				errorMessage = "Not enough memory!";
 				error = true;
 			}
-			s_M3C2Params.corePoints->setEnabled(false); //we can hide the core points
+			params.corePoints->setEnabled(false); //we can hide the core points
 		}
 	}
 
@@ -616,7 +1266,7 @@ bool qM3C2Process::Compute(const qM3C2Dialog& dlg, QString& errorMessage, ccPoin
 	if (!error)
 	{
 		bool normalsAreOk = false;
-		bool useCorePointsOnly = dlg.normUseCorePointsCheckBox->isChecked();
+		bool useCorePointsOnly = inputParams.normUseCorePoints;
 
 		switch (normMode)
 		{
@@ -625,16 +1275,16 @@ bool qM3C2Process::Compute(const qM3C2Dialog& dlg, QString& errorMessage, ccPoin
 		case qM3C2Normals::DEFAULT_MODE:
 		case qM3C2Normals::MULTI_SCALE_MODE:
 		{
-			s_M3C2Params.coreNormals = new NormsIndexesTableType();
-			s_M3C2Params.coreNormals->link(); //will be released anyway at the end of the process
+			params.coreNormals = new NormsIndexesTableType();
+			params.coreNormals->link(); //will be released anyway at the end of the process
 
 			std::vector<PointCoordinateType> radii;
 			if (normMode == qM3C2Normals::MULTI_SCALE_MODE)
 			{
 				//get multi-scale parameters
-				double startScale = dlg.minScaleDoubleSpinBox->value();
-				double step = dlg.stepScaleDoubleSpinBox->value();
-				double stopScale = dlg.maxScaleDoubleSpinBox->value();
+				double startScale = inputParams.normMinScale;
+				double step = inputParams.normStep;
+				double stopScale = inputParams.normMaxScale;
 				stopScale = std::max(startScale, stopScale); //just to be sure
 				//generate all corresponding 'scales'
 				for (double scale = startScale; scale <= stopScale; scale += step)
@@ -655,19 +1305,36 @@ bool qM3C2Process::Compute(const qM3C2Dialog& dlg, QString& errorMessage, ccPoin
 			}
 
 			bool invalidNormals = false;
-			ccPointCloud* baseCloud = (useCorePointsOnly ? s_M3C2Params.corePoints : cloud1);
-			ccOctree* baseOctree = (baseCloud == cloud1 ? s_M3C2Params.cloud1Octree.data() : nullptr);
-
-			//dedicated core points method
-			normalsAreOk = qM3C2Normals::ComputeCorePointsNormals(s_M3C2Params.corePoints,
-				s_M3C2Params.coreNormals,
-				baseCloud,
-				radii,
-				invalidNormals,
-				maxThreadCount,
-				normalScaleSF,
-				&pDlg,
-				baseOctree);
+			ccPointCloud* baseCloud = (useCorePointsOnly ? params.corePoints : cloud1);
+			ccOctree* baseOctree = (baseCloud == cloud1 ? cloud1Octree.data() : nullptr);
+
+			if (tiledMode && !baseOctree)
+			{
+				//the normals are computed by tiles as well (with a temporary octree per tile)
+				normalsAreOk = ComputeCorePointsNormalsByTiles(	params.corePoints,
+																params.coreNormals,
+																baseCloud,
+																radii,
+																static_cast<PointCoordinateType>(inputParams.tileSize),
+																invalidNormals,
+																maxThreadCount,
+																normalScaleSF,
+																progressCb,
+																errorMessage);
+			}
+			else
+			{
+				//dedicated core points method
+				normalsAreOk = qM3C2Normals::ComputeCorePointsNormals(params.corePoints,
+					params.coreNormals,
+					baseCloud,
+					radii,
+					invalidNormals,
+					maxThreadCount,
+					normalScaleSF,
+					progressCb,
+					baseOctree);
+			}
 
 			//now fix the orientation
 			if (normalsAreOk)
@@ -681,17 +1348,16 @@ bool qM3C2Process::Compute(const qM3C2Dialog& dlg, QString& errorMessage, ccPoin
 				//make normals horizontal if necessary
 				if (normMode == qM3C2Normals::HORIZ_MODE)
 				{
-					qM3C2Normals::MakeNormalsHorizontal(*s_M3C2Params.coreNormals);
+					qM3C2Normals::MakeNormalsHorizontal(*params.coreNormals);
 				}
 
 				//then either use a simple heuristic
-				bool usePreferredOrientation = dlg.normOriPreferredRadioButton->isChecked();
-				if (usePreferredOrientation)
+				if (inputParams.normUsePreferredOrientation)
 				{
-					int preferredOrientation = dlg.normOriPreferredComboBox->currentIndex();
+					int preferredOrientation = inputParams.normPreferredOrientation;
 					assert(preferredOrientation >= ccNormalVectors::PLUS_X && preferredOrientation <= ccNormalVectors::MINUS_SENSOR_ORIGIN);
-					if (!ccNormalVectors::UpdateNormalOrientations(	s_M3C2Params.corePoints,
-																	*s_M3C2Params.coreNormals,
+					if (!ccNormalVectors::UpdateNormalOrientations(	params.corePoints,
+																	*params.coreNormals,
 																	static_cast<ccNormalVectors::Orientation>(preferredOrientation))
 						)
 					{
@@ -701,14 +1367,14 @@ bool qM3C2Process::Compute(const qM3C2Dialog& dlg, QString& errorMessage, ccPoin
 				}
 				else //or use external points
 				{
-					ccPointCloud* orientationCloud = dlg.getNormalsOrientationCloud();
+					ccPointCloud* orientationCloud = inputParams.normOrientationCloud;
 					assert(orientationCloud);
 
-					if (!qM3C2Normals::UpdateNormalOrientationsWithCloud(	s_M3C2Params.corePoints,
-																			*s_M3C2Params.coreNormals,
+					if (!qM3C2Normals::UpdateNormalOrientationsWithCloud(	params.corePoints,
+																			*params.coreNormals,
 																			orientationCloud,
 																			maxThreadCount,
-																			&pDlg)
+																			progressCb)
 						)
 					{
 						errorMessage = "[M3C2] Failed to re-orient the normals with input point cloud!";
@@ -716,10 +1382,10 @@ bool qM3C2Process::Compute(const qM3C2Dialog& dlg, QString& errorMessage, ccPoin
 					}
 				}
 
-				if (!error && s_M3C2Params.coreNormals)
+				if (!error && params.coreNormals)
 				{
-					s_M3C2Params.outputCloud->setNormsTable(s_M3C2Params.coreNormals);
-					s_M3C2Params.outputCloud->showNormals(true);
+					params.outputCloud->setNormsTable(params.coreNormals);
+					params.outputCloud->showNormals(true);
 				}
 			}
 		}
@@ -728,10 +1394,10 @@ bool qM3C2Process::Compute(const qM3C2Dialog& dlg, QString& errorMessage, ccPoin
 		case qM3C2Normals::USE_CLOUD1_NORMALS:
 		{
 			outputName += QString(" scale=%1").arg(normalScale);
-			ccPointCloud* sourceCloud = (corePointsHaveBeenSubsampled ? s_M3C2Params.corePoints : cloud1);
-			s_M3C2Params.coreNormals = sourceCloud->normals();
-			normalsAreOk = (s_M3C2Params.coreNormals && s_M3C2Params.coreNormals->currentSize() == sourceCloud->size());
-			s_M3C2Params.coreNormals->link(); //will be released anyway at the end of the process
+			ccPointCloud* sourceCloud = (corePointsHaveBeenSubsampled ? params.corePoints : cloud1);
+			params.coreNormals = sourceCloud->normals();
+			normalsAreOk = (params.coreNormals && params.coreNormals->currentSize() == sourceCloud->size());
+			params.coreNormals->link(); //will be released anyway at the end of the process
 
 			//DGM TODO: should we export the normals to the output cloud?
 		}
@@ -739,11 +1405,11 @@ bool qM3C2Process::Compute(const qM3C2Dialog& dlg, QString& errorMessage, ccPoin
 
 		case qM3C2Normals::USE_CORE_POINTS_NORMALS:
 		{
-			normalsAreOk = s_M3C2Params.corePoints && s_M3C2Params.corePoints->hasNormals();
+			normalsAreOk = params.corePoints && params.corePoints->hasNormals();
 			if (normalsAreOk)
 			{
-				s_M3C2Params.coreNormals = s_M3C2Params.corePoints->normals();
-				s_M3C2Params.coreNormals->link(); //will be released anyway at the end of the process
+				params.coreNormals = params.corePoints->normals();
+				params.coreNormals->link(); //will be released anyway at the end of the process
 			}
 		}
 		break;
@@ -761,18 +1427,19 @@ bool qM3C2Process::Compute(const qM3C2Dialog& dlg, QString& errorMessage, ccPoin
 
 		if (!normalsAreOk)
 		{
-			errorMessage = "Failed to compute normals!";
+			if (errorMessage.isEmpty())
+				errorMessage = "Failed to compute normals!";
 			error = true;
 		}
 	}
 
-	if (!error && s_M3C2Params.coreNormals && corePointsHaveBeenSubsampled)
+	if (!error && params.coreNormals && corePointsHaveBeenSubsampled)
 	{
-		if (s_M3C2Params.corePoints->hasNormals() || s_M3C2Params.corePoints->resizeTheNormsTable())
+		if (params.corePoints->hasNormals() || params.corePoints->resizeTheNormsTable())
 		{
-			for (unsigned i = 0; i < s_M3C2Params.coreNormals->currentSize(); ++i)
-				s_M3C2Params.corePoints->setPointNormalIndex(i, s_M3C2Params.coreNormals->getValue(i));
-			s_M3C2Params.corePoints->showNormals(true);
+			for (unsigned i = 0; i < params.coreNormals->currentSize(); ++i)
+				params.corePoints->setPointNormalIndex(i, params.coreNormals->getValue(i));
+			params.corePoints->showNormals(true);
 		}
 		else if (app)
 		{
@@ -792,174 +1459,171 @@ bool qM3C2Process::Compute(const qM3C2Dialog& dlg, QString& errorMessage, ccPoin
 		distCompTimer.start();
 
 		//we are either in vertical mode or we have as many normals as core points
-		unsigned corePointCount = s_M3C2Params.corePoints->size();
-		assert(normMode == qM3C2Normals::VERT_MODE || (s_M3C2Params.coreNormals && corePointCount == s_M3C2Params.coreNormals->currentSize()));
+		unsigned corePointCount = params.corePoints->size();
+		assert(normMode == qM3C2Normals::VERT_MODE || (params.coreNormals && corePointCount == params.coreNormals->currentSize()));
 
-		pDlg.reset();
-		CCCoreLib::NormalizedProgress nProgress(&pDlg, corePointCount);
-		pDlg.setMethodTitle(QObject::tr("M3C2 Distances Computation"));
-		pDlg.setInfo(QObject::tr("Core points: %1").arg(corePointCount));
-		pDlg.start();
-		s_M3C2Params.nProgress = &nProgress;
+		CCCoreLib::NormalizedProgress nProgress(progressCb, corePointCount);
+		if (progressCb)
+		{
+			if (progressCb->textCanBeEdited())
+			{
+				progressCb->setMethodTitle(qPrintable(QObject::tr("M3C2 Distances Computation")));
+				progressCb->setInfo(qPrintable(QObject::tr("Core points: %1").arg(corePointCount)));
+			}
+			progressCb->update(0);
+			progressCb->start();
+		}
+		params.nProgress = progressCb ? &nProgress : nullptr;
 
 		//allocate distances SF
-		s_M3C2Params.m3c2DistSF = new ccScalarField(M3C2_DIST_SF_NAME);
-		s_M3C2Params.m3c2DistSF->link();
-		if (!s_M3C2Params.m3c2DistSF->resizeSafe(corePointCount, true, CCCoreLib::NAN_VALUE))
+		params.m3c2DistSF = new ccScalarField(M3C2_DIST_SF_NAME);
+		params.m3c2DistSF->link();
+		if (!params.m3c2DistSF->resizeSafe(corePointCount, true, CCCoreLib::NAN_VALUE))
 		{
 			errorMessage = "Failed to allocate memory for distance values!";
 			error = true;
 			break;
 		}
 		//allocate dist. uncertainty SF
-		s_M3C2Params.distUncertaintySF = new ccScalarField(DIST_UNCERTAINTY_SF_NAME);
-		s_M3C2Params.distUncertaintySF->link();
-		if (!s_M3C2Params.distUncertaintySF->resizeSafe(corePointCount, true, CCCoreLib::NAN_VALUE))
+		params.distUncertaintySF = new ccScalarField(DIST_UNCERTAINTY_SF_NAME);
+		params.distUncertaintySF->link();
+		if (!params.distUncertaintySF->resizeSafe(corePointCount, true, CCCoreLib::NAN_VALUE))
 		{
 			errorMessage = "Failed to allocate memory for dist. uncertainty values!";
 			error = true;
 			break;
 		}
 		//allocate change significance SF
-		s_M3C2Params.sigChangeSF = new ccScalarField(SIG_CHANGE_SF_NAME);
-		s_M3C2Params.sigChangeSF->link();
-		if (!s_M3C2Params.sigChangeSF->resizeSafe(corePointCount, true, SCALAR_ZERO))
+		params.sigChangeSF = new ccScalarField(SIG_CHANGE_SF_NAME);
+		params.sigChangeSF->link();
+		if (!params.sigChangeSF->resizeSafe(corePointCount, true, SCALAR_ZERO))
 		{
 			if (app)
 				app->dispToConsole("Failed to allocate memory for change significance values!", ccMainAppInterface::WRN_CONSOLE_MESSAGE);
-			s_M3C2Params.sigChangeSF->release();
-			s_M3C2Params.sigChangeSF = nullptr;
+			params.sigChangeSF->release();
+			params.sigChangeSF = nullptr;
 			//no need to stop just for this SF!
 			//error = true;
 			//break;
 		}
 
-		if (dlg.exportStdDevInfoCheckBox->isChecked())
+		if (inputParams.exportStdDevInfo)
 		{
 			QString prefix("STD");
-			if (s_M3C2Params.usePrecisionMaps)
+			if (params.usePrecisionMaps)
 			{
 				prefix = "SigmaN";
 			}
-			else if (s_M3C2Params.useMedian)
+			else if (params.useMedian)
 			{
 				prefix = "IQR";
 			}
 			//allocate cloud #1 std. dev. SF
 			QString stdDevSFName1 = QString(STD_DEV_CLOUD1_SF_NAME).arg(prefix);
-			s_M3C2Params.stdDevCloud1SF = new ccScalarField(qPrintable(stdDevSFName1));
-			s_M3C2Params.stdDevCloud1SF->link();
-			if (!s_M3C2Params.stdDevCloud1SF->resizeSafe(corePointCount, true, CCCoreLib::NAN_VALUE))
+			params.stdDevCloud1SF = new ccScalarField(qPrintable(stdDevSFName1));
+			params.stdDevCloud1SF->link();
+			if (!params.stdDevCloud1SF->resizeSafe(corePointCount, true, CCCoreLib::NAN_VALUE))
 			{
 				if (app)
 					app->dispToConsole("Failed to allocate memory for cloud #1 std. dev. values!", ccMainAppInterface::WRN_CONSOLE_MESSAGE);
-				s_M3C2Params.stdDevCloud1SF->release();
-				s_M3C2Params.stdDevCloud1SF = nullptr;
+				params.stdDevCloud1SF->release();
+				params.stdDevCloud1SF = nullptr;
 			}
 			//allocate cloud #2 std. dev. SF
 			QString stdDevSFName2 = QString(STD_DEV_CLOUD2_SF_NAME).arg(prefix);
-			s_M3C2Params.stdDevCloud2SF = new ccScalarField(qPrintable(stdDevSFName2));
-			s_M3C2Params.stdDevCloud2SF->link();
-			if (!s_M3C2Params.stdDevCloud2SF->resizeSafe(corePointCount, true, CCCoreLib::NAN_VALUE))
+			params.stdDevCloud2SF = new ccScalarField(qPrintable(stdDevSFName2));
+			params.stdDevCloud2SF->link();
+			if (!params.stdDevCloud2SF->resizeSafe(corePointCount, true, CCCoreLib::NAN_VALUE))
 			{
 				if (app)
 					app->dispToConsole("Failed to allocate memory for cloud #2 std. dev. values!", ccMainAppInterface::WRN_CONSOLE_MESSAGE);
-				s_M3C2Params.stdDevCloud2SF->release();
-				s_M3C2Params.stdDevCloud2SF = nullptr;
+				params.stdDevCloud2SF->release();
+				params.stdDevCloud2SF = nullptr;
 			}
 		}
-		if (dlg.exportDensityAtProjScaleCheckBox->isChecked())
+		if (inputParams.exportDensityAtProjScale)
 		{
 			//allocate cloud #1 density SF
-			s_M3C2Params.densityCloud1SF = new ccScalarField(DENSITY_CLOUD1_SF_NAME);
-			s_M3C2Params.densityCloud1SF->link();
-			if (!s_M3C2Params.densityCloud1SF->resizeSafe(corePointCount, true, CCCoreLib::NAN_VALUE))
+			params.densityCloud1SF = new ccScalarField(DENSITY_CLOUD1_SF_NAME);
+			params.densityCloud1SF->link();
+			if (!params.densityCloud1SF->resizeSafe(corePointCount, true, CCCoreLib::NAN_VALUE))
 			{
 				if (app)
 					app->dispToConsole("Failed to allocate memory for cloud #1 density values!", ccMainAppInterface::WRN_CONSOLE_MESSAGE);
-				s_M3C2Params.densityCloud1SF->release();
-				s_M3C2Params.densityCloud1SF = nullptr;
+				params.densityCloud1SF->release();
+				params.densityCloud1SF = nullptr;
 			}
 			//allocate cloud #2 density SF
-			s_M3C2Params.densityCloud2SF = new ccScalarField(DENSITY_CLOUD2_SF_NAME);
-			s_M3C2Params.densityCloud2SF->link();
-			if (!s_M3C2Params.densityCloud2SF->resizeSafe(corePointCount, true, CCCoreLib::NAN_VALUE))
+			params.densityCloud2SF = new ccScalarField(DENSITY_CLOUD2_SF_NAME);
+			params.densityCloud2SF->link();
+			if (!params.densityCloud2SF->resizeSafe(corePointCount, true, CCCoreLib::NAN_VALUE))
 			{
 				if (app)
 					app->dispToConsole("Failed to allocate memory for cloud #2 density values!", ccMainAppInterface::WRN_CONSOLE_MESSAGE);
-				s_M3C2Params.densityCloud2SF->release();
-				s_M3C2Params.densityCloud2SF = nullptr;
+				params.densityCloud2SF->release();
+				params.densityCloud2SF = nullptr;
 			}
 		}
 
-		//get best levels for neighbourhood extraction on both octrees
-		assert(s_M3C2Params.cloud1Octree && s_M3C2Params.cloud2Octree);
-		PointCoordinateType equivalentRadius = pow(s_M3C2Params.projectionDepth * s_M3C2Params.projectionDepth * s_M3C2Params.projectionRadius, CCCoreLib::PC_ONE / 3);
-		s_M3C2Params.level1 = s_M3C2Params.cloud1Octree->findBestLevelForAGivenNeighbourhoodSizeExtraction(equivalentRadius);
-		if (app)
-			app->dispToConsole(QString("[M3C2] Working subdivision level (cloud #1): %1").arg(s_M3C2Params.level1), ccMainAppInterface::STD_CONSOLE_MESSAGE);
-
-		s_M3C2Params.level2 = s_M3C2Params.cloud2Octree->findBestLevelForAGivenNeighbourhoodSizeExtraction(equivalentRadius);
-		if (app)
-			app->dispToConsole(QString("[M3C2] Working subdivision level (cloud #2): %1").arg(s_M3C2Params.level2), ccMainAppInterface::STD_CONSOLE_MESSAGE);
-
 		//other options
-		s_M3C2Params.updateNormal = (normMode != qM3C2Normals::VERT_MODE);
-		s_M3C2Params.exportNormal = s_M3C2Params.updateNormal && !s_M3C2Params.outputCloud->hasNormals();
-		if (s_M3C2Params.exportNormal && !s_M3C2Params.outputCloud->resizeTheNormsTable()) //resize because we will 'set' the normal in ComputeM3C2DistForPoint
+		params.updateNormal = (normMode != qM3C2Normals::VERT_MODE);
+		params.exportNormal = params.updateNormal && !params.outputCloud->hasNormals();
+		if (params.exportNormal && !params.outputCloud->resizeTheNormsTable()) //resize because we will 'set' the normal in ComputeM3C2DistForPoint
 		{
 			if (app)
 				app->dispToConsole("Failed to allocate memory for exporting normals!", ccMainAppInterface::WRN_CONSOLE_MESSAGE);
-			s_M3C2Params.exportNormal = false;
+			params.exportNormal = false;
 		}
-		s_M3C2Params.computeConfidence = (s_M3C2Params.distUncertaintySF || s_M3C2Params.sigChangeSF);
+		params.computeConfidence = (params.distUncertaintySF || params.sigChangeSF);
 
 		//compute distances
+		if (tiledMode)
 		{
-			std::vector<unsigned> pointIndexes;
-			bool useParallelStrategy = true;
-#ifdef _DEBUG
-			useParallelStrategy = false;
-#endif
-			if (useParallelStrategy)
+			if (!ComputeM3C2DistByTiles(params, cloud1, cloud2, static_cast<PointCoordinateType>(inputParams.tileSize), maxThreadCount, errorMessage, app))
 			{
-				try
-				{
-					pointIndexes.resize(corePointCount);
-				}
-				catch (const std::bad_alloc&)
-				{
-					//not enough memory
-					useParallelStrategy = false;
-				}
+				error = true;
+				break;
 			}
+		}
+		else
+		{
+			//get best levels for neighbourhood extraction on both octrees
+			assert(cloud1Octree && cloud2Octree);
+			PointCoordinateType equivalentRadius = pow(params.projectionDepth * params.projectionDepth * params.projectionRadius, CCCoreLib::PC_ONE / 3);
+			params.cloud1Octree = cloud1Octree.data();
+			params.level1 = cloud1Octree->findBestLevelForAGivenNeighbourhoodSizeExtraction(equivalentRadius);
+			if (app)
+				app->dispToConsole(QString("[M3C2] Working subdivision level (cloud #1): %1").arg(params.level1), ccMainAppInterface::STD_CONSOLE_MESSAGE);
+
+			params.cloud2Octree = cloud2Octree.data();
+			params.level2 = cloud2Octree->findBestLevelForAGivenNeighbourhoodSizeExtraction(equivalentRadius);
+			if (app)
+				app->dispToConsole(QString("[M3C2] Working subdivision level (cloud #2): %1").arg(params.level2), ccMainAppInterface::STD_CONSOLE_MESSAGE);
 
-			if (useParallelStrategy)
+			std::vector<unsigned> pointIndexes;
+			try
 			{
+				pointIndexes.resize(corePointCount);
 				for (unsigned i = 0; i < corePointCount; ++i)
 				{
 					pointIndexes[i] = i;
 				}
-
-				if (maxThreadCount == 0)
-				{
-					maxThreadCount = QThread::idealThreadCount();
-				}
-				assert(maxThreadCount > 0 && maxThreadCount <= QThread::idealThreadCount());
-				QThreadPool::globalInstance()->setMaxThreadCount(maxThreadCount);
-				QtConcurrent::blockingMap(pointIndexes, ComputeM3C2DistForPoint);
+				ComputeM3C2Dist(params, pointIndexes, maxThreadCount);
 			}
-			else
+			catch (const std::bad_alloc&)
 			{
-				//manually call the static per-point method!
+				//not enough memory: manually call the per-point method!
+				M3C2Workspace workspace;
 				for (unsigned i = 0; i < corePointCount; ++i)
 				{
-					ComputeM3C2DistForPoint(i);
+					ComputeM3C2DistForPoint(params, i, workspace);
 				}
 			}
+
+			params.cloud1Octree = params.cloud2Octree = nullptr;
 		}
 
-		if (s_M3C2Params.processCanceled)
+		if (params.processCanceled)
 		{
 			errorMessage = "Process canceled by user!";
 			error = true;
@@ -972,17 +1636,22 @@ bool qM3C2Process::Compute(const qM3C2Dialog& dlg, QString& errorMessage, ccPoin
 				app->dispToConsole(QString("[M3C2] Distances computation: %1 s.").arg(static_cast<double>(distTime_ms) / 1000.0, 0, 'f', 3), ccMainAppInterface::STD_CONSOLE_MESSAGE);
 		}
 
-		s_M3C2Params.nProgress = nullptr;
+		params.nProgress = nullptr;
 
 		break; //to break from fake loop
 	}
 
+	if (progressCb)
+	{
+		progressCb->stop();
+	}
+
 	//associate scalar fields to the output cloud
 	//(use reverse order so as to get the index of
 	//the most important one at the end)
 	if (!error)
 	{
-		assert(s_M3C2Params.outputCloud && s_M3C2Params.corePoints);
+		assert(params.outputCloud && params.corePoints);
 		int sfIdx = -1;
 
 		//normal scales
@@ -990,101 +1659,108 @@ bool qM3C2Process::Compute(const qM3C2Dialog& dlg, QString& errorMessage, ccPoin
 		{
 			normalScaleSF->computeMinAndMax();
 			//in case the output cloud is the original cloud, we must remove the former SF
-			RemoveScalarField(s_M3C2Params.outputCloud, normalScaleSF->getName());
-			sfIdx = s_M3C2Params.outputCloud->addScalarField(normalScaleSF);
+			RemoveScalarField(params.outputCloud, normalScaleSF->getName());
+			sfIdx = params.outputCloud->addScalarField(normalScaleSF);
 		}
 
 		//add clouds' density SFs to output cloud
-		if (s_M3C2Params.densityCloud1SF)
+		if (params.densityCloud1SF)
 		{
-			s_M3C2Params.densityCloud1SF->computeMinAndMax();
+			params.densityCloud1SF->computeMinAndMax();
 			//in case the output cloud is the original cloud, we must remove the former SF
-			RemoveScalarField(s_M3C2Params.outputCloud, s_M3C2Params.densityCloud1SF->getName());
-			sfIdx = s_M3C2Params.outputCloud->addScalarField(s_M3C2Params.densityCloud1SF);
+			RemoveScalarField(params.outputCloud, params.densityCloud1SF->getName());
+			sfIdx = params.outputCloud->addScalarField(params.densityCloud1SF);
 		}
-		if (s_M3C2Params.densityCloud2SF)
+		if (params.densityCloud2SF)
 		{
-			s_M3C2Params.densityCloud2SF->computeMinAndMax();
+			params.densityCloud2SF->computeMinAndMax();
 			//in case the output cloud is the original cloud, we must remove the former SF
-			RemoveScalarField(s_M3C2Params.outputCloud, s_M3C2Params.densityCloud2SF->getName());
-			sfIdx = s_M3C2Params.outputCloud->addScalarField(s_M3C2Params.densityCloud2SF);
+			RemoveScalarField(params.outputCloud, params.densityCloud2SF->getName());
+			sfIdx = params.outputCloud->addScalarField(params.densityCloud2SF);
 		}
 
 		//add clouds' std. dev. SFs to output cloud
-		if (s_M3C2Params.stdDevCloud1SF)
+		if (params.stdDevCloud1SF)
 		{
-			s_M3C2Params.stdDevCloud1SF->computeMinAndMax();
+			params.stdDevCloud1SF->computeMinAndMax();
 			//in case the output cloud is the original cloud, we must remove the former SF
-			RemoveScalarField(s_M3C2Params.outputCloud, s_M3C2Params.stdDevCloud1SF->getName());
-			sfIdx = s_M3C2Params.outputCloud->addScalarField(s_M3C2Params.stdDevCloud1SF);
+			RemoveScalarField(params.outputCloud, params.stdDevCloud1SF->getName());
+			sfIdx = params.outputCloud->addScalarField(params.stdDevCloud1SF);
 		}
-		if (s_M3C2Params.stdDevCloud2SF)
+		if (params.stdDevCloud2SF)
 		{
 			//add cloud #2 std. dev. SF to output cloud
-			s_M3C2Params.stdDevCloud2SF->computeMinAndMax();
+			params.stdDevCloud2SF->computeMinAndMax();
 			//in case the output cloud is the original cloud, we must remove the former SF
-			RemoveScalarField(s_M3C2Params.outputCloud, s_M3C2Params.stdDevCloud2SF->getName());
-			sfIdx = s_M3C2Params.outputCloud->addScalarField(s_M3C2Params.stdDevCloud2SF);
+			RemoveScalarField(params.outputCloud, params.stdDevCloud2SF->getName());
+			sfIdx = params.outputCloud->addScalarField(params.stdDevCloud2SF);
 		}
 
-		if (s_M3C2Params.sigChangeSF)
+		if (params.sigChangeSF)
 		{
 			//add significance SF to output cloud
-			s_M3C2Params.sigChangeSF->computeMinAndMax();
-			s_M3C2Params.sigChangeSF->setMinDisplayed(SCALAR_ONE);
+			params.sigChangeSF->computeMinAndMax();
+			params.sigChangeSF->setMinDisplayed(SCALAR_ONE);
 			//in case the output cloud is the original cloud, we must remove the former SF
-			RemoveScalarField(s_M3C2Params.outputCloud, s_M3C2Params.sigChangeSF->getName());
-			sfIdx = s_M3C2Params.outputCloud->addScalarField(s_M3C2Params.sigChangeSF);
+			RemoveScalarField(params.outputCloud, params.sigChangeSF->getName());
+			sfIdx = params.outputCloud->addScalarField(params.sigChangeSF);
 		}
 
-		if (s_M3C2Params.distUncertaintySF)
+		if (params.distUncertaintySF)
 		{
 			//add dist. uncertainty SF to output cloud
-			s_M3C2Params.distUncertaintySF->computeMinAndMax();
+			params.distUncertaintySF->computeMinAndMax();
 			//in case the output cloud is the original cloud, we must remove the former SF
-			RemoveScalarField(s_M3C2Params.outputCloud, s_M3C2Params.distUncertaintySF->getName());
-			sfIdx = s_M3C2Params.outputCloud->addScalarField(s_M3C2Params.distUncertaintySF);
+			RemoveScalarField(params.outputCloud, params.distUncertaintySF->getName());
+			sfIdx = params.outputCloud->addScalarField(params.distUncertaintySF);
 		}
 
-		if (s_M3C2Params.m3c2DistSF)
+		if (params.m3c2DistSF)
 		{
 			//add M3C2 distances SF to output cloud
-			s_M3C2Params.m3c2DistSF->computeMinAndMax();
-			s_M3C2Params.m3c2DistSF->setSymmetricalScale(true);
+			params.m3c2DistSF->computeMinAndMax();
+			params.m3c2DistSF->setSymmetricalScale(true);
 			//in case the output cloud is the original cloud, we must remove the former SF
-			RemoveScalarField(s_M3C2Params.outputCloud, s_M3C2Params.m3c2DistSF->getName());
-			sfIdx = s_M3C2Params.outputCloud->addScalarField(s_M3C2Params.m3c2DistSF);
+			RemoveScalarField(params.outputCloud, params.m3c2DistSF->getName());
+			sfIdx = params.outputCloud->addScalarField(params.m3c2DistSF);
 		}
 
-		s_M3C2Params.outputCloud->invalidateBoundingBox(); //see 'const_cast<...>' in ComputeM3C2DistForPoint ;)
-		s_M3C2Params.outputCloud->setCurrentDisplayedScalarField(sfIdx);
-		s_M3C2Params.outputCloud->showSF(true);
-		s_M3C2Params.outputCloud->showNormals(true);
-		s_M3C2Params.outputCloud->setVisible(true);
+		params.outputCloud->invalidateBoundingBox(); //see 'const_cast<...>' in ComputeM3C2DistForPoint ;)
+		params.outputCloud->setCurrentDisplayedScalarField(sfIdx);
+		params.outputCloud->showSF(true);
+		params.outputCloud->showNormals(true);
+		params.outputCloud->setVisible(true);
 
-		if (s_M3C2Params.outputCloud != cloud1 && s_M3C2Params.outputCloud != cloud2)
+		if (params.outputCloud != cloud1 && params.outputCloud != cloud2)
 		{
-			s_M3C2Params.outputCloud->setName(outputName);
-			s_M3C2Params.outputCloud->setDisplay(s_M3C2Params.corePoints->getDisplay());
-			s_M3C2Params.outputCloud->importParametersFrom(s_M3C2Params.corePoints);
+			params.outputCloud->setName(outputName);
+			params.outputCloud->setDisplay(params.corePoints->getDisplay());
+			params.outputCloud->importParametersFrom(params.corePoints);
 			if (app)
 			{
-				app->addToDB(s_M3C2Params.outputCloud);
+				app->addToDB(params.outputCloud);
 			}
 			else
 			{
 				//command line mode
-				outputCloud = s_M3C2Params.outputCloud;
+				outputCloud = params.outputCloud;
 			}
 		}
 	}
-	else if (s_M3C2Params.outputCloud)
+	else if (params.outputCloud)
 	{
-		if (s_M3C2Params.outputCloud != s_M3C2Params.corePoints)
+		if (params.outputCloud != params.corePoints)
 		{
-			delete s_M3C2Params.outputCloud;
+			delete params.outputCloud;
 		}
-		s_M3C2Params.outputCloud = nullptr;
+		params.outputCloud = nullptr;
+	}
+
+	//the sub-sampled core points are only kept if they have been added to the DB (or if they are the output cloud)
+	if (corePointsHaveBeenSubsampled && !app && params.corePoints != outputCloud)
+	{
+		delete params.corePoints;
+		params.corePoints = nullptr;
 	}
 
 	if (app)
@@ -1093,23 +1769,22 @@ bool qM3C2Process::Compute(const qM3C2Dialog& dlg, QString& errorMessage, ccPoin
 	//release structures
 	if (normalScaleSF)
 		normalScaleSF->release();
-	if (s_M3C2Params.coreNormals)
-		s_M3C2Params.coreNormals->release();
-	if (s_M3C2Params.m3c2DistSF)
-		s_M3C2Params.m3c2DistSF->release();
-	if (s_M3C2Params.sigChangeSF)
-		s_M3C2Params.sigChangeSF->release();
-	if (s_M3C2Params.distUncertaintySF)
-		s_M3C2Params.distUncertaintySF->release();
-	if (s_M3C2Params.stdDevCloud1SF)
-		s_M3C2Params.stdDevCloud1SF->release();
-	if (s_M3C2Params.stdDevCloud2SF)
-		s_M3C2Params.stdDevCloud2SF->release();
-	if (s_M3C2Params.densityCloud1SF)
-		s_M3C2Params.densityCloud1SF->release();
-	if (s_M3C2Params.densityCloud2SF)
-		s_M3C2Params.densityCloud2SF->release();
+	if (params.coreNormals)
+		params.coreNormals->release();
+	if (params.m3c2DistSF)
+		params.m3c2DistSF->release();
+	if (params.sigChangeSF)
+		params.sigChangeSF->release();
+	if (params.distUncertaintySF)
+		params.distUncertaintySF->release();
+	if (params.stdDevCloud1SF)
+		params.stdDevCloud1SF->release();
+	if (params.stdDevCloud2SF)
+		params.stdDevCloud2SF->release();
+	if (params.densityCloud1SF)
+		params.densityCloud1SF->release();
+	if (params.densityCloud2SF)
+		params.densityCloud2SF->release();
 
 	return !error;
 }
-
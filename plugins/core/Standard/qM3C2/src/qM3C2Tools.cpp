@@ -43,53 +43,53 @@
 #include <QtConcurrentMap>
 
 //system
+#include <atomic>
 #include <vector>
 
 // ComputeCorePointNormal parameters
-static struct
+struct CorePointsNormalsParams
 {
-	CCCoreLib::GenericIndexedCloud* corePoints;
-	ccGenericPointCloud* sourceCloud;
-	CCCoreLib::DgmOctree* octree;
-	unsigned char octreeLevel;
+	CCCoreLib::GenericIndexedCloud* corePoints = nullptr;
+	CCCoreLib::GenericIndexedCloudPersist* sourceCloud = nullptr;
+	CCCoreLib::DgmOctree* octree = nullptr;
+	unsigned char octreeLevel = 0;
 	std::vector<PointCoordinateType> radii;
-	NormsIndexesTableType* normCodes;
-	ccScalarField* normalScale;
-	bool invalidNormals;
+	NormsIndexesTableType* normCodes = nullptr;
+	ccScalarField* normalScale = nullptr;
+	std::atomic<bool> invalidNormals { false };
 
-	CCCoreLib::NormalizedProgress* nProgress;
-	bool processCanceled;
+	CCCoreLib::NormalizedProgress* nProgress = nullptr;
+	std::atomic<bool> processCanceled { false };
+};
 
-} s_corePointsNormalsParams;
-
-void ComputeCorePointNormal(unsigned index)
+static void ComputeCorePointNormal(CorePointsNormalsParams& params, unsigned index)
 {
-	if (s_corePointsNormalsParams.processCanceled)
+	if (params.processCanceled)
 		return;
 
 	CCVector3 bestNormal(0, 0, 0);
 	ScalarType bestScale = CCCoreLib::NAN_VALUE;
 
-	const CCVector3* P = s_corePointsNormalsParams.corePoints->getPoint(index);
+	const CCVector3* P = params.corePoints->getPoint(index);
 	CCCoreLib::DgmOctree::NeighboursSet neighbours;
-	CCCoreLib::ReferenceCloud subset(s_corePointsNormalsParams.sourceCloud);
+	CCCoreLib::ReferenceCloud subset(params.sourceCloud);
 
-	int n = s_corePointsNormalsParams.octree->getPointsInSphericalNeighbourhood(*P,
-																				s_corePointsNormalsParams.radii.back(), //we use the biggest neighborhood
+	int n = params.octree->getPointsInSphericalNeighbourhood(*P,
+																				params.radii.back(), //we use the biggest neighborhood
 																				neighbours,
-																				s_corePointsNormalsParams.octreeLevel);
+																				params.octreeLevel);
 	
 	//if the widest neighborhood has less than 3 points in it, there's nothing we can do for this core point!
 	if (n >= 3)
 	{
-		size_t radiiCount = s_corePointsNormalsParams.radii.size();
+		size_t radiiCount = params.radii.size();
 
 		double bestPlanarityCriterion = 0;
 		unsigned bestSamplePointCount = 0;
 
 		for (size_t i = 0; i < radiiCount; ++i)
 		{
-			double radius = s_corePointsNormalsParams.radii[radiiCount - 1 - i]; //we start from the biggest
+			double radius = params.radii[radiiCount - 1 - i]; //we start from the biggest
 			double squareRadius = radius*radius;
 
 			subset.clear(false);
@@ -165,32 +165,32 @@ void ComputeCorePointNormal(unsigned index)
 
 		if (bestSamplePointCount < 3)
 		{
-			s_corePointsNormalsParams.invalidNormals = true;
+			params.invalidNormals = true;
 		}
 	}
 	else
 	{
-		s_corePointsNormalsParams.invalidNormals = true;
+		params.invalidNormals = true;
 	}
 
 	//compress the best normal and store it
 	CompressedNormType normCode = ccNormalVectors::GetNormIndex(bestNormal.u);
-	s_corePointsNormalsParams.normCodes->setValue(index, normCode);
+	params.normCodes->setValue(index, normCode);
 
 	//if necessary, store 'best radius'
-	if (s_corePointsNormalsParams.normalScale)
-		s_corePointsNormalsParams.normalScale->setValue(index, bestScale);
+	if (params.normalScale)
+		params.normalScale->setValue(index, bestScale);
 
 	//progress notification
-	if (s_corePointsNormalsParams.nProgress && !s_corePointsNormalsParams.nProgress->oneStep())
+	if (params.nProgress && !params.nProgress->oneStep())
 	{
-		s_corePointsNormalsParams.processCanceled = true;
+		params.processCanceled = true;
 	}
 }
 
 bool qM3C2Normals::ComputeCorePointsNormals(CCCoreLib::GenericIndexedCloud* corePoints,
 											NormsIndexesTableType* corePointsNormals,
-											ccGenericPointCloud* sourceCloud,
+											CCCoreLib::GenericIndexedCloudPersist* sourceCloud,
 											const std::vector<PointCoordinateType>& sortedRadii,
 											bool& invalidNormals,
 											int maxThreadCount/*=0*/,
@@ -252,16 +252,15 @@ bool qM3C2Normals::ComputeCorePointsNormals(CCCoreLib::GenericIndexedCloud* core
 	PointCoordinateType biggestRadius = sortedRadii.back(); //we extract the biggest neighborhood
 	unsigned char octreeLevel = theOctree->findBestLevelForAGivenNeighbourhoodSizeExtraction(biggestRadius);
 
-	s_corePointsNormalsParams.corePoints = corePoints;
-	s_corePointsNormalsParams.normCodes = corePointsNormals;
-	s_corePointsNormalsParams.sourceCloud = sourceCloud;
-	s_corePointsNormalsParams.radii = sortedRadii;
-	s_corePointsNormalsParams.octree = theOctree;
-	s_corePointsNormalsParams.octreeLevel = octreeLevel;
-	s_corePointsNormalsParams.nProgress = progressCb ? &nProgress : nullptr;
-	s_corePointsNormalsParams.processCanceled = false;
-	s_corePointsNormalsParams.invalidNormals = false;
-	s_corePointsNormalsParams.normalScale = normalScale;
+	CorePointsNormalsParams params;
+	params.corePoints = corePoints;
+	params.normCodes = corePointsNormals;
+	params.sourceCloud = sourceCloud;
+	params.radii = sortedRadii;
+	params.octree = theOctree;
+	params.octreeLevel = octreeLevel;
+	params.nProgress = progressCb ? &nProgress : nullptr;
+	params.normalScale = normalScale;
 
 	//we try the parallel way (if we have enough memory)
 	bool useParallelStrategy = true;
@@ -295,20 +294,20 @@ bool qM3C2Normals::ComputeCorePointsNormals(CCCoreLib::GenericIndexedCloud* core
 			maxThreadCount = QThread::idealThreadCount();
 		}
 		QThreadPool::globalInstance()->setMaxThreadCount(maxThreadCount);
-		QtConcurrent::blockingMap(corePointsIndexes, ComputeCorePointNormal);
+		QtConcurrent::blockingMap(corePointsIndexes, [&params](unsigned index) { ComputeCorePointNormal(params, index); });
 	}
 	else
 	{
-		//manually call the static per-point method!
+		//manually call the per-point method!
 		for (unsigned i = 0; i < corePtsCount; ++i)
 		{
-			ComputeCorePointNormal(i);
+			ComputeCorePointNormal(params, i);
 		}
 	}
 
 	//output flags
-	bool wasCanceled = s_corePointsNormalsParams.processCanceled;
-	invalidNormals = s_corePointsNormalsParams.invalidNormals;
+	bool wasCanceled = params.processCanceled;
+	invalidNormals = params.invalidNormals;
 
 	if (progressCb)
 	{
@@ -321,35 +320,35 @@ bool qM3C2Normals::ComputeCorePointsNormals(CCCoreLib::GenericIndexedCloud* core
 	return !wasCanceled;
 }
 
-static struct
+// OrientPointNormalWithCloud parameters
+struct NormOriWithCloudParams
 {
-	NormsIndexesTableType* normsCodes;
-	CCCoreLib::GenericIndexedCloud* normCloud;
-	CCCoreLib::GenericIndexedCloud* orientationCloud;
-
-	CCCoreLib::NormalizedProgress* nProgress;
-	bool processCanceled;
+	NormsIndexesTableType* normsCodes = nullptr;
+	CCCoreLib::GenericIndexedCloud* normCloud = nullptr;
+	CCCoreLib::GenericIndexedCloud* orientationCloud = nullptr;
 
-} s_normOriWithCloud;
+	CCCoreLib::NormalizedProgress* nProgress = nullptr;
+	std::atomic<bool> processCanceled { false };
+};
 
-static void OrientPointNormalWithCloud(unsigned index)
+static void OrientPointNormalWithCloud(NormOriWithCloudParams& params, unsigned index)
 {
-	if (s_normOriWithCloud.processCanceled)
+	if (params.processCanceled)
 		return;
 
-	const CompressedNormType& nCode = s_normOriWithCloud.normsCodes->getValue(index);
+	const CompressedNormType& nCode = params.normsCodes->getValue(index);
 	CCVector3 N(ccNormalVectors::GetNormal(nCode));
 
 	//corresponding point
-	const CCVector3* P = s_normOriWithCloud.normCloud->getPoint(index);
+	const CCVector3* P = params.normCloud->getPoint(index);
 
 	//find nearest point in 'orientation cloud'
 	//(brute force: we don't expect much points!)
 	CCVector3 orientation(0, 0, 1);
 	PointCoordinateType minSquareDist = 0;
-	for (unsigned j = 0; j < s_normOriWithCloud.orientationCloud->size(); ++j)
+	for (unsigned j = 0; j < params.orientationCloud->size(); ++j)
 	{
-		const CCVector3* Q = s_normOriWithCloud.orientationCloud->getPoint(j);
+		const CCVector3* Q = params.orientationCloud->getPoint(j);
 		CCVector3 PQ = (*Q - *P);
 		PointCoordinateType squareDist = PQ.norm2();
 		if (j == 0 || squareDist < minSquareDist)
@@ -364,12 +363,12 @@ static void OrientPointNormalWithCloud(unsigned index)
 	{
 		//inverse normal and re-compress it
 		N *= -1;
-		s_normOriWithCloud.normsCodes->setValue(index, ccNormalVectors::GetNormIndex(N.u));
+		params.normsCodes->setValue(index, ccNormalVectors::GetNormIndex(N.u));
 	}
 
-	if (s_normOriWithCloud.nProgress && !s_normOriWithCloud.nProgress->oneStep())
+	if (params.nProgress && !params.nProgress->oneStep())
 	{
-		s_normOriWithCloud.processCanceled = true;
+		params.processCanceled = true;
 	}
 }
 
@@ -408,11 +407,11 @@ bool qM3C2Normals::UpdateNormalOrientationsWithCloud(	CCCoreLib::GenericIndexedC
 		progressCb->start();
 	}
 
-	s_normOriWithCloud.normCloud = normCloud;
-	s_normOriWithCloud.orientationCloud = orientationCloud;
-	s_normOriWithCloud.normsCodes = &normsCodes;
-	s_normOriWithCloud.nProgress = &nProgress;
-	s_normOriWithCloud.processCanceled = false;
+	NormOriWithCloudParams params;
+	params.normCloud = normCloud;
+	params.orientationCloud = orientationCloud;
+	params.normsCodes = &normsCodes;
+	params.nProgress = &nProgress;
 
 	//we check each normal's orientation
 	{
@@ -446,14 +445,14 @@ bool qM3C2Normals::UpdateNormalOrientationsWithCloud(	CCCoreLib::GenericIndexedC
 				maxThreadCount = QThread::idealThreadCount();
 			}
 			QThreadPool::globalInstance()->setMaxThreadCount(maxThreadCount);
-			QtConcurrent::blockingMap(pointIndexes, OrientPointNormalWithCloud);
+			QtConcurrent::blockingMap(pointIndexes, [&params](unsigned index) { OrientPointNormalWithCloud(params, index); });
 		}
 		else
 		{
-			//manually call the static per-point method!
+			//manually call the per-point method!
 			for (unsigned i = 0; i < count; ++i)
 			{
-				OrientPointNormalWithCloud(i);
+				OrientPointNormalWithCloud(params, i);
 			}
 		}
 	}
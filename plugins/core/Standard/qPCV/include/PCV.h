@@ -35,15 +35,16 @@
 class PCV
 {
 public:
-	//! Simulates global illumination on a cloud (or a mesh) with OpenGL - shortcut version
+	//! Simulates global illumination on a cloud (or a mesh) (CPU rendering) - shortcut version
 	/** Computes per-vertex illumination intensity as a scalar field.
+		The light directions are rendered in parallel (no OpenGL context required).
 		\param numberOfRays (approxiamate) number of rays to generate
 		\param mode360 whether light rays should be generated on the half superior sphere (false) or the whole sphere (true)
 		\param vertices vertices (eventually corresponding to a mesh - see below) to englight
 		\param mesh optional mesh structure associated to the vertices
 		\param meshIsClosed if a mesh is passed as argument (see above), specifies if the mesh surface is closed (enables optimization)
-		\param width width  of the OpenGL context used to simulate illumination
-		\param height height of the OpenGL context used to simulate illumination
+		\param width width  of the depth buffer used to simulate illumination
+		\param height height of the depth buffer used to simulate illumination
 		\param progressCb optional progress bar (optional)
 		\param entityName entity name (optional)
 		\return number of 'light' directions actually used (or a value <0 if an error occurred)
@@ -58,14 +59,15 @@ public:
 						CCCoreLib::GenericProgressCallback* progressCb = nullptr,
 						const QString& entityName = QString());
 
-	//! Simulates global illumination on a cloud (or a mesh) with OpenGL
+	//! Simulates global illumination on a cloud (or a mesh) (CPU rendering)
 	/** Computes per-vertex illumination intensity as a scalar field.
+		The light directions are rendered in parallel (no OpenGL context required).
 		\param rays light directions that will be used to compute global illumination
 		\param vertices vertices (eventually corresponding to a mesh - see below) to englight
 		\param mesh optional mesh structure associated to the vertices
 		\param meshIsClosed if a mesh is passed as argument (see above), specifies if the mesh surface is closed (enables optimization)
-		\param width width  of the OpenGL context used to simulate illumination
-		\param height height of the OpenGL context used to simulate illumination
+		\param width width  of the depth buffer used to simulate illumination
+		\param height height of the depth buffer used to simulate illumination
 		\param progressCb optional progress bar (optional)
 		\param entityName entity name (optional)
 		\return success
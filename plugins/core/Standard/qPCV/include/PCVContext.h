@@ -22,26 +22,34 @@
 #include <GenericCloud.h>
 #include <GenericMesh.h>
 
+//qCC_db
+#include <ccDepthRasterizer.h>
+
 //system
+#include <atomic>
 #include <vector>
 
-class QGLPixelBuffer;
-
-//! PCV (Portion de Ciel Visible / Ambiant Illumination) OpenGL context
-/** Similar to Cignoni's ShadeVis
+//! PCV (Portion de Ciel Visible / Ambiant Illumination) rendering context
+/** Similar to Cignoni's ShadeVis. The entity is rendered with a CPU rasterizer
+	(see ccDepthRasterizer), so that no OpenGL context is required and several
+	view directions can be rendered in parallel (one rasterizer per thread).
 **/
 class PCVContext
 {
 	public:
+		//! Per-vertex visibility counters (shared by all threads)
+		using VisibilityCounters = std::vector< std::atomic<int> >;
+
 		//! Default constructor
 		PCVContext();
 
 		//! Destructor
-		virtual ~PCVContext();
+		virtual ~PCVContext() = default;
 
 		//! Initialization
-		/** \param W OpenGL render context width (pixels)
-			\param H OpenGL render context height (pixels)
+		/** The geometry of the entity is copied (so that it can be read by several threads).
+			\param W depth buffer width (pixels)
+			\param H depth buffer height (pixels)
 			\param cloud associated cloud (or mesh vertices)
 			\param mesh associated mesh (if any)
 			\param closedMesh whether mesh is closed (faster) or not (need more memory)
@@ -53,51 +61,38 @@ class PCVContext
 					CCCoreLib::GenericMesh* mesh = nullptr,
 					bool closedMesh = true);
 
-		//! Set the viewing directions
-		void setViewDirection(const CCVector3& V);
+		//! Initializes a rasterizer compatible with this context
+		bool initRasterizer(ccDepthRasterizer& rasterizer) const;
 
-		//! Increments the visibility counter for points viewed in the current pass (see setViewDirection)
-		/** \param visibilityCount per-vertex visibility count (same size as the number of vertices)
+		//! Increments the visibility counter for vertices viewed from a given direction
+		/** Can be called by several threads at the same time (as long as each thread uses its own rasterizer).
+			\param viewDir view direction
+			\param rasterizer rasterizer (see initRasterizer)
+			\param visibilityCount per-vertex visibility count (same size as the number of vertices)
 			\return number of vertices seen during this pass
 		**/
-		int GLAccumPixel(std::vector<int>& visibilityCount);
+		int accumPixel(const CCVector3& viewDir, ccDepthRasterizer& rasterizer, VisibilityCounters& visibilityCount) const;
 
 	protected:
-		void glInit();
-		void drawEntity();
-		void associateToEntity(CCCoreLib::GenericCloud* cloud, CCCoreLib::GenericMesh* mesh = nullptr);
 
-		//! Displayed entity (cloud or mesh vertices)
-		CCCoreLib::GenericCloud* m_vertices;
+		//! Displayed entity vertices (cloud or mesh vertices)
+		std::vector<CCVector3> m_vertices;
 
-		//! Displayed entity (mesh - optional)
-		CCCoreLib::GenericMesh* m_mesh;
+		//! Displayed entity triangles (mesh only - 3 vertices per triangle)
+		std::vector<CCVector3> m_triangles;
 
 		//zoom courant
 		PointCoordinateType m_zoom;
 		//translation vers le centre de l'entitee a afficher
 		CCVector3 m_viewCenter;
 
-		//associated pixel buffer
-		QGLPixelBuffer* m_pixBuffer;
-
-		//! Pixel buffer width (pixels)
+		//! Depth buffer width (pixels)
 		unsigned m_width;
-		//! Pixel buffer height (pixels)
+		//! Depth buffer height (pixels)
 		unsigned m_height;
 
-		//! Model view matrix size (OpenGL)
-		/** \warning Never pass a 'constant initializer' by reference
-		**/
-		static const unsigned OPENGL_MATRIX_SIZE = 16;
-
-		//! Current model view matrix
-		float m_viewMat[OPENGL_MATRIX_SIZE];
-
-		//! Depth buffer
-		float* m_snapZ;
-		//! Color buffer
-		unsigned char* m_snapC;
+		//! Depth tolerance (for the visibility test)
+		PointCoordinateType m_depthTolerance;
 
 		//! Whether displayed mesh is closed or not
 		bool m_meshIsClosed;
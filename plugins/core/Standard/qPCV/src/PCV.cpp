@@ -19,8 +19,12 @@
 #include "PCV.h"
 #include "PCVContext.h"
 
+//qCC_db
+#include <ccParallel.h>
+
 //Qt
 #include <QString>
+#include <QThread>
 
 #ifdef USE_VLD
 //VLD
@@ -31,6 +35,7 @@
 #include <algorithm>
 #include <cassert>
 #include <cstring>
+#include <memory>
 
 using namespace CCCoreLib;
 
@@ -250,16 +255,20 @@ bool PCV::Launch(const std::vector<CCVector3>& rays,
 	unsigned numberOfRays = static_cast<unsigned>(rays.size());
 
 	//for each vertex we keep count of the number of light directions for which it is "illuminated"
-	std::vector<int> visibilityCount;
+	std::unique_ptr<PCVContext::VisibilityCounters> visibilityCount;
 	try
 	{
-		visibilityCount.resize(numberOfPoints, 0);
+		visibilityCount.reset(new PCVContext::VisibilityCounters(numberOfPoints));
 	}
 	catch (const std::bad_alloc&)
 	{
 		//not enough memory?
 		return false;
 	}
+	for (std::atomic<int>& count : *visibilityCount)
+	{
+		count = 0;
+	}
 
 	/*** Main illumination loop ***/
 
@@ -286,18 +295,44 @@ bool PCV::Launch(const std::vector<CCVector3>& rays,
 	bool success = true;
 
 	//must be done after progress dialog display!
-	PCVContext win;
-	if (win.init(width, height, vertices, mesh, meshIsClosed))
+	//(the view directions are rendered in parallel, with one rasterizer per thread)
+	PCVContext context;
+	std::vector<ccDepthRasterizer> rasterizers;
+	if (context.init(width, height, vertices, mesh, meshIsClosed))
 	{
-		for (unsigned i = 0; i < numberOfRays; ++i)
+		try
 		{
-			//set current 'light' direction
-			win.setViewDirection(rays[i]);
+			rasterizers.resize(std::max(1, QThread::idealThreadCount()));
+		}
+		catch (const std::bad_alloc&)
+		{
+			//not enough memory
+			success = false;
+		}
+		for (size_t k = 0; success && k < rasterizers.size(); ++k)
+		{
+			success = context.initRasterizer(rasterizers[k]);
+		}
+	}
+	else
+	{
+		success = false;
+	}
+
+	if (success)
+	{
+		const unsigned batchSize = static_cast<unsigned>(rasterizers.size());
+		for (unsigned i = 0; i < numberOfRays; i += batchSize)
+		{
+			unsigned currentBatchSize = std::min(batchSize, numberOfRays - i);
 
-			//flag viewed vertices
-			win.GLAccumPixel(visibilityCount);
+			//flag viewed vertices (for each 'light' direction of the batch)
+			ccParallelFor(static_cast<int>(currentBatchSize), [&](int k)
+			{
+				context.accumPixel(rays[i + k], rasterizers[k], *visibilityCount);
+			});
 
-			if (progressCb && !nProgress.oneStep())
+			if (progressCb && !nProgress.steps(currentBatchSize))
 			{
 				success = false;
 				break;
@@ -309,15 +344,11 @@ bool PCV::Launch(const std::vector<CCVector3>& rays,
 			//we convert per-vertex accumulators to an 'intensity' scalar field
 			for (unsigned j = 0; j < numberOfPoints; ++j)
 			{
-				ScalarType visValue = static_cast<ScalarType>(visibilityCount[j]) / numberOfRays;
+				ScalarType visValue = static_cast<ScalarType>((*visibilityCount)[j].load()) / numberOfRays;
 				vertices->setPointScalarValue(j, visValue);
 			}
 		}
 	}
-	else
-	{
-		success = false;
-	}
 
 	return success;
 }
@@ -19,33 +19,12 @@
 
 //CCCoreLib
 #include <CCMath.h>
-#include <CCMiscTools.h>
 #include <GenericTriangle.h>
 
-//Qt
-#include <QGLPixelBuffer>
-
-//OpenGL
-#ifdef __APPLE__
-#include <OpenGL/glu.h>
-#else
-#include <GL/glu.h>
-#endif
-
 //system
+#include <algorithm>
 #include <cassert>
-
-//type-less glVertex3Xv call (X=f,d)
-static inline void glVertex3v(const float* v) { glVertex3fv(v); }
-static inline void glVertex3v(const double* v) { glVertex3dv(v); }
-
-//type-less glTranslateX call (X=f,d)
-static inline void glTranslate(float x, float y, float z) { glTranslatef(x, y, z); }
-static inline void glTranslate(double x, double y, double z) { glTranslated(x, y, z); }
-
-//type-less glScaleX call (X=f,d)
-static inline void glScale(float x, float y, float z) { glScalef(x, y, z); }
-static inline void glScale(double x, double y, double z) { glScaled(x, y, z); }
+#include <limits>
 
 using namespace CCCoreLib;
 
@@ -54,24 +33,12 @@ using namespace CCCoreLib;
 #endif
 
 PCVContext::PCVContext()
-	: m_vertices(nullptr)
-	, m_mesh(nullptr)
-	, m_zoom(1)
-	, m_pixBuffer(nullptr)
+	: m_zoom(1)
 	, m_width(0)
 	, m_height(0)
-	, m_snapZ(nullptr)
-	, m_snapC(nullptr)
+	, m_depthTolerance(0)
 	, m_meshIsClosed(false)
 {
-	memset(m_viewMat, 0, sizeof(float)*OPENGL_MATRIX_SIZE);
-}
-
-PCVContext::~PCVContext()
-{
-	delete m_pixBuffer;
-	delete[] m_snapZ;
-	delete[] m_snapC;
 }
 
 bool PCVContext::init(unsigned W,
@@ -80,62 +47,50 @@ bool PCVContext::init(unsigned W,
 					  CCCoreLib::GenericMesh* mesh/*=nullptr*/,
 					  bool closedMesh/*=true*/)
 {
-	if (!QGLPixelBuffer::hasOpenGLPbuffers())
-		return false;
-
-	assert(!m_pixBuffer);
-
-	m_pixBuffer = new QGLPixelBuffer(W, H);
-	if (!m_pixBuffer || !m_pixBuffer->isValid())
-		return false;
-
-	unsigned size = W*H;
-	m_snapZ = new float[size];
-	if (!m_snapZ)
-	{
-		delete m_pixBuffer;
-		m_pixBuffer = nullptr;
+	assert(cloud);
+	if (!cloud || W == 0 || H == 0)
 		return false;
-	}
 
+	m_width = W;
+	m_height = H;
 	m_meshIsClosed = (closedMesh || !mesh);
-	if (!m_meshIsClosed)
+
+	//we copy the geometry (so that it can be read by several threads at once)
+	try
 	{
-		//buffer for color
-		m_snapC = new unsigned char[4*size];
-		if (!m_snapC)
+		unsigned nVert = cloud->size();
+		m_vertices.resize(nVert);
+		cloud->placeIteratorAtBeginning();
+		for (unsigned i = 0; i < nVert; ++i)
+			m_vertices[i] = *cloud->getNextPoint();
+
+		m_triangles.clear();
+		if (mesh)
 		{
-			delete m_pixBuffer;
-			m_pixBuffer = nullptr;
-			delete[] m_snapZ;
-			m_snapZ = nullptr;
-			return false;
+			unsigned nTri = mesh->size();
+			m_triangles.reserve(3 * static_cast<size_t>(nTri));
+			mesh->placeIteratorAtBeginning();
+			for (unsigned i = 0; i < nTri; ++i)
+			{
+				const GenericTriangle* t = mesh->_getNextTriangle();
+				m_triangles.push_back(*t->_getA());
+				m_triangles.push_back(*t->_getB());
+				m_triangles.push_back(*t->_getC());
+			}
 		}
 	}
-
-	m_width = W;
-	m_height = H;
-
-	associateToEntity(cloud, mesh);
-
-	glInit();
-
-	return true;
-}
-
-void PCVContext::associateToEntity(GenericCloud* cloud, GenericMesh* mesh)
-{
-	assert(cloud);
-	if (!cloud)
-		return;
-
-	m_vertices = cloud;
-	m_mesh = mesh;
+	catch (const std::bad_alloc&)
+	{
+		//not enough memory
+		m_vertices.clear();
+		m_triangles.clear();
+		return false;
+	}
 
 	//we get cloud bounding box
 	CCVector3 bbMin;
 	CCVector3 bbMax;
-	m_vertices->getBoundingBox(bbMin, bbMax);
+	cloud->getBoundingBox(bbMin, bbMax);
 
 	//we compute bbox diagonal
 	PointCoordinateType maxD = (bbMax - bbMin).norm();
@@ -145,109 +100,16 @@ void PCVContext::associateToEntity(GenericCloud* cloud, GenericMesh* mesh)
 
 	//as well as display center
 	m_viewCenter = (bbMax+bbMin)/2;
-}
-
-void PCVContext::glInit()
-{
-	if (!m_pixBuffer || !m_pixBuffer->isValid())
-		return;
-
-	m_pixBuffer->makeCurrent();
-
-	glClearColor(0.0, 0.0, 0.0, 0.0);
-	glEnable(GL_DEPTH_TEST);
-	glEnable(GL_CULL_FACE);
-	glDepthMask(GL_TRUE);
-	glDisable(GL_LIGHTING);
-
-	glPixelStorei(GL_PACK_ROW_LENGTH, 0);
-	glPixelStorei(GL_PACK_ALIGNMENT, 1);
-
-	//model view matrix initialization
-	glMatrixMode(GL_MODELVIEW);
-	glLoadIdentity();
-	glGetFloatv(GL_MODELVIEW_MATRIX, m_viewMat);
-	glPushMatrix();
-
-	//projection matrix initialization
-	glMatrixMode(GL_PROJECTION);
-	glLoadIdentity();
-	float w2 = 0.5f * m_width;
-	float h2 = 0.5f * m_height;
-	float maxD = static_cast<float>(std::max(m_width, m_height));
-	glOrtho(-w2, w2, -h2, h2, -maxD, maxD);
-	glPushMatrix();
-}
-
-void PCVContext::setViewDirection(const CCVector3& V)
-{
-	if (!m_pixBuffer || !m_pixBuffer->isValid())
-		return;
-
-	m_pixBuffer->makeCurrent();
 
-	glMatrixMode(GL_MODELVIEW);
-	glPushMatrix();
-	glLoadIdentity();
+	//same tolerance as the former OpenGL version (depth range 'twists' on a [-maxD ; maxD] depth interval)
+	m_depthTolerance = static_cast<PointCoordinateType>(4 * ZTWIST * std::max(m_width, m_height));
 
-	CCVector3 U(0, 0, 1);
-	if (1 - std::abs(V.dot(U)) < 1.0e-4)
-	{
-		U.y = 1;
-		U.z = 0;
-	}
-
-	gluLookAt(-V.x, -V.y, -V.z, 0.0, 0.0, 0.0, U.x, U.y, U.z);
-	glGetFloatv(GL_MODELVIEW_MATRIX, m_viewMat);
-	glPopMatrix();
-}
-
-void PCVContext::drawEntity()
-{
-	assert(m_vertices);
-
-	glMatrixMode(GL_MODELVIEW);
-	glLoadMatrixf(m_viewMat);
-	glScale(m_zoom, m_zoom, m_zoom);
-	glTranslate(-m_viewCenter.x, -m_viewCenter.y, -m_viewCenter.z);
-
-	glColor3ub(255, 255, 0); //yellow by default
-
-	if (m_mesh)
-	{
-		unsigned nTri = m_mesh->size();
-		m_mesh->placeIteratorAtBeginning();
-
-		glBegin(GL_TRIANGLES);
-		for (unsigned i = 0; i < nTri; ++i)
-		{
-			const GenericTriangle* t = m_mesh->_getNextTriangle();
-			glVertex3v(t->_getA()->u);
-			glVertex3v(t->_getB()->u);
-			glVertex3v(t->_getC()->u);
-		}
-		glEnd();
-	}
-	else
-	{
-		unsigned nPts = m_vertices->size();
-		m_vertices->placeIteratorAtBeginning();
-
-		glBegin(GL_POINTS);
-		for (unsigned i = 0; i < nPts; ++i)
-			glVertex3v(m_vertices->getNextPoint()->u);
-		glEnd();
-	}
+	return true;
 }
 
-void openGLSnapshot(GLenum format, GLenum type, void* buffer)
+bool PCVContext::initRasterizer(ccDepthRasterizer& rasterizer) const
 {
-	assert(buffer);
-
-	int vp[4];
-	glGetIntegerv(GL_VIEWPORT, vp);
-
-	glReadPixels(vp[0], vp[1], vp[2], vp[3], format, type, buffer);
+	return rasterizer.init(m_width, m_height, ccDepthRasterizer::KEEP_NEAREST, std::numeric_limits<PointCoordinateType>::max());
 }
 
 //The method below is inspired from ShadeVis' "GLAccumPixel" (Cignoni et al.)
@@ -259,95 +121,97 @@ void openGLSnapshot(GLenum format, GLenum type, void* buffer)
 * Visual Computing Lab                                            /\/|      *
 * ISTI - Italian National Research Council                           |      *
 *****************************************************************************/
-int PCVContext::GLAccumPixel(std::vector<int>& visibilityCount)
+int PCVContext::accumPixel(const CCVector3& viewDir, ccDepthRasterizer& rasterizer, VisibilityCounters& visibilityCount) const
 {
-	if (!m_pixBuffer || !m_pixBuffer->isValid())
+	if (m_vertices.empty())
 		return -1;
-	if (!m_vertices)
+	if (m_vertices.size() != visibilityCount.size())
 		return -1;
-	if (m_vertices->size() != visibilityCount.size())
+	if (rasterizer.width() != m_width || rasterizer.height() != m_height)
 		return -1;
 
-	assert(m_snapZ);
-
-	m_pixBuffer->makeCurrent();
+	//orthographic view frame (same as gluLookAt with the eye at -viewDir, looking at the origin)
+	CCVector3 f = viewDir;
+	f.normalize();
+	CCVector3 U(0, 0, 1);
+	if (1 - std::abs(f.dot(U)) < 1.0e-4)
+	{
+		U.y = 1;
+		U.z = 0;
+	}
+	CCVector3 s = f.cross(U);
+	s.normalize();
+	CCVector3 u = s.cross(f);
+
+	//the zoom is applied to the axes directly
+	const CCVector3 X = s * m_zoom;
+	const CCVector3 Y = u * m_zoom;
+	const CCVector3 Z = f * m_zoom;
+	const PointCoordinateType w2 = static_cast<PointCoordinateType>(m_width) / 2;
+	const PointCoordinateType h2 = static_cast<PointCoordinateType>(m_height) / 2;
+
+	//projection in window coordinates (x, y in pixels, z = depth)
+	auto project = [&](const CCVector3& P)
+	{
+		CCVector3 Q = P - m_viewCenter;
+		return CCVector3(X.dot(Q) + w2, Y.dot(Q) + h2, Z.dot(Q));
+	};
 
-	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-	glDepthRange(2.0f*ZTWIST, 1.0f);
+	rasterizer.clear();
 
-	if (m_meshIsClosed)
-		glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+	//display 3D entity
+	if (!m_triangles.empty())
+	{
+		//front faces only if the mesh is closed, front and back faces otherwise
+		ccDepthRasterizer::CullingMode cullingMode = (m_meshIsClosed ? ccDepthRasterizer::CULL_BACK_FACES : ccDepthRasterizer::NO_CULLING);
+		for (size_t i = 0; i + 2 < m_triangles.size(); i += 3)
+		{
+			rasterizer.drawTriangle(project(m_triangles[i]), project(m_triangles[i + 1]), project(m_triangles[i + 2]), cullingMode);
+		}
+	}
 	else
-		glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
-
-	//display 3D entity (front)
-	glCullFace(GL_BACK);
-	drawEntity();
-
-	if (!m_meshIsClosed)
 	{
-		//display it again (back)
-		glCullFace(GL_FRONT);
-		drawEntity();
-
-		assert(m_snapC);
-		openGLSnapshot(GL_RGBA, GL_UNSIGNED_BYTE, m_snapC);
+		for (const CCVector3& P : m_vertices)
+		{
+			CCVector3 Q = project(P);
+			uint32_t pixel = rasterizer.pixelIndex(Q.x, Q.y);
+			if (pixel != ccDepthRasterizer::INVALID_PIXEL)
+			{
+				rasterizer.drawSample(pixel, Q.z);
+			}
+		}
 	}
-	openGLSnapshot(GL_DEPTH_COMPONENT, GL_FLOAT, m_snapZ);
-
-	if (m_meshIsClosed)
-		glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
-
-	glDepthRange(0, 1.0f - 2.0f*ZTWIST);
-	double MM[OPENGL_MATRIX_SIZE];
-	glGetDoublev(GL_MODELVIEW_MATRIX, MM);
-	double MP[OPENGL_MATRIX_SIZE];
-	glGetDoublev(GL_PROJECTION_MATRIX, MP);
-	int VP[4];
-	glGetIntegerv(GL_VIEWPORT, VP);
 
 	int count = 0;
-	int sx4 = (m_width << 2);
 
-	unsigned nVert = m_vertices->size();
-	m_vertices->placeIteratorAtBeginning();
-	for (unsigned i = 0; i < nVert; ++i)
+	for (size_t i = 0; i < m_vertices.size(); ++i)
 	{
-		const CCVector3* P = m_vertices->getNextPoint();
+		CCVector3 Q = project(m_vertices[i]);
 
-		double tx = 0.0;
-		double ty = 0.0;
-		double tz = 0.0;
-		gluProject(P->x, P->y, P->z, MM, MP, VP, &tx, &ty, &tz);
+		uint32_t pixel = rasterizer.pixelIndex(Q.x, Q.y);
+		if (pixel == ccDepthRasterizer::INVALID_PIXEL)
+			continue;
 
-		int txi = static_cast<int>(floor(tx));
-		int tyi = static_cast<int>(floor(ty));
-		if (txi >= 0 && txi < static_cast<int>(m_width)
-			&& tyi >= 0 && tyi < static_cast<int>(m_height))
+		if (!m_meshIsClosed)
 		{
-			int dec = txi + tyi*static_cast<int>(m_width);
-			int col = 1;
-
-			if (!m_meshIsClosed)
+			//the vertex must be inside the rendered surface (2x2 pixels neighborhood)
+			unsigned x = pixel % m_width;
+			unsigned y = pixel / m_width;
+			uint32_t dx = (x + 1 < m_width ? 1 : 0);
+			uint32_t dy = (y + 1 < m_height ? m_width : 0);
+			if (	rasterizer.isEmpty(pixel)
+				&&	rasterizer.isEmpty(pixel + dx)
+				&&	rasterizer.isEmpty(pixel + dy)
+				&&	rasterizer.isEmpty(pixel + dx + dy))
 			{
-				//int c1 = std::max(m_snapC[dec],m_snapC[dec<<2+4]);
-				//int c2 = std::max(m_snapC[dec<<2+sx4],m_snapC[dec<<2+sx4+4]);
-				const unsigned char* pix = m_snapC + (dec << 2);
-				int c1 = std::max(pix[0], pix[4]);
-				pix += sx4;
-				int c2 = std::max(pix[0], pix[4]);
-				col = std::max(c1, c2);
+				continue;
 			}
+		}
 
-			if (col != 0)
-			{
-				if (tz < static_cast<double>(m_snapZ[dec]))
-				{
-					assert(i < visibilityCount.size());
-					++visibilityCount[i];
-					++count;
-				}
-			}
+		if (Q.z < rasterizer.depth(pixel) + m_depthTolerance)
+		{
+			++visibilityCount[i];
+			++count;
 		}
 	}
 
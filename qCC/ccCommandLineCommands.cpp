@@ -9,8 +9,10 @@
 #include <DistanceComputationTools.h>
 
 //qCC_db
+#include <cc2DViewportObject.h>
 #include <ccHObjectCaster.h>
 #include <ccNormalVectors.h>
+#include <ccOctree.h>
 #include <ccPlane.h>
 #include <ccPolyline.h>
 #include <ccProgressDialog.h>
@@ -19,6 +21,7 @@
 
 //qCC_io
 #include <AsciiFilter.h>
+#include <BinFilter.h>
 #include <PlyFilter.h>
 
 //qCC
@@ -36,8 +39,18 @@
 //Local
 #include "ccEntityAction.h"
 
+//qCC_glWindow
+#include <ccGLWindow.h>
+
 #include <QDateTime>
+#include <QDir>
+#include <QElapsedTimer>
 #include <QFileInfo>
+#include <QImage>
+
+//system
+#include <deque>
+#include <future>
 
 //commands
 constexpr char COMMAND_CLOUD_EXPORT_FORMAT[]			= "C_EXPORT_FMT";
@@ -50,6 +63,7 @@ constexpr char COMMAND_MESH_EXPORT_FORMAT[]				= "M_EXPORT_FMT";
 constexpr char COMMAND_HIERARCHY_EXPORT_FORMAT[]		= "H_EXPORT_FMT";
 constexpr char COMMAND_OPEN[]							= "O";				//+file name
 constexpr char COMMAND_OPEN_SKIP_LINES[]				= "SKIP";			//+number of lines to skip
+constexpr char COMMAND_OPEN_ENTITY_ID[]					= "ENTITY_ID";		//+unique ID of the only entity to load (BIN files)
 constexpr char COMMAND_SUBSAMPLE[]						= "SS";				//+ method (RANDOM/SPATIAL/OCTREE) + parameter (resp. point count / spatial step / octree level)
 constexpr char COMMAND_EXTRACT_CC[]						= "EXTRACT_CC";
 constexpr char COMMAND_CURVATURE[]						= "CURV";			//+ curvature type (MEAN/GAUSS)
@@ -124,6 +138,8 @@ constexpr char COMMAND_ICP_USE_MODEL_SF_AS_WEIGHT[]		= "MODEL_SF_AS_WEIGHTS";
 constexpr char COMMAND_ICP_USE_DATA_SF_AS_WEIGHT[]		= "DATA_SF_AS_WEIGHTS";
 constexpr char COMMAND_ICP_ROT[]						= "ROT";
 constexpr char COMMAND_PLY_EXPORT_FORMAT[]				= "PLY_EXPORT_FMT";
+constexpr char COMMAND_BIN_COMPRESSION[]				= "BIN_COMPRESSION";	//+ compression level (-1 = none, 0 to 9)
+constexpr char COMMAND_OCTREE_CACHE[]					= "OCTREE_CACHE";		//+ cache folder
 constexpr char COMMAND_COMPUTE_GRIDDED_NORMALS[]		= "COMPUTE_NORMALS";
 constexpr char COMMAND_INVERT_NORMALS[]					= "INVERT_NORMALS";
 constexpr char COMMAND_COMPUTE_OCTREE_NORMALS[]			= "OCTREE_NORMALS";
@@ -147,6 +163,11 @@ constexpr char COMMAND_MOMENT[]							= "MOMENT";
 constexpr char COMMAND_FEATURE[]						= "FEATURE";
 constexpr char COMMAND_RGB_CONVERT_TO_SF[]				= "RGB_CONVERT_TO_SF";
 constexpr char COMMAND_FLIP_TRIANGLES[]					= "FLIP_TRI";
+constexpr char COMMAND_RENDER[]							= "RENDER";				//+ output filename prefix
+constexpr char COMMAND_RENDER_SIZE[]					= "SIZE";				//+ width + height (in pixels)
+constexpr char COMMAND_RENDER_VIEWPORTS[]				= "VIEWPORTS";			//+ file containing the viewports
+constexpr char COMMAND_RENDER_FRAMES[]					= "FRAMES";				//+ number of frames per animation segment
+constexpr char COMMAND_RENDER_BATCH[]					= "BATCH";				//+ max number of images written in parallel
 
 //options / modifiers
 constexpr char COMMAND_MAX_THREAD_COUNT[]				= "MAX_TCOUNT";
@@ -442,6 +463,7 @@ bool CommandLoad::process(ccCommandLineInterface &cmd)
 	
 	//optional parameters
 	int skipLines = 0;
+	unsigned entityID = 0;
 	ccCommandLineInterface::GlobalShiftOptions globalShiftOptions;
 
 	while (!cmd.arguments().empty())
@@ -466,6 +488,25 @@ bool CommandLoad::process(ccCommandLineInterface &cmd)
 			
 			cmd.print(QObject::tr("Will skip %1 lines").arg(skipLines));
 		}
+		else if (ccCommandLineInterface::IsCommand(argument, COMMAND_OPEN_ENTITY_ID))
+		{
+			//local option confirmed, we can move on
+			cmd.arguments().pop_front();
+
+			if (cmd.arguments().empty())
+			{
+				return cmd.error(QObject::tr("Missing parameter: entity unique ID after '%1'").arg(COMMAND_OPEN_ENTITY_ID));
+			}
+
+			bool ok;
+			entityID = cmd.arguments().takeFirst().toUInt(&ok);
+			if (!ok || entityID == 0)
+			{
+				return cmd.error(QObject::tr("Invalid parameter: entity unique ID after '%1'").arg(COMMAND_OPEN_ENTITY_ID));
+			}
+
+			cmd.print(QObject::tr("Will only load entity #%1 (BIN files)").arg(entityID));
+		}
 		else if (cmd.nextCommandIsGlobalShift())
 		{
 			//local option confirmed, we can move on
@@ -490,12 +531,11 @@ bool CommandLoad::process(ccCommandLineInterface &cmd)
 	
 	//open specified file
 	QString filename(cmd.arguments().takeFirst());
-	if (!cmd.importFile(filename, globalShiftOptions))
-	{
-		return false;
-	}
+	BinFilter::SetEntityToLoad(entityID);
+	bool success = cmd.importFile(filename, globalShiftOptions);
+	BinFilter::SetEntityToLoad(0);
 
-	return true;
+	return success;
 }
 
 CommandClearNormals::CommandClearNormals()
@@ -5421,6 +5461,53 @@ bool CommandChangePLYExportFormat::process(ccCommandLineInterface &cmd)
 	return true;
 }
 
+CommandChangeBINCompression::CommandChangeBINCompression()
+	: ccCommandLineInterface::Command(QObject::tr("Change BIN compression level"), COMMAND_BIN_COMPRESSION)
+{}
+
+bool CommandChangeBINCompression::process(ccCommandLineInterface &cmd)
+{
+	if (cmd.arguments().empty())
+	{
+		return cmd.error(QObject::tr("Missing parameter: compression level (-1 = none, 0 to 9) after '%1'").arg(COMMAND_BIN_COMPRESSION));
+	}
+
+	bool ok = false;
+	int level = cmd.arguments().takeFirst().toInt(&ok);
+	if (!ok || level < -1 || level > 9)
+	{
+		return cmd.error(QObject::tr("Invalid compression level! (should be between -1 and 9)"));
+	}
+
+	ccSerializationHelper::SetArrayCompressionLevel(level);
+	cmd.print(QObject::tr("BIN compression level: %1").arg(level));
+
+	return true;
+}
+
+CommandSetOctreeCache::CommandSetOctreeCache()
+	: ccCommandLineInterface::Command(QObject::tr("Set octree cache folder"), COMMAND_OCTREE_CACHE)
+{}
+
+bool CommandSetOctreeCache::process(ccCommandLineInterface &cmd)
+{
+	if (cmd.arguments().empty())
+	{
+		return cmd.error(QObject::tr("Missing parameter: cache folder after '%1'").arg(COMMAND_OCTREE_CACHE));
+	}
+
+	QString folder = cmd.arguments().takeFirst();
+	if (!QDir().mkpath(folder))
+	{
+		return cmd.error(QObject::tr("Failed to create the octree cache folder '%1'").arg(folder));
+	}
+
+	ccOctree::SetCacheFolder(folder);
+	cmd.print(QObject::tr("Octree cache folder: %1").arg(folder));
+
+	return true;
+}
+
 CommandForceNormalsComputation::CommandForceNormalsComputation()
 	: ccCommandLineInterface::Command(QObject::tr("Compute structured cloud normals"), COMMAND_COMPUTE_GRIDDED_NORMALS)
 {}
@@ -5908,3 +5995,295 @@ bool CommandFeature::process(ccCommandLineInterface &cmd)
 	}
 	return true;
 }
+
+CommandRender::CommandRender()
+	: ccCommandLineInterface::Command(QObject::tr("Render"), COMMAND_RENDER)
+{}
+
+//! Interpolates two viewports (same method as the qAnimation plugin)
+static ccViewportParameters InterpolateViewports(const ccViewportParameters& view1, const ccViewportParameters& view2, double ratio)
+{
+	ccViewportParameters view = view1;
+
+	view.defaultPointSize = static_cast<float>(view1.defaultPointSize + (view2.defaultPointSize - view1.defaultPointSize) * ratio);
+	view.defaultLineWidth = static_cast<float>(view1.defaultLineWidth + (view2.defaultLineWidth - view1.defaultLineWidth) * ratio);
+	view.zNearCoef = view1.zNearCoef + (view2.zNearCoef - view1.zNearCoef) * ratio;
+	view.zNear = view1.zNear + (view2.zNear - view1.zNear) * ratio;
+	view.zFar = view1.zFar + (view2.zFar - view1.zFar) * ratio;
+	view.fov_deg = static_cast<float>(view1.fov_deg + (view2.fov_deg - view1.fov_deg) * ratio);
+	view.cameraAspectRatio = static_cast<float>(view1.cameraAspectRatio + (view2.cameraAspectRatio - view1.cameraAspectRatio) * ratio);
+	view.viewMat = ccGLMatrixd::Interpolate(ratio, view1.viewMat, view2.viewMat);
+	view.setPivotPoint(view1.getPivotPoint() + (view2.getPivotPoint() - view1.getPivotPoint()) * ratio, false);
+	view.setCameraCenter(view1.getCameraCenter() + (view2.getCameraCenter() - view1.getCameraCenter()) * ratio, true);
+	view.setFocalDistance(view1.getFocalDistance() + (view2.getFocalDistance() - view1.getFocalDistance()) * ratio);
+
+	return view;
+}
+
+bool CommandRender::process(ccCommandLineInterface &cmd)
+{
+	cmd.print(QObject::tr("[RENDER]"));
+
+	int width = 1920;
+	int height = 1080;
+	QString viewportsFilename;
+	unsigned framesPerSegment = 0;
+	size_t batchSize = 8;
+	QString extension = "png";
+
+	//look for additional parameters
+	while (!cmd.arguments().empty())
+	{
+		QString argument = cmd.arguments().front();
+		if (ccCommandLineInterface::IsCommand(argument, COMMAND_RENDER_SIZE))
+		{
+			//local option confirmed, we can move on
+			cmd.arguments().pop_front();
+
+			if (cmd.arguments().size() < 2)
+			{
+				return cmd.error(QObject::tr("Missing parameter(s): width and height (in pixels) after '%1'").arg(COMMAND_RENDER_SIZE));
+			}
+			bool widthOk = false;
+			bool heightOk = false;
+			width = cmd.arguments().takeFirst().toInt(&widthOk);
+			height = cmd.arguments().takeFirst().toInt(&heightOk);
+			if (!widthOk || !heightOk || width <= 0 || height <= 0)
+			{
+				return cmd.error(QObject::tr("Invalid image size after '%1'").arg(COMMAND_RENDER_SIZE));
+			}
+		}
+		else if (ccCommandLineInterface::IsCommand(argument, COMMAND_RENDER_VIEWPORTS))
+		{
+			//local option confirmed, we can move on
+			cmd.arguments().pop_front();
+
+			if (cmd.arguments().empty())
+			{
+				return cmd.error(QObject::tr("Missing parameter: filename after '%1'").arg(COMMAND_RENDER_VIEWPORTS));
+			}
+			viewportsFilename = cmd.arguments().takeFirst();
+		}
+		else if (ccCommandLineInterface::IsCommand(argument, COMMAND_RENDER_FRAMES))
+		{
+			//local option confirmed, we can move on
+			cmd.arguments().pop_front();
+
+			if (cmd.arguments().empty())
+			{
+				return cmd.error(QObject::tr("Missing parameter: number of frames after '%1'").arg(COMMAND_RENDER_FRAMES));
+			}
+			bool ok = false;
+			framesPerSegment = cmd.arguments().takeFirst().toUInt(&ok);
+			if (!ok || framesPerSegment == 0)
+			{
+				return cmd.error(QObject::tr("Invalid number of frames after '%1'").arg(COMMAND_RENDER_FRAMES));
+			}
+		}
+		else if (ccCommandLineInterface::IsCommand(argument, COMMAND_RENDER_BATCH))
+		{
+			//local option confirmed, we can move on
+			cmd.arguments().pop_front();
+
+			if (cmd.arguments().empty())
+			{
+				return cmd.error(QObject::tr("Missing parameter: batch size after '%1'").arg(COMMAND_RENDER_BATCH));
+			}
+			bool ok = false;
+			int value = cmd.arguments().takeFirst().toInt(&ok);
+			if (!ok || value <= 0)
+			{
+				return cmd.error(QObject::tr("Invalid batch size after '%1'").arg(COMMAND_RENDER_BATCH));
+			}
+			batchSize = static_cast<size_t>(value);
+		}
+		else if (ccCommandLineInterface::IsCommand(argument, COMMAND_EXPORT_EXTENSION))
+		{
+			//local option confirmed, we can move on
+			cmd.arguments().pop_front();
+
+			if (cmd.arguments().empty())
+			{
+				return cmd.error(QObject::tr("Missing parameter: image extension after '%1'").arg(COMMAND_EXPORT_EXTENSION));
+			}
+			extension = cmd.arguments().takeFirst();
+		}
+		else
+		{
+			break;
+		}
+	}
+
+	if (cmd.arguments().empty())
+	{
+		return cmd.error(QObject::tr("Missing parameter: output filename prefix after \"-%1\"").arg(COMMAND_RENDER));
+	}
+	QString prefix = cmd.arguments().takeFirst();
+
+	if (cmd.clouds().empty() && cmd.meshes().empty())
+	{
+		return cmd.error(QObject::tr("No entity to render! (be sure to open one with \"-%1 [filename]\" before \"-%2\")").arg(COMMAND_OPEN, COMMAND_RENDER));
+	}
+
+	//load the viewports (if any)
+	std::vector<ccViewportParameters> viewports;
+	if (!viewportsFilename.isEmpty())
+	{
+		CC_FILE_ERROR result = CC_FERR_NO_ERROR;
+		ccHObject* db = FileIOFilter::LoadFromFile(viewportsFilename, cmd.fileLoadingParams(), result, QString());
+		if (!db)
+		{
+			return cmd.error(QObject::tr("Failed to load the viewports from file '%1'").arg(viewportsFilename));
+		}
+
+		ccHObject::Container viewportObjects;
+		db->filterChildren(viewportObjects, true, CC_TYPES::VIEWPORT_2D_OBJECT, false);
+		try
+		{
+			viewports.reserve(viewportObjects.size());
+			for (ccHObject* object : viewportObjects)
+			{
+				viewports.push_back(static_cast<cc2DViewportObject*>(object)->getParameters());
+			}
+		}
+		catch (const std::bad_alloc&)
+		{
+			delete db;
+			return cmd.error(QObject::tr("Not enough memory"));
+		}
+		delete db;
+		db = nullptr;
+
+		if (viewports.empty())
+		{
+			return cmd.error(QObject::tr("File '%1' doesn't contain any viewport").arg(viewportsFilename));
+		}
+		cmd.print(QObject::tr("\t%1 viewport(s) loaded").arg(viewports.size()));
+	}
+
+	//offscreen 3D view (no window is shown and the GUI event loop is not involved)
+	QSurfaceFormat format = QSurfaceFormat::defaultFormat();
+	format.setSwapBehavior(QSurfaceFormat::SingleBuffer);
+	format.setStereo(false);
+	ccGLWindow window(&format, nullptr, true);
+	if (!window.initOffscreen(width, height))
+	{
+		return cmd.error(QObject::tr("Failed to initialize the offscreen 3D view"));
+	}
+
+	//the loaded entities are temporarily attached to a dedicated scene
+	ccHObject scene("Render scene");
+	for (CLCloudDesc& desc : cmd.clouds())
+	{
+		scene.addChild(desc.pc, ccHObject::DP_NONE);
+	}
+	for (CLMeshDesc& desc : cmd.meshes())
+	{
+		scene.addChild(desc.mesh, ccHObject::DP_NONE);
+	}
+	scene.setDisplay_recursive(&window);
+	window.setSceneDB(&scene);
+
+	//frames to render
+	std::vector<ccViewportParameters> frames;
+	try
+	{
+		if (viewports.empty())
+		{
+			//default view
+			window.setView(CC_ISO_VIEW_1, false);
+			window.zoomGlobal();
+			frames.push_back(window.getViewportParameters());
+		}
+		else if (framesPerSegment == 0 || viewports.size() < 2)
+		{
+			//one image per viewport
+			frames = viewports;
+		}
+		else
+		{
+			//animation path
+			frames.reserve((viewports.size() - 1) * framesPerSegment + 1);
+			for (size_t i = 0; i + 1 < viewports.size(); ++i)
+			{
+				for (unsigned j = 0; j < framesPerSegment; ++j)
+				{
+					frames.push_back(InterpolateViewports(viewports[i], viewports[i + 1], static_cast<double>(j) / framesPerSegment));
+				}
+			}
+			frames.push_back(viewports.back());
+		}
+	}
+	catch (const std::bad_alloc&)
+	{
+		frames.clear();
+	}
+
+	bool success = !frames.empty();
+	if (!success)
+	{
+		cmd.error(QObject::tr("Not enough memory"));
+	}
+	else
+	{
+		cmd.print(QObject::tr("\tRendering %1 frame(s) (%2 x %3)").arg(frames.size()).arg(width).arg(height));
+	}
+
+	//the images are written in parallel (by batches) while the next frames are rendered
+	struct PendingWrite
+	{
+		QString filename;
+		std::future<bool> result;
+	};
+	std::deque<PendingWrite> pendingWrites;
+	auto waitForOldestWrite = [&]()
+	{
+		PendingWrite& write = pendingWrites.front();
+		if (!write.result.get())
+		{
+			cmd.warning(QObject::tr("Failed to save image '%1'").arg(write.filename));
+			success = false;
+		}
+		pendingWrites.pop_front();
+	};
+
+	QElapsedTimer timer;
+	timer.start();
+	for (size_t i = 0; success && i < frames.size(); ++i)
+	{
+		window.setViewportParameters(frames[i]);
+
+		QImage image = window.renderToImage(1.0f, false, false, true);
+		if (image.isNull())
+		{
+			cmd.error(QObject::tr("Failed to render frame #%1").arg(i));
+			success = false;
+			break;
+		}
+
+		while (pendingWrites.size() >= batchSize)
+		{
+			waitForOldestWrite();
+		}
+
+		QString filename = QString("%1_%2.%3").arg(prefix).arg(i, 5, 10, QChar('0')).arg(extension);
+		pendingWrites.push_back({ filename, std::async(std::launch::async, [image, filename]() { return image.save(filename); }) });
+	}
+	while (!pendingWrites.empty())
+	{
+		waitForOldestWrite();
+	}
+
+	if (success)
+	{
+		double elapsed_s = timer.elapsed() / 1000.0;
+		cmd.print(QObject::tr("\t%1 image(s) saved in %2 s.").arg(frames.size()).arg(elapsed_s, 0, 'f', 2));
+	}
+
+	//detach the entities from the offscreen view
+	window.setSceneDB(nullptr);
+	scene.setDisplay_recursive(nullptr);
+	scene.detachAllChildren();
+
+	return success;
+}
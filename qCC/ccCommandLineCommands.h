@@ -419,6 +419,20 @@ struct CommandChangePLYExportFormat : public ccCommandLineInterface::Command
 	bool process(ccCommandLineInterface& cmd) override;
 };
 
+struct CommandChangeBINCompression : public ccCommandLineInterface::Command
+{
+	CommandChangeBINCompression();
+
+	bool process(ccCommandLineInterface& cmd) override;
+};
+
+struct CommandSetOctreeCache : public ccCommandLineInterface::Command
+{
+	CommandSetOctreeCache();
+
+	bool process(ccCommandLineInterface& cmd) override;
+};
+
 struct CommandForceNormalsComputation : public ccCommandLineInterface::Command
 {
 	CommandForceNormalsComputation();
@@ -519,4 +533,11 @@ struct CommandFeature : public ccCommandLineInterface::Command
 	bool process(ccCommandLineInterface& cmd) override;
 };
 
+struct CommandRender : public ccCommandLineInterface::Command
+{
+	CommandRender();
+
+	bool process(ccCommandLineInterface& cmd) override;
+};
+
 #endif //COMMAND_LINE_COMMANDS_HEADER
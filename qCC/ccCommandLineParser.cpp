@@ -4,6 +4,7 @@
 #include "ccCommandCrossSection.h"
 #include "ccCommandLineCommands.h"
 #include "ccCommandRaster.h"
+#include "ccCommandStream.h"
 #include "ccPluginInterface.h"
 
 //qCC_db
@@ -684,6 +685,8 @@ void ccCommandLineParser::registerBuiltInCommands()
 	registerCommand(Command::Shared(new CommandChangeMeshOutputFormat));
 	registerCommand(Command::Shared(new CommandChangeHierarchyOutputFormat));
 	registerCommand(Command::Shared(new CommandChangePLYExportFormat));
+	registerCommand(Command::Shared(new CommandChangeBINCompression));
+	registerCommand(Command::Shared(new CommandSetOctreeCache));
 	registerCommand(Command::Shared(new CommandForceNormalsComputation));
 	registerCommand(Command::Shared(new CommandSaveClouds));
 	registerCommand(Command::Shared(new CommandSaveMeshes));
@@ -710,6 +713,8 @@ void ccCommandLineParser::registerBuiltInCommands()
 	registerCommand(Command::Shared(new CommandFeature));
 	registerCommand(Command::Shared(new CommandRGBConvertToSF));
 	registerCommand(Command::Shared(new CommandFlipTriangles));
+	registerCommand(Command::Shared(new CommandRender));
+	registerCommand(Command::Shared(new CommandStream(m_commands)));
 }
 
 void ccCommandLineParser::cleanup()
@@ -40,6 +40,7 @@ constexpr char COMMAND_RASTER_PROJ_MAX[]				= "MAX";
 constexpr char COMMAND_RASTER_PROJ_AVG[]				= "AVG";
 constexpr char COMMAND_RASTER_PROJ_MED[]				= "MED";
 constexpr char COMMAND_RASTER_RESAMPLE[]				= "RESAMPLE";
+constexpr char COMMAND_RASTER_TILE_SIZE[]				= "TILE_SIZE";
 
 //2.5D Volume calculation specific commands
 constexpr char COMMAND_VOLUME[] = "VOLUME";
@@ -121,6 +122,7 @@ bool CommandRasterize::process(ccCommandLineInterface &cmd)
 	ccRasterGrid::ProjectionType sfProjectionType = ccRasterGrid::PROJ_AVERAGE_VALUE;
 	ccRasterGrid::EmptyCellFillOption emptyCellFillStrategy = ccRasterGrid::LEAVE_EMPTY;
 	double maxEdgeLength = 0.0;
+	unsigned tileSize = 0;
 
 	while (!cmd.arguments().empty())
 	{
@@ -252,6 +254,18 @@ bool CommandRasterize::process(ccCommandLineInterface &cmd)
 
 			resample = true;
 		}
+		else if (ccCommandLineInterface::IsCommand(argument, COMMAND_RASTER_TILE_SIZE))
+		{
+			//local option confirmed, we can move on
+			cmd.arguments().pop_front();
+
+			bool ok = false;
+			tileSize = cmd.arguments().takeFirst().toUInt(&ok);
+			if (!ok || tileSize == 0)
+			{
+				return cmd.error(QString("Invalid tile size! (after %1)").arg(COMMAND_RASTER_TILE_SIZE));
+			}
+		}
 		else
 		{
 			break;
@@ -269,6 +283,24 @@ bool CommandRasterize::process(ccCommandLineInterface &cmd)
 		emptyCellFillStrategy = ccRasterGrid::LEAVE_EMPTY;
 	}
 
+	if (tileSize != 0)
+	{
+		//in tiled mode, the full grid is never held in memory: it can only be exported as raster file(s)
+		if (outputCloud || outputMesh)
+		{
+			cmd.warning(QString("[Rasterize] The grid can't be exported as a cloud or a mesh in tiled mode (%1)").arg(COMMAND_RASTER_TILE_SIZE));
+			outputCloud = outputMesh = false;
+		}
+		if (!outputRasterZ && !outputRasterRGB)
+		{
+			outputRasterZ = true;
+		}
+		if (emptyCellFillStrategy == ccRasterGrid::INTERPOLATE && (maxEdgeLength <= 0.0 || maxEdgeLength > tileSize))
+		{
+			return cmd.error(QString("[Rasterize] A max edge length (%1, not larger than the tile size) is required to interpolate the empty cells in tiled mode (%2)").arg(COMMAND_RASTER_INTERP_MAX_EDGE_LENGTH).arg(COMMAND_RASTER_TILE_SIZE));
+		}
+	}
+
 	if (!outputCloud && !outputMesh && !outputRasterZ && !outputRasterRGB)
 	{
 		//if no export target is specified, we chose the cloud by default
@@ -300,6 +332,58 @@ bool CommandRasterize::process(ccCommandLineInterface &cmd)
 
 		cmd.print(QString("Grid size: %1 x %2").arg(gridWidth).arg(gridHeight));
 
+		if (tileSize != 0)
+		{
+			//progress dialog
+			QScopedPointer<ccProgressDialog> pDlg(nullptr);
+			if (!cmd.silentMode())
+			{
+				pDlg.reset(new ccProgressDialog(true, cmd.widgetParent()));
+			}
+
+			if (outputRasterZ)
+			{
+				ccRasterizeTool::ExportBands bands;
+				{
+					bands.height = true;
+					bands.rgb = false; //not a good idea to mix RGB and height values!
+					bands.allSFs = outputRasterSFs;
+				}
+				QString exportFilename = cmd.getExportFilename(cloudDesc, "tif", outputRasterSFs ? "RASTER_Z_AND_SF" : "RASTER_Z", nullptr, !cmd.addTimestamp());
+				if (exportFilename.isEmpty())
+				{
+					exportFilename = "rasterZ.tif";
+				}
+
+				if (!ccRasterizeTool::ExportTiledGeoTiff(exportFilename, bands, cloudDesc.pc, gridBBox, vertDir, gridStep, tileSize, projectionType, sfProjectionType, emptyCellFillStrategy, maxEdgeLength, customHeight, pDlg.data()))
+				{
+					return cmd.error("Tiled rasterize process failed");
+				}
+			}
+
+			if (outputRasterRGB)
+			{
+				ccRasterizeTool::ExportBands bands;
+				{
+					bands.rgb = true;
+					bands.height = false; //not a good idea to mix RGB and height values!
+					bands.allSFs = outputRasterSFs;
+				}
+				QString exportFilename = cmd.getExportFilename(cloudDesc, "tif", "RASTER_RGB", nullptr, !cmd.addTimestamp());
+				if (exportFilename.isEmpty())
+				{
+					exportFilename = "rasterRGB.tif";
+				}
+
+				if (!ccRasterizeTool::ExportTiledGeoTiff(exportFilename, bands, cloudDesc.pc, gridBBox, vertDir, gridStep, tileSize, projectionType, sfProjectionType, emptyCellFillStrategy, maxEdgeLength, customHeight, pDlg.data()))
+				{
+					return cmd.error("Tiled rasterize process failed");
+				}
+			}
+
+			continue;
+		}
+
 		if (gridWidth * gridHeight > (1 << 26)) //64 million of cells
 		{
 			if (cmd.silentMode())
@@ -0,0 +1,268 @@
+#include "ccCommandStream.h"
+
+//qCC_db
+#include <ccPointCloud.h>
+
+//qCC_io
+#include <AsciiFilter.h>
+
+//Qt
+#include <QFile>
+#include <QFileInfo>
+#include <QObject>
+
+//system
+#include <cmath>
+
+//commands
+constexpr char COMMAND_STREAM[]			= "STREAM";			//+ [-CHUNK_SIZE {points}] + input file + output file + commands + '-END_STREAM'
+constexpr char COMMAND_STREAM_CHUNK[]	= "CHUNK_SIZE";
+constexpr char COMMAND_STREAM_END[]		= "END_STREAM";
+
+//! Default number of points per chunk (streaming mode)
+static const unsigned c_defaultStreamChunkSize = 5000000;
+
+//! Commands that only depend on each point (and can therefore be applied chunk by chunk)
+static const QStringList s_streamableCommands{	"APPLY_TRANS",
+												"CBANDING",
+												"COORD_TO_SF",
+												"CROP",
+												"FILTER_SF",
+												"INVERT_NORMALS",
+												"NORMALS_TO_DIP",
+												"NORMALS_TO_SFS",
+												"REMOVE_ALL_SFS",
+												"REMOVE_NORMALS",
+												"REMOVE_RGB",
+												"REMOVE_SF",
+												"RENAME_SF",
+												"RGB_CONVERT_TO_SF",
+												"SET_ACTIVE_SF",
+												"SF_ADD_CONST",
+												"SF_ARITHMETIC",
+												"SF_OP",
+												"SS" };
+
+CommandStream::CommandStream(const QMap<QString, ccCommandLineInterface::Command::Shared>& commands)
+	: ccCommandLineInterface::Command(QObject::tr("Stream"), COMMAND_STREAM)
+	, m_commands(commands)
+{}
+
+bool CommandStream::process(ccCommandLineInterface& cmd)
+{
+	cmd.print("[STREAM]");
+
+	QStringList& arguments = cmd.arguments();
+
+	unsigned chunkSize = c_defaultStreamChunkSize;
+	if (!arguments.empty() && ccCommandLineInterface::IsCommand(arguments.front(), COMMAND_STREAM_CHUNK))
+	{
+		arguments.pop_front();
+		bool ok = false;
+		chunkSize = (arguments.empty() ? 0 : arguments.takeFirst().toUInt(&ok));
+		if (!ok || chunkSize == 0)
+		{
+			return cmd.error(QString("Invalid or missing chunk size after '-%1'").arg(COMMAND_STREAM_CHUNK));
+		}
+	}
+
+	if (arguments.size() < 2)
+	{
+		return cmd.error(QString("Missing parameter(s): input and output filenames after '-%1'").arg(COMMAND_STREAM));
+	}
+	QString inputFilename = arguments.takeFirst();
+	QString outputFilename = arguments.takeFirst();
+
+	//only ASCII files can be streamed (read and written chunk by chunk)
+	auto isAsciiFile = [](const QString& filename)
+	{
+		FileIOFilter::Shared filter = FileIOFilter::FindBestFilterForExtension(QFileInfo(filename).suffix());
+		return (filter && filter->getFileFilters(true).contains(AsciiFilter::GetFileFilter()));
+	};
+	if (!QFileInfo::exists(inputFilename))
+	{
+		return cmd.error(QString("Input file '%1' doesn't exist").arg(inputFilename));
+	}
+	if (!isAsciiFile(inputFilename))
+	{
+		return cmd.error(QString("Only ASCII files can be streamed (input file: '%1')").arg(inputFilename));
+	}
+	if (!isAsciiFile(outputFilename))
+	{
+		return cmd.error(QString("Only ASCII files can be written in streaming mode (output file: '%1')").arg(outputFilename));
+	}
+
+	//split the commands to be applied on each chunk
+	std::vector<QStringList> pipeline;
+	bool endFound = false;
+	while (!arguments.empty())
+	{
+		QString argument = arguments.takeFirst();
+		if (ccCommandLineInterface::IsCommand(argument, COMMAND_STREAM_END))
+		{
+			endFound = true;
+			break;
+		}
+
+		QString keyword = (argument.startsWith("-") ? argument.mid(1).toUpper() : QString());
+		if (m_commands.contains(keyword))
+		{
+			if (!s_streamableCommands.contains(keyword))
+			{
+				return cmd.error(QString("Command '%1' can't be applied in streaming mode").arg(argument));
+			}
+			pipeline.push_back(QStringList{ argument });
+		}
+		else if (!pipeline.empty())
+		{
+			//command parameter (may be a negative value)
+			pipeline.back().push_back(argument);
+		}
+		else
+		{
+			return cmd.error(QString("Command expected after '-%1' (found '%2')").arg(COMMAND_STREAM, argument));
+		}
+	}
+	if (!endFound)
+	{
+		cmd.warning(QString("No '-%1' found: all the remaining commands will be applied in streaming mode").arg(COMMAND_STREAM_END));
+	}
+
+	//options that depend on the whole cloud can't be used
+	for (const QStringList& commandArgs : pipeline)
+	{
+		QString keyword = commandArgs.front().mid(1).toUpper();
+		if (keyword == "SS" && (commandArgs.size() != 3 || commandArgs[1].toUpper() != "RANDOM"))
+		{
+			return cmd.error("Only the RANDOM subsampling method can be applied in streaming mode");
+		}
+		if (keyword == "FILTER_SF" && commandArgs.size() >= 3)
+		{
+			bool okMin = false;
+			bool okMax = false;
+			commandArgs[1].toDouble(&okMin);
+			commandArgs[2].toDouble(&okMax);
+			if (!okMin || !okMax)
+			{
+				return cmd.error("Only explicit (numerical) bounds can be used to filter a scalar field in streaming mode");
+			}
+		}
+	}
+
+	//the other entities are put aside (and the auto-save mode is disabled)
+	std::vector<CLCloudDesc> previousClouds;
+	std::swap(previousClouds, cmd.clouds());
+	std::vector<CLMeshDesc> previousMeshes;
+	std::swap(previousMeshes, cmd.meshes());
+	QStringList remainingArguments;
+	std::swap(remainingArguments, arguments);
+	bool previousAutoSaveMode = cmd.autoSaveMode();
+	cmd.toggleAutoSaveMode(false);
+
+	//we start with an empty output file
+	bool success = true;
+	{
+		QFile outputFile(outputFilename);
+		if (!outputFile.open(QFile::WriteOnly | QFile::Truncate))
+		{
+			success = cmd.error(QString("Failed to create output file '%1'").arg(outputFilename));
+		}
+	}
+
+	QFileInfo inputInfo(inputFilename);
+	unsigned chunkIndex = 0;
+	unsigned pointsRead = 0;
+	unsigned pointsWritten = 0;
+	//number of points kept so far by each random subsampling command (see below)
+	std::vector<qint64> keptPoints(pipeline.size(), 0);
+
+	AsciiFilter writer;
+	writer.setAppendMode(true);
+
+	AsciiFilter reader;
+	reader.setChunkHandler([&](ccPointCloud* chunk, double progress) -> CC_FILE_ERROR
+	{
+		cmd.clouds().emplace_back(chunk, inputInfo.completeBaseName(), inputInfo.path(), static_cast<int>(chunkIndex++));
+		pointsRead += chunk->size();
+
+		CC_FILE_ERROR chunkResult = CC_FERR_NO_ERROR;
+		for (size_t i = 0; i < pipeline.size() && chunkResult == CC_FERR_NO_ERROR && !cmd.clouds().empty(); ++i)
+		{
+			arguments = pipeline[i];
+			QString keyword = arguments.takeFirst().mid(1).toUpper();
+
+			if (keyword == "SS")
+			{
+				//the total number of points is distributed over the chunks (pro rata of the input file)
+				qint64 totalCount = arguments[1].toLongLong();
+				qint64 count = std::max<qint64>(0, std::llround(totalCount * progress) - keptPoints[i]);
+				keptPoints[i] += std::min<qint64>(count, cmd.clouds().front().pc->size());
+				if (count == 0)
+				{
+					//nothing to keep in this chunk
+					cmd.removeClouds();
+					break;
+				}
+				arguments[1] = QString::number(count);
+			}
+
+			if (!m_commands.value(keyword)->process(cmd))
+			{
+				//the error message has already been issued
+				chunkResult = CC_FERR_CONSOLE_ERROR;
+			}
+		}
+
+		//append the result to the output file
+		FileIOFilter::SaveParameters saveParameters;
+		saveParameters.alwaysDisplaySaveDialog = false;
+		for (CLCloudDesc& desc : cmd.clouds())
+		{
+			if (chunkResult != CC_FERR_NO_ERROR)
+				break;
+			if (desc.pc->size() == 0)
+				continue;
+			chunkResult = writer.saveToFile(desc.pc, outputFilename, saveParameters);
+			if (chunkResult != CC_FERR_NO_ERROR)
+			{
+				cmd.error(QString("Failed to write in output file '%1'").arg(outputFilename));
+				break;
+			}
+			pointsWritten += desc.pc->size();
+		}
+
+		cmd.removeClouds();
+		cmd.print(QString("Chunk #%1 processed (%2%)").arg(chunkIndex).arg(static_cast<int>(progress * 100)));
+
+		return chunkResult;
+	}, chunkSize);
+
+	if (success)
+	{
+		ccCommandLineInterface::CLLoadParameters parameters = cmd.fileLoadingParams();
+		parameters.shiftHandlingMode = ccGlobalShiftManager::NO_DIALOG_AUTO_SHIFT;
+		parameters.alwaysDisplayLoadDialog = false;
+
+		cmd.print(QString("Streaming file: '%1' (%2 points per chunk)").arg(inputFilename).arg(chunkSize));
+		ccHObject container;
+		CC_FILE_ERROR result = reader.loadFile(inputFilename, container, parameters);
+		if (result != CC_FERR_NO_ERROR)
+		{
+			FileIOFilter::DisplayErrorMessage(result, "streaming", inputFilename);
+			success = false;
+		}
+		else
+		{
+			cmd.print(QString("%1 points read, %2 points written in '%3'").arg(pointsRead).arg(pointsWritten).arg(outputFilename));
+		}
+	}
+
+	//restore the previous state
+	cmd.removeClouds();
+	cmd.clouds() = std::move(previousClouds);
+	cmd.meshes() = std::move(previousMeshes);
+	arguments = std::move(remainingArguments);
+	cmd.toggleAutoSaveMode(previousAutoSaveMode);
+
+	return success;
+}
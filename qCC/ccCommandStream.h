@@ -0,0 +1,27 @@
+#ifndef COMMAND_LINE_STREAM_HEADER
+#define COMMAND_LINE_STREAM_HEADER
+
+#include "ccCommandLineInterface.h"
+
+//Qt
+#include <QMap>
+
+//! Applies (point-wise) commands chunk by chunk, while an ASCII file is read, and appends the results to another ASCII file
+/** Syntax: -STREAM [-CHUNK_SIZE {points}] {input file} {output file} {commands} -END_STREAM
+**/
+struct CommandStream : public ccCommandLineInterface::Command
+{
+	//! Default constructor
+	/** \param commands the registered commands (applied to each chunk)
+	**/
+	CommandStream(const QMap<QString, ccCommandLineInterface::Command::Shared>& commands);
+
+	bool process(ccCommandLineInterface& cmd) override;
+
+protected:
+
+	//! Registered commands
+	const QMap<QString, ccCommandLineInterface::Command::Shared>& m_commands;
+};
+
+#endif //COMMAND_LINE_STREAM_HEADER
@@ -37,10 +37,14 @@
 //qCC_gl
 #include <ccGLWindow.h>
 
+//CCCoreLib
+#include <ReferenceCloud.h>
+
 //qCC_io
 #include <ImageFileFilter.h>
 
 //Qt
+#include <QCoreApplication>
 #include <QFileDialog>
 #include <QMap>
 #include <QMessageBox>
@@ -59,6 +63,7 @@
 
 //System
 #include <cassert>
+#include <functional>
 
 constexpr char HILLSHADE_FIELD_NAME[] = "Hillshade";
 
@@ -1452,6 +1457,520 @@ bool ccRasterizeTool::ExportGeoTiff(const QString& outputFilename,
 #endif
 }
 
+bool ccRasterizeTool::ExportTiledGeoTiff(	const QString& outputFilename,
+											const ExportBands& exportBands,
+											ccPointCloud* cloud,
+											const ccBBox& gridBBox,
+											unsigned char Z,
+											double gridStep,
+											unsigned tileSize,
+											ccRasterGrid::ProjectionType projectionType,
+											ccRasterGrid::ProjectionType sfProjectionType,
+											ccRasterGrid::EmptyCellFillOption fillEmptyCellsStrategy,
+											double maxEdgeLength,
+											double customHeightForEmptyCells/*=std::numeric_limits<double>::quiet_NaN()*/,
+											ccProgressDialog* progressDialog/*=nullptr*/)
+{
+#ifdef CC_GDAL_SUPPORT
+
+	if (!cloud || tileSize == 0)
+	{
+		assert(false);
+		return false;
+	}
+
+	//vertical dimension
+	assert(Z <= 2);
+	const unsigned char X = Z == 2 ? 0 : Z + 1;
+	const unsigned char Y = X == 2 ? 0 : X + 1;
+
+	unsigned gridWidth = 0;
+	unsigned gridHeight = 0;
+	if (!ccRasterGrid::ComputeGridSize(Z, gridBBox, gridStep, gridWidth, gridHeight))
+	{
+		return false;
+	}
+	const CCVector3d minCorner = gridBBox.minCorner().toDouble();
+
+	double stepX = gridStep;
+	double stepY = gridStep;
+
+	//global shift
+	double shiftX = gridBBox.minCorner().u[X] - stepX / 2; //we will declare the raster grid as 'Pixel-is-area'!
+	double shiftY = gridBBox.maxCorner().u[Y] + stepY / 2; //we will declare the raster grid as 'Pixel-is-area'!
+	double shiftZ = 0.0;
+	{
+		const CCVector3d& shift = cloud->getGlobalShift();
+		shiftX -= shift.u[X];
+		shiftY -= shift.u[Y];
+		shiftZ -= shift.u[Z];
+
+		double scale = cloud->getGlobalScale();
+		assert(scale != 0);
+		stepX /= scale;
+		stepY /= scale;
+	}
+
+	//bands
+	const bool interpolate = (fillEmptyCellsStrategy == ccRasterGrid::INTERPOLATE);
+	const unsigned sfCount = (exportBands.allSFs ? cloud->getNumberOfScalarFields() : 0);
+	//DGM: we can't know in advance if there will be empty cells, so we always add the alpha band
+	const bool rgbaMode = (exportBands.rgb && cloud->hasColors() && fillEmptyCellsStrategy == ccRasterGrid::LEAVE_EMPTY);
+	int totalBands = 0;
+	if (exportBands.rgb && cloud->hasColors())
+		totalBands += (rgbaMode ? 4 : 3);
+	if (exportBands.height)
+		++totalBands;
+	if (exportBands.density)
+		++totalBands;
+	totalBands += static_cast<int>(sfCount);
+
+	if (totalBands == 0)
+	{
+		ccLog::Error("Can't output a raster with no band! (check export parameters)");
+		return false;
+	}
+	const bool onlyRGBA = (totalBands == (rgbaMode ? 4 : 3) && exportBands.rgb && cloud->hasColors());
+
+	if (interpolate && (maxEdgeLength <= 0.0 || maxEdgeLength > tileSize))
+	{
+		ccLog::Error(QString("[Rasterize] A max edge length (between 0 and the tile size, i.e. %1 cells) is required to interpolate the empty cells in tiled mode").arg(tileSize));
+		return false;
+	}
+
+	//sort the points by tile (counting sort)
+	const unsigned tileCountX = (gridWidth + tileSize - 1) / tileSize;
+	const unsigned tileCountY = (gridHeight + tileSize - 1) / tileSize;
+	const unsigned tileCount = tileCountX * tileCountY;
+	const unsigned pointCount = cloud->size();
+	std::vector<unsigned> tileStartIndexes;
+	std::vector<unsigned> sortedPointIndexes;
+	try
+	{
+		tileStartIndexes.resize(static_cast<size_t>(tileCount) + 1, 0);
+		sortedPointIndexes.resize(pointCount);
+	}
+	catch (const std::bad_alloc&)
+	{
+		ccLog::Error("[Rasterize] Not enough memory");
+		return false;
+	}
+
+	auto computeTileIndex = [&](const CCVector3* P) -> unsigned
+	{
+		CCVector2i cellPos = ccRasterGrid::ComputeCellPos(*P, minCorner, gridStep, X, Y);
+		if (cellPos.x < 0 || cellPos.y < 0 || cellPos.x >= static_cast<int>(gridWidth) || cellPos.y >= static_cast<int>(gridHeight))
+		{
+			return tileCount;
+		}
+		return (static_cast<unsigned>(cellPos.y) / tileSize) * tileCountX + static_cast<unsigned>(cellPos.x) / tileSize;
+	};
+
+	for (unsigned n = 0; n < pointCount; ++n)
+	{
+		unsigned tileIndex = computeTileIndex(cloud->getPoint(n));
+		if (tileIndex < tileCount)
+			++tileStartIndexes[tileIndex + 1];
+	}
+	for (unsigned t = 0; t < tileCount; ++t)
+	{
+		tileStartIndexes[t + 1] += tileStartIndexes[t];
+	}
+	{
+		std::vector<unsigned> tileFillIndexes(tileStartIndexes.begin(), tileStartIndexes.end() - 1);
+		for (unsigned n = 0; n < pointCount; ++n)
+		{
+			unsigned tileIndex = computeTileIndex(cloud->getPoint(n));
+			if (tileIndex < tileCount)
+				sortedPointIndexes[tileFillIndexes[tileIndex]++] = n;
+		}
+	}
+
+	//margin around each tile (in cells) for the interpolation of the empty cells
+	//(the triangles of the full grid that cover a cell of the tile lie inside this margin
+	//as their edges are bounded by the max edge length)
+	int margin = 0;
+	if (interpolate)
+	{
+		margin = static_cast<int>(std::ceil(maxEdgeLength)) + 1;
+	}
+
+	GDALAllRegister();
+
+	const char pszFormat[] = "GTiff";
+	GDALDriver *poDriver = GetGDALDriverManager()->GetDriverByName(pszFormat);
+	if (!poDriver)
+	{
+		ccLog::Error("[GDAL] Driver %s is not supported", pszFormat);
+		return false;
+	}
+
+	//we create a tiled geotiff (BigTIFF if necessary)
+	char **papszOptions = nullptr;
+	papszOptions = CSLSetNameValue(papszOptions, "TILED", "YES");
+	papszOptions = CSLSetNameValue(papszOptions, "BLOCKXSIZE", "256");
+	papszOptions = CSLSetNameValue(papszOptions, "BLOCKYSIZE", "256");
+	papszOptions = CSLSetNameValue(papszOptions, "BIGTIFF", "IF_SAFER");
+	GDALDataset* poDstDS = poDriver->Create(qUtf8Printable(outputFilename),
+											static_cast<int>(gridWidth),
+											static_cast<int>(gridHeight),
+											totalBands,
+											onlyRGBA ? GDT_Byte : GDT_Float64,
+											papszOptions);
+	CSLDestroy(papszOptions);
+
+	if (!poDstDS)
+	{
+		ccLog::Error("[GDAL] Failed to create output raster");
+		return false;
+	}
+
+	poDstDS->SetMetadataItem("AREA_OR_POINT", "AREA");
+
+	double adfGeoTransform[6] = {	shiftX,		//top left x
+									stepX,		//w-e pixel resolution (can be negative)
+									0,			//0
+									shiftY,		//top left y
+									0,			//0
+									-stepY		//n-s pixel resolution (can be negative)
+	};
+	poDstDS->SetGeoTransform(adfGeoTransform);
+
+	if (progressDialog)
+	{
+		progressDialog->setMethodTitle(QObject::tr("Tiled rasterization"));
+		progressDialog->setInfo(QObject::tr("Cells: %L1 x %L2\nTiles: %L3").arg(gridWidth).arg(gridHeight).arg(tileCount));
+		progressDialog->start();
+		progressDialog->show();
+		QCoreApplication::processEvents();
+	}
+	CCCoreLib::NormalizedProgress nProgress(progressDialog, tileCount);
+
+	//statistics on the valid cells (for filling the empty cells afterwards)
+	double minHeight = std::numeric_limits<double>::max();
+	double maxHeight = std::numeric_limits<double>::lowest();
+	double sumHeight = 0.0;
+	size_t validCellCount = 0;
+
+	std::vector<double> buffer;
+	std::vector<unsigned char> byteBuffer;
+	bool error = false;
+
+	for (unsigned t = 0; t < tileCount && !error; ++t)
+	{
+		//core window of the tile (in grid coordinates)
+		const int x0 = static_cast<int>((t % tileCountX) * tileSize);
+		const int y0 = static_cast<int>((t / tileCountX) * tileSize);
+		const int x1 = std::min(x0 + static_cast<int>(tileSize), static_cast<int>(gridWidth)) - 1;
+		const int y1 = std::min(y0 + static_cast<int>(tileSize), static_cast<int>(gridHeight)) - 1;
+		const int coreWidth = x1 - x0 + 1;
+		const int coreHeight = y1 - y0 + 1;
+
+		//extended window (with the margin)
+		const int wx0 = std::max(0, x0 - margin);
+		const int wy0 = std::max(0, y0 - margin);
+		const int wx1 = std::min(static_cast<int>(gridWidth) - 1, x1 + margin);
+		const int wy1 = std::min(static_cast<int>(gridHeight) - 1, y1 + margin);
+
+		ccRasterGrid tileGrid;
+		CCVector3d tileMinCorner = minCorner;
+		tileMinCorner.u[X] += wx0 * gridStep;
+		tileMinCorner.u[Y] += wy0 * gridStep;
+		if (!tileGrid.init(static_cast<unsigned>(wx1 - wx0 + 1), static_cast<unsigned>(wy1 - wy0 + 1), gridStep, tileMinCorner))
+		{
+			ccLog::Error("[Rasterize] Not enough memory");
+			error = true;
+			break;
+		}
+
+		//gather the points of the extended window (from the current tile and its neighbors)
+		CCCoreLib::ReferenceCloud tilePoints(cloud);
+		{
+			const unsigned tx0 = static_cast<unsigned>(wx0) / tileSize;
+			const unsigned tx1 = static_cast<unsigned>(wx1) / tileSize;
+			const unsigned ty0 = static_cast<unsigned>(wy0) / tileSize;
+			const unsigned ty1 = static_cast<unsigned>(wy1) / tileSize;
+			for (unsigned ty = ty0; ty <= ty1 && !error; ++ty)
+			{
+				for (unsigned tx = tx0; tx <= tx1; ++tx)
+				{
+					unsigned neighborIndex = ty * tileCountX + tx;
+					for (unsigned n = tileStartIndexes[neighborIndex]; n < tileStartIndexes[neighborIndex + 1]; ++n)
+					{
+						unsigned pointIndex = sortedPointIndexes[n];
+						CCVector2i cellPos = tileGrid.computeCellPos(*cloud->getPoint(pointIndex), X, Y);
+						if (	cellPos.x >= 0 && cellPos.x < static_cast<int>(tileGrid.width)
+							&&	cellPos.y >= 0 && cellPos.y < static_cast<int>(tileGrid.height))
+						{
+							if (!tilePoints.addPointIndex(pointIndex))
+							{
+								ccLog::Error("[Rasterize] Not enough memory");
+								error = true;
+								break;
+							}
+						}
+					}
+				}
+			}
+		}
+		if (error)
+		{
+			break;
+		}
+
+		if (tilePoints.size() != 0)
+		{
+			ccPointCloud* tileCloud = cloud->partialClone(&tilePoints);
+			if (!tileCloud)
+			{
+				ccLog::Error("[Rasterize] Not enough memory");
+				error = true;
+				break;
+			}
+
+			if (!tileGrid.fillWith(	tileCloud,
+									Z,
+									projectionType,
+									interpolate,
+									maxEdgeLength,
+									sfCount != 0 ? sfProjectionType : ccRasterGrid::INVALID_PROJECTION_TYPE))
+			{
+				delete tileCloud;
+				ccLog::Error("[Rasterize] Failed to compute tile #%u", t + 1);
+				error = true;
+				break;
+			}
+			delete tileCloud;
+			tileCloud = nullptr;
+		}
+
+		//update the statistics (on the core window only)
+		for (int j = y0; j <= y1; ++j)
+		{
+			const ccRasterGrid::Row& row = tileGrid.rows[j - wy0];
+			for (int i = x0; i <= x1; ++i)
+			{
+				double h = row[i - wx0].h;
+				if (std::isfinite(h))
+				{
+					minHeight = std::min(minHeight, h);
+					maxHeight = std::max(maxHeight, h);
+					sumHeight += h;
+					++validCellCount;
+				}
+			}
+		}
+
+		//now write the core window in the raster file
+		try
+		{
+			buffer.resize(static_cast<size_t>(coreWidth) * coreHeight);
+			byteBuffer.resize(static_cast<size_t>(coreWidth) * coreHeight);
+		}
+		catch (const std::bad_alloc&)
+		{
+			ccLog::Error("[Rasterize] Not enough memory");
+			error = true;
+			break;
+		}
+
+		//the first row of the raster is the northest one (i.e. Ymax)
+		const int rasterY = static_cast<int>(gridHeight) - 1 - y1;
+		auto cellAt = [&](int i, int j) -> const ccRasterCell&
+		{
+			return tileGrid.rows[y1 - j - wy0][x0 + i - wx0];
+		};
+		auto writeBand = [&](int bandIndex, const std::function<double(int, int)>& getValue) -> bool
+		{
+			for (int j = 0; j < coreHeight; ++j)
+				for (int i = 0; i < coreWidth; ++i)
+					buffer[static_cast<size_t>(j) * coreWidth + i] = getValue(i, j);
+
+			return (poDstDS->GetRasterBand(bandIndex)->RasterIO(GF_Write, x0, rasterY, coreWidth, coreHeight, buffer.data(), coreWidth, coreHeight, GDT_Float64, 0, 0) == CE_None);
+		};
+		auto writeByteBand = [&](int bandIndex, const std::function<unsigned char(int, int)>& getValue) -> bool
+		{
+			for (int j = 0; j < coreHeight; ++j)
+				for (int i = 0; i < coreWidth; ++i)
+					byteBuffer[static_cast<size_t>(j) * coreWidth + i] = getValue(i, j);
+
+			return (poDstDS->GetRasterBand(bandIndex)->RasterIO(GF_Write, x0, rasterY, coreWidth, coreHeight, byteBuffer.data(), coreWidth, coreHeight, GDT_Byte, 0, 0) == CE_None);
+		};
+
+		int currentBand = 0;
+
+		//export RGB bands?
+		if (exportBands.rgb && cloud->hasColors())
+		{
+			for (unsigned k = 0; k < 3 && !error; ++k)
+			{
+				error = !writeByteBand(++currentBand, [&](int i, int j)
+				{
+					const ccRasterCell& cell = cellAt(i, j);
+					return (std::isfinite(cell.h) && tileGrid.hasColors ? static_cast<unsigned char>(std::max(0.0, std::min(255.0, cell.color.u[k]))) : 0);
+				});
+			}
+			if (!error && rgbaMode)
+			{
+				error = !writeByteBand(++currentBand, [&](int i, int j)
+				{
+					return static_cast<unsigned char>(std::isfinite(cellAt(i, j).h) ? 255 : 0);
+				});
+			}
+		}
+
+		//export height band? (the empty cells will be filled afterwards)
+		if (!error && exportBands.height)
+		{
+			error = !writeBand(++currentBand, [&](int i, int j)
+			{
+				double h = cellAt(i, j).h;
+				return std::isfinite(h) ? h + shiftZ : std::numeric_limits<double>::quiet_NaN();
+			});
+		}
+
+		//export density band?
+		if (!error && exportBands.density)
+		{
+			error = !writeBand(++currentBand, [&](int i, int j)
+			{
+				return static_cast<double>(cellAt(i, j).nbPoints);
+			});
+		}
+
+		//export SF bands
+		for (unsigned k = 0; k < sfCount && !error; ++k)
+		{
+			const double* sfGrid = (k < tileGrid.scalarFields.size() ? tileGrid.scalarFields[k].data() : nullptr);
+			error = !writeBand(++currentBand, [&](int i, int j)
+			{
+				int cellIndex = (y1 - j - wy0) * static_cast<int>(tileGrid.width) + (x0 + i - wx0);
+				return (sfGrid && cellAt(i, j).nbPoints ? sfGrid[cellIndex] : std::numeric_limits<ccRasterGrid::SF::value_type>::quiet_NaN());
+			});
+		}
+
+		if (error)
+		{
+			ccLog::Error("[GDAL] An error occurred while writing tile #%u", t + 1);
+			break;
+		}
+
+		if (!nProgress.oneStep())
+		{
+			ccLog::Warning("[Rasterize] Process cancelled by the user");
+			error = true;
+			break;
+		}
+	}
+
+	//the empty cells of the height band can only be filled now (as we need the global statistics)
+	if (!error && exportBands.height && validCellCount < static_cast<size_t>(gridWidth) * gridHeight)
+	{
+		if (validCellCount == 0)
+		{
+			minHeight = maxHeight = 0.0;
+		}
+
+		double emptyCellHeight = 0;
+		switch (fillEmptyCellsStrategy)
+		{
+		case ccRasterGrid::LEAVE_EMPTY:
+			emptyCellHeight = minHeight - 1.0;
+			break;
+		case ccRasterGrid::FILL_MINIMUM_HEIGHT:
+			emptyCellHeight = minHeight;
+			break;
+		case ccRasterGrid::FILL_MAXIMUM_HEIGHT:
+			emptyCellHeight = maxHeight;
+			break;
+		case ccRasterGrid::FILL_CUSTOM_HEIGHT:
+		case ccRasterGrid::INTERPOLATE:
+			emptyCellHeight = customHeightForEmptyCells;
+			break;
+		case ccRasterGrid::FILL_AVERAGE_HEIGHT:
+			emptyCellHeight = (validCellCount ? sumHeight / validCellCount : 0.0);
+			break;
+		default:
+			assert(false);
+		}
+		emptyCellHeight += shiftZ;
+
+		const int heightBandIndex = (exportBands.rgb && cloud->hasColors() ? (rgbaMode ? 4 : 3) : 0) + 1;
+		GDALRasterBand* poBand = poDstDS->GetRasterBand(heightBandIndex);
+		if (fillEmptyCellsStrategy == ccRasterGrid::LEAVE_EMPTY)
+		{
+			poBand->SetNoDataValue(emptyCellHeight); //should be transparent!
+		}
+
+		if (!std::isnan(emptyCellHeight))
+		{
+			//we process the raster by stripes of blocks
+			const int stripeHeight = 256;
+			try
+			{
+				buffer.resize(static_cast<size_t>(gridWidth) * stripeHeight);
+			}
+			catch (const std::bad_alloc&)
+			{
+				ccLog::Error("[Rasterize] Not enough memory");
+				error = true;
+			}
+
+			for (int y = 0; y < static_cast<int>(gridHeight) && !error; y += stripeHeight)
+			{
+				const int lineCount = std::min(stripeHeight, static_cast<int>(gridHeight) - y);
+				if (poBand->RasterIO(GF_Read, 0, y, static_cast<int>(gridWidth), lineCount, buffer.data(), static_cast<int>(gridWidth), lineCount, GDT_Float64, 0, 0) != CE_None)
+				{
+					error = true;
+					break;
+				}
+				for (size_t n = 0; n < static_cast<size_t>(gridWidth) * lineCount; ++n)
+				{
+					if (std::isnan(buffer[n]))
+						buffer[n] = emptyCellHeight;
+				}
+				if (poBand->RasterIO(GF_Write, 0, y, static_cast<int>(gridWidth), lineCount, buffer.data(), static_cast<int>(gridWidth), lineCount, GDT_Float64, 0, 0) != CE_None)
+				{
+					error = true;
+					break;
+				}
+			}
+
+			if (error)
+			{
+				ccLog::Error("[GDAL] An error occurred while filling the empty cells of the height band!");
+			}
+		}
+	}
+
+	//SF bands
+	if (!error)
+	{
+		for (unsigned k = 0; k < sfCount; ++k)
+		{
+			int bandIndex = totalBands - static_cast<int>(sfCount) + 1 + static_cast<int>(k);
+			poDstDS->GetRasterBand(bandIndex)->SetNoDataValue(std::numeric_limits<ccRasterGrid::SF::value_type>::quiet_NaN()); //should be transparent!
+		}
+	}
+
+	/* Once we're done, close properly the dataset */
+	GDALClose(poDstDS);
+
+	if (error)
+	{
+		return false;
+	}
+
+	ccLog::Print(QString("[Rasterize] Raster '%1' successfully saved (%2 x %3 cells, %4 tiles)").arg(outputFilename).arg(gridWidth).arg(gridHeight).arg(tileCount));
+	return true;
+
+#else
+	assert(false);
+	ccLog::Error("[Rasterize] GDAL not supported by this version! Can't generate a raster...");
+	return false;
+#endif
+}
+
 //See http://edndoc.esri.com/arcobjects/9.2/net/shared/geoprocessing/spatial_analyst_tools/how_hillshade_works.htm
 void ccRasterizeTool::generateHillshade()
 {
@@ -28,6 +28,7 @@
 class ccGenericPointCloud;
 class ccPointCloud;
 class ccPolyline;
+class ccProgressDialog;
 
 namespace Ui
 {
@@ -69,6 +70,28 @@ public: //raster export
 								ccGenericPointCloud* originCloud = nullptr,
 								int visibleSfIndex = -1);
 
+	//! Rasterizes a cloud tile by tile and exports the result as a (tiled) geotiff file
+	/** The full grid is never held in memory: each tile is computed from the points that fall
+		inside it (plus a margin for the interpolation of the empty cells) and is directly
+		written to the file. Therefore the grid size is only limited by the disk space.
+		When interpolating the empty cells, a max edge length (in cells, not larger than the tile
+		size) is required: it bounds the margin, so that the interpolated cells are the same as
+		with the full grid.
+	**/
+	static bool ExportTiledGeoTiff(	const QString& outputFilename,
+									const ExportBands& exportBands,
+									ccPointCloud* cloud,
+									const ccBBox& gridBBox,
+									unsigned char Z,
+									double gridStep,
+									unsigned tileSize,
+									ccRasterGrid::ProjectionType projectionType,
+									ccRasterGrid::ProjectionType sfProjectionType,
+									ccRasterGrid::EmptyCellFillOption fillEmptyCellsStrategy,
+									double maxEdgeLength,
+									double customHeightForEmptyCells = std::numeric_limits<double>::quiet_NaN(),
+									ccProgressDialog* progressDialog = nullptr);
+
 private:
 
 	//! Exports the grid as a cloud
@@ -58,6 +58,7 @@
 
 //QCC_glWindow
 #include <ccGLWindow.h>
+#include <ccRenderingProfiler.h>
 #include <ccRenderingTools.h>
 
 //local includes
@@ -776,6 +777,8 @@ void MainWindow::connectActions()
 	
 	//hidden
 	connect(m_UI->actionEnableVisualDebugTraces,	&QAction::triggered, this, &MainWindow::toggleVisualDebugTraces);
+	connect(m_UI->actionToggleRenderingProfiler,	&QAction::triggered, this, &MainWindow::toggleRenderingProfiler);
+	connect(m_UI->actionExportRenderingProfile,		&QAction::triggered, this, &MainWindow::doActionExportRenderingProfile);
 }
 
 void MainWindow::doActionColorize()
@@ -5920,12 +5923,18 @@ void MainWindow::doActionResetAllVBOs()
 	m_ccRoot->getRootEntity()->filterChildren(clouds, true, CC_TYPES::POINT_CLOUD, true);
 
 	size_t releasedSize = 0;
+	size_t releasedPagesSize = 0;
+	size_t releasedPointCount = 0;
 	for (ccHObject* entity : clouds)
 	{
 		ccPointCloud* cloud = ccHObjectCaster::ToPointCloud(entity);
 		if (cloud)
 		{
-			releasedSize += cloud->vboSize();
+			unsigned loadedPointCount = 0;
+			size_t pagesSize = 0;
+			releasedSize += cloud->vboSize(&loadedPointCount, &pagesSize);
+			releasedPagesSize += pagesSize;
+			releasedPointCount += loadedPointCount;
 			cloud->releaseVBOs();
 		}
 	}
@@ -5933,6 +5942,16 @@ void MainWindow::doActionResetAllVBOs()
 	if (releasedSize != 0)
 	{
 		ccLog::Print(tr("All VBOs have been released (%1 Mb)").arg(releasedSize / static_cast<double>(1 << 20), 0, 'f', 2));
+		if (releasedPointCount != 0)
+		{
+			//the LOD pages hold (copies of) points that are not counted here
+			size_t standardVBOsSize = releasedSize - releasedPagesSize;
+			ccLog::Print(tr("Points loaded in VBOs: %1 (%2 bytes/point)").arg(releasedPointCount).arg(standardVBOsSize / static_cast<double>(releasedPointCount), 0, 'f', 1));
+		}
+		if (releasedPagesSize != 0)
+		{
+			ccLog::Print(tr("LOD pages: %1 Mb").arg(releasedPagesSize / static_cast<double>(1 << 20), 0, 'f', 2));
+		}
 		if (ccGui::Parameters().useVBOs)
 		{
 			ccLog::Warning(tr("You might want to disable the 'use VBOs' option in the Display Settings to keep the GPU memory empty"));
@@ -6168,6 +6187,63 @@ void MainWindow::toggleVisualDebugTraces()
 	}
 }
 
+void MainWindow::toggleRenderingProfiler()
+{
+	ccGLWindow* win = getActiveGLWindow();
+	if (win)
+	{
+		win->toggleProfiler();
+		ccLog::Print(tr("[3D View %1] Rendering profiler %2").arg(win->getUniqueID()).arg(win->profilerEnabled() ? tr("enabled") : tr("disabled")));
+	}
+}
+
+void MainWindow::doActionExportRenderingProfile()
+{
+	ccGLWindow* win = getActiveGLWindow();
+	if (!win || !win->profiler())
+	{
+		ccConsole::Error(tr("The rendering profiler is not enabled on the active 3D view"));
+		return;
+	}
+
+	if (win->profiler()->frames().empty())
+	{
+		ccConsole::Error(tr("No frame recorded yet"));
+		return;
+	}
+
+	//persistent settings
+	QSettings settings;
+	settings.beginGroup(ccPS::SaveFile());
+	QString currentPath = settings.value(ccPS::CurrentPath(), ccFileUtils::defaultDocPath()).toString();
+
+	QString outputFilename = QFileDialog::getSaveFileName(	this,
+															tr("Select output file"),
+															currentPath,
+															tr("CSV file (*.csv);;JSON file (*.json)"),
+															nullptr,
+															CCFileDialogOptions());
+
+	if (outputFilename.isEmpty())
+	{
+		//process cancelled by the user
+		return;
+	}
+
+	//save last saving location
+	settings.setValue(ccPS::CurrentPath(), QFileInfo(outputFilename).absolutePath());
+	settings.endGroup();
+
+	if (win->profiler()->exportToFile(outputFilename))
+	{
+		ccLog::Print(tr("[Rendering profiler] %1 frame(s) exported to '%2'").arg(win->profiler()->frames().size()).arg(outputFilename));
+	}
+	else
+	{
+		ccConsole::Error(tr("Failed to save file '%1'").arg(outputFilename));
+	}
+}
+
 void MainWindow::toggleFullScreen(bool state)
 {
 	if (state)
@@ -9087,16 +9163,14 @@ void MainWindow::doActionCloudPrimitiveDist()
 			ccScalarField* sf = static_cast<ccScalarField*>(compEnt->getScalarField(sfIdx));
 			if (sf)
 			{
-				ScalarType mean;
-				ScalarType variance;				
 				sf->computeMinAndMax();
-				sf->computeMeanAndVariance(mean, &variance);
+				const ccScalarField::Statistics& stats = sf->getStatistics();
 				ccLog::Print(tr("[Compute Primitive Distances] [Primitive: %1] [Cloud: %2] [%3] Mean distance = %4 / std deviation = %5")
 					.arg(refEntity->getName())
 					.arg(compEnt->getName())
 					.arg(sfName)
-					.arg(mean)
-					.arg(sqrt(variance)));			
+					.arg(stats.mean)
+					.arg(stats.stdDev));
 			}
 			compEnt->setCurrentDisplayedScalarField(sfIdx);
 			compEnt->showSF(sfIdx >= 0);
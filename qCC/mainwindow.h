@@ -237,6 +237,8 @@ private:
 	void testFrameRate();
 	void toggleFullScreen(bool state);
 	void toggleVisualDebugTraces();
+	void toggleRenderingProfiler();
+	void doActionExportRenderingProfile();
 	void toggleExclusiveFullScreen(bool state);
 	void update3DViewsMenu();
 	void updateMenus();